@@ -110,6 +110,22 @@ pub fn build(b: *std.build.Builder) void {
             const run_cmd = zmath.buildBenchmarks(b, options.target).run();
             benchmark_step.dependOn(&run_cmd.step);
         }
+        {
+            const run_cmd = @import("libs/zbullet/build.zig").buildBenchmarks(b, options.target).run();
+            benchmark_step.dependOn(&run_cmd.step);
+        }
+        {
+            const run_cmd = @import("libs/zmesh/build.zig").buildBenchmarks(b, options.target).run();
+            benchmark_step.dependOn(&run_cmd.step);
+        }
+        {
+            const run_cmd = @import("libs/znoise/build.zig").buildBenchmarks(b, options.target).run();
+            benchmark_step.dependOn(&run_cmd.step);
+        }
+        {
+            const run_cmd = @import("libs/zaudio/build.zig").buildBenchmarks(b, options.target).run();
+            benchmark_step.dependOn(&run_cmd.step);
+        }
     }
 }
 
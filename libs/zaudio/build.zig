@@ -36,7 +36,6 @@ fn buildLibrary(exe: *std.build.LibExeObjStep) *std.build.LibExeObjStep {
     lib.addCSourceFile(thisDir() ++ "/libs/miniaudio/miniaudio.c", &.{
         "-DMA_NO_WEBAUDIO",
         "-DMA_NO_ENCODING",
-        "-DMA_NO_NULL",
         "-DMA_NO_JACK",
         "-fno-sanitize=undefined",
         if (@import("builtin").target.os.tag == .macos) "-DMA_NO_RUNTIME_LINKING" else "",
@@ -57,6 +56,18 @@ pub fn buildTests(
     return tests;
 }
 
+pub fn buildBenchmarks(
+    b: *std.build.Builder,
+    target: std.zig.CrossTarget,
+) *std.build.LibExeObjStep {
+    const exe = b.addExecutable("zaudio-benchmark", thisDir() ++ "/src/benchmark.zig");
+    exe.setBuildMode(std.builtin.Mode.ReleaseFast);
+    exe.setTarget(target);
+    exe.addPackage(pkg);
+    link(exe);
+    return exe;
+}
+
 inline fn thisDir() []const u8 {
     return comptime std.fs.path.dirname(@src().file) orelse ".";
 }
@@ -0,0 +1,175 @@
+// -------------------------------------------------------------------------------------------------
+// zaudio - benchmarks
+// -------------------------------------------------------------------------------------------------
+// 'zig build benchmark' in the root project directory will build and run 'ReleaseFast' configuration.
+//
+// All benchmarks use a headless engine (`EngineConfig.initHeadless()`, stereo, 48 kHz) and mix
+// 2 seconds of audio in 10 ms blocks with `Engine.readPcmFrames()` on the calling thread. The
+// result is reported as a realtime factor (seconds of audio mixed per second of CPU time) and as
+// the number of voices / nodes one core could sustain in real time (count * realtime factor).
+//
+// voices: N looping sine waveforms played as sounds, without and with spatialization (sounds are
+// placed around the listener).
+//
+// node graph: N waveform data source nodes, each routed through its own 2nd order low-pass filter
+// node into the engine endpoint (2 * N nodes).
+// -------------------------------------------------------------------------------------------------
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    try voiceBenchmark(allocator, false);
+    try voiceBenchmark(allocator, true);
+    try nodeGraphBenchmark(allocator);
+}
+
+const std = @import("std");
+const time = std.time;
+const Timer = time.Timer;
+const zaudio = @import("zaudio");
+
+const num_channels = 2;
+const sample_rate = 48_000;
+const block_size = 480;
+const num_blocks = 200;
+
+const counts = [_]u32{ 16, 64, 256, 1024 };
+
+noinline fn voiceBenchmark(allocator: std.mem.Allocator, spatialized: bool) !void {
+    for (counts) |num_voices| {
+        const engine = try zaudio.createEngine(allocator, zaudio.EngineConfig.initHeadless(num_channels, sample_rate));
+        defer engine.destroy(allocator);
+
+        var waveforms = std.ArrayList(zaudio.WaveformDataSource).init(allocator);
+        defer {
+            for (waveforms.items) |waveform| waveform.destroy(allocator);
+            waveforms.deinit();
+        }
+        var sounds = std.ArrayList(zaudio.Sound).init(allocator);
+        defer {
+            for (sounds.items) |sound| sound.destroy(allocator);
+            sounds.deinit();
+        }
+
+        var i: u32 = 0;
+        while (i < num_voices) : (i += 1) {
+            try waveforms.ensureUnusedCapacity(1);
+            waveforms.appendAssumeCapacity(try zaudio.createWaveformDataSource(
+                allocator,
+                zaudio.WaveformConfig.init(
+                    .float32,
+                    num_channels,
+                    sample_rate,
+                    .sine,
+                    0.01,
+                    110.0 + @intToFloat(f64, i),
+                ),
+            ));
+
+            try sounds.ensureUnusedCapacity(1);
+            const sound = try engine.createSoundFromDataSource(
+                allocator,
+                waveforms.items[i].asDataSource(),
+                .{ .no_spatialization = !spatialized },
+                null,
+            );
+            sounds.appendAssumeCapacity(sound);
+
+            if (spatialized) {
+                const angle = @intToFloat(f32, i) * (2.0 * std.math.pi / @intToFloat(f32, num_voices));
+                sound.setPosition(.{ 10.0 * @cos(angle), 0.0, 10.0 * @sin(angle) });
+            }
+            try sound.start();
+        }
+
+        const realtime_factor = try render(engine);
+        std.debug.print("{s:>20} - {d:>4} voices: {d:>8.1}x realtime, {d:>8.0} voices per core\n", .{
+            if (spatialized) "voices, spatialized" else "voices",
+            num_voices,
+            realtime_factor,
+            @intToFloat(f64, num_voices) * realtime_factor,
+        });
+    }
+}
+
+noinline fn nodeGraphBenchmark(allocator: std.mem.Allocator) !void {
+    for (counts) |num_sources| {
+        const engine = try zaudio.createEngine(allocator, zaudio.EngineConfig.initHeadless(num_channels, sample_rate));
+        defer engine.destroy(allocator);
+
+        var waveforms = std.ArrayList(zaudio.WaveformDataSource).init(allocator);
+        defer {
+            for (waveforms.items) |waveform| waveform.destroy(allocator);
+            waveforms.deinit();
+        }
+        var source_nodes = std.ArrayList(zaudio.DataSourceNode).init(allocator);
+        defer {
+            for (source_nodes.items) |node| node.destroy(allocator);
+            source_nodes.deinit();
+        }
+        var lpf_nodes = std.ArrayList(zaudio.LpfNode).init(allocator);
+        defer {
+            for (lpf_nodes.items) |node| node.destroy(allocator);
+            lpf_nodes.deinit();
+        }
+
+        var i: u32 = 0;
+        while (i < num_sources) : (i += 1) {
+            try waveforms.ensureUnusedCapacity(1);
+            waveforms.appendAssumeCapacity(try zaudio.createWaveformDataSource(
+                allocator,
+                zaudio.WaveformConfig.init(
+                    .float32,
+                    num_channels,
+                    sample_rate,
+                    .sawtooth,
+                    0.01,
+                    55.0 + @intToFloat(f64, i),
+                ),
+            ));
+
+            try source_nodes.ensureUnusedCapacity(1);
+            const source_node = try engine.createDataSourceNode(
+                allocator,
+                zaudio.DataSourceNodeConfig.init(waveforms.items[i].asDataSource()),
+            );
+            source_nodes.appendAssumeCapacity(source_node);
+
+            try lpf_nodes.ensureUnusedCapacity(1);
+            const lpf_node = try engine.createLpfNode(
+                allocator,
+                zaudio.LpfNodeConfig.init(num_channels, sample_rate, 1000.0, 2),
+            );
+            lpf_nodes.appendAssumeCapacity(lpf_node);
+
+            try source_node.attachOutputBus(0, lpf_node.asNode(), 0);
+            try lpf_node.attachOutputBus(0, engine.getEndpoint(), 0);
+        }
+
+        const realtime_factor = try render(engine);
+        std.debug.print("{s:>20} - {d:>4} nodes:  {d:>8.1}x realtime, {d:>8.0} nodes per core\n", .{
+            "node graph",
+            2 * num_sources,
+            realtime_factor,
+            @intToFloat(f64, 2 * num_sources) * realtime_factor,
+        });
+    }
+}
+
+fn render(engine: zaudio.Engine) !f64 {
+    var frames: [num_channels * block_size]f32 = undefined;
+
+    // Warm up (first block pulls data sources and sets up the mixer).
+    try engine.readPcmFrames(&frames, block_size, null);
+
+    var timer = try Timer.start();
+    var block: u32 = 0;
+    while (block < num_blocks) : (block += 1) {
+        try engine.readPcmFrames(&frames, block_size, null);
+    }
+    const elapsed_s = @intToFloat(f64, timer.read()) / time.ns_per_s;
+    const audio_s = @intToFloat(f64, num_blocks * block_size) / sample_rate;
+    return audio_s / elapsed_s;
+}
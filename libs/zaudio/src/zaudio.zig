@@ -98,6 +98,34 @@ pub const CaptureCallback = struct {
 pub const ResourceManager = *align(@sizeOf(usize)) ResourceManagerImpl;
 const ResourceManagerImpl = opaque {
     // TODO: Add methods.
+
+    pub fn asRaw(rm: ResourceManager) *c.ma_resource_manager {
+        return @ptrCast(*c.ma_resource_manager, rm);
+    }
+
+    /// Makes decoded `frames` (f32, interleaved) loadable under `name` (e.g. by `VoicePool.loadSample()`).
+    /// `frames` are not copied and must stay valid until all users are gone and `unregisterData()` is called.
+    pub fn registerDecodedData(
+        rm: ResourceManager,
+        name: [:0]const u8,
+        frames: []const f32,
+        num_channels: u32,
+        sample_rate: u32,
+    ) Error!void {
+        assert(frames.len % num_channels == 0);
+        try checkResult(c.ma_resource_manager_register_decoded_data(
+            rm.asRaw(),
+            name.ptr,
+            frames.ptr,
+            frames.len / num_channels,
+            c.ma_format_f32,
+            num_channels,
+            sample_rate,
+        ));
+    }
+    pub fn unregisterData(rm: ResourceManager, name: [:0]const u8) Error!void {
+        try checkResult(c.ma_resource_manager_unregister_data(rm.asRaw(), name.ptr));
+    }
 };
 
 pub const Context = *align(@sizeOf(usize)) ContextImpl;
@@ -980,6 +1008,18 @@ pub const EngineConfig = struct {
     pub fn init() EngineConfig {
         return .{ .raw = c.ma_engine_config_init() };
     }
+
+    /// Engine without a playback device. Mixed PCM frames (f32, interleaved) are pulled with
+    /// `Engine.readPcmFrames()` as fast as the CPU allows - for tests, servers and offline rendering. Reading advances
+    /// the engine time and must not be done from more than one thread at a time.
+    pub fn initHeadless(num_channels: u32, sample_rate: u32) EngineConfig {
+        assert(num_channels > 0 and sample_rate > 0);
+        var config = init();
+        config.raw.noDevice = c.MA_TRUE;
+        config.raw.channels = num_channels;
+        config.raw.sampleRate = sample_rate;
+        return config;
+    }
 };
 
 pub fn createEngine(allocator: std.mem.Allocator, config: ?EngineConfig) Error!Engine {
@@ -1054,6 +1094,14 @@ const EngineImpl = opaque {
         return SoundGroupImpl.create(allocator, engine, flags, parent);
     }
 
+    pub fn createVoicePool(
+        engine: Engine,
+        allocator: std.mem.Allocator,
+        config: VoicePoolConfig,
+    ) Error!*VoicePool {
+        return VoicePool.create(allocator, engine, config);
+    }
+
     pub fn getResourceManager(engine: Engine) ResourceManager {
         return @ptrCast(ResourceManager, c.ma_engine_get_resource_manager(engine.asRaw()));
     }
@@ -1066,6 +1114,14 @@ const EngineImpl = opaque {
         return @ptrCast(?Log, c.ma_engine_get_log(engine.asRaw()));
     }
 
+    /// Global engine time in PCM frames (advanced by mixing).
+    pub fn getTimePcmFrames(engine: Engine) u64 {
+        return c.ma_engine_get_time(engine.asRaw());
+    }
+    pub fn setTimePcmFrames(engine: Engine, time: u64) Error!void {
+        try checkResult(c.ma_engine_set_time(engine.asRaw(), time));
+    }
+
     pub fn getSampleRate(engine: Engine) u32 {
         return c.ma_engine_get_sample_rate(engine.asRaw());
     }
@@ -1238,9 +1294,9 @@ const SoundImpl = opaque {
 
         try checkResult(c.ma_sound_init_from_data_source(
             engine.asRaw(),
-            data_source.asRaw(),
+            data_source.asRawDataSource(),
             @bitCast(u32, flags),
-            if (sgroup) |g| g.handle else null,
+            if (sgroup) |g| g.asRaw() else null,
             handle,
         ));
 
@@ -1779,6 +1835,444 @@ const SoundGroupImpl = opaque {
 };
 //--------------------------------------------------------------------------------------------------
 //
+// Voice Pool
+//
+//--------------------------------------------------------------------------------------------------
+pub const VoicePoolConfig = struct {
+    /// Voices that are actually mixed.
+    num_real_voices: u32 = 32,
+    /// Voices that can be playing at the same time (real and virtual).
+    num_voices: u32 = 256,
+    /// Channel count of all samples played by the pool.
+    num_channels: u32 = 1,
+    flags: SoundFlags = .{},
+    sgroup: ?SoundGroup = null,
+    /// Voices with estimated gain (volume, attenuated by the distance to listener 0 when spatialized)
+    /// below this threshold are not mixed.
+    min_audible_gain: f32 = 0.001,
+};
+
+/// Fixed set of voices for short, frequently triggered sounds (gunshots, footsteps).
+///
+/// Samples are decoded once by the engine's resource manager and shared by all voices (and by other
+/// sounds loaded from the same file). Every real voice is a preallocated `ma_sound` reading through
+/// its own `ma_audio_buffer_ref`, so `play()`, `stop()` and `update()` do not allocate.
+///
+/// Voices that are inaudible or lose to higher priority voices are virtualized: they keep their
+/// playback position (derived from the engine time) but are not mixed until they get a real voice
+/// back in `update()`. When all voices are in use, `play()` steals the least important one.
+///
+/// A stolen sound can't be reused until the next mixing period, so the pool keeps a spare sound per
+/// real voice. A new voice that takes a real voice from a less important one starts right away for up
+/// to `num_real_voices` steals per mixing period; after that it starts virtual and gets a real voice
+/// in a later `update()`.
+///
+/// All methods must be called from the same (game) thread.
+pub const VoicePool = struct {
+    engine: Engine,
+    config: VoicePoolConfig,
+    samples: std.ArrayListUnmanaged(SampleData),
+    slots: []Slot,
+    free_slots: []u32,
+    num_free_slots: u32,
+    order: []u32,
+    real_voices: []RealVoice,
+    num_real_voices: u32,
+
+    pub const Sample = enum(u32) { _ };
+
+    pub const Voice = struct {
+        index: u32,
+        generation: u32,
+    };
+
+    pub const PlayArgs = struct {
+        /// Higher priority voices are mixed first and steal from lower priority ones.
+        priority: u8 = 128,
+        volume: f32 = 1.0,
+        position: [3]f32 = .{ 0.0, 0.0, 0.0 },
+        looping: bool = false,
+    };
+
+    const SampleData = struct {
+        buffer: *c.ma_resource_manager_data_buffer,
+        frames: ?*const anyopaque,
+        num_frames: u64,
+    };
+
+    const Slot = struct {
+        generation: u32 = 0,
+        is_active: bool = false,
+        sample: u32 = 0,
+        args: PlayArgs = .{},
+        audibility: f32 = 0.0,
+        /// Engine time (in PCM frames) at which the first frame of the sample was (or would have been) mixed.
+        start_time: u64 = 0,
+        real_voice: ?u32 = null,
+    };
+
+    const RealVoice = struct {
+        sound: c.ma_sound,
+        buffer: c.ma_audio_buffer_ref,
+        slot: ?u32,
+        /// Engine time when the sound was stopped. Mixing thread may still be reading it until the engine
+        /// time moves past this point, only then the sound can be pointed at another sample.
+        stop_time: ?u64,
+
+        fn asSound(real_voice: *RealVoice) Sound {
+            return @ptrCast(Sound, &real_voice.sound);
+        }
+    };
+
+    fn create(allocator: std.mem.Allocator, engine: Engine, config: VoicePoolConfig) Error!*VoicePool {
+        assert(config.num_real_voices > 0 and config.num_voices >= config.num_real_voices);
+
+        const pool = allocator.create(VoicePool) catch return error.OutOfMemory;
+        errdefer allocator.destroy(pool);
+
+        const slots = allocator.alloc(Slot, config.num_voices) catch return error.OutOfMemory;
+        errdefer allocator.free(slots);
+        for (slots) |*slot| slot.* = .{};
+
+        const free_slots = allocator.alloc(u32, config.num_voices) catch return error.OutOfMemory;
+        errdefer allocator.free(free_slots);
+        for (free_slots) |*free_slot, i| free_slot.* = config.num_voices - 1 - @intCast(u32, i);
+
+        const order = allocator.alloc(u32, config.num_voices) catch return error.OutOfMemory;
+        errdefer allocator.free(order);
+
+        // Twice as many sounds as real voices: stolen sounds are stopped and can't be reused before
+        // the next mixing period, spare ones let new voices steal without waiting for it.
+        const real_voices = allocator.alloc(RealVoice, 2 * config.num_real_voices) catch return error.OutOfMemory;
+        errdefer allocator.free(real_voices);
+
+        var num_initialized: u32 = 0;
+        errdefer {
+            for (real_voices[0..num_initialized]) |*real_voice| {
+                c.ma_sound_uninit(&real_voice.sound);
+                c.ma_audio_buffer_ref_uninit(&real_voice.buffer);
+            }
+        }
+        for (real_voices) |*real_voice| {
+            try checkResult(c.ma_audio_buffer_ref_init(
+                c.ma_format_f32,
+                config.num_channels,
+                null,
+                0,
+                &real_voice.buffer,
+            ));
+            real_voice.buffer.sampleRate = engine.getSampleRate();
+
+            checkResult(c.ma_sound_init_from_data_source(
+                engine.asRaw(),
+                &real_voice.buffer,
+                @bitCast(u32, config.flags),
+                if (config.sgroup) |g| g.asRaw() else null,
+                &real_voice.sound,
+            )) catch |err| {
+                c.ma_audio_buffer_ref_uninit(&real_voice.buffer);
+                return err;
+            };
+            real_voice.slot = null;
+            real_voice.stop_time = null;
+            num_initialized += 1;
+        }
+
+        pool.* = .{
+            .engine = engine,
+            .config = config,
+            .samples = .{},
+            .slots = slots,
+            .free_slots = free_slots,
+            .num_free_slots = config.num_voices,
+            .order = order,
+            .real_voices = real_voices,
+            .num_real_voices = 0,
+        };
+        return pool;
+    }
+
+    pub fn destroy(pool: *VoicePool, allocator: std.mem.Allocator) void {
+        for (pool.real_voices) |*real_voice| {
+            c.ma_sound_uninit(&real_voice.sound);
+            c.ma_audio_buffer_ref_uninit(&real_voice.buffer);
+        }
+        for (pool.samples.items) |sample| {
+            _ = c.ma_resource_manager_data_buffer_uninit(sample.buffer);
+            allocator.destroy(sample.buffer);
+        }
+        pool.samples.deinit(allocator);
+        allocator.free(pool.real_voices);
+        allocator.free(pool.order);
+        allocator.free(pool.free_slots);
+        allocator.free(pool.slots);
+        allocator.destroy(pool);
+    }
+
+    /// Decodes `filepath` (or finds data already decoded / registered under this name) in the engine's
+    /// resource manager. The sample must have `config.num_channels` channels.
+    pub fn loadSample(pool: *VoicePool, allocator: std.mem.Allocator, filepath: [:0]const u8) Error!Sample {
+        const buffer = allocator.create(c.ma_resource_manager_data_buffer) catch return error.OutOfMemory;
+        errdefer allocator.destroy(buffer);
+
+        try checkResult(c.ma_resource_manager_data_buffer_init(
+            pool.engine.getResourceManager().asRaw(),
+            filepath.ptr,
+            c.MA_RESOURCE_MANAGER_DATA_SOURCE_FLAG_DECODE,
+            null,
+            buffer,
+        ));
+        errdefer _ = c.ma_resource_manager_data_buffer_uninit(buffer);
+
+        // Voices read the decoded frames directly, so they have to be in one block and in mixing format.
+        const supply = &buffer.pNode.*.data;
+        if (supply.@"type" != c.ma_resource_manager_data_supply_type_decoded)
+            return error.InvalidOperation;
+
+        const decoded = supply.backend.decoded;
+        if (decoded.format != c.ma_format_f32 or
+            decoded.channels != pool.config.num_channels or
+            decoded.sampleRate != pool.engine.getSampleRate() or
+            decoded.totalFrameCount == 0)
+            return error.InvalidArgs;
+
+        pool.samples.append(allocator, .{
+            .buffer = buffer,
+            .frames = decoded.pData,
+            .num_frames = decoded.totalFrameCount,
+        }) catch return error.OutOfMemory;
+
+        return @intToEnum(Sample, @intCast(u32, pool.samples.items.len - 1));
+    }
+
+    /// Starts `sample`. Returns null when all voices are in use by voices that are more important.
+    pub fn play(pool: *VoicePool, sample: Sample, args: PlayArgs) ?Voice {
+        assert(@enumToInt(sample) < pool.samples.items.len);
+
+        const now = pool.engine.getTimePcmFrames();
+        const audibility = pool.estimateAudibility(args, pool.engine.getListenerPosition(0));
+
+        if (pool.num_free_slots == 0) {
+            const victim = pool.findVictim(args.priority, audibility, false) orelse return null;
+            pool.release(victim, now);
+        }
+        pool.num_free_slots -= 1;
+        const index = pool.free_slots[pool.num_free_slots];
+
+        const slot = &pool.slots[index];
+        const generation = slot.generation;
+        slot.* = .{
+            .generation = generation,
+            .is_active = true,
+            .sample = @enumToInt(sample),
+            .args = args,
+            .audibility = audibility,
+            .start_time = now,
+        };
+
+        // Without a spare sound the new voice could not start now, so the victim keeps its real voice.
+        if (audibility >= pool.config.min_audible_gain) {
+            if (pool.findFreeRealVoice(now)) |real_voice_index| {
+                if (pool.num_real_voices == pool.config.num_real_voices) {
+                    if (pool.findVictim(args.priority, audibility, true)) |victim| {
+                        pool.makeVirtual(victim, now);
+                    }
+                }
+                if (pool.num_real_voices < pool.config.num_real_voices) {
+                    _ = pool.makeReal(index, real_voice_index, now);
+                }
+            }
+        }
+        return Voice{ .index = index, .generation = generation };
+    }
+
+    pub fn stop(pool: *VoicePool, voice: Voice) void {
+        if (pool.getSlotIndex(voice)) |index| {
+            pool.release(index, pool.engine.getTimePcmFrames());
+        }
+    }
+
+    /// Releases finished voices and gives real voices to the most important (priority, then estimated
+    /// gain) audible ones. Call once per game frame.
+    pub fn update(pool: *VoicePool) void {
+        const now = pool.engine.getTimePcmFrames();
+        const listener_position = pool.engine.getListenerPosition(0);
+
+        var num_active: u32 = 0;
+        for (pool.slots) |*slot, i| {
+            if (!slot.is_active) continue;
+            const index = @intCast(u32, i);
+            if (pool.hasFinished(index, now)) {
+                pool.release(index, now);
+                continue;
+            }
+            slot.audibility = pool.estimateAudibility(slot.args, listener_position);
+            pool.order[num_active] = index;
+            num_active += 1;
+        }
+
+        const active = pool.order[0..num_active];
+        std.sort.sort(u32, active, @as([]const Slot, pool.slots), struct {
+            fn lessThan(slots: []const Slot, a: u32, b: u32) bool {
+                return isMoreImportant(slots[a], slots[b]);
+            }
+        }.lessThan);
+
+        const num_real = math.min(num_active, pool.config.num_real_voices);
+
+        // Voices that lost their place give back their sounds first.
+        for (active) |index, rank| {
+            const slot = pool.slots[index];
+            if (slot.real_voice != null and (rank >= num_real or slot.audibility < pool.config.min_audible_gain)) {
+                pool.makeVirtual(index, now);
+            }
+        }
+        for (active[0..num_real]) |index| {
+            const slot = pool.slots[index];
+            if (slot.real_voice == null and slot.audibility >= pool.config.min_audible_gain) {
+                const real_voice_index = pool.findFreeRealVoice(now) orelse break;
+                if (!pool.makeReal(index, real_voice_index, now)) break;
+            }
+        }
+    }
+
+    pub fn isPlaying(pool: *VoicePool, voice: Voice) bool {
+        if (pool.getSlotIndex(voice)) |index| {
+            return !pool.hasFinished(index, pool.engine.getTimePcmFrames());
+        }
+        return false;
+    }
+
+    pub fn isVirtual(pool: *VoicePool, voice: Voice) bool {
+        if (pool.getSlotIndex(voice)) |index| {
+            return pool.slots[index].real_voice == null;
+        }
+        return false;
+    }
+
+    pub fn setVolume(pool: *VoicePool, voice: Voice, volume: f32) void {
+        if (pool.getSlotIndex(voice)) |index| {
+            const slot = &pool.slots[index];
+            slot.args.volume = volume;
+            if (slot.real_voice) |real_voice| pool.real_voices[real_voice].asSound().setVolume(volume);
+        }
+    }
+
+    pub fn setPosition(pool: *VoicePool, voice: Voice, v: [3]f32) void {
+        if (pool.getSlotIndex(voice)) |index| {
+            const slot = &pool.slots[index];
+            slot.args.position = v;
+            if (slot.real_voice) |real_voice| pool.real_voices[real_voice].asSound().setPosition(v);
+        }
+    }
+
+    /// Number of voices that are currently mixed.
+    pub fn getNumRealVoices(pool: *const VoicePool) u32 {
+        return pool.num_real_voices;
+    }
+
+    fn getSlotIndex(pool: *const VoicePool, voice: Voice) ?u32 {
+        if (voice.index >= pool.slots.len) return null;
+        const slot = pool.slots[voice.index];
+        return if (slot.is_active and slot.generation == voice.generation) voice.index else null;
+    }
+
+    fn estimateAudibility(pool: *const VoicePool, args: PlayArgs, listener_position: [3]f32) f32 {
+        if (pool.config.flags.no_spatialization) return args.volume;
+        // Default (inverse, min distance 1) attenuation.
+        const dx = args.position[0] - listener_position[0];
+        const dy = args.position[1] - listener_position[1];
+        const dz = args.position[2] - listener_position[2];
+        return args.volume / math.max(1.0, @sqrt(dx * dx + dy * dy + dz * dz));
+    }
+
+    fn isMoreImportant(a: Slot, b: Slot) bool {
+        if (a.args.priority != b.args.priority) return a.args.priority > b.args.priority;
+        if (a.audibility != b.audibility) return a.audibility > b.audibility;
+        return a.start_time > b.start_time;
+    }
+
+    /// Least important voice (a real one when `real_only` is true) that is less important than a new
+    /// voice with `priority` and `audibility`.
+    fn findVictim(pool: *const VoicePool, priority: u8, audibility: f32, real_only: bool) ?u32 {
+        var victim: ?u32 = null;
+        for (pool.slots) |slot, i| {
+            if (!slot.is_active or (real_only and slot.real_voice == null)) continue;
+            if (slot.args.priority > priority or (slot.args.priority == priority and slot.audibility > audibility))
+                continue;
+            if (victim == null or isMoreImportant(pool.slots[victim.?], slot)) {
+                victim = @intCast(u32, i);
+            }
+        }
+        return victim;
+    }
+
+    fn hasFinished(pool: *const VoicePool, index: u32, now: u64) bool {
+        const slot = pool.slots[index];
+        if (slot.real_voice) |real_voice| {
+            return c.ma_sound_at_end(&pool.real_voices[real_voice].sound) == c.MA_TRUE;
+        }
+        return !slot.args.looping and now - slot.start_time >= pool.samples.items[slot.sample].num_frames;
+    }
+
+    /// Sound that is not used by any voice and is no longer read by the mixing thread.
+    fn findFreeRealVoice(pool: *const VoicePool, now: u64) ?u32 {
+        for (pool.real_voices) |real_voice, i| {
+            if (real_voice.slot == null and (real_voice.stop_time == null or real_voice.stop_time.? < now))
+                return @intCast(u32, i);
+        }
+        return null;
+    }
+
+    fn makeReal(pool: *VoicePool, index: u32, real_voice_index: u32, now: u64) bool {
+        const slot = &pool.slots[index];
+        assert(slot.real_voice == null);
+
+        const real_voice = &pool.real_voices[real_voice_index];
+        const sample = pool.samples.items[slot.sample];
+        _ = c.ma_audio_buffer_ref_set_data(&real_voice.buffer, sample.frames, sample.num_frames);
+
+        const sound = real_voice.asSound();
+        sound.setVolume(slot.args.volume);
+        sound.setPosition(slot.args.position);
+        sound.setLooping(slot.args.looping);
+        // Sound is stopped and not read by the mixing thread here. Starting a sound that played to its end
+        // rewinds it (and clears its end flag), so seek only after the start.
+        sound.start() catch return false;
+        sound.seekToPcmFrame((now - slot.start_time) % sample.num_frames) catch {
+            _ = c.ma_sound_stop(&real_voice.sound);
+            real_voice.stop_time = now;
+            return false;
+        };
+
+        real_voice.slot = index;
+        slot.real_voice = real_voice_index;
+        pool.num_real_voices += 1;
+        return true;
+    }
+
+    fn makeVirtual(pool: *VoicePool, index: u32, now: u64) void {
+        const slot = &pool.slots[index];
+        const real_voice = &pool.real_voices[slot.real_voice.?];
+        _ = c.ma_sound_stop(&real_voice.sound);
+        real_voice.slot = null;
+        real_voice.stop_time = now;
+        slot.real_voice = null;
+        pool.num_real_voices -= 1;
+    }
+
+    fn release(pool: *VoicePool, index: u32, now: u64) void {
+        const slot = &pool.slots[index];
+        assert(slot.is_active);
+        if (slot.real_voice != null) pool.makeVirtual(index, now);
+        slot.is_active = false;
+        slot.generation +%= 1;
+        pool.free_slots[pool.num_free_slots] = index;
+        pool.num_free_slots += 1;
+    }
+};
+//--------------------------------------------------------------------------------------------------
+//
 // Fence
 //
 //--------------------------------------------------------------------------------------------------
@@ -1863,6 +2357,178 @@ test "zaudio.engine.basic" {
     try hpf_node.attachOutputBus(0, engine.getEndpoint(), 0);
 }
 
+test "zaudio.engine.headless" {
+    const engine = try createEngine(std.testing.allocator, EngineConfig.initHeadless(2, 48_000));
+    defer engine.destroy(std.testing.allocator);
+
+    try expect(engine.getDevice() == null);
+    try expect(engine.getNumChannels() == 2);
+    try expect(engine.getSampleRate() == 48_000);
+
+    const waveform = try createWaveformDataSource(
+        std.testing.allocator,
+        WaveformConfig.init(.float32, 2, 48_000, .sine, 0.5, 440.0),
+    );
+    defer waveform.destroy(std.testing.allocator);
+
+    const sound = try engine.createSoundFromDataSource(
+        std.testing.allocator,
+        waveform.asDataSource(),
+        .{ .no_spatialization = true },
+        null,
+    );
+    defer sound.destroy(std.testing.allocator);
+
+    var frames: [2 * 480]f32 = undefined;
+    var num_frames_read: u64 = 0;
+    try engine.readPcmFrames(&frames, 480, &num_frames_read);
+    try expect(num_frames_read == 480);
+    for (frames) |sample| try expect(sample == 0.0);
+
+    try sound.start();
+    var peak: f32 = 0.0;
+    var block: u32 = 0;
+    while (block < 10) : (block += 1) {
+        try engine.readPcmFrames(&frames, 480, &num_frames_read);
+        try expect(num_frames_read == 480);
+        for (frames) |sample| peak = math.max(peak, @fabs(sample));
+    }
+    try expect(peak > 0.1 and peak <= 1.0);
+    try expect(engine.getTimePcmFrames() == 11 * 480);
+}
+
+test "zaudio.voice_pool.basic" {
+    const engine = try createEngine(std.testing.allocator, EngineConfig.initHeadless(2, 48_000));
+    defer engine.destroy(std.testing.allocator);
+
+    var sample_frames: [4800]f32 = undefined;
+    for (sample_frames) |*frame| frame.* = 0.5;
+    try engine.getResourceManager().registerDecodedData("zaudio.test.sample", &sample_frames, 1, 48_000);
+    defer engine.getResourceManager().unregisterData("zaudio.test.sample") catch unreachable;
+
+    const pool = try engine.createVoicePool(std.testing.allocator, .{
+        .num_real_voices = 2,
+        .num_voices = 3,
+        .flags = .{ .no_spatialization = true },
+    });
+    defer pool.destroy(std.testing.allocator);
+
+    const sample = try pool.loadSample(std.testing.allocator, "zaudio.test.sample");
+
+    const v1 = pool.play(sample, .{ .priority = 10 }).?;
+    const v2 = pool.play(sample, .{ .priority = 20 }).?;
+    try expect(!pool.isVirtual(v1) and !pool.isVirtual(v2));
+
+    // Takes the real voice of the lowest priority voice, which keeps playing virtually.
+    const v3 = pool.play(sample, .{ .priority = 30 }).?;
+    try expect(pool.isVirtual(v1) and pool.isPlaying(v1));
+    try expect(!pool.isVirtual(v3));
+    try expect(pool.getNumRealVoices() == 2);
+
+    // All voices are in use by more important voices.
+    try expect(pool.play(sample, .{ .priority = 5 }) == null);
+
+    // Steals the least important voice.
+    const v4 = pool.play(sample, .{ .priority = 40 }).?;
+    try expect(!pool.isPlaying(v1));
+    try expect(pool.isVirtual(v2) and !pool.isVirtual(v4));
+
+    var frames: [2 * 480]f32 = undefined;
+    try engine.readPcmFrames(&frames, 480, null);
+    try expect(frames[0] > 0.0);
+
+    pool.stop(v3);
+    pool.update();
+    try expect(!pool.isPlaying(v3));
+    try expect(!pool.isVirtual(v2));
+
+    var block: u32 = 0;
+    while (block < 11) : (block += 1) try engine.readPcmFrames(&frames, 480, null);
+    pool.update();
+    try expect(!pool.isPlaying(v2) and !pool.isPlaying(v4));
+    try expect(pool.getNumRealVoices() == 0);
+}
+
+test "zaudio.voice_pool.reuse" {
+    const engine = try createEngine(std.testing.allocator, EngineConfig.initHeadless(2, 48_000));
+    defer engine.destroy(std.testing.allocator);
+
+    // Every frame holds its own position so the mixed output tells where a voice resumed.
+    var sample_frames: [4800]f32 = undefined;
+    for (sample_frames) |*frame, i| frame.* = @intToFloat(f32, i) / sample_frames.len;
+    try engine.getResourceManager().registerDecodedData("zaudio.test.ramp", &sample_frames, 1, 48_000);
+    defer engine.getResourceManager().unregisterData("zaudio.test.ramp") catch unreachable;
+
+    const pool = try engine.createVoicePool(std.testing.allocator, .{
+        .num_real_voices = 1,
+        .num_voices = 2,
+        .flags = .{ .no_spatialization = true },
+    });
+    defer pool.destroy(std.testing.allocator);
+
+    const sample = try pool.loadSample(std.testing.allocator, "zaudio.test.ramp");
+
+    var frames: [2 * 480]f32 = undefined;
+    var block: u32 = 0;
+
+    // Plays to the end on the first sound.
+    const v1 = pool.play(sample, .{}).?;
+    while (block < 11) : (block += 1) try engine.readPcmFrames(&frames, 480, null);
+    try expect(pool.real_voices[0].asSound().isAtEnd());
+    pool.update();
+    try expect(!pool.isPlaying(v1));
+    try engine.readPcmFrames(&frames, 480, null);
+
+    // Inaudible voice starts virtual and gets the first sound back two blocks later.
+    const v2 = pool.play(sample, .{ .volume = 0.0 }).?;
+    try expect(pool.isVirtual(v2));
+    try engine.readPcmFrames(&frames, 480, null);
+    try engine.readPcmFrames(&frames, 480, null);
+    pool.setVolume(v2, 1.0);
+    pool.update();
+    try expect(!pool.isVirtual(v2));
+    try expect(pool.slots[v2.index].real_voice.? == 0);
+
+    try engine.readPcmFrames(&frames, 480, null);
+    try expect(math.approxEqAbs(f32, frames[2 * 240], (960.0 + 240.0) / 4800.0, 0.01));
+    try expect(math.approxEqAbs(f32, frames[2 * 240 + 1], (960.0 + 240.0) / 4800.0, 0.01));
+}
+
+test "zaudio.voice_pool.steal" {
+    const engine = try createEngine(std.testing.allocator, EngineConfig.initHeadless(2, 48_000));
+    defer engine.destroy(std.testing.allocator);
+
+    var sample_frames: [4800]f32 = undefined;
+    for (sample_frames) |*frame| frame.* = 0.5;
+    try engine.getResourceManager().registerDecodedData("zaudio.test.sample", &sample_frames, 1, 48_000);
+    defer engine.getResourceManager().unregisterData("zaudio.test.sample") catch unreachable;
+
+    const pool = try engine.createVoicePool(std.testing.allocator, .{
+        .num_real_voices = 1,
+        .num_voices = 3,
+        .flags = .{ .no_spatialization = true },
+    });
+    defer pool.destroy(std.testing.allocator);
+
+    const sample = try pool.loadSample(std.testing.allocator, "zaudio.test.sample");
+
+    const v1 = pool.play(sample, .{ .priority = 10 }).?;
+    const v2 = pool.play(sample, .{ .priority = 20 }).?;
+    try expect(pool.isVirtual(v1) and !pool.isVirtual(v2));
+
+    // Stolen sound is still read by the mixing thread and the spare one is in use: the victim keeps
+    // its real voice until the next mixing period.
+    const v3 = pool.play(sample, .{ .priority = 30 }).?;
+    try expect(!pool.isVirtual(v2) and pool.isVirtual(v3));
+    try expect(pool.getNumRealVoices() == 1);
+
+    var frames: [2 * 480]f32 = undefined;
+    try engine.readPcmFrames(&frames, 480, null);
+    pool.update();
+    try expect(pool.isVirtual(v2) and !pool.isVirtual(v3));
+    try expect(pool.getNumRealVoices() == 1);
+}
+
 test "zaudio.soundgroup.basic" {
     const engine = try createEngine(std.testing.allocator, null);
     defer engine.destroy(std.testing.allocator);
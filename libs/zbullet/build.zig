@@ -31,6 +31,18 @@ pub fn buildTests(
     return tests;
 }
 
+pub fn buildBenchmarks(
+    b: *std.build.Builder,
+    target: std.zig.CrossTarget,
+) *std.build.LibExeObjStep {
+    const exe = b.addExecutable("zbullet-benchmark", thisDir() ++ "/src/benchmark.zig");
+    exe.setBuildMode(std.builtin.Mode.ReleaseFast);
+    exe.setTarget(target);
+    exe.addPackage(pkg);
+    link(exe);
+    return exe;
+}
+
 fn buildLibrary(exe: *std.build.LibExeObjStep) *std.build.LibExeObjStep {
     const lib = exe.builder.addStaticLibrary("zbullet", thisDir() ++ "/src/zbullet.zig");
 
@@ -1,26 +1,565 @@
 #include "cbullet.h"
 #include <assert.h>
+#include <limits.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
 #include "btBulletCollisionCommon.h"
 #include "btBulletDynamicsCommon.h"
 #include "BulletDynamics/ConstraintSolver/btContactConstraint.h"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletCollision/CollisionDispatch/btCollisionWorldImporter.h"
+#include "BulletCollision/CollisionDispatch/btGhostObject.h"
+#include "BulletCollision/CollisionShapes/btConvexHullShape.h"
+#include "BulletCollision/CollisionShapes/btMultiSphereShape.h"
+#include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionShapes/btTriangleInfoMap.h"
+#include "BulletCollision/Gimpact/btGImpactShape.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
+
+//
+// Memory allocation
+//
+// All Bullet allocations go through routeAlloc()/routeFree(). Each memory block is preceded by a small header which
+// records its owner so that any block can be freed without knowing which world (if any) allocated it. While a world
+// with an arena is being updated (see ArenaScope) allocations made on the calling thread and on task scheduler worker
+// threads are served from that world's arena.
+//
+static const size_t k_alloc_header_size = 16;
+static const uint32_t k_arena_num_size_classes = 10; // 32 B - 16 KB (header included)
+static const uint32_t k_arena_min_size_class_log2 = 5;
+static const uint32_t k_arena_max_cached_blocks = 64; // per size class, per thread
+static const uint8_t k_size_class_large = 0xff;
+static const size_t k_arena_default_block_size = 256 * 1024;
+static const size_t k_arena_block_header_size = 64;
+
+struct AllocHeader {
+    void* owner; // Arena* for arena allocations, pointer returned by the backing allocator otherwise
+    uint32_t size;
+    uint8_t size_class;
+    uint8_t category;
+    uint8_t is_arena;
+    uint8_t backing; // BackingAllocator that served a non-arena block
+};
+static_assert(sizeof(AllocHeader) <= k_alloc_header_size, "AllocHeader is too big");
+
+// Backing allocators can be installed and removed while blocks are alive, so every block remembers which one
+// allocated it and is returned to the same one.
+enum BackingAllocator : uint8_t {
+    k_backing_malloc,
+    k_backing_custom,
+    k_backing_custom_aligned,
+};
+
+struct ArenaLargeAlloc {
+    ArenaLargeAlloc* prev;
+    ArenaLargeAlloc* next;
+    void* base;
+    size_t size;
+};
+static const size_t k_arena_large_prefix_size = 32;
+static_assert(sizeof(ArenaLargeAlloc) <= k_arena_large_prefix_size, "ArenaLargeAlloc is too big");
+
+struct Arena {
+    uint64_t id;
+    Arena* next_live;
+    CbtArenaAllocCallback alloc;
+    CbtArenaFreeCallback free;
+    void* context;
+    size_t block_size;
+    bool releasing;
+
+    btSpinMutex mutex; // protects everything below
+    void* free_lists[k_arena_num_size_classes];
+    uint8_t* bump;
+    uint8_t* bump_end;
+    void* blocks; // first pointer in each block links to the next block
+    ArenaLargeAlloc* large_allocs;
+
+    std::atomic<size_t> bytes_reserved;
+    std::atomic<size_t> bytes_in_use[CBT_ARENA_CATEGORY_COUNT];
+    std::atomic<uint32_t> num_live_allocs[CBT_ARENA_CATEGORY_COUNT];
+    std::atomic<uint64_t> num_total_allocs[CBT_ARENA_CATEGORY_COUNT];
+};
+
+// Each thread keeps small free lists for the last arena it allocated from. When a thread switches to another arena
+// its cached blocks are returned to the previous arena (if that arena still exists).
+struct ArenaThreadCache {
+    uint64_t arena_id;
+    Arena* arena;
+    void* heads[k_arena_num_size_classes];
+    uint32_t counts[k_arena_num_size_classes];
+};
+
+static thread_local ArenaThreadCache t_arena_cache;
+static thread_local Arena* t_arena = nullptr;
+static thread_local uint8_t t_arena_category = CBT_ARENA_CATEGORY_SIMULATION;
+
+static btSpinMutex s_live_arenas_mutex;
+static Arena* s_live_arenas = nullptr;
+static uint64_t s_next_arena_id = 1;
+
+static CbtAllocFunc* s_alloc = nullptr;
+static CbtFreeFunc* s_free = nullptr;
+static CbtAlignedAllocFunc* s_aligned_alloc = nullptr;
+static CbtAlignedFreeFunc* s_aligned_free = nullptr;
+
+static inline AllocHeader* getAllocHeader(void* ptr) {
+    return (AllocHeader*)((uint8_t*)ptr - k_alloc_header_size);
+}
+
+static inline uint8_t* alignPointer(uint8_t* ptr, size_t alignment) {
+    return (uint8_t*)(((uintptr_t)ptr + (alignment - 1)) & ~(uintptr_t)(alignment - 1));
+}
+
+static void* globalAlloc(size_t size, int alignment) {
+    const size_t align = alignment > (int)k_alloc_header_size ? (size_t)alignment : k_alloc_header_size;
+    uint8_t* base = nullptr;
+    uint8_t* ptr = nullptr;
+    BackingAllocator backing;
+    if (s_aligned_alloc) {
+        backing = k_backing_custom_aligned;
+        base = (uint8_t*)s_aligned_alloc(size + align, (int)align);
+        if (base == nullptr) {
+            return nullptr;
+        }
+        ptr = base + align;
+    } else {
+        const size_t total = size + k_alloc_header_size + align;
+        backing = s_alloc ? k_backing_custom : k_backing_malloc;
+        base = (uint8_t*)(s_alloc ? s_alloc(total) : malloc(total));
+        if (base == nullptr) {
+            return nullptr;
+        }
+        ptr = alignPointer(base + k_alloc_header_size, align);
+    }
+    AllocHeader* header = getAllocHeader(ptr);
+    header->owner = base;
+    header->size = (uint32_t)size;
+    header->size_class = k_size_class_large;
+    header->category = 0;
+    header->is_arena = 0;
+    header->backing = backing;
+    return ptr;
+}
+
+static void globalFree(AllocHeader* header) {
+    switch (header->backing) {
+        case k_backing_custom_aligned:
+            // A block that outlives its allocator can't be returned to it; it is leaked.
+            assert(s_aligned_free && "block freed after its custom aligned allocator was removed");
+            if (s_aligned_free) {
+                s_aligned_free(header->owner);
+            }
+            break;
+        case k_backing_custom:
+            assert(s_free && "block freed after its custom allocator was removed");
+            if (s_free) {
+                s_free(header->owner);
+            }
+            break;
+        default:
+            free(header->owner);
+            break;
+    }
+}
+
+static void* arenaBackingAlloc(Arena* arena, size_t size, int alignment) {
+    if (arena->alloc) {
+        return arena->alloc(arena->context, size, alignment);
+    }
+    return globalAlloc(size, alignment);
+}
+
+static void arenaBackingFree(Arena* arena, void* ptr) {
+    if (arena->alloc) {
+        arena->free(arena->context, ptr);
+    } else {
+        globalFree(getAllocHeader(ptr));
+    }
+}
+
+static inline uint32_t arenaSizeClass(size_t size_with_header) {
+    uint32_t size_class = 0;
+    while (size_class < k_arena_num_size_classes &&
+        ((size_t)1 << (size_class + k_arena_min_size_class_log2)) < size_with_header) {
+        ++size_class;
+    }
+    return size_class;
+}
+
+// Returns thread-local cached blocks to the arena they came from. Arenas which were destroyed in the meantime are
+// skipped - their memory has already been released.
+static void arenaFlushThreadCache(ArenaThreadCache* cache) {
+    if (cache->arena != nullptr) {
+        s_live_arenas_mutex.lock();
+        Arena* arena = s_live_arenas;
+        while (arena && !(arena == cache->arena && arena->id == cache->arena_id)) {
+            arena = arena->next_live;
+        }
+        if (arena) {
+            arena->mutex.lock();
+            for (uint32_t c = 0; c < k_arena_num_size_classes; ++c) {
+                while (cache->heads[c]) {
+                    void* block = cache->heads[c];
+                    cache->heads[c] = *(void**)block;
+                    *(void**)block = arena->free_lists[c];
+                    arena->free_lists[c] = block;
+                }
+            }
+            arena->mutex.unlock();
+        }
+        s_live_arenas_mutex.unlock();
+    }
+    memset(cache, 0, sizeof(*cache));
+}
+
+static uint8_t* arenaCarve(Arena* arena, size_t size) {
+    if (arena->bump + size > arena->bump_end) {
+        auto block = (uint8_t*)arenaBackingAlloc(arena, arena->block_size, 64);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        arena->bytes_reserved += arena->block_size;
+        *(void**)block = arena->blocks;
+        arena->blocks = block;
+        arena->bump = block + k_arena_block_header_size;
+        arena->bump_end = block + arena->block_size;
+    }
+    uint8_t* mem = arena->bump;
+    arena->bump += size;
+    return mem;
+}
+
+static void* arenaAlloc(Arena* arena, size_t size, int alignment, uint8_t category) {
+    assert(size <= UINT32_MAX);
+    const uint32_t size_class = arenaSizeClass(size + k_alloc_header_size);
+
+    uint8_t* ptr = nullptr;
+    if (size_class == k_arena_num_size_classes || alignment > (int)k_alloc_header_size) {
+        const size_t align = alignment > (int)k_alloc_header_size ? (size_t)alignment : k_alloc_header_size;
+        const size_t total = size + k_arena_large_prefix_size + k_alloc_header_size + align;
+        auto base = (uint8_t*)arenaBackingAlloc(arena, total, (int)k_alloc_header_size);
+        if (base == nullptr) {
+            return nullptr;
+        }
+        ptr = alignPointer(base + k_arena_large_prefix_size + k_alloc_header_size, align);
+
+        auto large = (ArenaLargeAlloc*)(ptr - k_alloc_header_size - k_arena_large_prefix_size);
+        large->base = base;
+        large->size = total;
+        large->prev = nullptr;
+
+        arena->mutex.lock();
+        large->next = arena->large_allocs;
+        if (arena->large_allocs) {
+            arena->large_allocs->prev = large;
+        }
+        arena->large_allocs = large;
+        arena->mutex.unlock();
+
+        arena->bytes_reserved += total;
+        getAllocHeader(ptr)->size_class = k_size_class_large;
+    } else {
+        ArenaThreadCache* cache = &t_arena_cache;
+        if (cache->arena != arena || cache->arena_id != arena->id) {
+            arenaFlushThreadCache(cache);
+            cache->arena = arena;
+            cache->arena_id = arena->id;
+        }
+
+        void* block = cache->heads[size_class];
+        if (block) {
+            cache->heads[size_class] = *(void**)block;
+            cache->counts[size_class] -= 1;
+        } else {
+            arena->mutex.lock();
+            block = arena->free_lists[size_class];
+            if (block) {
+                arena->free_lists[size_class] = *(void**)block;
+            } else {
+                block = arenaCarve(arena, (size_t)1 << (size_class + k_arena_min_size_class_log2));
+            }
+            arena->mutex.unlock();
+            if (block == nullptr) {
+                return nullptr;
+            }
+        }
+        ptr = (uint8_t*)block + k_alloc_header_size;
+        getAllocHeader(ptr)->size_class = (uint8_t)size_class;
+    }
+
+    AllocHeader* header = getAllocHeader(ptr);
+    header->owner = arena;
+    header->size = (uint32_t)size;
+    header->category = category;
+    header->is_arena = 1;
+
+    arena->bytes_in_use[category].fetch_add(size, std::memory_order_relaxed);
+    arena->num_live_allocs[category].fetch_add(1, std::memory_order_relaxed);
+    arena->num_total_allocs[category].fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+}
+
+static void arenaFree(AllocHeader* header) {
+    auto arena = (Arena*)header->owner;
+    arena->bytes_in_use[header->category].fetch_sub(header->size, std::memory_order_relaxed);
+    arena->num_live_allocs[header->category].fetch_sub(1, std::memory_order_relaxed);
+
+    // Arena is being released as a whole, there is no need to return individual blocks.
+    if (arena->releasing) {
+        return;
+    }
+
+    const uint32_t size_class = header->size_class;
+    if (size_class == k_size_class_large) {
+        auto large = (ArenaLargeAlloc*)((uint8_t*)header - k_arena_large_prefix_size);
+        arena->mutex.lock();
+        if (large->prev) large->prev->next = large->next;
+        else arena->large_allocs = large->next;
+        if (large->next) large->next->prev = large->prev;
+        arena->mutex.unlock();
+
+        arena->bytes_reserved -= large->size;
+        arenaBackingFree(arena, large->base);
+        return;
+    }
+
+    ArenaThreadCache* cache = &t_arena_cache;
+    void* block = header;
+    if (cache->arena == arena && cache->arena_id == arena->id &&
+        cache->counts[size_class] < k_arena_max_cached_blocks) {
+        *(void**)block = cache->heads[size_class];
+        cache->heads[size_class] = block;
+        cache->counts[size_class] += 1;
+    } else {
+        arena->mutex.lock();
+        *(void**)block = arena->free_lists[size_class];
+        arena->free_lists[size_class] = block;
+        arena->mutex.unlock();
+    }
+}
+
+static Arena* arenaCreate(const CbtArenaDesc* desc) {
+    assert(desc);
+    assert((desc->alloc == nullptr) == (desc->free == nullptr));
+
+    auto arena = (Arena*)globalAlloc(sizeof(Arena), 64);
+    new (arena) Arena();
+    memset(arena->free_lists, 0, sizeof(arena->free_lists));
+    arena->alloc = desc->alloc;
+    arena->free = desc->free;
+    arena->context = desc->context;
+    arena->block_size = desc->block_size ? desc->block_size : k_arena_default_block_size;
+    assert(arena->block_size >= k_arena_block_header_size +
+        ((size_t)1 << (k_arena_num_size_classes - 1 + k_arena_min_size_class_log2)));
+    arena->releasing = false;
+    arena->bump = nullptr;
+    arena->bump_end = nullptr;
+    arena->blocks = nullptr;
+    arena->large_allocs = nullptr;
+    arena->bytes_reserved = 0;
+    for (int c = 0; c < CBT_ARENA_CATEGORY_COUNT; ++c) {
+        arena->bytes_in_use[c] = 0;
+        arena->num_live_allocs[c] = 0;
+        arena->num_total_allocs[c] = 0;
+    }
+
+    s_live_arenas_mutex.lock();
+    arena->id = s_next_arena_id++;
+    arena->next_live = s_live_arenas;
+    s_live_arenas = arena;
+    s_live_arenas_mutex.unlock();
+
+    return arena;
+}
+
+// Releases all memory owned by the arena. Cost depends only on the number of backing blocks, not on the number of
+// allocations made from the arena.
+static void arenaDestroy(Arena* arena) {
+    s_live_arenas_mutex.lock();
+    Arena** link = &s_live_arenas;
+    while (*link != arena) {
+        link = &(*link)->next_live;
+    }
+    *link = arena->next_live;
+    s_live_arenas_mutex.unlock();
+
+    if (t_arena_cache.arena == arena && t_arena_cache.arena_id == arena->id) {
+        memset(&t_arena_cache, 0, sizeof(t_arena_cache));
+    }
+
+    ArenaLargeAlloc* large = arena->large_allocs;
+    while (large) {
+        ArenaLargeAlloc* next = large->next;
+        arenaBackingFree(arena, large->base);
+        large = next;
+    }
+    void* block = arena->blocks;
+    while (block) {
+        void* next = *(void**)block;
+        arenaBackingFree(arena, block);
+        block = next;
+    }
+
+    arena->~Arena();
+    globalFree(getAllocHeader(arena));
+}
+
+static void* routeAlloc(size_t size, int alignment) {
+    if (t_arena) {
+        return arenaAlloc(t_arena, size, alignment, t_arena_category);
+    }
+    return globalAlloc(size, alignment);
+}
+
+static void routeFree(void* ptr) {
+    if (ptr) {
+        AllocHeader* header = getAllocHeader(ptr);
+        if (header->is_arena) {
+            arenaFree(header);
+        } else {
+            globalFree(header);
+        }
+    }
+}
+
+static const bool s_route_alloc_installed = (btAlignedAllocSetCustomAligned(routeAlloc, routeFree), true);
+
+// Directs allocations made on the current thread to `arena` (no-op when `arena` is null).
+struct ArenaScope {
+    Arena* saved_arena;
+    uint8_t saved_category;
+
+    ArenaScope(Arena* arena, uint8_t category) : saved_arena(t_arena), saved_category(t_arena_category) {
+        if (arena) {
+            t_arena = arena;
+            t_arena_category = category;
+        }
+    }
+    ~ArenaScope() {
+        t_arena = saved_arena;
+        t_arena_category = saved_category;
+    }
+};
+
+// Propagates the arena of the calling thread to worker threads.
+struct ArenaParallelForBody : public btIParallelForBody {
+    const btIParallelForBody& body;
+    Arena* arena;
+    uint8_t category;
+
+    ArenaParallelForBody(const btIParallelForBody& in_body, Arena* in_arena, uint8_t in_category) :
+        body(in_body), arena(in_arena), category(in_category) {}
+
+    virtual void forLoop(int begin, int end) const override {
+        ArenaScope scope(arena, category);
+        body.forLoop(begin, end);
+    }
+};
+
+struct ArenaParallelSumBody : public btIParallelSumBody {
+    const btIParallelSumBody& body;
+    Arena* arena;
+    uint8_t category;
+
+    ArenaParallelSumBody(const btIParallelSumBody& in_body, Arena* in_arena, uint8_t in_category) :
+        body(in_body), arena(in_arena), category(in_category) {}
+
+    virtual btScalar sumLoop(int begin, int end) const override {
+        ArenaScope scope(arena, category);
+        return body.sumLoop(begin, end);
+    }
+};
+
+struct ArenaTaskScheduler : public btITaskScheduler {
+    btITaskScheduler* scheduler;
+
+    ArenaTaskScheduler(btITaskScheduler* in_scheduler) :
+        btITaskScheduler(in_scheduler->getName()), scheduler(in_scheduler) {}
+
+    virtual int getMaxNumThreads() const override { return scheduler->getMaxNumThreads(); }
+    virtual int getNumThreads() const override { return scheduler->getNumThreads(); }
+    virtual void setNumThreads(int num_threads) override { scheduler->setNumThreads(num_threads); }
+    virtual void sleepWorkerThreadsHint() override { scheduler->sleepWorkerThreadsHint(); }
+    virtual void activate() override { scheduler->activate(); }
+    virtual void deactivate() override { scheduler->deactivate(); }
+
+    virtual void parallelFor(int begin, int end, int grain_size, const btIParallelForBody& body) override {
+        if (t_arena == nullptr) {
+            scheduler->parallelFor(begin, end, grain_size, body);
+        } else {
+            scheduler->parallelFor(begin, end, grain_size, ArenaParallelForBody(body, t_arena, t_arena_category));
+        }
+    }
+
+    virtual btScalar parallelSum(int begin, int end, int grain_size, const btIParallelSumBody& body) override {
+        if (t_arena == nullptr) {
+            return scheduler->parallelSum(begin, end, grain_size, body);
+        }
+        return scheduler->parallelSum(begin, end, grain_size, ArenaParallelSumBody(body, t_arena, t_arena_category));
+    }
+};
 
 void cbtAlignedAllocSetCustom(CbtAllocFunc alloc, CbtFreeFunc free) {
+    assert(s_route_alloc_installed);
     btAlignedAllocSetCustom(alloc, free);
+    s_alloc = alloc;
+    s_free = free;
 }
 
 void cbtAlignedAllocSetCustomAligned(CbtAlignedAllocFunc alloc, CbtAlignedFreeFunc free) {
-    btAlignedAllocSetCustomAligned(alloc, free);
+    assert(s_route_alloc_installed);
+    s_aligned_alloc = alloc;
+    s_aligned_free = free;
+}
+
+static inline unsigned int packDebugColor(const btVector3& color) {
+    const unsigned int r = (unsigned int)(color.x() * 255.0f);
+    const unsigned int g = (unsigned int)(color.y() * 255.0f) << 8;
+    const unsigned int b = (unsigned int)(color.z() * 255.0f) << 16;
+    return r | g | b;
 }
 
 struct DebugDraw : public btIDebugDraw {
     CbtDebugDraw drawer = {};
     int mode = 0;
 
+    // Set only for the duration of cbtWorldDebugDrawAllToBuffer().
+    CbtDebugLineBuffer* buffer = nullptr;
+    btAlignedObjectArray<btCollisionObject*> culled_objects;
+
+    void appendLine(const btVector3& from, const btVector3& to, unsigned int color0, unsigned int color1) {
+        if (buffer->num_lines == buffer->max_lines && buffer->grow) {
+            buffer->grow(buffer->context, buffer, buffer->num_lines + 1);
+        }
+        if (buffer->num_lines == buffer->max_lines) {
+            buffer->num_dropped_lines += 1;
+            return;
+        }
+        CbtDebugLineVertex* v = &buffer->vertices[2 * buffer->num_lines];
+        v[0].position[0] = from.x();
+        v[0].position[1] = from.y();
+        v[0].position[2] = from.z();
+        v[0].color = color0;
+        v[1].position[0] = to.x();
+        v[1].position[1] = to.y();
+        v[1].position[2] = to.z();
+        v[1].color = color1;
+        buffer->num_lines += 1;
+    }
+
     virtual void drawLine(const btVector3& from, const btVector3& to, const btVector3& color) override {
+        if (buffer) {
+            const unsigned int c = packDebugColor(color);
+            appendLine(from, to, c, c);
+            return;
+        }
         assert(drawer.drawLine1);
         const CbtVector3 p0 = { from.x(), from.y(), from.z() };
         const CbtVector3 p1 = { to.x(), to.y(), to.z() };
@@ -34,7 +573,9 @@ struct DebugDraw : public btIDebugDraw {
         const btVector3& color0,
         const btVector3& color1
     ) override {
-        if (drawer.drawLine2) {
+        if (buffer) {
+            appendLine(from, to, packDebugColor(color0), packDebugColor(color1));
+        } else if (drawer.drawLine2) {
             const CbtVector3 p0 = { from.x(), from.y(), from.z() };
             const CbtVector3 p1 = { to.x(), to.y(), to.z() };
             const CbtVector3 c0 = { color0.x(), color0.y(), color0.z() };
@@ -52,7 +593,11 @@ struct DebugDraw : public btIDebugDraw {
         int life_time,
         const btVector3& color
     ) override {
-        if (drawer.drawContactPoint) {
+        if (buffer) {
+            // Contact normal, 0.1 units long.
+            const unsigned int c = packDebugColor(color);
+            appendLine(point, point + normal * btScalar(0.1), c, c);
+        } else if (drawer.drawContactPoint) {
             const CbtVector3 p = { point.x(), point.y(), point.z() };
             const CbtVector3 n = { normal.x(), normal.y(), normal.z() };
             const CbtVector3 c = { color.x(), color.y(), color.z() };
@@ -73,6 +618,35 @@ struct DebugDraw : public btIDebugDraw {
     }
 };
 
+// Physics LOD state (see cbtWorldLodSetTiers). Per-object arrays are indexed by collision object world array index
+// and are (re)sized before the arena scope of a step is entered so that they always live in global memory.
+struct LodState {
+    int num_tiers = 1;
+    float tier_distances_sq[CBT_LOD_MAX_TIERS - 1] = {};
+    btAlignedObjectArray<btVector3> focus_points;
+    btHashMap<btHashPtr, int> body_max_tiers;
+    uint64_t step_index = 0;
+    float update_cost_us = 0.0f; // running average cost of one body update
+
+    btAlignedObjectArray<int> body_tiers; // -1 for objects not managed by LOD
+    btAlignedObjectArray<int> island_tiers;
+    btAlignedObjectArray<int> saved_states;
+    btAlignedObjectArray<btVector3> saved_forces; // force and torque of frozen bodies, two per object
+
+    CbtLodStats stats = {};
+};
+
+struct Trigger;
+
+// Trigger volumes (see cbtWorldTriggerCreate). Events are consumed from `first_event` so that draining does not move
+// the remaining events.
+struct TriggerState {
+    btAlignedObjectArray<Trigger*> list;
+    btAlignedObjectArray<CbtTriggerEvent> events;
+    int first_event = 0;
+    btGhostPairCallback* pair_callback = nullptr; // installed when the first trigger is created
+};
+
 struct WorldData {
     btDiscreteDynamicsWorld* world = nullptr;
     btDefaultCollisionConfiguration* collision_config = nullptr;
@@ -82,20 +656,27 @@ struct WorldData {
 
     btConstraintSolverPoolMt* solver_pool = nullptr;
     DebugDraw* debug = nullptr;
+    Arena* arena = nullptr;
+    LodState lod;
+    TriggerState triggers;
 };
 
 static btITaskScheduler* s_task_scheduler = nullptr;
+static ArenaTaskScheduler* s_arena_task_scheduler = nullptr;
 
 void cbtTaskSchedInit(void) {
     assert(s_task_scheduler == nullptr);
     s_task_scheduler = btCreateDefaultTaskScheduler();
-    btSetTaskScheduler(s_task_scheduler);
+    s_arena_task_scheduler = new ArenaTaskScheduler(s_task_scheduler);
+    btSetTaskScheduler(s_arena_task_scheduler);
 }
 
 void cbtTaskSchedDeinit(void) {
     assert(s_task_scheduler != nullptr);
     btSetTaskScheduler(nullptr);
+    delete s_arena_task_scheduler;
     delete s_task_scheduler;
+    s_arena_task_scheduler = nullptr;
     s_task_scheduler = nullptr;
 }
 
@@ -114,17 +695,34 @@ void cbtTaskSchedSetNumThreads(int num_threads) {
     s_task_scheduler->setNumThreads(num_threads);
 }
 
-CbtWorldHandle cbtWorldCreate(void) {
+static CbtWorldHandle createWorld(const CbtArenaDesc* arena_desc) {
+    // WorldData itself always comes from the global allocator because it owns the arena.
     auto world_data = (WorldData*)btAlignedAlloc(sizeof(WorldData), 16);
     new (world_data) WorldData();
 
-    world_data->collision_config = (btDefaultCollisionConfiguration*)btAlignedAlloc(
-        sizeof(btDefaultCollisionConfiguration),
-        16
-    );
-    world_data->broadphase = (btDbvtBroadphase*)btAlignedAlloc(sizeof(btDbvtBroadphase), 16);
+    btDefaultCollisionConstructionInfo collision_info;
+    if (arena_desc) {
+        world_data->arena = arenaCreate(arena_desc);
+        if (arena_desc->max_persistent_manifolds > 0) {
+            collision_info.m_defaultMaxPersistentManifoldPoolSize = arena_desc->max_persistent_manifolds;
+        }
+        if (arena_desc->max_collision_algorithms > 0) {
+            collision_info.m_defaultMaxCollisionAlgorithmPoolSize = arena_desc->max_collision_algorithms;
+        }
+    }
+
+    {
+        ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_COLLISION_POOLS);
+        world_data->collision_config = (btDefaultCollisionConfiguration*)btAlignedAlloc(
+            sizeof(btDefaultCollisionConfiguration),
+            16
+        );
+        new (world_data->collision_config) btDefaultCollisionConfiguration(collision_info);
+    }
+
+    ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_WORLD);
 
-    new (world_data->collision_config) btDefaultCollisionConfiguration();
+    world_data->broadphase = (btDbvtBroadphase*)btAlignedAlloc(sizeof(btDbvtBroadphase), 16);
     new (world_data->broadphase) btDbvtBroadphase();
 
     if (s_task_scheduler == nullptr) {
@@ -172,9 +770,25 @@ CbtWorldHandle cbtWorldCreate(void) {
     return (CbtWorldHandle)world_data;
 }
 
+CbtWorldHandle cbtWorldCreate(void) {
+    return createWorld(nullptr);
+}
+
+CbtWorldHandle cbtWorldCreateWithArena(const CbtArenaDesc* desc) {
+    assert(desc);
+    return createWorld(desc);
+}
+
 void cbtWorldDestroy(CbtWorldHandle world_handle) {
     assert(world_handle);
     auto world_data = (WorldData*)world_handle;
+    assert(world_data->triggers.list.size() == 0);
+
+    if (world_data->arena) {
+        // Destructors still run but blocks freed from now on are not returned individually - the whole arena is
+        // released at the end.
+        world_data->arena->releasing = true;
+    }
 
     world_data->dispatcher->~btCollisionDispatcher();
     world_data->collision_config->~btDefaultCollisionConfiguration();
@@ -197,10 +811,38 @@ void cbtWorldDestroy(CbtWorldHandle world_handle) {
         world_data->debug->~DebugDraw();
         btAlignedFree(world_data->debug);
     }
+    if (world_data->triggers.pair_callback) {
+        world_data->triggers.pair_callback->~btGhostPairCallback();
+        btAlignedFree(world_data->triggers.pair_callback);
+    }
+    // Event queue may have been grown while stepping - release it before the arena goes away.
+    world_data->triggers.events.clear();
+
+    if (world_data->arena) {
+        arenaDestroy(world_data->arena);
+    }
     world_data->~WorldData();
     btAlignedFree(world_data);
 }
 
+bool cbtWorldHasArena(CbtWorldHandle world_handle) {
+    assert(world_handle);
+    return ((WorldData*)world_handle)->arena != nullptr;
+}
+
+void cbtWorldGetArenaStats(CbtWorldHandle world_handle, CbtArenaStats* stats) {
+    assert(world_handle && stats);
+    auto arena = ((WorldData*)world_handle)->arena;
+    assert(arena != nullptr);
+
+    stats->bytes_reserved = arena->bytes_reserved.load(std::memory_order_relaxed);
+    for (int c = 0; c < CBT_ARENA_CATEGORY_COUNT; ++c) {
+        stats->bytes_in_use[c] = arena->bytes_in_use[c].load(std::memory_order_relaxed);
+        stats->num_live_allocs[c] = arena->num_live_allocs[c].load(std::memory_order_relaxed);
+        stats->num_total_allocs[c] = arena->num_total_allocs[c].load(std::memory_order_relaxed);
+    }
+}
+
 void cbtWorldSetGravity(CbtWorldHandle world_handle, const CbtVector3 gravity) {
     assert(world_handle && gravity);
     auto world = ((WorldData*)world_handle)->world;
@@ -216,132 +858,1312 @@ void cbtWorldGetGravity(CbtWorldHandle world_handle, CbtVector3 gravity) {
     gravity[2] = tmp.z();
 }
 
-int cbtWorldStepSimulation(CbtWorldHandle world_handle, float time_step, int max_sub_steps, float fixed_time_step) {
-    assert(world_handle);
-    auto world = ((WorldData*)world_handle)->world;
-    return world->stepSimulation(time_step, max_sub_steps, fixed_time_step);
-}
-
-void cbtWorldAddBody(CbtWorldHandle world_handle, CbtBodyHandle body_handle) {
-    assert(world_handle);
-    assert(body_handle && cbtBodyIsCreated(body_handle));
-    auto world = ((WorldData*)world_handle)->world;
-    auto body = (btRigidBody*)body_handle;
-    world->addRigidBody(body);
-}
-
-void cbtWorldAddConstraint(
-    CbtWorldHandle world_handle,
-    CbtConstraintHandle con_handle,
-    bool disable_collision_between_linked_bodies
-) {
-    assert(world_handle);
-    assert(con_handle && cbtConIsCreated(con_handle));
-    auto world = ((WorldData*)world_handle)->world;
-    auto con = (btTypedConstraint*)con_handle;
-    world->addConstraint(con, disable_collision_between_linked_bodies);
-}
+// Gives access to btDiscreteDynamicsWorld::internalSingleStepSimulation() which is protected.
+struct WorldInternals : public btDiscreteDynamicsWorld {
+    static void singleStep(btDiscreteDynamicsWorld* world, btScalar time_step) {
+        (world->*&WorldInternals::internalSingleStepSimulation)(time_step);
+    }
+};
 
-void cbtWorldRemoveBody(CbtWorldHandle world_handle, CbtBodyHandle body_handle) {
-    assert(world_handle);
-    assert(body_handle && cbtBodyIsCreated(body_handle));
-    auto world = ((WorldData*)world_handle)->world;
-    auto body = (btRigidBody*)body_handle;
-    world->removeRigidBody(body);
+static inline bool isLodManaged(const btCollisionObject* object) {
+    return btRigidBody::upcast(object) != nullptr && !object->isStaticOrKinematicObject() && object->isActive();
 }
 
-void cbtWorldRemoveConstraint(CbtWorldHandle world_handle, CbtConstraintHandle con_handle) {
-    assert(world_handle);
-    assert(con_handle && cbtConIsCreated(con_handle));
-    auto world = ((WorldData*)world_handle)->world;
-    auto con = (btTypedConstraint*)con_handle;
-    world->removeConstraint(con);
+static void setLodStates(WorldData* world_data, int tier, int state) {
+    LodState& lod = world_data->lod;
+    btCollisionObjectArray& objects = world_data->world->getCollisionObjectArray();
+    for (int i = 0; i < lod.body_tiers.size(); ++i) {
+        if (lod.body_tiers[i] == tier) {
+            lod.saved_states[i] = objects[i]->getActivationState();
+            objects[i]->forceActivationState(state);
+        }
+    }
 }
 
-int cbtWorldGetNumBodies(CbtWorldHandle world_handle) {
-    assert(world_handle);
-    auto world = ((WorldData*)world_handle)->world;
-    return (int)world->getCollisionObjectArray().size();
+static void restoreLodStates(WorldData* world_data, int tier) {
+    LodState& lod = world_data->lod;
+    btCollisionObjectArray& objects = world_data->world->getCollisionObjectArray();
+    for (int i = 0; i < lod.body_tiers.size(); ++i) {
+        if (lod.body_tiers[i] == tier) {
+            objects[i]->forceActivationState(lod.saved_states[i]);
+        }
+    }
 }
 
-int cbtWorldGetNumConstraints(CbtWorldHandle world_handle) {
-    assert(world_handle);
-    auto world = ((WorldData*)world_handle)->world;
-    return world->getNumConstraints();
+// Every world step clears forces, including the regular step that frozen tiers skip. Forces of frozen bodies are saved
+// before it and applied as impulses over that step afterwards, so a body gets the same impulse as at full rate no
+// matter in which step the force was applied.
+static void saveLodForces(WorldData* world_data) {
+    LodState& lod = world_data->lod;
+    btCollisionObjectArray& objects = world_data->world->getCollisionObjectArray();
+    for (int i = 0; i < lod.body_tiers.size(); ++i) {
+        if (lod.body_tiers[i] > 0) {
+            const btRigidBody* body = btRigidBody::upcast(objects[i]);
+            lod.saved_forces[2 * i] = body->getTotalForce();
+            lod.saved_forces[2 * i + 1] = body->getTotalTorque();
+        }
+    }
 }
 
-CbtBodyHandle cbtWorldGetBody(CbtWorldHandle world_handle, int body_index) {
-    assert(world_handle);
-    auto world = ((WorldData*)world_handle)->world;
-    return (CbtBodyHandle)world->getCollisionObjectArray()[body_index];
+static void applyLodForces(WorldData* world_data, float time_step) {
+    LodState& lod = world_data->lod;
+    btCollisionObjectArray& objects = world_data->world->getCollisionObjectArray();
+    for (int i = 0; i < lod.body_tiers.size(); ++i) {
+        if (lod.body_tiers[i] > 0) {
+            btRigidBody* body = btRigidBody::upcast(objects[i]);
+            body->applyCentralImpulse(lod.saved_forces[2 * i] * time_step);
+            body->applyTorqueImpulse(lod.saved_forces[2 * i + 1] * time_step);
+        }
+    }
 }
 
-CbtConstraintHandle cbtWorldGetConstraint(CbtWorldHandle world_handle, int con_index) {
-    assert(world_handle);
-    auto world = ((WorldData*)world_handle)->world;
-    return (CbtConstraintHandle)world->getConstraint(con_index);
-}
+// Assigns tiers to active dynamic bodies. Bodies in one simulation island (island tags come from the previous step)
+// share the lowest tier found in the island so that interacting bodies are always updated together.
+static void assignLodTiers(WorldData* world_data) {
+    LodState& lod = world_data->lod;
+    btCollisionObjectArray& objects = world_data->world->getCollisionObjectArray();
+    const int num_objects = objects.size();
 
-bool cbtWorldRayTestClosest(
-    CbtWorldHandle world_handle,
-    const CbtVector3 ray_from_world,
-    const CbtVector3 ray_to_world,
-    int collision_filter_group,
-    int collision_filter_mask,
-    unsigned int flags,
-    CbtRayCastResult* result
-) {
-    assert(world_handle);
-    auto world = ((WorldData*)world_handle)->world;
+    for (int t = 0; t < CBT_LOD_MAX_TIERS; ++t) {
+        lod.stats.num_bodies_per_tier[t] = 0;
+    }
+    for (int i = 0; i < num_objects; ++i) {
+        lod.island_tiers[i] = CBT_LOD_MAX_TIERS;
+    }
 
-    const btVector3 from(ray_from_world[0], ray_from_world[1], ray_from_world[2]);
-    const btVector3 to(ray_to_world[0], ray_to_world[1], ray_to_world[2]);
+    for (int i = 0; i < num_objects; ++i) {
+        const btCollisionObject* object = objects[i];
+        if (!isLodManaged(object)) {
+            lod.body_tiers[i] = -1;
+            continue;
+        }
 
-    btCollisionWorld::ClosestRayResultCallback closest(from, to);
-    closest.m_collisionFilterGroup = collision_filter_group;
-    closest.m_collisionFilterMask = collision_filter_mask;
-    closest.m_flags = flags;
+        int tier = 0;
+        if (lod.focus_points.size() > 0) {
+            const btVector3& position = object->getWorldTransform().getOrigin();
+            btScalar min_distance_sq = BT_LARGE_FLOAT;
+            for (int p = 0; p < lod.focus_points.size(); ++p) {
+                min_distance_sq = btMin(min_distance_sq, position.distance2(lod.focus_points[p]));
+            }
+            while (tier < lod.num_tiers - 1 && min_distance_sq >= lod.tier_distances_sq[tier]) {
+                tier += 1;
+            }
+        }
+        if (lod.body_max_tiers.size() > 0) {
+            const int* max_tier = lod.body_max_tiers.find(object);
+            if (max_tier) {
+                tier = btMin(tier, *max_tier);
+            }
+        }
+        lod.body_tiers[i] = tier;
 
-    world->rayTest(from, to, closest);
+        const int island = object->getIslandTag();
+        if (island >= 0 && island < num_objects) {
+            lod.island_tiers[island] = btMin(lod.island_tiers[island], tier);
+        }
+    }
 
-    if (result) {
-        result->hit_normal_world[0] = closest.m_hitNormalWorld.x();
-        result->hit_normal_world[1] = closest.m_hitNormalWorld.y();
-        result->hit_normal_world[2] = closest.m_hitNormalWorld.z();
-        result->hit_point_world[0] = closest.m_hitPointWorld.x();
-        result->hit_point_world[1] = closest.m_hitPointWorld.y();
-        result->hit_point_world[2] = closest.m_hitPointWorld.z();
-        result->hit_fraction = closest.m_closestHitFraction;
-        result->body = (CbtBodyHandle)closest.m_collisionObject;
+    for (int i = 0; i < num_objects; ++i) {
+        if (lod.body_tiers[i] < 0) continue;
+        const int island = objects[i]->getIslandTag();
+        if (island >= 0 && island < num_objects) {
+            lod.body_tiers[i] = lod.island_tiers[island];
+        }
+        lod.stats.num_bodies_per_tier[lod.body_tiers[i]] += 1;
     }
-    return closest.m_collisionObject != 0;
 }
 
-void cbtWorldDebugSetDrawer(CbtWorldHandle world_handle, const CbtDebugDraw* drawer) {
-    assert(world_handle && drawer);
-    auto world_data = (WorldData*)world_handle;
+// Tier 0 is simulated normally. Tier t > 0 is frozen (DISABLE_SIMULATION) during the regular step and is simulated on
+// steps where `step_index % 2^t == 2^(t-1)` in an extra single step with a 2^t times larger time step (and everything
+// else frozen). Different tiers never update on the same step which keeps the per-step cost flat.
+static int stepSimulationLod(WorldData* world_data, float time_step, int max_sub_steps, float fixed_time_step) {
+    LodState& lod = world_data->lod;
+    btDiscreteDynamicsWorld* world = world_data->world;
 
+    assignLodTiers(world_data);
+
+    int due_tier = 0;
+    for (int t = 1; t < lod.num_tiers; ++t) {
+        if ((lod.step_index & ((1ull << t) - 1)) == (1ull << (t - 1))) {
+            due_tier = t;
+            break;
+        }
+    }
+
+    unsigned int num_lod_bodies = 0;
+    for (int t = 1; t < lod.num_tiers; ++t) {
+        setLodStates(world_data, t, DISABLE_SIMULATION);
+        num_lod_bodies += lod.stats.num_bodies_per_tier[t];
+    }
+
+    btClock clock;
+    if (num_lod_bodies > 0) {
+        saveLodForces(world_data);
+    }
+    const int num_sub_steps = world->stepSimulation(time_step, max_sub_steps, fixed_time_step);
+
+    unsigned int num_updates = 0;
+    int updated_tier = 0;
+    if (num_sub_steps > 0) {
+        num_updates += lod.stats.num_bodies_per_tier[0];
+
+        const float main_time_step = max_sub_steps > 0 ? num_sub_steps * fixed_time_step : time_step;
+        if (num_lod_bodies > 0) {
+            applyLodForces(world_data, main_time_step);
+        }
+
+        if (due_tier > 0 && lod.stats.num_bodies_per_tier[due_tier] > 0) {
+            setLodStates(world_data, 0, DISABLE_SIMULATION);
+            restoreLodStates(world_data, due_tier);
+
+            world->applyGravity();
+            WorldInternals::singleStep(world, main_time_step * (float)(1 << due_tier));
+            world->synchronizeMotionStates();
+            world->clearForces();
+
+            restoreLodStates(world_data, 0);
+            num_updates += lod.stats.num_bodies_per_tier[due_tier];
+            updated_tier = due_tier;
+        }
+        lod.step_index += 1;
+    }
+    for (int t = 1; t < lod.num_tiers; ++t) {
+        // Updated tier keeps the activation state it got in its own step.
+        if (t != updated_tier) {
+            restoreLodStates(world_data, t);
+        }
+    }
+
+    const float step_time_us = (float)clock.getTimeMicroseconds();
+    if (num_updates > 0) {
+        const float cost = step_time_us / (float)num_updates;
+        lod.update_cost_us = lod.update_cost_us == 0.0f ? cost : lod.update_cost_us * 0.9f + cost * 0.1f;
+    }
+
+    const unsigned int num_skipped =
+        num_sub_steps > 0 ? lod.stats.num_bodies_per_tier[0] + num_lod_bodies - num_updates : 0;
+    lod.stats.num_body_updates = num_updates;
+    lod.stats.num_body_updates_skipped = num_skipped;
+    lod.stats.step_time_ms = step_time_us * 0.001f;
+    lod.stats.time_saved_ms = num_skipped * lod.update_cost_us * 0.001f;
+    lod.stats.total_time_saved_ms += lod.stats.time_saved_ms;
+
+    return num_sub_steps;
+}
+
+static void removeStaleTriggerPairs(WorldData* world_data);
+
+int cbtWorldStepSimulation(CbtWorldHandle world_handle, float time_step, int max_sub_steps, float fixed_time_step) {
+    assert(world_handle);
+    auto world_data = (WorldData*)world_handle;
+
+    if (world_data->lod.num_tiers > 1) {
+        LodState& lod = world_data->lod;
+        const int num_objects = world_data->world->getCollisionObjectArray().size();
+        lod.body_tiers.resize(num_objects);
+        lod.island_tiers.resize(num_objects);
+        lod.saved_states.resize(num_objects);
+        lod.saved_forces.resize(2 * num_objects);
+    }
+
+    ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_SIMULATION);
+
+    const int num_sub_steps = world_data->lod.num_tiers > 1 ?
+        stepSimulationLod(world_data, time_step, max_sub_steps, fixed_time_step) :
+        world_data->world->stepSimulation(time_step, max_sub_steps, fixed_time_step);
+
+    if (num_sub_steps > 0 && world_data->triggers.list.size() > 0) {
+        removeStaleTriggerPairs(world_data);
+    }
+    return num_sub_steps;
+}
+
+void cbtWorldLodSetTiers(CbtWorldHandle world_handle, const float* tier_distances, int num_tiers) {
+    assert(world_handle);
+    assert(num_tiers >= 1 && num_tiers <= CBT_LOD_MAX_TIERS);
+    assert(num_tiers == 1 || tier_distances);
+    LodState& lod = ((WorldData*)world_handle)->lod;
+
+    for (int t = 0; t < num_tiers - 1; ++t) {
+        assert(tier_distances[t] >= 0.0f && (t == 0 || tier_distances[t] >= tier_distances[t - 1]));
+        lod.tier_distances_sq[t] = tier_distances[t] * tier_distances[t];
+    }
+    lod.num_tiers = num_tiers;
+    lod.step_index = 0;
+    lod.stats = {};
+}
+
+int cbtWorldLodGetNumTiers(CbtWorldHandle world_handle) {
+    assert(world_handle);
+    return ((WorldData*)world_handle)->lod.num_tiers;
+}
+
+void cbtWorldLodSetFocusPoints(CbtWorldHandle world_handle, const CbtVector3* points, int num_points) {
+    assert(world_handle);
+    assert(num_points >= 0 && (num_points == 0 || points));
+    LodState& lod = ((WorldData*)world_handle)->lod;
+
+    lod.focus_points.resize(num_points);
+    for (int i = 0; i < num_points; ++i) {
+        lod.focus_points[i].setValue(points[i][0], points[i][1], points[i][2]);
+    }
+}
+
+void cbtWorldLodSetBodyMaxTier(CbtWorldHandle world_handle, CbtBodyHandle body_handle, int max_tier) {
+    assert(world_handle);
+    assert(body_handle && cbtBodyIsCreated(body_handle));
+    assert(max_tier >= 0);
+    LodState& lod = ((WorldData*)world_handle)->lod;
+
+    if (max_tier >= CBT_LOD_MAX_TIERS - 1) {
+        lod.body_max_tiers.remove((const void*)body_handle);
+    } else {
+        lod.body_max_tiers.insert((const void*)body_handle, max_tier);
+    }
+}
+
+int cbtWorldLodGetBodyTier(CbtWorldHandle world_handle, CbtBodyHandle body_handle) {
+    assert(world_handle);
+    assert(body_handle && cbtBodyIsCreated(body_handle));
+    auto world_data = (WorldData*)world_handle;
+    auto body = (btRigidBody*)body_handle;
+
+    const int index = body->getWorldArrayIndex();
+    if (world_data->lod.num_tiers == 1 || index < 0 || index >= world_data->lod.body_tiers.size()) {
+        return 0;
+    }
+    if (world_data->world->getCollisionObjectArray()[index] != body) {
+        return 0;
+    }
+    return btMax(world_data->lod.body_tiers[index], 0);
+}
+
+void cbtWorldLodGetStats(CbtWorldHandle world_handle, CbtLodStats* stats) {
+    assert(world_handle && stats);
+    *stats = ((WorldData*)world_handle)->lod.stats;
+}
+
+void cbtWorldAddBody(CbtWorldHandle world_handle, CbtBodyHandle body_handle) {
+    assert(world_handle);
+    assert(body_handle && cbtBodyIsCreated(body_handle));
+    auto world_data = (WorldData*)world_handle;
+    auto body = (btRigidBody*)body_handle;
+    ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_OBJECTS);
+    world_data->world->addRigidBody(body);
+}
+
+void cbtWorldAddConstraint(
+    CbtWorldHandle world_handle,
+    CbtConstraintHandle con_handle,
+    bool disable_collision_between_linked_bodies
+) {
+    assert(world_handle);
+    assert(con_handle && cbtConIsCreated(con_handle));
+    auto world = ((WorldData*)world_handle)->world;
+    auto con = (btTypedConstraint*)con_handle;
+    // NOTE: No arena scope here - btRigidBody::addConstraintRef() grows an array owned by the body and bodies may
+    // outlive the world.
+    world->addConstraint(con, disable_collision_between_linked_bodies);
+}
+
+void cbtWorldRemoveBody(CbtWorldHandle world_handle, CbtBodyHandle body_handle) {
+    assert(world_handle);
+    assert(body_handle && cbtBodyIsCreated(body_handle));
+    auto world_data = (WorldData*)world_handle;
+    auto body = (btRigidBody*)body_handle;
+    if (world_data->lod.body_max_tiers.size() > 0) {
+        world_data->lod.body_max_tiers.remove((const void*)body);
+    }
+    ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_OBJECTS);
+    world_data->world->removeRigidBody(body);
+}
+
+void cbtWorldRemoveConstraint(CbtWorldHandle world_handle, CbtConstraintHandle con_handle) {
+    assert(world_handle);
+    assert(con_handle && cbtConIsCreated(con_handle));
+    auto world = ((WorldData*)world_handle)->world;
+    auto con = (btTypedConstraint*)con_handle;
+    world->removeConstraint(con);
+}
+
+int cbtWorldGetNumBodies(CbtWorldHandle world_handle) {
+    assert(world_handle);
+    auto world_data = (WorldData*)world_handle;
+    return world_data->world->getCollisionObjectArray().size() - world_data->triggers.list.size();
+}
+
+int cbtWorldGetNumConstraints(CbtWorldHandle world_handle) {
+    assert(world_handle);
+    auto world = ((WorldData*)world_handle)->world;
+    return world->getNumConstraints();
+}
+
+CbtBodyHandle cbtWorldGetBody(CbtWorldHandle world_handle, int body_index) {
+    assert(world_handle);
+    assert(body_index >= 0 && body_index < cbtWorldGetNumBodies(world_handle));
+    auto world_data = (WorldData*)world_handle;
+    // Triggers occupy the front of the collision object array (see cbtWorldTriggerCreate).
+    return (CbtBodyHandle)world_data->world->getCollisionObjectArray()[world_data->triggers.list.size() + body_index];
+}
+
+CbtConstraintHandle cbtWorldGetConstraint(CbtWorldHandle world_handle, int con_index) {
+    assert(world_handle);
+    auto world = ((WorldData*)world_handle)->world;
+    return (CbtConstraintHandle)world->getConstraint(con_index);
+}
+
+bool cbtWorldRayTestClosest(
+    CbtWorldHandle world_handle,
+    const CbtVector3 ray_from_world,
+    const CbtVector3 ray_to_world,
+    int collision_filter_group,
+    int collision_filter_mask,
+    unsigned int flags,
+    CbtRayCastResult* result
+) {
+    assert(world_handle);
+    auto world_data = (WorldData*)world_handle;
+    auto world = world_data->world;
+    ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_SIMULATION);
+
+    const btVector3 from(ray_from_world[0], ray_from_world[1], ray_from_world[2]);
+    const btVector3 to(ray_to_world[0], ray_to_world[1], ray_to_world[2]);
+
+    btCollisionWorld::ClosestRayResultCallback closest(from, to);
+    closest.m_collisionFilterGroup = collision_filter_group;
+    closest.m_collisionFilterMask = collision_filter_mask;
+    closest.m_flags = flags;
+
+    world->rayTest(from, to, closest);
+
+    if (result) {
+        result->hit_normal_world[0] = closest.m_hitNormalWorld.x();
+        result->hit_normal_world[1] = closest.m_hitNormalWorld.y();
+        result->hit_normal_world[2] = closest.m_hitNormalWorld.z();
+        result->hit_point_world[0] = closest.m_hitPointWorld.x();
+        result->hit_point_world[1] = closest.m_hitPointWorld.y();
+        result->hit_point_world[2] = closest.m_hitPointWorld.z();
+        result->hit_fraction = closest.m_closestHitFraction;
+        result->body = (CbtBodyHandle)closest.m_collisionObject;
+    }
+    return closest.m_collisionObject != 0;
+}
+
+//
+// Trigger
+//
+// Overlap sets are kept by btPairCachingGhostObject: btGhostPairCallback installed on the broadphase pair cache
+// forwards every pair added or removed by the broadphase to the trigger, which records a change as an event.
+// btDbvtBroadphase drops pairs whose AABBs stopped overlapping incrementally (a small fraction of all pairs per step)
+// so after each step trigger pairs are tested the same way but immediately, which keeps leave events in time.
+//
+static void pushTriggerEvent(Trigger* trigger, btCollisionObject* body, int type);
+
+struct Trigger : public btPairCachingGhostObject {
+    WorldData* world_data = nullptr;
+    int index = 0; // in TriggerState::list
+    bool removing = false; // no events while the trigger is being destroyed
+
+    void addOverlappingObjectInternal(btBroadphaseProxy* other_proxy, btBroadphaseProxy* this_proxy) override {
+        auto other = (btCollisionObject*)other_proxy->m_clientObject;
+        if (btRigidBody::upcast(other) == nullptr) {
+            return;
+        }
+        const int num_overlaps = m_overlappingObjects.size();
+        btPairCachingGhostObject::addOverlappingObjectInternal(other_proxy, this_proxy);
+        if (!removing && m_overlappingObjects.size() != num_overlaps) {
+            pushTriggerEvent(this, other, CBT_TRIGGER_EVENT_ENTER);
+        }
+    }
+
+    void removeOverlappingObjectInternal(
+        btBroadphaseProxy* other_proxy,
+        btDispatcher* dispatcher,
+        btBroadphaseProxy* this_proxy
+    ) override {
+        const int num_overlaps = m_overlappingObjects.size();
+        btPairCachingGhostObject::removeOverlappingObjectInternal(other_proxy, dispatcher, this_proxy);
+        if (!removing && m_overlappingObjects.size() != num_overlaps) {
+            pushTriggerEvent(this, (btCollisionObject*)other_proxy->m_clientObject, CBT_TRIGGER_EVENT_LEAVE);
+        }
+    }
+};
+
+static void pushTriggerEvent(Trigger* trigger, btCollisionObject* body, int type) {
+    CbtTriggerEvent event;
+    event.trigger = (CbtTriggerHandle)trigger;
+    event.body = (CbtBodyHandle)body;
+    event.type = type;
+    trigger->world_data->triggers.events.push_back(event);
+}
+
+static void swapCollisionObjects(btCollisionObjectArray& objects, int a, int b) {
+    if (a != b) {
+        objects.swap(a, b);
+        objects[a]->setWorldArrayIndex(a);
+        objects[b]->setWorldArrayIndex(b);
+    }
+}
+
+// Trigger pairs only drive btGhostPairCallback - they never need collision algorithms or contact points.
+static void nearCallbackSkipTriggers(
+    btBroadphasePair& pair,
+    btCollisionDispatcher& dispatcher,
+    const btDispatcherInfo& dispatch_info
+) {
+    auto object0 = (const btCollisionObject*)pair.m_pProxy0->m_clientObject;
+    auto object1 = (const btCollisionObject*)pair.m_pProxy1->m_clientObject;
+    if (object0->getInternalType() == btCollisionObject::CO_GHOST_OBJECT ||
+        object1->getInternalType() == btCollisionObject::CO_GHOST_OBJECT) {
+        return;
+    }
+    btCollisionDispatcher::defaultNearCallback(pair, dispatcher, dispatch_info);
+}
+
+static void removeStaleTriggerPairs(WorldData* world_data) {
+    btOverlappingPairCache* pair_cache = world_data->broadphase->getOverlappingPairCache();
+
+    for (int t = 0; t < world_data->triggers.list.size(); ++t) {
+        Trigger* trigger = world_data->triggers.list[t];
+        auto proxy = (btDbvtProxy*)trigger->getBroadphaseHandle();
+        btAlignedObjectArray<btCollisionObject*>& overlaps = trigger->getOverlappingPairs();
+
+        // Removing a pair swaps the last overlap into its slot - iterate backwards.
+        for (int i = overlaps.size() - 1; i >= 0; --i) {
+            auto other_proxy = (btDbvtProxy*)overlaps[i]->getBroadphaseHandle();
+            if (!Intersect(proxy->leaf->volume, other_proxy->leaf->volume)) {
+                pair_cache->removeOverlappingPair(proxy, other_proxy, world_data->dispatcher);
+            }
+        }
+    }
+}
+
+static inline btTransform makeBtTransform(const CbtVector3 transform[4]);
+
+CbtTriggerHandle cbtWorldTriggerCreate(
+    CbtWorldHandle world_handle,
+    CbtShapeHandle shape_handle,
+    const CbtVector3 transform[4],
+    int collision_mask
+) {
+    assert(world_handle);
+    assert(shape_handle && cbtShapeIsCreated(shape_handle));
+    assert(transform);
+    auto world_data = (WorldData*)world_handle;
+    TriggerState& triggers = world_data->triggers;
+
+    if (triggers.pair_callback == nullptr) {
+        triggers.pair_callback = (btGhostPairCallback*)btAlignedAlloc(sizeof(btGhostPairCallback), 16);
+        new (triggers.pair_callback) btGhostPairCallback();
+        world_data->broadphase->getOverlappingPairCache()->setInternalGhostPairCallback(triggers.pair_callback);
+        world_data->dispatcher->setNearCallback(nearCallbackSkipTriggers);
+    }
+
+    auto trigger = (Trigger*)btAlignedAlloc(sizeof(Trigger), 16);
+    new (trigger) Trigger();
+    trigger->world_data = world_data;
+    trigger->index = triggers.list.size();
+    trigger->setCollisionShape((btCollisionShape*)shape_handle);
+    trigger->setWorldTransform(makeBtTransform(transform));
+    trigger->setCollisionFlags(trigger->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
+    triggers.list.push_back(trigger);
+
+    ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_OBJECTS);
+    world_data->world->addCollisionObject(
+        trigger,
+        CBT_COLLISION_FILTER_SENSOR_TRIGGER,
+        collision_mask & ~CBT_COLLISION_FILTER_SENSOR_TRIGGER
+    );
+    // Triggers are kept in front of the bodies so that cbtWorldGetBody can index bodies directly. Removing a body
+    // swaps the last object into its place, which is never a trigger.
+    swapCollisionObjects(world_data->world->getCollisionObjectArray(), trigger->getWorldArrayIndex(), trigger->index);
+    return (CbtTriggerHandle)trigger;
+}
+
+void cbtWorldTriggerDestroy(CbtWorldHandle world_handle, CbtTriggerHandle trigger_handle) {
+    assert(world_handle && trigger_handle);
+    auto world_data = (WorldData*)world_handle;
+    auto trigger = (Trigger*)trigger_handle;
+    assert(trigger->world_data == world_data);
+    TriggerState& triggers = world_data->triggers;
+
+    trigger->removing = true;
+    {
+        // Last trigger slot becomes the first body slot once the trigger is swapped out by removeCollisionObject.
+        swapCollisionObjects(
+            world_data->world->getCollisionObjectArray(),
+            trigger->getWorldArrayIndex(),
+            triggers.list.size() - 1
+        );
+        ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_OBJECTS);
+        world_data->world->removeCollisionObject(trigger);
+    }
+
+    int num_events = triggers.first_event;
+    for (int i = triggers.first_event; i < triggers.events.size(); ++i) {
+        if (triggers.events[i].trigger != trigger_handle) {
+            triggers.events[num_events++] = triggers.events[i];
+        }
+    }
+    triggers.events.resize(num_events);
+
+    Trigger* last = triggers.list[triggers.list.size() - 1];
+    triggers.list[trigger->index] = last;
+    last->index = trigger->index;
+    triggers.list.pop_back();
+
+    trigger->~Trigger();
+    btAlignedFree(trigger);
+}
+
+int cbtWorldTriggerGetNumEvents(CbtWorldHandle world_handle) {
+    assert(world_handle);
+    const TriggerState& triggers = ((WorldData*)world_handle)->triggers;
+    return triggers.events.size() - triggers.first_event;
+}
+
+int cbtWorldTriggerDrainEvents(CbtWorldHandle world_handle, CbtTriggerEvent* events, int max_events) {
+    assert(world_handle);
+    assert(max_events >= 0 && (max_events == 0 || events));
+    TriggerState& triggers = ((WorldData*)world_handle)->triggers;
+
+    const int num_events = btMin(max_events, triggers.events.size() - triggers.first_event);
+    if (num_events > 0) {
+        memcpy(events, &triggers.events[triggers.first_event], num_events * sizeof(CbtTriggerEvent));
+        triggers.first_event += num_events;
+    }
+    if (triggers.first_event == triggers.events.size()) {
+        // Keeps capacity.
+        triggers.events.resize(0);
+        triggers.first_event = 0;
+    }
+    return num_events;
+}
+
+void cbtTriggerSetTransform(CbtTriggerHandle trigger_handle, const CbtVector3 transform[4]) {
+    assert(trigger_handle && transform);
+    auto trigger = (Trigger*)trigger_handle;
+    trigger->setWorldTransform(makeBtTransform(transform));
+
+    ArenaScope scope(trigger->world_data->arena, CBT_ARENA_CATEGORY_OBJECTS);
+    trigger->world_data->world->updateSingleAabb(trigger);
+}
+
+void cbtTriggerGetTransform(CbtTriggerHandle trigger_handle, CbtVector3 transform[4]) {
+    assert(trigger_handle && transform);
+    auto trigger = (Trigger*)trigger_handle;
+
+    const btTransform& trans = trigger->getWorldTransform();
+    const btMatrix3x3& basis = trans.getBasis();
+    const btVector3& origin = trans.getOrigin();
+
+    // Transposed, see makeBtTransform().
+    for (int r = 0; r < 3; ++r) {
+        transform[0][r] = basis.getRow(r).x();
+        transform[1][r] = basis.getRow(r).y();
+        transform[2][r] = basis.getRow(r).z();
+    }
+    transform[3][0] = origin.x();
+    transform[3][1] = origin.y();
+    transform[3][2] = origin.z();
+}
+
+void cbtTriggerSetUserPointer(CbtTriggerHandle trigger_handle, void* user_pointer) {
+    assert(trigger_handle);
+    ((Trigger*)trigger_handle)->setUserPointer(user_pointer);
+}
+
+void* cbtTriggerGetUserPointer(CbtTriggerHandle trigger_handle) {
+    assert(trigger_handle);
+    return ((Trigger*)trigger_handle)->getUserPointer();
+}
+
+int cbtTriggerGetNumOverlaps(CbtTriggerHandle trigger_handle) {
+    assert(trigger_handle);
+    return ((Trigger*)trigger_handle)->getNumOverlappingObjects();
+}
+
+CbtBodyHandle cbtTriggerGetOverlap(CbtTriggerHandle trigger_handle, int index) {
+    assert(trigger_handle);
+    auto trigger = (Trigger*)trigger_handle;
+    assert(index >= 0 && index < trigger->getNumOverlappingObjects());
+    return (CbtBodyHandle)trigger->getOverlappingObject(index);
+}
+
+//
+// World serialization
+//
+// cbtWorldSave writes btDefaultSerializer output: 12 byte header followed by chunks (btChunk + data). Pointer fields
+// in chunk data hold unique ids of other chunks. cbtWorldLoad copies chunk data to one aligned scratch buffer, replaces
+// ids with addresses in the structures it understands and lets btCollisionWorldImporter create shapes from them
+// (serialized BVHs are copied, not rebuilt). Rigid bodies are created directly in cbtBodyAllocateBatch() layout.
+// The blob is untrusted: structure sizes, element counts, indices and links are checked against the chunks they point
+// into before btCollisionWorldImporter sees them, and any failure rejects the whole blob.
+//
+// Chunk data copied to the scratch buffer. `claimed` marks arrays that hold pointers to other chunks (mesh parts and
+// compound children) once they are resolved, so no array is resolved twice.
+struct LoadedChunk {
+    int code;
+    void* data;
+    size_t size;
+    bool claimed;
+};
+
+typedef btHashMap<btHashPtr, LoadedChunk> ChunkMap;
+
+// btCollisionWorldImporter converts compound children recursively.
+static const int k_max_compound_depth = 16;
+
+struct WorldImporter : public btCollisionWorldImporter {
+    WorldImporter() : btCollisionWorldImporter(nullptr) {}
+
+    btCollisionShape* findShape(const void* shape_data) {
+        btCollisionShape** shape = m_shapeMap.find(shape_data);
+        return shape ? *shape : nullptr;
+    }
+};
+
+struct WorldImport {
+    WorldData* world_data = nullptr;
+    WorldImporter importer;
+    btAlignedObjectArray<CbtBodyHandle> bodies; // all handles come from a single cbtBodyAllocateBatch()
+};
+
+// All resolve*() functions below return false when the blob is invalid, cbtWorldLoad then rejects the whole blob.
+
+// Replaces chunk id `ptr` with the address of a `code` chunk that holds at least `count` elements. NULL is valid only
+// when `count` is 0.
+template<typename T>
+static bool resolveArray(ChunkMap& chunks, T*& ptr, int64_t count, int code = BT_ARRAY_CODE, bool claim = false) {
+    if (count < 0) {
+        return false;
+    }
+    if (ptr == nullptr) {
+        return count == 0;
+    }
+    LoadedChunk* chunk = chunks.find(btHashPtr(ptr));
+    if (chunk == nullptr || chunk->code != code || chunk->size / sizeof(T) < (uint64_t)count) {
+        return false;
+    }
+    if (claim) {
+        if (chunk->claimed) {
+            return false;
+        }
+        chunk->claimed = true;
+    }
+    ptr = (T*)chunk->data;
+    return true;
+}
+
+// Same as resolveArray() but NULL is always valid (optional objects and alternative float/double arrays).
+template<typename T>
+static bool resolveOptionalArray(ChunkMap& chunks, T*& ptr, int64_t count, int code = BT_ARRAY_CODE) {
+    return ptr == nullptr || resolveArray(chunks, ptr, count, code);
+}
+
+static bool resolveName(ChunkMap& chunks, char*& name) {
+    if (name == nullptr) {
+        return true;
+    }
+    const LoadedChunk* chunk = chunks.find(btHashPtr(name));
+    if (chunk == nullptr || chunk->code != BT_ARRAY_CODE || memchr(chunk->data, 0, chunk->size) == nullptr) {
+        return false;
+    }
+    name = (char*)chunk->data;
+    return true;
+}
+
+static bool resolveMeshInterface(ChunkMap& chunks, btStridingMeshInterfaceData* mesh) {
+    if (!resolveArray(chunks, mesh->m_meshPartsPtr, mesh->m_numMeshParts, BT_ARRAY_CODE, true)) {
+        return false;
+    }
+    for (int i = 0; i < mesh->m_numMeshParts; ++i) {
+        btMeshPartData* part = &mesh->m_meshPartsPtr[i];
+        const int num_vertices = part->m_numVertices;
+        const int64_t num_triangles = part->m_numTriangles;
+        if (num_vertices < 0 || num_triangles < 0 || num_triangles > INT_MAX / 3) {
+            return false;
+        }
+        if (!resolveOptionalArray(chunks, part->m_vertices3f, num_vertices) ||
+            !resolveOptionalArray(chunks, part->m_vertices3d, num_vertices) ||
+            !resolveOptionalArray(chunks, part->m_indices32, 3 * num_triangles) ||
+            !resolveOptionalArray(chunks, part->m_indices16, 3 * num_triangles) ||
+            !resolveOptionalArray(chunks, part->m_3indices16, num_triangles) ||
+            !resolveOptionalArray(chunks, part->m_3indices8, num_triangles)) {
+            return false;
+        }
+        // btCollisionWorldImporter leaves out parts without vertices or indices, which would shift BVH part indices.
+        if ((part->m_vertices3f == nullptr && part->m_vertices3d == nullptr) ||
+            (part->m_indices32 == nullptr && part->m_indices16 == nullptr &&
+                part->m_3indices16 == nullptr && part->m_3indices8 == nullptr)) {
+            return false;
+        }
+        for (int64_t j = 0; j < 3 * num_triangles; ++j) {
+            if ((part->m_indices32 && (unsigned int)part->m_indices32[j].m_value >= (unsigned int)num_vertices) ||
+                (part->m_indices16 && (unsigned short)part->m_indices16[j].m_value >= num_vertices) ||
+                (part->m_3indices16 && (unsigned short)part->m_3indices16[j / 3].m_values[j % 3] >= num_vertices) ||
+                (part->m_3indices8 && part->m_3indices8[j / 3].m_values[j % 3] >= num_vertices)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Checks that every internal node spans exactly its two child subtrees, so stackless and recursive walks stay within
+// the first `num_nodes` nodes. `subtree_size(i)` is 1 for leaves, the escape index for internal nodes and 0 for
+// invalid nodes.
+template<typename SubtreeSize>
+static bool isValidBvhTree(int num_nodes, SubtreeSize subtree_size) {
+    for (int i = 0; i < num_nodes; ++i) {
+        const int64_t end = i + subtree_size(i);
+        if (end <= i || end > num_nodes) {
+            return false;
+        }
+        if (end - i > 1) {
+            const int64_t right = i + 1 + subtree_size(i + 1);
+            if (right <= i + 1 || right >= end || right + subtree_size((int)right) != end) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool resolveBvh(ChunkMap& chunks, btQuantizedBvhFloatData* bvh) {
+    if (!resolveArray(chunks, bvh->m_contiguousNodesPtr, bvh->m_numContiguousLeafNodes) ||
+        !resolveArray(chunks, bvh->m_quantizedContiguousNodesPtr, bvh->m_numQuantizedContiguousNodes) ||
+        !resolveArray(chunks, bvh->m_subTreeInfoPtr, bvh->m_numSubtreeHeaders)) {
+        return false;
+    }
+    // Only the first m_curNodeIndex nodes are used.
+    const int num_nodes = bvh->m_curNodeIndex;
+    if (num_nodes < 1 ||
+        num_nodes > (bvh->m_useQuantization ? bvh->m_numQuantizedContiguousNodes : bvh->m_numContiguousLeafNodes)) {
+        return false;
+    }
+    for (int i = 0; i < bvh->m_numSubtreeHeaders; ++i) {
+        const btBvhSubtreeInfoData& subtree = bvh->m_subTreeInfoPtr[i];
+        if (subtree.m_rootNodeIndex < 0 || subtree.m_subtreeSize < 0 ||
+            (int64_t)subtree.m_rootNodeIndex + subtree.m_subtreeSize > num_nodes) {
+            return false;
+        }
+    }
+    if (bvh->m_useQuantization) {
+        const btQuantizedBvhNodeData* nodes = bvh->m_quantizedContiguousNodesPtr;
+        return isValidBvhTree(num_nodes, [nodes](int i) -> int64_t {
+            const int x = nodes[i].m_escapeIndexOrTriangleIndex;
+            return x >= 0 ? 1 : (x < -2 ? -(int64_t)x : 0);
+        });
+    }
+    const btOptimizedBvhNodeFloatData* nodes = bvh->m_contiguousNodesPtr;
+    return isValidBvhTree(num_nodes, [nodes](int i) -> int64_t {
+        const int x = nodes[i].m_escapeIndex;
+        return x == -1 ? 1 : (x > 2 ? x : 0);
+    });
+}
+
+// Leaf nodes must index triangles of the mesh the BVH is used with.
+static bool isValidBvhForMesh(const btQuantizedBvhFloatData* bvh, const btStridingMeshInterfaceData* mesh) {
+    for (int i = 0; i < bvh->m_curNodeIndex; ++i) {
+        int part, triangle;
+        if (bvh->m_useQuantization) {
+            const int x = bvh->m_quantizedContiguousNodesPtr[i].m_escapeIndexOrTriangleIndex;
+            if (x < 0) {
+                continue;
+            }
+            part = x >> (31 - MAX_NUM_PARTS_IN_BITS);
+            triangle = x & ((1 << (31 - MAX_NUM_PARTS_IN_BITS)) - 1);
+        } else {
+            const btOptimizedBvhNodeFloatData& node = bvh->m_contiguousNodesPtr[i];
+            if (node.m_escapeIndex != -1) {
+                continue;
+            }
+            part = node.m_subPart;
+            triangle = node.m_triangleIndex;
+        }
+        if (part < 0 || part >= mesh->m_numMeshParts ||
+            triangle < 0 || triangle >= mesh->m_meshPartsPtr[part].m_numTriangles) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool resolveTriangleInfoMap(ChunkMap& chunks, btTriangleInfoMapData* map) {
+    if (!resolveArray(chunks, map->m_hashTablePtr, map->m_hashTableSize) ||
+        !resolveArray(chunks, map->m_nextPtr, map->m_nextSize) ||
+        !resolveArray(chunks, map->m_valueArrayPtr, map->m_numValues) ||
+        !resolveArray(chunks, map->m_keyArrayPtr, map->m_numKeys)) {
+        return false;
+    }
+    // btHashMap::findIndex() follows hash table and next links into the key and value arrays.
+    const int num_values = map->m_numValues;
+    if (map->m_numKeys != num_values || map->m_nextSize < num_values) {
+        return false;
+    }
+    for (int i = 0; i < map->m_hashTableSize; ++i) {
+        int steps = 0;
+        for (int index = map->m_hashTablePtr[i]; index != -1; index = map->m_nextPtr[index]) {
+            if (index < -1 || index >= num_values || ++steps > num_values) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool resolveTriMeshShape(ChunkMap& chunks, btTriangleMeshShapeData* trimesh) {
+    // BVH and triangle info map chunks are resolved on their own (they can be shared).
+    trimesh->m_quantizedDoubleBvh = nullptr;
+    return resolveMeshInterface(chunks, &trimesh->m_meshInterface) &&
+        resolveOptionalArray(chunks, trimesh->m_quantizedFloatBvh, 1, BT_QUANTIZED_BVH_CODE) &&
+        resolveOptionalArray(chunks, trimesh->m_triangleInfoMap, 1, BT_TRIANLGE_INFO_MAP);
+}
+
+// Size of the serialized structure btCollisionWorldImporter reads for `shape_type`.
+static size_t shapeDataSize(int shape_type) {
+    switch (shape_type) {
+        case BOX_SHAPE_PROXYTYPE:
+        case SPHERE_SHAPE_PROXYTYPE:
+            return sizeof(btConvexInternalShapeData);
+        case CAPSULE_SHAPE_PROXYTYPE:
+            return sizeof(btCapsuleShapeData);
+        case CYLINDER_SHAPE_PROXYTYPE:
+            return sizeof(btCylinderShapeData);
+        case CONE_SHAPE_PROXYTYPE:
+            return sizeof(btConeShapeData);
+        case STATIC_PLANE_PROXYTYPE:
+            return sizeof(btStaticPlaneShapeData);
+        case MULTI_SPHERE_SHAPE_PROXYTYPE:
+            return sizeof(btMultiSphereShapeData);
+        case CONVEX_HULL_SHAPE_PROXYTYPE:
+            return sizeof(btConvexHullShapeData);
+        case TRIANGLE_MESH_SHAPE_PROXYTYPE:
+            return sizeof(btTriangleMeshShapeData);
+        case SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE:
+            return sizeof(btScaledTriangleMeshShapeData);
+        case GIMPACT_SHAPE_PROXYTYPE:
+            return sizeof(btGImpactMeshShapeData);
+        case COMPOUND_SHAPE_PROXYTYPE:
+            return sizeof(btCompoundShapeData);
+        default:
+            return sizeof(btCollisionShapeData);
+    }
+}
+
+// Every shape chunk is resolved exactly once. Array chunks referenced from a shape belong to that shape only.
+static bool resolveShape(ChunkMap& chunks, btCollisionShapeData* shape, size_t size) {
+    if (size < sizeof(btCollisionShapeData) || size < shapeDataSize(shape->m_shapeType)) {
+        return false;
+    }
+    if (!resolveName(chunks, shape->m_name)) {
+        return false;
+    }
+
+    switch (shape->m_shapeType) {
+        case COMPOUND_SHAPE_PROXYTYPE: {
+            auto compound = (btCompoundShapeData*)shape;
+            if (!resolveArray(chunks, compound->m_childShapePtr, compound->m_numChildShapes, BT_ARRAY_CODE, true)) {
+                return false;
+            }
+            for (int i = 0; i < compound->m_numChildShapes; ++i) {
+                if (!resolveArray(chunks, compound->m_childShapePtr[i].m_childShape, 1, BT_SHAPE_CODE)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case TRIANGLE_MESH_SHAPE_PROXYTYPE:
+            return resolveTriMeshShape(chunks, (btTriangleMeshShapeData*)shape);
+        case SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE:
+            return resolveTriMeshShape(chunks, &((btScaledTriangleMeshShapeData*)shape)->m_trimeshShapeData);
+        case GIMPACT_SHAPE_PROXYTYPE:
+            return resolveMeshInterface(chunks, &((btGImpactMeshShapeData*)shape)->m_meshInterface);
+        case CONVEX_HULL_SHAPE_PROXYTYPE: {
+            auto hull = (btConvexHullShapeData*)shape;
+            const int num_points = hull->m_numUnscaledPoints;
+            return num_points >= 0 &&
+                resolveOptionalArray(chunks, hull->m_unscaledPointsFloatPtr, num_points) &&
+                resolveOptionalArray(chunks, hull->m_unscaledPointsDoublePtr, num_points) &&
+                (num_points == 0 || hull->m_unscaledPointsFloatPtr || hull->m_unscaledPointsDoublePtr);
+        }
+        case MULTI_SPHERE_SHAPE_PROXYTYPE: {
+            auto multi_sphere = (btMultiSphereShapeData*)shape;
+            return resolveArray(chunks, multi_sphere->m_localPositionArrayPtr, multi_sphere->m_localPositionArraySize);
+        }
+        default:
+            return true;
+    }
+}
+
+// Returns the compound nesting height of a resolved shape or -1 for cycles and nesting deeper than
+// k_max_compound_depth. `heights` memoizes shared children.
+static int compoundHeight(const btCollisionShapeData* shape, int depth, btHashMap<btHashPtr, int>& heights) {
+    if (shape->m_shapeType != COMPOUND_SHAPE_PROXYTYPE) {
+        return 0;
+    }
+    if (const int* known = heights.find(btHashPtr(shape))) {
+        return *known;
+    }
+    if (depth >= k_max_compound_depth) {
+        return -1;
+    }
+    heights.insert(btHashPtr(shape), -1); // a cycle finds this while the children are visited
+
+    auto compound = (const btCompoundShapeData*)shape;
+    int height = 1;
+    for (int i = 0; i < compound->m_numChildShapes && height > 0; ++i) {
+        const int child_height = compoundHeight(compound->m_childShapePtr[i].m_childShape, depth + 1, heights);
+        height = child_height < 0 ? -1 : btMax(height, child_height + 1);
+    }
+    heights.insert(btHashPtr(shape), height);
+    return height;
+}
+
+static bool isValidShapeBvh(const btCollisionShapeData* shape) {
+    const btTriangleMeshShapeData* trimesh = nullptr;
+    if (shape->m_shapeType == TRIANGLE_MESH_SHAPE_PROXYTYPE) {
+        trimesh = (const btTriangleMeshShapeData*)shape;
+    } else if (shape->m_shapeType == SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE) {
+        trimesh = &((const btScaledTriangleMeshShapeData*)shape)->m_trimeshShapeData;
+    }
+    return trimesh == nullptr || trimesh->m_quantizedFloatBvh == nullptr ||
+        isValidBvhForMesh(trimesh->m_quantizedFloatBvh, &trimesh->m_meshInterface);
+}
+
+static void createBodyFromData(
+    CbtBodyHandle body_handle,
+    const btRigidBodyFloatData* data,
+    btCollisionShape* shape
+) {
+    const btCollisionObjectFloatData& object = data->m_collisionObjectData;
+
+    void* body_mem = (void*)body_handle;
+    void* motion_state_mem = (void*)((uint8_t*)body_handle + sizeof(btRigidBody));
+
+    btTransform transform;
+    transform.deSerializeFloat(object.m_worldTransform);
+
+    btVector3 inv_inertia;
+    inv_inertia.deSerializeFloat(data->m_invInertiaLocal);
+    const btVector3 local_inertia(
+        inv_inertia.x() != 0.0f ? 1.0f / inv_inertia.x() : 0.0f,
+        inv_inertia.y() != 0.0f ? 1.0f / inv_inertia.y() : 0.0f,
+        inv_inertia.z() != 0.0f ? 1.0f / inv_inertia.z() : 0.0f
+    );
+    const float mass = data->m_inverseMass != 0.0f ? 1.0f / data->m_inverseMass : 0.0f;
+
+    btDefaultMotionState* motion_state = new (motion_state_mem) btDefaultMotionState(transform);
+    btRigidBody::btRigidBodyConstructionInfo info(mass, motion_state, shape, local_inertia);
+    info.m_linearDamping = data->m_linearDamping;
+    info.m_angularDamping = data->m_angularDamping;
+    info.m_friction = object.m_friction;
+    info.m_rollingFriction = object.m_rollingFriction;
+    info.m_restitution = object.m_restitution;
+    info.m_linearSleepingThreshold = data->m_linearSleepingThreshold;
+    info.m_angularSleepingThreshold = data->m_angularSleepingThreshold;
+    info.m_additionalDamping = data->m_additionalDamping != 0;
+    info.m_additionalDampingFactor = data->m_additionalDampingFactor;
+    info.m_additionalLinearDampingThresholdSqr = data->m_additionalLinearDampingThresholdSqr;
+    info.m_additionalAngularDampingThresholdSqr = data->m_additionalAngularDampingThresholdSqr;
+    info.m_additionalAngularDampingFactor = data->m_additionalAngularDampingFactor;
+
+    auto body = new (body_mem) btRigidBody(info);
+
+    btVector3 v;
+    v.deSerializeFloat(data->m_linearVelocity);
+    body->setLinearVelocity(v);
+    v.deSerializeFloat(data->m_angularVelocity);
+    body->setAngularVelocity(v);
+    v.deSerializeFloat(data->m_linearFactor);
+    body->setLinearFactor(v);
+    v.deSerializeFloat(data->m_angularFactor);
+    body->setAngularFactor(v);
+    if (object.m_hasAnisotropicFriction) {
+        v.deSerializeFloat(object.m_anisotropicFriction);
+        body->setAnisotropicFriction(v, object.m_hasAnisotropicFriction);
+    }
+
+    body->setCollisionFlags(object.m_collisionFlags);
+    if (object.m_collisionFlags & btCollisionObject::CF_HAS_CONTACT_STIFFNESS_DAMPING) {
+        body->setContactStiffnessAndDamping(object.m_contactStiffness, object.m_contactDamping);
+    }
+    body->setContactProcessingThreshold(object.m_contactProcessingThreshold);
+    body->setCcdMotionThreshold(object.m_ccdMotionThreshold);
+    body->setCcdSweptSphereRadius(object.m_ccdSweptSphereRadius);
+    body->setDeactivationTime(object.m_deactivationTime);
+    body->forceActivationState(object.m_activationState1);
+}
+
+static bool isValidWorldBlobHeader(const uint8_t* header) {
+    const int little_endian = 1;
+    return memcmp(header, "BULLETf", 7) == 0 &&
+        header[7] == (sizeof(void*) == 8 ? '-' : '_') &&
+        header[8] == (((const char*)&little_endian)[0] ? 'v' : 'V');
+}
+
+void cbtWorldSave(CbtWorldHandle world_handle, CbtWorldSaveCallback write, void* context) {
+    assert(world_handle && write);
+    auto world = ((WorldData*)world_handle)->world;
+
+    btDefaultSerializer serializer;
+    world->serialize(&serializer);
+
+    write(context, serializer.getBufferPointer(), (size_t)serializer.getCurrentBufferSize());
+}
+
+CbtWorldImportHandle cbtWorldLoad(CbtWorldHandle world_handle, const void* data, size_t data_size) {
+    assert(world_handle && data);
+    auto world_data = (WorldData*)world_handle;
+    const uint8_t* blob = (const uint8_t*)data;
+
+    if (data_size < BT_HEADER_LENGTH || !isValidWorldBlobHeader(blob)) {
+        return nullptr;
+    }
+
+    // Validate chunks and compute the size of the scratch buffer (chunk data only, 16-byte aligned).
+    size_t scratch_size = 0;
+    int num_chunks = 0;
+    int last_chunk_code = 0;
+    for (size_t offset = BT_HEADER_LENGTH; offset < data_size;) {
+        btChunk chunk;
+        if (data_size - offset < sizeof(btChunk)) {
+            return nullptr;
+        }
+        memcpy(&chunk, blob + offset, sizeof(btChunk));
+        if (chunk.m_length < 0 || (size_t)chunk.m_length > data_size - offset - sizeof(btChunk)) {
+            return nullptr;
+        }
+        if (chunk.m_chunkCode != BT_DNA_CODE) {
+            scratch_size += ((size_t)chunk.m_length + 15) & ~(size_t)15;
+            num_chunks += 1;
+        }
+        last_chunk_code = chunk.m_chunkCode;
+        offset += sizeof(btChunk) + chunk.m_length;
+    }
+    // btDefaultSerializer writes the DNA chunk last, a blob cut at a chunk boundary would otherwise look valid.
+    if (last_chunk_code != BT_DNA_CODE) {
+        return nullptr;
+    }
+
+    uint8_t* scratch = (uint8_t*)btAlignedAlloc(scratch_size > 0 ? scratch_size : 16, 16);
+
+    ChunkMap chunks;
+    btAlignedObjectArray<LoadedChunk> loaded;
+    loaded.reserve(num_chunks);
+    {
+        uint8_t* dst = scratch;
+        for (size_t offset = BT_HEADER_LENGTH; offset < data_size;) {
+            btChunk chunk;
+            memcpy(&chunk, blob + offset, sizeof(btChunk));
+            if (chunk.m_chunkCode != BT_DNA_CODE) {
+                memcpy(dst, blob + offset + sizeof(btChunk), chunk.m_length);
+                const LoadedChunk loaded_chunk = { chunk.m_chunkCode, dst, (size_t)chunk.m_length, false };
+                chunks.insert(btHashPtr(chunk.m_oldPtr), loaded_chunk);
+                loaded.push_back(loaded_chunk);
+                dst += ((size_t)chunk.m_length + 15) & ~(size_t)15;
+            }
+            offset += sizeof(btChunk) + chunk.m_length;
+        }
+    }
+
+    btBulletSerializedArrays arrays;
+    btAlignedObjectArray<btRigidBodyFloatData*> body_datas;
+    const btDynamicsWorldFloatData* world_info = nullptr;
+
+    bool valid = true;
+    for (int i = 0; i < loaded.size() && valid; ++i) {
+        const LoadedChunk& chunk = loaded[i];
+        switch (chunk.code) {
+            case BT_QUANTIZED_BVH_CODE: {
+                auto bvh = (btQuantizedBvhFloatData*)chunk.data;
+                valid = chunk.size >= sizeof(btQuantizedBvhFloatData) && resolveBvh(chunks, bvh);
+                arrays.m_bvhsFloat.push_back(bvh);
+            } break;
+            case BT_TRIANLGE_INFO_MAP:
+                valid = chunk.size >= sizeof(btTriangleInfoMapData) &&
+                    resolveTriangleInfoMap(chunks, (btTriangleInfoMapData*)chunk.data);
+                break;
+            case BT_SHAPE_CODE: {
+                auto shape = (btCollisionShapeData*)chunk.data;
+                valid = resolveShape(chunks, shape, chunk.size);
+                arrays.m_colShapeData.push_back(shape);
+            } break;
+            case BT_RIGIDBODY_CODE: {
+                auto body = (btRigidBodyFloatData*)chunk.data;
+                if (chunk.size < sizeof(btRigidBodyFloatData)) {
+                    valid = false;
+                    break;
+                }
+                btCollisionObjectFloatData& object = body->m_collisionObjectData;
+                object.m_broadphaseHandle = nullptr;
+                object.m_rootCollisionShape = nullptr;
+                auto shape = (btCollisionShapeData*)object.m_collisionShape;
+                valid = resolveArray(chunks, shape, 1, BT_SHAPE_CODE) && resolveName(chunks, object.m_name);
+                object.m_collisionShape = shape;
+                body_datas.push_back(body);
+            } break;
+            case BT_DYNAMICSWORLD_CODE:
+                valid = chunk.size >= sizeof(btDynamicsWorldFloatData);
+                world_info = (const btDynamicsWorldFloatData*)chunk.data;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Checks that need all chunks resolved.
+    btHashMap<btHashPtr, int> compound_heights;
+    for (int i = 0; i < arrays.m_colShapeData.size() && valid; ++i) {
+        const btCollisionShapeData* shape = arrays.m_colShapeData[i];
+        valid = compoundHeight(shape, 0, compound_heights) >= 0 && isValidShapeBvh(shape);
+    }
+    if (!valid) {
+        btAlignedFree(scratch);
+        return nullptr;
+    }
+
+    auto import = (WorldImport*)btAlignedAlloc(sizeof(WorldImport), 16);
+    new (import) WorldImport();
+    import->world_data = world_data;
+
+    import->importer.convertAllObjects(&arrays);
+
+    // Bodies keep their saved order, so a shape btCollisionWorldImporter could not create (unsupported type or a
+    // compound child it would silently leave out) fails the whole load.
+    btAlignedObjectArray<btCollisionShape*> body_shapes;
+    body_shapes.resize(body_datas.size());
+    for (int i = 0; i < body_datas.size() && valid; ++i) {
+        body_shapes[i] = import->importer.findShape(body_datas[i]->m_collisionObjectData.m_collisionShape);
+        valid = body_shapes[i] != nullptr;
+    }
+    for (int i = 0; i < arrays.m_colShapeData.size() && valid; ++i) {
+        if (arrays.m_colShapeData[i]->m_shapeType == COMPOUND_SHAPE_PROXYTYPE) {
+            auto compound = (const btCompoundShapeData*)arrays.m_colShapeData[i];
+            for (int j = 0; j < compound->m_numChildShapes && valid; ++j) {
+                valid = import->importer.findShape(compound->m_childShapePtr[j].m_childShape) != nullptr;
+            }
+        }
+    }
+    if (!valid) {
+        import->importer.deleteAllData();
+        import->~WorldImport();
+        btAlignedFree(import);
+        btAlignedFree(scratch);
+        return nullptr;
+    }
+
+    if (world_info) {
+        btVector3 gravity;
+        gravity.deSerializeFloat(world_info->m_gravity);
+        world_data->world->setGravity(gravity);
+    }
+
+    const int num_bodies = body_datas.size();
+    if (num_bodies > 0) {
+        import->bodies.resize(num_bodies);
+        cbtBodyAllocateBatch((unsigned int)num_bodies, &import->bodies[0]);
+
+        ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_OBJECTS);
+        for (int i = 0; i < num_bodies; ++i) {
+            const btCollisionObjectFloatData& object = body_datas[i]->m_collisionObjectData;
+            createBodyFromData(import->bodies[i], body_datas[i], body_shapes[i]);
+
+            auto body = (btRigidBody*)import->bodies[i];
+            if (object.m_collisionFilterGroup != 0 || object.m_collisionFilterMask != 0) {
+                world_data->world->addRigidBody(body, object.m_collisionFilterGroup, object.m_collisionFilterMask);
+            } else {
+                world_data->world->addRigidBody(body);
+            }
+        }
+    }
+
+    btAlignedFree(scratch);
+    return (CbtWorldImportHandle)import;
+}
+
+void cbtWorldImportDestroy(CbtWorldImportHandle import_handle) {
+    assert(import_handle);
+    auto import = (WorldImport*)import_handle;
+    auto world_data = import->world_data;
+
+    if (import->bodies.size() > 0) {
+        ArenaScope scope(world_data->arena, CBT_ARENA_CATEGORY_OBJECTS);
+        for (int i = 0; i < import->bodies.size(); ++i) {
+            auto body = (btRigidBody*)import->bodies[i];
+            if (world_data->lod.body_max_tiers.size() > 0) {
+                world_data->lod.body_max_tiers.remove((const void*)body);
+            }
+            world_data->world->removeRigidBody(body);
+            cbtBodyDestroy(import->bodies[i]);
+        }
+    }
+    if (import->bodies.size() > 0) {
+        cbtBodyDeallocateBatch((unsigned int)import->bodies.size(), &import->bodies[0]);
+    }
+    import->importer.deleteAllData();
+
+    import->~WorldImport();
+    btAlignedFree(import);
+}
+
+int cbtWorldImportGetNumBodies(CbtWorldImportHandle import_handle) {
+    assert(import_handle);
+    return ((WorldImport*)import_handle)->bodies.size();
+}
+
+CbtBodyHandle cbtWorldImportGetBody(CbtWorldImportHandle import_handle, int body_index) {
+    assert(import_handle);
+    auto import = (WorldImport*)import_handle;
+    assert(body_index >= 0 && body_index < import->bodies.size());
+    return import->bodies[body_index];
+}
+
+int cbtWorldImportGetNumShapes(CbtWorldImportHandle import_handle) {
+    assert(import_handle);
+    return ((WorldImport*)import_handle)->importer.getNumCollisionShapes();
+}
+
+CbtShapeHandle cbtWorldImportGetShape(CbtWorldImportHandle import_handle, int shape_index) {
+    assert(import_handle);
+    auto import = (WorldImport*)import_handle;
+    assert(shape_index >= 0 && shape_index < import->importer.getNumCollisionShapes());
+    return (CbtShapeHandle)import->importer.getCollisionShapeByIndex(shape_index);
+}
+
+static DebugDraw* getOrCreateDebugDraw(WorldData* world_data) {
     if (world_data->debug == nullptr) {
         world_data->debug = (DebugDraw*)btAlignedAlloc(sizeof(DebugDraw), 16);
         new (world_data->debug) DebugDraw();
     }
-    world_data->debug->drawer = *drawer;
-    world_data->debug->setDebugMode(CBT_DBGMODE_NO_DEBUG);
+    return world_data->debug;
+}
 
-    world_data->world->setDebugDrawer(world_data->debug);
+void cbtWorldDebugSetDrawer(CbtWorldHandle world_handle, const CbtDebugDraw* drawer) {
+    assert(world_handle && drawer);
+    auto world_data = (WorldData*)world_handle;
+
+    auto debug = getOrCreateDebugDraw(world_data);
+    debug->drawer = *drawer;
+    debug->setDebugMode(CBT_DBGMODE_NO_DEBUG);
+
+    world_data->world->setDebugDrawer(debug);
 }
 
 void cbtWorldDebugSetMode(CbtWorldHandle world_handle, int mode) {
     assert(world_handle);
     auto world_data = (WorldData*)world_handle;
-    assert(world_data->debug != nullptr);
+
+    // Drawer callbacks are not required when only cbtWorldDebugDrawAllToBuffer() is used.
+    auto debug = getOrCreateDebugDraw(world_data);
 
     if (mode == CBT_DBGMODE_DISABLED) {
-        world_data->debug->setDebugMode(CBT_DBGMODE_NO_DEBUG);
+        debug->setDebugMode(CBT_DBGMODE_NO_DEBUG);
         world_data->world->setDebugDrawer(nullptr);
     } else {
-        world_data->debug->setDebugMode(mode);
-        world_data->world->setDebugDrawer(world_data->debug);
+        debug->setDebugMode(mode);
+        world_data->world->setDebugDrawer(debug);
     }
 }
 
@@ -358,6 +2180,69 @@ void cbtWorldDebugDrawAll(CbtWorldHandle world_handle) {
     world->debugDrawWorld();
 }
 
+static inline bool isAabbOutsidePlanes(
+    const btVector3& aabb_min,
+    const btVector3& aabb_max,
+    const float (*planes)[4],
+    int num_planes
+) {
+    for (int i = 0; i < num_planes; ++i) {
+        // Test the AABB corner which is furthest along the plane normal.
+        const float x = planes[i][0] >= 0.0f ? aabb_max.x() : aabb_min.x();
+        const float y = planes[i][1] >= 0.0f ? aabb_max.y() : aabb_min.y();
+        const float z = planes[i][2] >= 0.0f ? aabb_max.z() : aabb_min.z();
+        if (planes[i][0] * x + planes[i][1] * y + planes[i][2] * z + planes[i][3] < 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void cbtWorldDebugDrawAllToBuffer(
+    CbtWorldHandle world_handle,
+    CbtDebugLineBuffer* buffer,
+    const float cull_planes[][4],
+    int num_cull_planes
+) {
+    assert(world_handle && buffer);
+    assert(buffer->num_lines <= buffer->max_lines);
+    assert(buffer->vertices != nullptr || buffer->max_lines == 0);
+    assert(num_cull_planes >= 0 && (cull_planes != nullptr || num_cull_planes == 0));
+    auto world_data = (WorldData*)world_handle;
+    auto world = world_data->world;
+
+    auto debug = world_data->debug;
+    if (debug == nullptr || world->getDebugDrawer() == nullptr) {
+        return;
+    }
+
+    // Objects whose broadphase AABB is completely outside of any plane are temporarily hidden.
+    debug->culled_objects.resize(0);
+    if (num_cull_planes > 0) {
+        btCollisionObjectArray& objects = world->getCollisionObjectArray();
+        for (int i = 0; i < objects.size(); ++i) {
+            btCollisionObject* object = objects[i];
+            const btBroadphaseProxy* proxy = object->getBroadphaseHandle();
+            if ((object->getCollisionFlags() & btCollisionObject::CF_DISABLE_VISUALIZE_OBJECT) == 0 && proxy &&
+                isAabbOutsidePlanes(proxy->m_aabbMin, proxy->m_aabbMax, cull_planes, num_cull_planes)) {
+                object->setCollisionFlags(
+                    object->getCollisionFlags() | btCollisionObject::CF_DISABLE_VISUALIZE_OBJECT
+                );
+                debug->culled_objects.push_back(object);
+            }
+        }
+    }
+
+    debug->buffer = buffer;
+    world->debugDrawWorld();
+    debug->buffer = nullptr;
+
+    for (int i = 0; i < debug->culled_objects.size(); ++i) {
+        btCollisionObject* object = debug->culled_objects[i];
+        object->setCollisionFlags(object->getCollisionFlags() & ~btCollisionObject::CF_DISABLE_VISUALIZE_OBJECT);
+    }
+}
+
 void cbtWorldDebugDrawLine1(
     CbtWorldHandle world_handle,
     const CbtVector3 p0,
@@ -74,6 +74,20 @@
 #define CBT_ROTATE_ORDER_ZXY 4
 #define CBT_ROTATE_ORDER_ZYX 5
 
+// cbtWorldGetArenaStats
+#define CBT_ARENA_CATEGORY_WORLD 0 // world, dispatcher, broadphase and solver objects
+#define CBT_ARENA_CATEGORY_COLLISION_POOLS 1 // collision configuration, manifold and algorithm pools
+#define CBT_ARENA_CATEGORY_OBJECTS 2 // broadphase proxies and pairs created when bodies are added
+#define CBT_ARENA_CATEGORY_SIMULATION 3 // overlapping pairs, islands and solver data created while stepping
+#define CBT_ARENA_CATEGORY_COUNT 4
+
+// cbtWorldLodSetTiers
+#define CBT_LOD_MAX_TIERS 4
+
+// CbtTriggerEvent
+#define CBT_TRIGGER_EVENT_ENTER 0
+#define CBT_TRIGGER_EVENT_LEAVE 1
+
 #define CBT_DBGMODE_DISABLED -1
 #define CBT_DBGMODE_NO_DEBUG 0
 #define CBT_DBGMODE_DRAW_WIREFRAME 1
@@ -92,6 +106,8 @@ CBT_DECLARE_HANDLE(CbtShapeHandle);
 CBT_DECLARE_HANDLE(CbtBodyHandle);
 CBT_DECLARE_HANDLE(CbtConstraintHandle);
 CBT_DECLARE_HANDLE(CbtDebugDrawHandle);
+CBT_DECLARE_HANDLE(CbtWorldImportHandle);
+CBT_DECLARE_HANDLE(CbtTriggerHandle);
 
 typedef void* (CbtAlignedAllocFunc)(size_t size, int alignment);
 typedef void (CbtAlignedFreeFunc)(void* memblock);
@@ -101,6 +117,26 @@ typedef void (CbtFreeFunc)(void* memblock);
 void cbtAlignedAllocSetCustom(CbtAllocFunc alloc, CbtFreeFunc free);
 void cbtAlignedAllocSetCustomAligned(CbtAlignedAllocFunc alloc, CbtAlignedFreeFunc free);
 
+typedef void* (*CbtArenaAllocCallback)(void* context, size_t size, int alignment);
+typedef void (*CbtArenaFreeCallback)(void* context, void* memblock);
+
+typedef struct CbtArenaDesc {
+    // Backing allocator for arena blocks. When `alloc` is NULL global allocator is used.
+    CbtArenaAllocCallback alloc;
+    CbtArenaFreeCallback free;
+    void* context;
+    unsigned int block_size; // 0 means 256 KB
+    int max_persistent_manifolds; // 0 means 4096
+    int max_collision_algorithms; // 0 means 4096
+} CbtArenaDesc;
+
+typedef struct CbtArenaStats {
+    size_t bytes_reserved; // memory obtained from the backing allocator
+    size_t bytes_in_use[CBT_ARENA_CATEGORY_COUNT];
+    unsigned int num_live_allocs[CBT_ARENA_CATEGORY_COUNT];
+    unsigned long long num_total_allocs[CBT_ARENA_CATEGORY_COUNT];
+} CbtArenaStats;
+
 typedef void (*CbtDrawLine1Callback)(
     void* context,
     const CbtVector3 p0,
@@ -130,6 +166,50 @@ typedef struct CbtDebugDraw {
     void* context;
 } CbtDebugDraw;
 
+// cbtWorldDebugDrawAllToBuffer
+typedef struct CbtDebugLineVertex {
+    CbtVector3 position;
+    unsigned int color; // 0x00BBGGRR
+} CbtDebugLineVertex;
+
+struct CbtDebugLineBuffer;
+
+// Called when `buffer` is full. Should reallocate `buffer->vertices` (preserving existing content) and update
+// `buffer->max_lines` so that it holds at least `min_num_lines` lines.
+typedef void (*CbtDebugLineBufferGrowCallback)(
+    void* context,
+    struct CbtDebugLineBuffer* buffer,
+    unsigned int min_num_lines
+);
+
+typedef struct CbtDebugLineBuffer {
+    CbtDebugLineVertex* vertices; // two vertices per line
+    unsigned int num_lines; // new lines are appended, set to 0 to start from scratch
+    unsigned int max_lines;
+    unsigned int num_dropped_lines; // lines that did not fit (`grow` is NULL or did not grow the buffer)
+    CbtDebugLineBufferGrowCallback grow; // can be NULL
+    void* context;
+} CbtDebugLineBuffer;
+
+typedef struct CbtLodStats {
+    unsigned int num_bodies_per_tier[CBT_LOD_MAX_TIERS]; // active dynamic bodies in each tier (last step)
+    unsigned int num_body_updates; // body updates performed in the last step
+    unsigned int num_body_updates_skipped; // body updates skipped in the last step
+    float step_time_ms; // time spent in the last step
+    float time_saved_ms; // estimated: skipped updates * running average cost of one body update
+    double total_time_saved_ms; // estimated, since cbtWorldLodSetTiers
+} CbtLodStats;
+
+// cbtWorldTriggerDrainEvents
+typedef struct CbtTriggerEvent {
+    CbtTriggerHandle trigger;
+    CbtBodyHandle body; // may be already removed from the world (and destroyed) for CBT_TRIGGER_EVENT_LEAVE
+    int type; // CBT_TRIGGER_EVENT_ENTER or CBT_TRIGGER_EVENT_LEAVE
+} CbtTriggerEvent;
+
+// cbtWorldSave
+typedef void (*CbtWorldSaveCallback)(void* context, const void* data, size_t data_size);
+
 typedef struct CbtRayCastResult {
     CbtVector3 hit_normal_world;
     CbtVector3 hit_point_world;
@@ -150,7 +230,13 @@ void cbtTaskSchedSetNumThreads(int num_threads);
 // World
 //
 CbtWorldHandle cbtWorldCreate(void);
+// Memory used internally by the world (pair cache, manifolds, collision algorithms, islands, solver data) comes from
+// a world-owned arena with size-class free lists and per-thread caches. cbtWorldDestroy releases the arena as a whole.
+// Bodies, shapes and constraints are still allocated by the user and must not depend on the world's lifetime.
+CbtWorldHandle cbtWorldCreateWithArena(const CbtArenaDesc* desc);
 void cbtWorldDestroy(CbtWorldHandle world_handle);
+bool cbtWorldHasArena(CbtWorldHandle world_handle);
+void cbtWorldGetArenaStats(CbtWorldHandle world_handle, CbtArenaStats* stats);
 void cbtWorldSetGravity(CbtWorldHandle world_handle, const CbtVector3 gravity);
 void cbtWorldGetGravity(CbtWorldHandle world_handle, CbtVector3 gravity);
 int cbtWorldStepSimulation(
@@ -186,10 +272,49 @@ bool cbtWorldRayTestClosest(
     CbtRayCastResult* result
 );
 
+// Physics LOD. Active dynamic bodies are assigned to update tiers by distance to the nearest focus point. Tier `t` is
+// simulated every 2^t-th step with a 2^t times larger time step; different tiers never update on the same step. All
+// bodies of a simulation island use the island's lowest tier. `tier_distances[t]` (ascending) is the distance where
+// tier t + 1 starts; `num_tiers` == 1 disables LOD. Without focus points all bodies stay in tier 0. Forces applied to
+// a body between updates act as impulses, so its velocity matches full rate simulation. Assumes that each
+// cbtWorldStepSimulation call performs one simulation sub-step.
+void cbtWorldLodSetTiers(CbtWorldHandle world_handle, const float* tier_distances, int num_tiers);
+int cbtWorldLodGetNumTiers(CbtWorldHandle world_handle);
+void cbtWorldLodSetFocusPoints(CbtWorldHandle world_handle, const CbtVector3* points, int num_points);
+// Limits the tier of a body (0 - always simulated at full rate). Passing CBT_LOD_MAX_TIERS - 1 removes the limit.
+void cbtWorldLodSetBodyMaxTier(CbtWorldHandle world_handle, CbtBodyHandle body_handle, int max_tier);
+int cbtWorldLodGetBodyTier(CbtWorldHandle world_handle, CbtBodyHandle body_handle); // tier used in the last step
+void cbtWorldLodGetStats(CbtWorldHandle world_handle, CbtLodStats* stats);
+
+// Serializes gravity, rigid bodies and their shapes (including prebuilt triangle mesh BVHs) to a single binary blob
+// and passes it to `write`. Constraints and non-rigid collision objects are not saved.
+void cbtWorldSave(CbtWorldHandle world_handle, CbtWorldSaveCallback write, void* context);
+// Loads a blob produced by cbtWorldSave on a platform with the same pointer size and endianness: sets gravity, creates
+// shapes (BVHs are not rebuilt) and bodies and adds the bodies to the world. Returns NULL and leaves the world
+// unchanged when `data` is not a complete, consistent blob or when any saved body or shape can't be recreated. `data`
+// is not referenced after this call returns. Loaded objects are owned by the returned import and must not be destroyed
+// individually; destroy the import before the world.
+CbtWorldImportHandle cbtWorldLoad(CbtWorldHandle world_handle, const void* data, size_t data_size);
+// Removes loaded bodies from the world and destroys them together with loaded shapes.
+void cbtWorldImportDestroy(CbtWorldImportHandle import_handle);
+int cbtWorldImportGetNumBodies(CbtWorldImportHandle import_handle);
+CbtBodyHandle cbtWorldImportGetBody(CbtWorldImportHandle import_handle, int body_index); // same order as when saved
+int cbtWorldImportGetNumShapes(CbtWorldImportHandle import_handle);
+CbtShapeHandle cbtWorldImportGetShape(CbtWorldImportHandle import_handle, int shape_index);
+
 void cbtWorldDebugSetDrawer(CbtWorldHandle world_handle, const CbtDebugDraw* drawer);
 void cbtWorldDebugSetMode(CbtWorldHandle world_handle, int mode);
 int cbtWorldDebugGetMode(CbtWorldHandle world_handle);
 void cbtWorldDebugDrawAll(CbtWorldHandle world_handle);
+// Like cbtWorldDebugDrawAll but writes lines to `buffer` instead of calling drawer callbacks. Objects whose AABB is
+// outside of any of `cull_planes` (a, b, c, d; inside when a * x + b * y + c * z + d >= 0) are skipped.
+// `cull_planes` can be NULL. Debug mode must be set with cbtWorldDebugSetMode, drawer is not required.
+void cbtWorldDebugDrawAllToBuffer(
+    CbtWorldHandle world_handle,
+    CbtDebugLineBuffer* buffer,
+    const float cull_planes[][4],
+    int num_cull_planes
+);
 void cbtWorldDebugDrawLine1(
     CbtWorldHandle world_handle,
     const CbtVector3 p0,
@@ -210,6 +335,37 @@ void cbtWorldDebugDrawSphere(
     const CbtVector3 color
 );
 
+//
+// Trigger
+//
+// Trigger volume (btPairCachingGhostObject) owned by the world. Its set of overlapping rigid bodies is updated by
+// broadphase pair callbacks (AABB overlap, no narrowphase) and every change is queued as an enter or leave event.
+// Pairs between triggers and bodies never reach the narrowphase. Triggers use CBT_COLLISION_FILTER_SENSOR_TRIGGER
+// group and never overlap each other. They are collision objects of the world but are not counted by
+// cbtWorldGetNumBodies nor returned by cbtWorldGetBody. Ray tests whose mask includes
+// CBT_COLLISION_FILTER_SENSOR_TRIGGER hit them.
+// All triggers must be destroyed before the world.
+CbtTriggerHandle cbtWorldTriggerCreate(
+    CbtWorldHandle world_handle,
+    CbtShapeHandle shape_handle, // must outlive the trigger
+    const CbtVector3 transform[4],
+    int collision_mask // CBT_COLLISION_FILTER_ALL - all bodies
+);
+// Queued events of the trigger are discarded, no leave events are generated.
+void cbtWorldTriggerDestroy(CbtWorldHandle world_handle, CbtTriggerHandle trigger_handle);
+int cbtWorldTriggerGetNumEvents(CbtWorldHandle world_handle);
+// Copies up to `max_events` queued events of all triggers (in the order they happened) to `events` and removes them
+// from the queue. Returns number of copied events. Typically called once after cbtWorldStepSimulation.
+int cbtWorldTriggerDrainEvents(CbtWorldHandle world_handle, CbtTriggerEvent* events, int max_events);
+
+// Overlaps change on the next cbtWorldStepSimulation.
+void cbtTriggerSetTransform(CbtTriggerHandle trigger_handle, const CbtVector3 transform[4]);
+void cbtTriggerGetTransform(CbtTriggerHandle trigger_handle, CbtVector3 transform[4]);
+void cbtTriggerSetUserPointer(CbtTriggerHandle trigger_handle, void* user_pointer);
+void* cbtTriggerGetUserPointer(CbtTriggerHandle trigger_handle);
+int cbtTriggerGetNumOverlaps(CbtTriggerHandle trigger_handle);
+CbtBodyHandle cbtTriggerGetOverlap(CbtTriggerHandle trigger_handle, int index);
+
 //
 // Shape
 //
@@ -0,0 +1,183 @@
+// -------------------------------------------------------------------------------------------------
+// zbullet - benchmarks
+// -------------------------------------------------------------------------------------------------
+// 'zig build benchmark' in the root project directory will build and run 'ReleaseFast' configuration.
+//
+// level load benchmark: builds a level (triangle mesh terrain + many dynamic bodies) through the
+// C API (shapes, BVH build, bodies) and compares it with loading the same level from a blob
+// produced by `World.save()` (BVH is deserialized, not rebuilt).
+// -------------------------------------------------------------------------------------------------
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    zbt.init(allocator);
+    defer zbt.deinit();
+
+    // 256 x 256 quads terrain, 2000 boxes/spheres/compounds.
+    try levelLoadBenchmark(allocator, 256, 2000);
+}
+
+const std = @import("std");
+const time = std.time;
+const Timer = time.Timer;
+const zbt = @import("zbullet");
+
+const Level = struct {
+    terrain: zbt.TriangleMeshShape,
+    box: zbt.BoxShape,
+    sphere: zbt.SphereShape,
+    compound: zbt.CompoundShape,
+    bodies: []zbt.Body,
+
+    fn init(
+        allocator: std.mem.Allocator,
+        world: zbt.World,
+        indices: []const u32,
+        vertices: []const [3]f32,
+        num_bodies: u32,
+    ) !Level {
+        const terrain = zbt.initTriangleMeshShape();
+        terrain.addIndexVertexArray(
+            @intCast(u32, indices.len / 3),
+            &indices[0],
+            @sizeOf([3]u32),
+            @intCast(u32, vertices.len),
+            &vertices[0],
+            @sizeOf([3]f32),
+        );
+        terrain.finish();
+
+        const box = zbt.initBoxShape(&.{ 0.5, 0.5, 0.5 });
+        const sphere = zbt.initSphereShape(0.4);
+        const compound = zbt.initCompoundShape(.{});
+        compound.addChild(&identityTranslation(0.6, 0.0, 0.0), box.asShape());
+        compound.addChild(&identityTranslation(-0.6, 0.0, 0.0), sphere.asShape());
+
+        var bodies = try allocator.alloc(zbt.Body, num_bodies + 1);
+        bodies[0] = zbt.initBody(0.0, &identityTranslation(0.0, -2.0, 0.0), terrain.asShape());
+        world.addBody(bodies[0]);
+
+        for (bodies[1..]) |*body, i| {
+            const shape = switch (i % 3) {
+                0 => box.asShape(),
+                1 => sphere.asShape(),
+                else => compound.asShape(),
+            };
+            body.* = zbt.initBody(
+                1.0,
+                &identityTranslation(
+                    @intToFloat(f32, i % 40) * 2.0 - 40.0,
+                    3.0 + @intToFloat(f32, i / 400) * 2.0,
+                    @intToFloat(f32, (i / 40) % 10) * 2.0 - 10.0,
+                ),
+                shape,
+            );
+            world.addBody(body.*);
+        }
+
+        return Level{
+            .terrain = terrain,
+            .box = box,
+            .sphere = sphere,
+            .compound = compound,
+            .bodies = bodies,
+        };
+    }
+
+    fn deinit(level: *Level, allocator: std.mem.Allocator, world: zbt.World) void {
+        for (level.bodies) |body| {
+            world.removeBody(body);
+            body.deinit();
+        }
+        allocator.free(level.bodies);
+        level.compound.deinit();
+        level.sphere.deinit();
+        level.box.deinit();
+        level.terrain.deinit();
+        level.* = undefined;
+    }
+};
+
+fn identityTranslation(x: f32, y: f32, z: f32) [12]f32 {
+    return .{ 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, x, y, z };
+}
+
+noinline fn levelLoadBenchmark(
+    allocator: std.mem.Allocator,
+    comptime grid_size: comptime_int,
+    comptime num_bodies: comptime_int,
+) !void {
+    std.debug.print("{s:>42} - ", .{"level load benchmark"});
+
+    var vertices = std.ArrayList([3]f32).init(allocator);
+    defer vertices.deinit();
+    var indices = std.ArrayList(u32).init(allocator);
+    defer indices.deinit();
+    {
+        var z: u32 = 0;
+        while (z <= grid_size) : (z += 1) {
+            var x: u32 = 0;
+            while (x <= grid_size) : (x += 1) {
+                const fx = @intToFloat(f32, x);
+                const fz = @intToFloat(f32, z);
+                try vertices.append(.{ fx - grid_size / 2, @sin(fx * 0.3) * @cos(fz * 0.2), fz - grid_size / 2 });
+            }
+        }
+        z = 0;
+        while (z < grid_size) : (z += 1) {
+            var x: u32 = 0;
+            while (x < grid_size) : (x += 1) {
+                const i = z * (grid_size + 1) + x;
+                try indices.appendSlice(&.{ i, i + grid_size + 1, i + 1, i + 1, i + grid_size + 1, i + grid_size + 2 });
+            }
+        }
+    }
+
+    const blob = blk: {
+        const world = zbt.initWorld();
+        defer world.deinit();
+        var level = try Level.init(allocator, world, indices.items, vertices.items, num_bodies);
+        defer level.deinit(allocator, world);
+        break :blk try world.save(allocator);
+    };
+    defer allocator.free(blob);
+
+    const num_iterations = 10;
+
+    var build_time: u64 = 0;
+    {
+        var i: u32 = 0;
+        while (i < num_iterations) : (i += 1) {
+            var timer = try Timer.start();
+            const world = zbt.initWorld();
+            var level = try Level.init(allocator, world, indices.items, vertices.items, num_bodies);
+            build_time += timer.read();
+
+            level.deinit(allocator, world);
+            world.deinit();
+        }
+    }
+
+    var load_time: u64 = 0;
+    {
+        var i: u32 = 0;
+        while (i < num_iterations) : (i += 1) {
+            var timer = try Timer.start();
+            const world = zbt.initWorld();
+            const import = try world.load(blob);
+            load_time += timer.read();
+
+            import.deinit();
+            world.deinit();
+        }
+    }
+
+    std.debug.print("C API build: {d:.2}ms, load from blob ({d} KB): {d:.2}ms\n", .{
+        @intToFloat(f64, build_time) / time.ns_per_ms / num_iterations,
+        blob.len / 1024,
+        @intToFloat(f64, load_time) / time.ns_per_ms / num_iterations,
+    });
+}
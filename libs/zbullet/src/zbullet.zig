@@ -7,6 +7,7 @@ const Mutex = std.Thread.Mutex;
 const expect = std.testing.expect;
 
 pub const World = *align(@sizeOf(usize)) WorldImpl;
+pub const WorldImport = *align(@sizeOf(usize)) WorldImportImpl;
 pub const Shape = *align(@sizeOf(usize)) ShapeImpl;
 pub const BoxShape = *align(@sizeOf(usize)) BoxShapeImpl;
 pub const SphereShape = *align(@sizeOf(usize)) SphereShapeImpl;
@@ -17,6 +18,7 @@ pub const TriangleMeshShape = *align(@sizeOf(usize)) TriangleMeshShapeImpl;
 pub const Body = *align(@sizeOf(usize)) BodyImpl;
 pub const Constraint = *align(@sizeOf(usize)) ConstraintImpl;
 pub const Point2PointConstraint = *align(@sizeOf(usize)) Point2PointConstraintImpl;
+pub const Trigger = *align(@sizeOf(usize)) TriggerImpl;
 
 pub const AllocFn = if (builtin.zig_backend == .stage1)
     fn (size: usize, alignment: i32) callconv(.C) ?*anyopaque
@@ -126,10 +128,73 @@ pub const RayCastResult = extern struct {
     body: ?Body,
 };
 
+pub const ArenaCategory = enum(c_int) {
+    world = 0, // world, dispatcher, broadphase and solver objects
+    collision_pools = 1, // collision configuration, manifold and algorithm pools
+    objects = 2, // broadphase proxies and pairs created when bodies are added
+    simulation = 3, // overlapping pairs, islands and solver data created while stepping
+};
+pub const num_arena_categories = 4;
+
+pub const ArenaAllocFn = if (builtin.zig_backend == .stage1)
+    fn (context: ?*anyopaque, size: usize, alignment: i32) callconv(.C) ?*anyopaque
+else
+    *const fn (context: ?*anyopaque, size: usize, alignment: i32) callconv(.C) ?*anyopaque;
+
+pub const ArenaFreeFn = if (builtin.zig_backend == .stage1)
+    fn (context: ?*anyopaque, ptr: ?*anyopaque) callconv(.C) void
+else
+    *const fn (context: ?*anyopaque, ptr: ?*anyopaque) callconv(.C) void;
+
+pub const ArenaDesc = extern struct {
+    // Backing allocator for arena blocks, zbullet allocator is used when `alloc` is null.
+    alloc: ?ArenaAllocFn = null,
+    free: ?ArenaFreeFn = null,
+    context: ?*anyopaque = null,
+    block_size: u32 = 0, // 0 means 256 KB
+    max_persistent_manifolds: i32 = 0, // 0 means 4096
+    max_collision_algorithms: i32 = 0, // 0 means 4096
+};
+
+pub const ArenaStats = extern struct {
+    bytes_reserved: usize,
+    bytes_in_use: [num_arena_categories]usize,
+    num_live_allocs: [num_arena_categories]u32,
+    num_total_allocs: [num_arena_categories]u64,
+};
+
+pub const lod_max_tiers = 4;
+
+pub const LodStats = extern struct {
+    num_bodies_per_tier: [lod_max_tiers]u32,
+    num_body_updates: u32,
+    num_body_updates_skipped: u32,
+    step_time_ms: f32,
+    time_saved_ms: f32, // estimated
+    total_time_saved_ms: f64, // estimated
+};
+
+pub const TriggerEventType = enum(c_int) {
+    enter = 0,
+    leave = 1,
+};
+
+pub const TriggerEvent = extern struct {
+    trigger: Trigger,
+    body: Body, // for `.leave` the body may be already removed from the world
+    type: TriggerEventType,
+};
+
 pub fn initWorld() World {
     return WorldImpl.init();
 }
 
+/// World's internal memory (pairs, manifolds, collision algorithms, islands, solver data) comes from its own arena
+/// which is released as a whole in `World.deinit()`.
+pub fn initWorldWithArena(desc: ArenaDesc) World {
+    return WorldImpl.initWithArena(desc);
+}
+
 const WorldImpl = opaque {
     fn init() World {
         std.debug.assert(allocator != null and allocations != null);
@@ -137,6 +202,12 @@ const WorldImpl = opaque {
     }
     extern fn cbtWorldCreate() World;
 
+    fn initWithArena(desc: ArenaDesc) World {
+        std.debug.assert(allocator != null and allocations != null);
+        return cbtWorldCreateWithArena(&desc);
+    }
+    extern fn cbtWorldCreateWithArena(desc: *const ArenaDesc) World;
+
     pub fn deinit(world: World) void {
         std.debug.assert(world.getNumBodies() == 0);
         std.debug.assert(world.getNumConstraints() == 0);
@@ -144,6 +215,17 @@ const WorldImpl = opaque {
     }
     extern fn cbtWorldDestroy(world: World) void;
 
+    pub const hasArena = cbtWorldHasArena;
+    extern fn cbtWorldHasArena(world: World) bool;
+
+    pub fn getArenaStats(world: World) ArenaStats {
+        std.debug.assert(world.hasArena());
+        var stats: ArenaStats = undefined;
+        cbtWorldGetArenaStats(world, &stats);
+        return stats;
+    }
+    extern fn cbtWorldGetArenaStats(world: World, stats: *ArenaStats) void;
+
     pub const setGravity = cbtWorldSetGravity;
     extern fn cbtWorldSetGravity(world: World, gravity: *const [3]f32) void;
 
@@ -212,6 +294,27 @@ const WorldImpl = opaque {
     pub const debugDrawAll = cbtWorldDebugDrawAll;
     extern fn cbtWorldDebugDrawAll(world: World) void;
 
+    /// Appends debug lines to `buffer` instead of calling `DebugDraw` callbacks. Objects whose AABB is outside
+    /// of any of `cull_planes` are skipped (plane is `a, b, c, d`, inside when `a * x + b * y + c * z + d >= 0`).
+    pub fn debugDrawAllToBuffer(
+        world: World,
+        buffer: *DebugLineBuffer,
+        cull_planes: ?[]const [4]f32,
+    ) void {
+        cbtWorldDebugDrawAllToBuffer(
+            world,
+            buffer,
+            if (cull_planes) |planes| planes.ptr else null,
+            if (cull_planes) |planes| @intCast(c_int, planes.len) else 0,
+        );
+    }
+    extern fn cbtWorldDebugDrawAllToBuffer(
+        world: World,
+        buffer: *DebugLineBuffer,
+        cull_planes: ?[*]const [4]f32,
+        num_cull_planes: c_int,
+    ) void;
+
     pub const debugDrawLine1 = cbtWorldDebugDrawLine1;
     extern fn cbtWorldDebugDrawLine1(
         world: World,
@@ -265,6 +368,142 @@ const WorldImpl = opaque {
         flags: c_int,
         raycast_result: ?*RayCastResult,
     ) bool;
+
+    /// Physics LOD: active dynamic bodies are assigned to tiers by distance to the nearest focus point. Tier `t` is
+    /// simulated every 2^t-th step with a 2^t times larger time step. `tier_distances[t]` (ascending) is the distance
+    /// where tier `t + 1` starts; empty slice disables LOD.
+    pub fn lodSetTiers(world: World, tier_distances: []const f32) void {
+        std.debug.assert(tier_distances.len < lod_max_tiers);
+        cbtWorldLodSetTiers(world, tier_distances.ptr, @intCast(c_int, tier_distances.len + 1));
+    }
+    extern fn cbtWorldLodSetTiers(world: World, tier_distances: [*]const f32, num_tiers: c_int) void;
+
+    pub fn lodGetNumTiers(world: World) u32 {
+        return @intCast(u32, cbtWorldLodGetNumTiers(world));
+    }
+    extern fn cbtWorldLodGetNumTiers(world: World) c_int;
+
+    pub fn lodSetFocusPoints(world: World, points: []const [3]f32) void {
+        cbtWorldLodSetFocusPoints(world, points.ptr, @intCast(c_int, points.len));
+    }
+    extern fn cbtWorldLodSetFocusPoints(world: World, points: [*]const [3]f32, num_points: c_int) void;
+
+    /// Limits the tier of `body` (0 - always simulated at full rate).
+    pub fn lodSetBodyMaxTier(world: World, body: Body, max_tier: u32) void {
+        cbtWorldLodSetBodyMaxTier(world, body, @intCast(c_int, max_tier));
+    }
+    extern fn cbtWorldLodSetBodyMaxTier(world: World, body: Body, max_tier: c_int) void;
+
+    pub fn lodGetBodyTier(world: World, body: Body) u32 {
+        return @intCast(u32, cbtWorldLodGetBodyTier(world, body));
+    }
+    extern fn cbtWorldLodGetBodyTier(world: World, body: Body) c_int;
+
+    pub fn lodGetStats(world: World) LodStats {
+        var stats: LodStats = undefined;
+        cbtWorldLodGetStats(world, &stats);
+        return stats;
+    }
+    extern fn cbtWorldLodGetStats(world: World, stats: *LodStats) void;
+
+    /// Trigger volume owned by the world. Overlapping bodies (AABB test) are tracked by broadphase pair callbacks
+    /// and every change is queued as `TriggerEvent`. Triggers must be destroyed before the world.
+    pub fn triggerCreate(world: World, shape: Shape, transform: *const [12]f32, mask: CollisionFilter) Trigger {
+        return cbtWorldTriggerCreate(world, shape, transform, @bitCast(c_int, mask));
+    }
+    extern fn cbtWorldTriggerCreate(world: World, shape: Shape, transform: *const [12]f32, mask: c_int) Trigger;
+
+    /// Queued events of the trigger are discarded.
+    pub const triggerDestroy = cbtWorldTriggerDestroy;
+    extern fn cbtWorldTriggerDestroy(world: World, trigger: Trigger) void;
+
+    pub fn triggerGetNumEvents(world: World) u32 {
+        return @intCast(u32, cbtWorldTriggerGetNumEvents(world));
+    }
+    extern fn cbtWorldTriggerGetNumEvents(world: World) c_int;
+
+    /// Moves queued events of all triggers (oldest first) to `events`. Returns the filled part of `events`.
+    pub fn triggerDrainEvents(world: World, events: []TriggerEvent) []TriggerEvent {
+        const num_events = cbtWorldTriggerDrainEvents(world, events.ptr, @intCast(c_int, events.len));
+        return events[0..@intCast(usize, num_events)];
+    }
+    extern fn cbtWorldTriggerDrainEvents(world: World, events: [*]TriggerEvent, max_events: c_int) c_int;
+
+    /// Serializes gravity, rigid bodies and their shapes (including prebuilt triangle mesh BVHs) to a single blob.
+    /// Constraints are not saved. Returned memory is owned by the caller.
+    pub fn save(world: World, alloc: std.mem.Allocator) std.mem.Allocator.Error![]u8 {
+        var context = SaveContext{ .allocator = alloc };
+        cbtWorldSave(world, SaveContext.write, &context);
+        return context.result;
+    }
+    extern fn cbtWorldSave(world: World, write: SaveContext.WriteFn, context: ?*anyopaque) void;
+
+    const SaveContext = struct {
+        allocator: std.mem.Allocator,
+        result: std.mem.Allocator.Error![]u8 = &[_]u8{},
+
+        const WriteFn = if (builtin.zig_backend == .stage1)
+            fn (?*anyopaque, *const anyopaque, usize) callconv(.C) void
+        else
+            *const fn (?*anyopaque, *const anyopaque, usize) callconv(.C) void;
+
+        fn write(context: ?*anyopaque, data: *const anyopaque, data_size: usize) callconv(.C) void {
+            const save_context = @ptrCast(
+                *SaveContext,
+                @alignCast(@alignOf(SaveContext), context.?),
+            );
+            save_context.result = save_context.allocator.dupe(u8, @ptrCast([*]const u8, data)[0..data_size]);
+        }
+    };
+
+    /// Loads a blob produced by `save()` on a platform with the same pointer size and endianness. Shapes are created
+    /// without rebuilding BVHs, bodies are added to the world. Loaded objects are owned by the returned
+    /// `WorldImport` which must be deinitialized before the world. `data` is not referenced after this call.
+    /// Truncated or corrupt data and bodies or shapes that can't be recreated fail the whole load.
+    pub fn load(world: World, data: []const u8) error{InvalidWorldData}!WorldImport {
+        return cbtWorldLoad(world, data.ptr, data.len) orelse error.InvalidWorldData;
+    }
+    extern fn cbtWorldLoad(world: World, data: [*]const u8, data_size: usize) ?WorldImport;
+};
+
+const WorldImportImpl = opaque {
+    /// Removes loaded bodies from the world and destroys them together with loaded shapes.
+    pub const deinit = cbtWorldImportDestroy;
+    extern fn cbtWorldImportDestroy(import: WorldImport) void;
+
+    pub const getNumBodies = cbtWorldImportGetNumBodies;
+    extern fn cbtWorldImportGetNumBodies(import: WorldImport) i32;
+
+    /// Bodies are in the same order as they were in the saved world.
+    pub const getBody = cbtWorldImportGetBody;
+    extern fn cbtWorldImportGetBody(import: WorldImport, index: i32) Body;
+
+    pub const getNumShapes = cbtWorldImportGetNumShapes;
+    extern fn cbtWorldImportGetNumShapes(import: WorldImport) i32;
+
+    pub const getShape = cbtWorldImportGetShape;
+    extern fn cbtWorldImportGetShape(import: WorldImport, index: i32) Shape;
+};
+
+const TriggerImpl = opaque {
+    /// Overlaps change on the next `World.stepSimulation()`.
+    pub const setTransform = cbtTriggerSetTransform;
+    extern fn cbtTriggerSetTransform(trigger: Trigger, transform: *const [12]f32) void;
+
+    pub const getTransform = cbtTriggerGetTransform;
+    extern fn cbtTriggerGetTransform(trigger: Trigger, transform: *[12]f32) void;
+
+    pub const setUserPointer = cbtTriggerSetUserPointer;
+    extern fn cbtTriggerSetUserPointer(trigger: Trigger, ptr: ?*anyopaque) void;
+
+    pub const getUserPointer = cbtTriggerGetUserPointer;
+    extern fn cbtTriggerGetUserPointer(trigger: Trigger) ?*anyopaque;
+
+    pub const getNumOverlaps = cbtTriggerGetNumOverlaps;
+    extern fn cbtTriggerGetNumOverlaps(trigger: Trigger) i32;
+
+    pub const getOverlap = cbtTriggerGetOverlap;
+    extern fn cbtTriggerGetOverlap(trigger: Trigger, index: i32) Body;
 };
 
 pub const Axis = enum(c_int) {
@@ -726,6 +965,12 @@ const BodyImpl = opaque {
     pub const applyCentralImpulse = cbtBodyApplyCentralImpulse;
     extern fn cbtBodyApplyCentralImpulse(body: Body, impulse: *const [3]f32) void;
 
+    pub const applyCentralForce = cbtBodyApplyCentralForce;
+    extern fn cbtBodyApplyCentralForce(body: Body, force: *const [3]f32) void;
+
+    pub const getLinearVelocity = cbtBodyGetLinearVelocity;
+    extern fn cbtBodyGetLinearVelocity(body: Body, velocity: *[3]f32) void;
+
     pub const setUserIndex = cbtBodySetUserIndex;
     extern fn cbtBodySetUserIndex(body: Body, slot: u32, index: i32) void;
 
@@ -976,13 +1221,34 @@ pub const DebugDraw = extern struct {
     context: ?*anyopaque,
 };
 
+pub const DebugLineBuffer = extern struct {
+    pub const Vertex = extern struct {
+        position: [3]f32,
+        color: u32, // 0x00BBGGRR
+    };
+
+    const GrowFn = if (builtin.zig_backend == .stage1) fn (
+        ?*anyopaque,
+        *DebugLineBuffer,
+        u32,
+    ) callconv(.C) void else *const fn (
+        ?*anyopaque,
+        *DebugLineBuffer,
+        u32,
+    ) callconv(.C) void;
+
+    vertices: ?[*]Vertex, // two vertices per line
+    num_lines: u32,
+    max_lines: u32,
+    num_dropped_lines: u32,
+    grow: ?GrowFn,
+    context: ?*anyopaque,
+};
+
 pub const DebugDrawer = struct {
     lines: std.ArrayList(Vertex),
 
-    pub const Vertex = struct {
-        position: [3]f32,
-        color: u32,
-    };
+    pub const Vertex = DebugLineBuffer.Vertex;
 
     pub fn init(alloc: std.mem.Allocator) DebugDrawer {
         return .{ .lines = std.ArrayList(Vertex).init(alloc) };
@@ -993,6 +1259,35 @@ pub const DebugDrawer = struct {
         debug.* = undefined;
     }
 
+    /// Draws the whole world in one call (no per-line callbacks). New lines are appended to `debug.lines`.
+    pub fn drawAll(debug: *DebugDrawer, world: World, cull_planes: ?[]const [4]f32) void {
+        var buffer = DebugLineBuffer{
+            .vertices = debug.lines.items.ptr,
+            .num_lines = @intCast(u32, debug.lines.items.len / 2),
+            .max_lines = @intCast(u32, debug.lines.capacity / 2),
+            .num_dropped_lines = 0,
+            .grow = growLineBuffer,
+            .context = debug,
+        };
+        world.debugDrawAllToBuffer(&buffer, cull_planes);
+        debug.lines.items.len = 2 * buffer.num_lines;
+    }
+
+    fn growLineBuffer(
+        context: ?*anyopaque,
+        buffer: *DebugLineBuffer,
+        min_num_lines: u32,
+    ) callconv(.C) void {
+        const debug = @ptrCast(
+            *DebugDrawer,
+            @alignCast(@alignOf(DebugDrawer), context.?),
+        );
+        debug.lines.items.len = 2 * buffer.num_lines;
+        debug.lines.ensureTotalCapacity(2 * min_num_lines) catch unreachable;
+        buffer.vertices = debug.lines.items.ptr;
+        buffer.max_lines = @intCast(u32, debug.lines.capacity / 2);
+    }
+
     pub fn getDebugDraw(debug: *DebugDrawer) DebugDraw {
         return .{
             .drawLine1 = drawLine1,
@@ -1079,6 +1374,323 @@ test "zbullet.world.gravity" {
     try expect(gravity[0] == 1.0 and gravity[1] == 2.0 and gravity[2] == 3.0);
 }
 
+test "zbullet.world.arena" {
+    const zm = @import("zmath");
+    init(std.testing.allocator);
+    defer deinit();
+
+    const world = initWorldWithArena(.{});
+    defer world.deinit();
+    try expect(world.hasArena());
+
+    const sphere = initSphereShape(0.5);
+    defer sphere.deinit();
+
+    var bodies: [16]Body = undefined;
+    for (bodies) |*body, body_index| {
+        body.* = initBody(
+            1.0,
+            &zm.matToArr43(zm.translation(0.0, @intToFloat(f32, body_index) * 0.9, 0.0)),
+            sphere.asShape(),
+        );
+        world.addBody(body.*);
+    }
+    defer {
+        for (bodies) |body| {
+            world.removeBody(body);
+            body.deinit();
+        }
+    }
+
+    var i: u32 = 0;
+    while (i < 10) : (i += 1) {
+        _ = world.stepSimulation(1.0 / 60.0, .{});
+    }
+
+    const stats = world.getArenaStats();
+    try expect(stats.bytes_reserved > 0);
+    try expect(stats.num_live_allocs[@enumToInt(ArenaCategory.world)] > 0);
+    try expect(stats.num_live_allocs[@enumToInt(ArenaCategory.collision_pools)] > 0);
+    try expect(stats.num_total_allocs[@enumToInt(ArenaCategory.objects)] > 0);
+    try expect(stats.bytes_in_use[@enumToInt(ArenaCategory.collision_pools)] <= stats.bytes_reserved);
+}
+
+test "zbullet.world.debug_draw_to_buffer" {
+    const zm = @import("zmath");
+    init(std.testing.allocator);
+    defer deinit();
+
+    const world = initWorld();
+    defer world.deinit();
+
+    const box = initBoxShape(&.{ 1.0, 1.0, 1.0 });
+    defer box.deinit();
+
+    const body0 = initBody(0.0, &zm.matToArr43(zm.translation(0.0, 0.0, 0.0)), box.asShape());
+    defer body0.deinit();
+    const body1 = initBody(0.0, &zm.matToArr43(zm.translation(10.0, 0.0, 0.0)), box.asShape());
+    defer body1.deinit();
+
+    world.addBody(body0);
+    defer world.removeBody(body0);
+    world.addBody(body1);
+    defer world.removeBody(body1);
+
+    var debug = DebugDrawer.init(std.testing.allocator);
+    defer debug.deinit();
+
+    world.debugSetMode(.{ .draw_wireframe = true });
+    debug.drawAll(world, null);
+    const num_lines_all = debug.lines.items.len / 2;
+    try expect(num_lines_all > 0);
+
+    // Keep only objects with x <= 5.0.
+    debug.lines.clearRetainingCapacity();
+    debug.drawAll(world, &[_][4]f32{.{ -1.0, 0.0, 0.0, 5.0 }});
+    try expect(debug.lines.items.len / 2 == num_lines_all / 2);
+}
+
+test "zbullet.world.lod" {
+    const zm = @import("zmath");
+    init(std.testing.allocator);
+    defer deinit();
+
+    // worlds[1] is a full-rate reference with the same bodies and forces.
+    const worlds = [2]World{ initWorld(), initWorld() };
+    defer for (worlds) |w| w.deinit();
+
+    const sphere = initSphereShape(0.5);
+    defer sphere.deinit();
+
+    var bodies: [2][4]Body = undefined;
+    for (worlds) |w, world_index| {
+        w.setGravity(&.{ 0.0, -10.0, 0.0 });
+        for (bodies[world_index]) |*body, body_index| {
+            body.* = initBody(
+                1.0,
+                &zm.matToArr43(zm.translation(@intToFloat(f32, body_index) * 100.0, 10.0, 0.0)),
+                sphere.asShape(),
+            );
+            w.addBody(body.*);
+        }
+    }
+    defer {
+        for (worlds) |w, world_index| {
+            for (bodies[world_index]) |body| {
+                w.removeBody(body);
+                body.deinit();
+            }
+        }
+    }
+
+    const world = worlds[0];
+    world.lodSetTiers(&.{ 50.0, 150.0, 250.0 });
+    world.lodSetFocusPoints(&.{.{ 0.0, 0.0, 0.0 }});
+    world.lodSetBodyMaxTier(bodies[0][3], 1);
+    try expect(world.lodGetNumTiers() == 4);
+
+    // 8 steps are a whole update period of every tier, forces are applied on every step.
+    var i: u32 = 0;
+    while (i < 8) : (i += 1) {
+        for (worlds) |w, world_index| {
+            for (bodies[world_index]) |body| body.applyCentralForce(&.{ 2.0, 0.0, 0.0 });
+            _ = w.stepSimulation(1.0 / 60.0, .{});
+        }
+    }
+
+    try expect(world.lodGetBodyTier(bodies[0][0]) == 0);
+    try expect(world.lodGetBodyTier(bodies[0][1]) == 1);
+    try expect(world.lodGetBodyTier(bodies[0][2]) == 2);
+    try expect(world.lodGetBodyTier(bodies[0][3]) == 1);
+
+    // Every body has been simulated for the same amount of time and got the same impulse as at full rate (positions
+    // differ because lower tiers integrate with larger time steps).
+    for (bodies[0]) |body, body_index| {
+        var velocity: [3]f32 = undefined;
+        var reference_velocity: [3]f32 = undefined;
+        body.getLinearVelocity(&velocity);
+        bodies[1][body_index].getLinearVelocity(&reference_velocity);
+        for (velocity) |v, axis| try expect(std.math.approxEqAbs(f32, v, reference_velocity[axis], 0.0001));
+        try expect(std.math.approxEqAbs(f32, velocity[0], 2.0 * 8.0 / 60.0, 0.0001));
+    }
+
+    const stats = world.lodGetStats();
+    try expect(stats.num_bodies_per_tier[0] == 1 and stats.num_bodies_per_tier[1] == 2);
+    try expect(stats.total_time_saved_ms >= 0.0);
+
+    world.lodSetTiers(&.{});
+    try expect(world.lodGetNumTiers() == 1);
+}
+
+test "zbullet.world.trigger" {
+    const zm = @import("zmath");
+    init(std.testing.allocator);
+    defer deinit();
+
+    const world = initWorld();
+    defer world.deinit();
+    world.setGravity(&.{ 0.0, -10.0, 0.0 });
+
+    const box = initBoxShape(&.{ 2.0, 0.5, 2.0 });
+    defer box.deinit();
+    const sphere = initSphereShape(0.5);
+    defer sphere.deinit();
+
+    const trigger = world.triggerCreate(
+        box.asShape(),
+        &zm.matToArr43(zm.translation(0.0, 5.0, 0.0)),
+        CollisionFilter.all,
+    );
+    defer world.triggerDestroy(trigger);
+
+    const body = initBody(1.0, &zm.matToArr43(zm.translation(0.0, 10.0, 0.0)), sphere.asShape());
+    defer body.deinit();
+    world.addBody(body);
+    defer world.removeBody(body);
+
+    var num_enter: u32 = 0;
+    var num_leave: u32 = 0;
+    var events: [4]TriggerEvent = undefined;
+    var i: u32 = 0;
+    while (i < 120) : (i += 1) {
+        _ = world.stepSimulation(1.0 / 60.0, .{});
+        for (world.triggerDrainEvents(events[0..])) |event| {
+            try expect(event.trigger == trigger and event.body == body);
+            switch (event.type) {
+                .enter => {
+                    num_enter += 1;
+                    try expect(trigger.getNumOverlaps() == 1 and trigger.getOverlap(0) == body);
+                },
+                .leave => num_leave += 1,
+            }
+        }
+    }
+    // Body falls through the trigger.
+    try expect(num_enter == 1 and num_leave == 1);
+    try expect(trigger.getNumOverlaps() == 0);
+    try expect(world.triggerGetNumEvents() == 0);
+
+    var transform: [12]f32 = undefined;
+    trigger.getTransform(&transform);
+    try expect(transform[10] == 5.0);
+}
+
+test "zbullet.world.trigger_bodies" {
+    const zm = @import("zmath");
+    init(std.testing.allocator);
+    defer deinit();
+
+    const world = initWorld();
+    defer world.deinit();
+
+    const box = initBoxShape(&.{ 1.0, 1.0, 1.0 });
+    defer box.deinit();
+
+    const body0 = initBody(1.0, &zm.matToArr43(zm.translation(0.0, 0.0, 0.0)), box.asShape());
+    defer body0.deinit();
+    world.addBody(body0);
+
+    const trigger0 = world.triggerCreate(
+        box.asShape(),
+        &zm.matToArr43(zm.translation(10.0, 0.0, 0.0)),
+        CollisionFilter.all,
+    );
+    const body1 = initBody(1.0, &zm.matToArr43(zm.translation(20.0, 0.0, 0.0)), box.asShape());
+    defer body1.deinit();
+    world.addBody(body1);
+    const trigger1 = world.triggerCreate(
+        box.asShape(),
+        &zm.matToArr43(zm.translation(30.0, 0.0, 0.0)),
+        CollisionFilter.all,
+    );
+    defer world.triggerDestroy(trigger1);
+
+    // Triggers are not bodies.
+    try expect(world.getNumBodies() == 2);
+    try expect(world.getBody(0) != world.getBody(1));
+    try expect(world.getBody(0) == body0 or world.getBody(0) == body1);
+    try expect(world.getBody(1) == body0 or world.getBody(1) == body1);
+
+    world.triggerDestroy(trigger0);
+    try expect(world.getNumBodies() == 2);
+    try expect(world.getBody(0) == body0 or world.getBody(0) == body1);
+    try expect(world.getBody(1) == body0 or world.getBody(1) == body1);
+
+    world.removeBody(body0);
+    try expect(world.getNumBodies() == 1 and world.getBody(0) == body1);
+    world.removeBody(body1);
+    try expect(world.getNumBodies() == 0);
+}
+
+test "zbullet.world.save_load" {
+    const zm = @import("zmath");
+    init(std.testing.allocator);
+    defer deinit();
+
+    const blob = blk: {
+        const world = initWorld();
+        defer world.deinit();
+        world.setGravity(&.{ 0.0, -5.0, 0.0 });
+
+        const trimesh = initTriangleMeshShape();
+        defer trimesh.deinit();
+        const triangles = [_]u32{ 0, 1, 2, 0, 2, 3 };
+        const vertices = [_]f32{ -10.0, 0.0, -10.0, -10.0, 0.0, 10.0, 10.0, 0.0, 10.0, 10.0, 0.0, -10.0 };
+        trimesh.addIndexVertexArray(2, &triangles, 12, 4, &vertices, 12);
+        trimesh.finish();
+
+        const box = initBoxShape(&.{ 0.5, 0.5, 0.5 });
+        defer box.deinit();
+
+        const ground = initBody(0.0, &zm.matToArr43(zm.identity()), trimesh.asShape());
+        defer ground.deinit();
+        world.addBody(ground);
+        defer world.removeBody(ground);
+
+        const body = initBody(2.0, &zm.matToArr43(zm.translation(1.0, 3.0, 2.0)), box.asShape());
+        defer body.deinit();
+        body.setRestitution(0.25);
+        world.addBody(body);
+        defer world.removeBody(body);
+
+        break :blk try world.save(std.testing.allocator);
+    };
+    defer std.testing.allocator.free(blob);
+
+    const world = initWorld();
+    defer world.deinit();
+
+    try std.testing.expectError(error.InvalidWorldData, world.load(blob[0 .. blob.len / 2]));
+
+    const import = try world.load(blob);
+    defer import.deinit();
+
+    try expect(import.getNumBodies() == 2);
+    try expect(world.getNumBodies() == 2);
+    try expect(import.getNumShapes() >= 2);
+    try expect(import.getBody(0).getShape().getType() == .trimesh);
+    try expect(import.getBody(1).getShape().getType() == .box);
+
+    var gravity: [3]f32 = undefined;
+    world.getGravity(&gravity);
+    try expect(gravity[1] == -5.0);
+
+    const body = import.getBody(1);
+    try expect(body.getMass() == 2.0);
+    try expect(body.getRestitution() == 0.25);
+
+    var transform: [12]f32 = undefined;
+    body.getCenterOfMassTransform(&transform);
+    try expect(transform[9] == 1.0 and transform[10] == 3.0 and transform[11] == 2.0);
+
+    var i: u32 = 0;
+    while (i < 120) : (i += 1) {
+        _ = world.stepSimulation(1.0 / 60.0, .{});
+    }
+    body.getCenterOfMassTransform(&transform);
+    try expect(transform[10] > 0.4 and transform[10] < 0.6);
+}
+
 test "zbullet.shape.box" {
     init(std.testing.allocator);
     defer deinit();
@@ -2,6 +2,8 @@ const std = @import("std");
 
 pub const BuildOptions = struct {
     shape_use_32bit_indices: bool = false,
+    /// Per-library allocation counters (`zmesh.getMemoryStats()`); adds atomic updates to every allocation.
+    memory_stats: bool = false,
 };
 
 pub const BuildOptionsStep = struct {
@@ -14,6 +16,7 @@ pub const BuildOptionsStep = struct {
             .step = b.addOptions(),
         };
         bos.step.addOption(bool, "shape_use_32bit_indices", bos.options.shape_use_32bit_indices);
+        bos.step.addOption(bool, "memory_stats", bos.options.memory_stats);
         return bos;
     }
 
@@ -55,6 +58,19 @@ pub fn buildTests(
     return tests;
 }
 
+pub fn buildBenchmarks(
+    b: *std.build.Builder,
+    target: std.zig.CrossTarget,
+) *std.build.LibExeObjStep {
+    const exe = b.addExecutable("zmesh-benchmark", thisDir() ++ "/src/benchmark.zig");
+    exe.setBuildMode(std.builtin.Mode.ReleaseFast);
+    exe.setTarget(target);
+    const bos = BuildOptionsStep.init(b, .{});
+    exe.addPackage(getPkg(&.{bos.getPkg()}));
+    link(exe, bos);
+    return exe;
+}
+
 fn buildLibrary(exe: *std.build.LibExeObjStep, bos: BuildOptionsStep) *std.build.LibExeObjStep {
     const lib = exe.builder.addStaticLibrary("zmesh", thisDir() ++ "/src/main.zig");
 
@@ -81,6 +97,11 @@ fn buildLibrary(exe: *std.build.LibExeObjStep, bos: BuildOptionsStep) *std.build
     lib.addCSourceFile(thisDir() ++ "/libs/meshoptimizer/vfetchanalyzer.cpp", &.{""});
     lib.addCSourceFile(thisDir() ++ "/libs/meshoptimizer/overdrawoptimizer.cpp", &.{""});
     lib.addCSourceFile(thisDir() ++ "/libs/meshoptimizer/overdrawanalyzer.cpp", &.{""});
+    lib.addCSourceFile(thisDir() ++ "/libs/meshoptimizer/simplifier.cpp", &.{""});
+    lib.addCSourceFile(thisDir() ++ "/libs/meshoptimizer/spatialorder.cpp", &.{""});
+    lib.addCSourceFile(thisDir() ++ "/libs/meshoptimizer/indexcodec.cpp", &.{""});
+    lib.addCSourceFile(thisDir() ++ "/libs/meshoptimizer/vertexcodec.cpp", &.{""});
+    lib.addCSourceFile(thisDir() ++ "/libs/meshoptimizer/vertexfilter.cpp", &.{""});
     lib.addCSourceFile(thisDir() ++ "/libs/meshoptimizer/allocator.cpp", &.{""});
 
     lib.addIncludeDir(thisDir() ++ "/libs/cgltf");
@@ -0,0 +1,71 @@
+// Read-only memory mapping of a whole file.
+
+const builtin = @import("builtin");
+const std = @import("std");
+const os = std.os;
+
+const MappedFile = @This();
+
+bytes: []align(std.mem.page_size) const u8,
+
+pub fn init(path: []const u8) !MappedFile {
+    const file = try std.fs.cwd().openFile(path, .{});
+    defer file.close();
+    return initFile(file);
+}
+
+/// `file` can be closed after the call.
+pub fn initFile(file: std.fs.File) !MappedFile {
+    const size = std.math.cast(usize, try file.getEndPos()) orelse return error.FileTooBig;
+    if (size == 0) {
+        return MappedFile{ .bytes = @as([*]align(std.mem.page_size) const u8, undefined)[0..0] };
+    }
+
+    if (builtin.os.tag == .windows) {
+        const windows = os.windows;
+        const mapping = CreateFileMappingW(file.handle, null, windows.PAGE_READONLY, 0, 0, null) orelse
+            return windows.unexpectedError(windows.kernel32.GetLastError());
+        // The view keeps the mapping object alive.
+        defer windows.CloseHandle(mapping);
+
+        const ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) orelse
+            return windows.unexpectedError(windows.kernel32.GetLastError());
+        return MappedFile{ .bytes = @ptrCast([*]align(std.mem.page_size) const u8, @alignCast(std.mem.page_size, ptr))[0..size] };
+    }
+
+    const bytes = try os.mmap(null, size, os.PROT.READ, os.MAP.PRIVATE, file.handle, 0);
+    return MappedFile{ .bytes = bytes };
+}
+
+pub fn deinit(mapped: MappedFile) void {
+    if (mapped.bytes.len == 0) return;
+
+    if (builtin.os.tag == .windows) {
+        _ = UnmapViewOfFile(mapped.bytes.ptr);
+    } else {
+        os.munmap(mapped.bytes);
+    }
+}
+
+const FILE_MAP_READ: u32 = 0x0004;
+
+const WINAPI = std.os.windows.WINAPI;
+
+extern "kernel32" fn CreateFileMappingW(
+    file: os.windows.HANDLE,
+    attributes: ?*anyopaque,
+    protect: u32,
+    maximum_size_high: u32,
+    maximum_size_low: u32,
+    name: ?[*:0]const u16,
+) callconv(WINAPI) ?os.windows.HANDLE;
+
+extern "kernel32" fn MapViewOfFile(
+    mapping: os.windows.HANDLE,
+    desired_access: u32,
+    offset_high: u32,
+    offset_low: u32,
+    num_bytes: usize,
+) callconv(WINAPI) ?*anyopaque;
+
+extern "kernel32" fn UnmapViewOfFile(address: *const anyopaque) callconv(WINAPI) os.windows.BOOL;
@@ -0,0 +1,1053 @@
+// Skeletal animation on the CPU: glTF skins and animations converted to compact clips, sampled for many skeleton
+// instances per frame, and linear blend skinning of vertex streams.
+//
+// Clips are resampled at a fixed rate when they are created, so at any time every joint interpolates between the
+// same pair of frames. A frame stores one array per channel (translation x, ..., scale z) and joints are interpolated
+// `lanes` at a time.
+//
+// Conventions (the same as zmath): row vectors (`p * local * parent`), quaternions are (x, y, z, w); glTF
+// (column-major) matrices are used as row-major row-vector matrices.
+
+const std = @import("std");
+const assert = std.debug.assert;
+const cgltf = @import("zcgltf.zig");
+const convert = @import("convert.zig");
+const parallel = @import("parallel.zig");
+
+pub const lanes = 8;
+const F32xN = @Vector(lanes, f32);
+const F32x4 = @Vector(4, f32);
+const Mat = [4][4]f32;
+
+const identity = Mat{
+    .{ 1.0, 0.0, 0.0, 0.0 },
+    .{ 0.0, 1.0, 0.0, 0.0 },
+    .{ 0.0, 0.0, 1.0, 0.0 },
+    .{ 0.0, 0.0, 0.0, 1.0 },
+};
+
+/// Channels of a joint transform, in the order they are stored in clip frames and poses.
+pub const Channel = enum(u32) { tx, ty, tz, rx, ry, rz, rw, sx, sy, sz };
+pub const num_channels = @typeInfo(Channel).Enum.fields.len;
+
+pub const Error = error{OutOfMemory} || convert.Error;
+
+/// Local (relative to the parent) joint transform.
+pub const Transform = struct {
+    translation: [3]f32 = .{ 0.0, 0.0, 0.0 },
+    rotation: [4]f32 = .{ 0.0, 0.0, 0.0, 1.0 },
+    scale: [3]f32 = .{ 1.0, 1.0, 1.0 },
+
+    pub fn fromNode(node: *const cgltf.Node) Transform {
+        if (node.has_matrix != 0) return decompose(node.matrix);
+        var transform = Transform{};
+        if (node.has_translation != 0) transform.translation = node.translation;
+        if (node.has_rotation != 0) transform.rotation = node.rotation;
+        if (node.has_scale != 0) transform.scale = node.scale;
+        return transform;
+    }
+
+    /// Splits an affine (column-major) matrix into translation, rotation and scale; shear is lost.
+    pub fn decompose(m: [16]f32) Transform {
+        var axes = [3][3]f32{ m[0..3].*, m[4..7].*, m[8..11].* };
+        var scale: [3]f32 = undefined;
+        for (axes) |*axis, i| {
+            scale[i] = @sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            if (scale[i] > 0.0) {
+                for (axis) |*v| v.* /= scale[i];
+            }
+        }
+        // Mirroring is folded into the x scale.
+        const det = axes[0][0] * (axes[1][1] * axes[2][2] - axes[1][2] * axes[2][1]) -
+            axes[1][0] * (axes[0][1] * axes[2][2] - axes[0][2] * axes[2][1]) +
+            axes[2][0] * (axes[0][1] * axes[1][2] - axes[0][2] * axes[1][1]);
+        if (det < 0.0) {
+            scale[0] = -scale[0];
+            for (axes[0]) |*v| v.* = -v.*;
+        }
+
+        // `r(row, col)` of the column-vector rotation matrix is `axes[col][row]`.
+        const r = struct {
+            fn get(a: [3][3]f32, row: usize, col: usize) f32 {
+                return a[col][row];
+            }
+        }.get;
+        const trace = r(axes, 0, 0) + r(axes, 1, 1) + r(axes, 2, 2);
+        var q: [4]f32 = undefined;
+        if (trace > 0.0) {
+            const s = @sqrt(trace + 1.0) * 2.0;
+            q = .{
+                (r(axes, 2, 1) - r(axes, 1, 2)) / s,
+                (r(axes, 0, 2) - r(axes, 2, 0)) / s,
+                (r(axes, 1, 0) - r(axes, 0, 1)) / s,
+                0.25 * s,
+            };
+        } else if (r(axes, 0, 0) > r(axes, 1, 1) and r(axes, 0, 0) > r(axes, 2, 2)) {
+            const s = @sqrt(1.0 + r(axes, 0, 0) - r(axes, 1, 1) - r(axes, 2, 2)) * 2.0;
+            q = .{
+                0.25 * s,
+                (r(axes, 0, 1) + r(axes, 1, 0)) / s,
+                (r(axes, 0, 2) + r(axes, 2, 0)) / s,
+                (r(axes, 2, 1) - r(axes, 1, 2)) / s,
+            };
+        } else if (r(axes, 1, 1) > r(axes, 2, 2)) {
+            const s = @sqrt(1.0 + r(axes, 1, 1) - r(axes, 0, 0) - r(axes, 2, 2)) * 2.0;
+            q = .{
+                (r(axes, 0, 1) + r(axes, 1, 0)) / s,
+                0.25 * s,
+                (r(axes, 1, 2) + r(axes, 2, 1)) / s,
+                (r(axes, 0, 2) - r(axes, 2, 0)) / s,
+            };
+        } else {
+            const s = @sqrt(1.0 + r(axes, 2, 2) - r(axes, 0, 0) - r(axes, 1, 1)) * 2.0;
+            q = .{
+                (r(axes, 0, 2) + r(axes, 2, 0)) / s,
+                (r(axes, 1, 2) + r(axes, 2, 1)) / s,
+                0.25 * s,
+                (r(axes, 1, 0) - r(axes, 0, 1)) / s,
+            };
+        }
+        return .{ .translation = m[12..15].*, .rotation = normalize4(q), .scale = scale };
+    }
+};
+
+/// Joint hierarchy of a skin. Joints are sorted so that parents come before their children; `skin_joints` maps them
+/// back to the skin order which skinning matrices and vertex joint indices use.
+pub const Skeleton = struct {
+    num_joints: usize,
+    /// Parent joint of every joint, -1 for roots.
+    parents: []i32,
+    /// Static transform between a joint and its parent joint (nodes in between which aren't joints); for roots, the
+    /// model-space transform of the parent node.
+    parent_offsets: []?Mat,
+    inverse_bind_matrices: []Mat,
+    rest_pose: []Transform,
+    skin_joints: []u32,
+    /// glTF nodes of joints (empty for skeletons made with `init()`).
+    nodes: []*const cgltf.Node,
+
+    /// Joints must be sorted (`parents[i] < i`). Copies all arrays.
+    pub fn init(
+        allocator: std.mem.Allocator,
+        parents: []const i32,
+        inverse_bind_matrices: []const [4][4]f32,
+        rest_pose: []const Transform,
+    ) error{OutOfMemory}!Skeleton {
+        const n = parents.len;
+        assert(inverse_bind_matrices.len == n and rest_pose.len == n);
+        for (parents) |parent, i| assert(parent < @intCast(i32, i));
+
+        const skeleton_parents = try allocator.dupe(i32, parents);
+        errdefer allocator.free(skeleton_parents);
+        const parent_offsets = try allocator.alloc(?Mat, n);
+        errdefer allocator.free(parent_offsets);
+        const skeleton_inverse_bind_matrices = try allocator.dupe(Mat, inverse_bind_matrices);
+        errdefer allocator.free(skeleton_inverse_bind_matrices);
+        const skeleton_rest_pose = try allocator.dupe(Transform, rest_pose);
+        errdefer allocator.free(skeleton_rest_pose);
+        const skin_joints = try allocator.alloc(u32, n);
+        errdefer allocator.free(skin_joints);
+        const nodes = try allocator.alloc(*const cgltf.Node, 0);
+
+        std.mem.set(?Mat, parent_offsets, null);
+        for (skin_joints) |*joint, i| joint.* = @intCast(u32, i);
+
+        return Skeleton{
+            .num_joints = n,
+            .parents = skeleton_parents,
+            .parent_offsets = parent_offsets,
+            .inverse_bind_matrices = skeleton_inverse_bind_matrices,
+            .rest_pose = skeleton_rest_pose,
+            .skin_joints = skin_joints,
+            .nodes = nodes,
+        };
+    }
+
+    pub fn initGltf(allocator: std.mem.Allocator, skin: *const cgltf.Skin) Error!Skeleton {
+        const n = skin.joints_count;
+        const skin_nodes = skin.joints[0..n];
+
+        // Sort joints by their depth in the joint hierarchy (stable, so siblings keep the skin order).
+        const depths = try allocator.alloc(u32, n);
+        defer allocator.free(depths);
+        for (skin_nodes) |node, i| {
+            depths[i] = 0;
+            var ancestor = node.parent;
+            while (ancestor) |a| : (ancestor = a.parent) {
+                if (findNode(skin_nodes, a) != null) depths[i] += 1;
+            }
+        }
+        const order = try allocator.alloc(u32, n);
+        defer allocator.free(order);
+        for (order) |*o, i| o.* = @intCast(u32, i);
+        std.sort.sort(u32, order, depths, struct {
+            fn lessThan(d: []u32, a: u32, b: u32) bool {
+                return d[a] < d[b];
+            }
+        }.lessThan);
+
+        const inverse_bind_matrices = try allocator.alloc(Mat, n);
+        defer allocator.free(inverse_bind_matrices);
+        if (skin.inverse_bind_matrices) |accessor| {
+            if (accessor.count != n) return error.InvalidAccessor;
+            const matrices = try allocator.alloc([16]f32, n);
+            defer allocator.free(matrices);
+            try convert.readAccessor([16]f32, accessor, matrices);
+            for (matrices) |m, i| inverse_bind_matrices[i] = matFromArray(m);
+        } else {
+            std.mem.set(Mat, inverse_bind_matrices, identity);
+        }
+
+        const parents = try allocator.alloc(i32, n);
+        defer allocator.free(parents);
+        const sorted_matrices = try allocator.alloc(Mat, n);
+        defer allocator.free(sorted_matrices);
+        const rest_pose = try allocator.alloc(Transform, n);
+        defer allocator.free(rest_pose);
+        for (order) |skin_joint, i| {
+            sorted_matrices[i] = inverse_bind_matrices[skin_joint];
+            rest_pose[i] = Transform.fromNode(skin_nodes[skin_joint]);
+            parents[i] = -1;
+        }
+
+        var skeleton = try Skeleton.init(allocator, parents, sorted_matrices, rest_pose);
+        errdefer skeleton.deinit(allocator);
+
+        allocator.free(skeleton.nodes);
+        skeleton.nodes = try allocator.alloc(*const cgltf.Node, n);
+        for (order) |skin_joint, i| {
+            skeleton.skin_joints[i] = skin_joint;
+            skeleton.nodes[i] = skin_nodes[skin_joint];
+        }
+
+        // Ancestors of a joint have smaller depths, so they are already in `nodes[0..i]`.
+        for (skeleton.nodes) |node, i| {
+            var offset = identity;
+            var has_offset = false;
+            var ancestor = node.parent;
+            while (ancestor) |a| : (ancestor = a.parent) {
+                if (findNode(skeleton.nodes[0..i], a)) |parent| {
+                    skeleton.parents[i] = @intCast(i32, parent);
+                    break;
+                }
+                offset = mulMat(offset, matFromArray(a.transformLocal()));
+                has_offset = true;
+            }
+            if (has_offset) skeleton.parent_offsets[i] = offset;
+        }
+        return skeleton;
+    }
+
+    pub fn deinit(skeleton: *Skeleton, allocator: std.mem.Allocator) void {
+        allocator.free(skeleton.parents);
+        allocator.free(skeleton.parent_offsets);
+        allocator.free(skeleton.inverse_bind_matrices);
+        allocator.free(skeleton.rest_pose);
+        allocator.free(skeleton.skin_joints);
+        allocator.free(skeleton.nodes);
+        skeleton.* = undefined;
+    }
+
+    pub fn findJoint(skeleton: Skeleton, node: *const cgltf.Node) ?usize {
+        return findNode(skeleton.nodes, node);
+    }
+
+    fn findNode(nodes: []const *const cgltf.Node, node: *const cgltf.Node) ?usize {
+        for (nodes) |n, i| {
+            if (n == node) return i;
+        }
+        return null;
+    }
+};
+
+pub const ClipOptions = struct {
+    /// Frames per second animations are resampled at.
+    sample_rate: f32 = 30.0,
+    /// Store channels as 16-bit values (see `Clip.quantize()`).
+    quantize: bool = false,
+};
+
+/// Animation of one skeleton: `num_frames` frames evenly spaced over `duration` seconds, each frame
+/// `[channel][joint]` with joints padded to `stride` (a multiple of `lanes`). Frames are either `f32` (`frames`) or
+/// quantized (`quantized_frames`, `value = offsets[c] + q * scales[c]` with `c = channel * stride + joint`).
+pub const Clip = struct {
+    num_joints: usize,
+    stride: usize,
+    num_frames: usize,
+    sample_rate: f32,
+    duration: f32,
+    frames: []align(32) f32,
+    quantized_frames: []align(32) u16,
+    offsets: []align(32) f32,
+    scales: []align(32) f32,
+
+    /// Every frame is set to the rest pose of `skeleton`.
+    pub fn init(
+        allocator: std.mem.Allocator,
+        skeleton: *const Skeleton,
+        num_frames: usize,
+        duration: f32,
+    ) error{OutOfMemory}!Clip {
+        assert(num_frames > 0 and duration >= 0.0);
+        const stride = std.mem.alignForward(skeleton.num_joints, lanes);
+
+        var clip = Clip{
+            .num_joints = skeleton.num_joints,
+            .stride = stride,
+            .num_frames = num_frames,
+            .sample_rate = if (num_frames > 1 and duration > 0.0) @intToFloat(f32, num_frames - 1) / duration else 0.0,
+            .duration = duration,
+            .frames = try allocator.alignedAlloc(f32, 32, num_frames * num_channels * stride),
+            .quantized_frames = @as([*]align(32) u16, undefined)[0..0],
+            .offsets = @as([*]align(32) f32, undefined)[0..0],
+            .scales = @as([*]align(32) f32, undefined)[0..0],
+        };
+
+        var frame: usize = 0;
+        while (frame < num_frames) : (frame += 1) {
+            var joint: usize = 0;
+            while (joint < stride) : (joint += 1) {
+                const transform = if (joint < skeleton.num_joints) skeleton.rest_pose[joint] else Transform{};
+                storeTransform(clip.frames[frame * num_channels * stride ..], stride, joint, transform);
+            }
+        }
+        return clip;
+    }
+
+    /// Resamples channels of `animation` which target joints of `skeleton`; joints without channels keep their rest
+    /// pose. Step, linear and cubic spline samplers are supported; `weights` (morph target) channels are skipped.
+    pub fn initGltf(
+        allocator: std.mem.Allocator,
+        skeleton: *const Skeleton,
+        animation: *const cgltf.Animation,
+        options: ClipOptions,
+    ) Error!Clip {
+        const channels = animation.channels[0..animation.channels_count];
+
+        var duration: f32 = 0.0;
+        for (channels) |channel| {
+            if (findChannelJoint(skeleton, channel) == null or channel.sampler.input.count == 0) continue;
+            var last_time: [1]f32 = undefined;
+            if (!channel.sampler.input.readFloat(channel.sampler.input.count - 1, &last_time)) {
+                return error.InvalidAccessor;
+            }
+            duration = std.math.max(duration, last_time[0]);
+        }
+
+        const num_intervals = std.math.max(@floatToInt(usize, @ceil(duration * options.sample_rate)), 1);
+        var clip = try Clip.init(allocator, skeleton, num_intervals + 1, duration);
+        errdefer clip.deinit(allocator);
+
+        for (channels) |channel| {
+            const joint = findChannelJoint(skeleton, channel) orelse continue;
+            switch (channel.target_path) {
+                .translation => try clip.resampleChannel(allocator, 3, channel.sampler, joint, .tx),
+                .rotation => try clip.resampleChannel(allocator, 4, channel.sampler, joint, .rx),
+                .scale => try clip.resampleChannel(allocator, 3, channel.sampler, joint, .sx),
+                else => {},
+            }
+        }
+
+        if (options.quantize) try clip.quantize(allocator);
+        return clip;
+    }
+
+    pub fn deinit(clip: *Clip, allocator: std.mem.Allocator) void {
+        allocator.free(clip.frames);
+        allocator.free(clip.quantized_frames);
+        allocator.free(clip.offsets);
+        allocator.free(clip.scales);
+        clip.* = undefined;
+    }
+
+    pub fn isQuantized(clip: Clip) bool {
+        return clip.quantized_frames.len != 0;
+    }
+
+    /// Only for `f32` clips (before `quantize()`).
+    pub fn setTransform(clip: *Clip, frame: usize, joint: usize, transform: Transform) void {
+        assert(!clip.isQuantized() and frame < clip.num_frames and joint < clip.num_joints);
+        storeTransform(clip.frames[frame * num_channels * clip.stride ..], clip.stride, joint, transform);
+    }
+
+    pub fn getTransform(clip: Clip, frame: usize, joint: usize) Transform {
+        assert(frame < clip.num_frames and joint < clip.num_joints);
+        var values: [num_channels]f32 = undefined;
+        for (values) |*v, channel| {
+            const c = channel * clip.stride + joint;
+            const index = frame * num_channels * clip.stride + c;
+            v.* = if (clip.isQuantized())
+                clip.offsets[c] + @intToFloat(f32, clip.quantized_frames[index]) * clip.scales[c]
+            else
+                clip.frames[index];
+        }
+        return .{ .translation = values[0..3].*, .rotation = values[3..7].*, .scale = values[7..10].* };
+    }
+
+    /// Converts frames to 16 bits per channel: rotations over [-1, 1], translations and scales over the range each
+    /// joint covers in this clip (exact for channels which don't change).
+    pub fn quantize(clip: *Clip, allocator: std.mem.Allocator) error{OutOfMemory}!void {
+        if (clip.isQuantized()) return;
+
+        const stride = clip.stride;
+        const quantized_frames = try allocator.alignedAlloc(u16, 32, clip.frames.len);
+        errdefer allocator.free(quantized_frames);
+        const offsets = try allocator.alignedAlloc(f32, 32, num_channels * stride);
+        errdefer allocator.free(offsets);
+        const scales = try allocator.alignedAlloc(f32, 32, num_channels * stride);
+
+        for (offsets) |*offset, c| {
+            const channel = c / stride;
+            const is_rotation = channel >= @enumToInt(Channel.rx) and channel <= @enumToInt(Channel.rw);
+
+            var min_value: f32 = -1.0;
+            var max_value: f32 = 1.0;
+            if (!is_rotation) {
+                min_value = std.math.inf(f32);
+                max_value = -std.math.inf(f32);
+                var f: usize = 0;
+                while (f < clip.num_frames) : (f += 1) {
+                    const v = clip.frames[f * num_channels * stride + c];
+                    min_value = std.math.min(min_value, v);
+                    max_value = std.math.max(max_value, v);
+                }
+            }
+
+            const range = max_value - min_value;
+            const inv_scale = if (range > 0.0) 65535.0 / range else 0.0;
+            offset.* = min_value;
+            scales[c] = range / 65535.0;
+
+            var frame: usize = 0;
+            while (frame < clip.num_frames) : (frame += 1) {
+                const index = frame * num_channels * stride + c;
+                const q = @round((clip.frames[index] - min_value) * inv_scale);
+                quantized_frames[index] = @floatToInt(u16, std.math.clamp(q, 0.0, 65535.0));
+            }
+        }
+
+        allocator.free(clip.frames);
+        clip.frames = @as([*]align(32) f32, undefined)[0..0];
+        clip.quantized_frames = quantized_frames;
+        clip.offsets = offsets;
+        clip.scales = scales;
+    }
+
+    fn resampleChannel(
+        clip: *Clip,
+        allocator: std.mem.Allocator,
+        comptime N: usize,
+        sampler: *const cgltf.AnimationSampler,
+        joint: usize,
+        first_channel: Channel,
+    ) Error!void {
+        const times = try allocator.alloc(f32, sampler.input.count);
+        defer allocator.free(times);
+        try convert.readAccessor(f32, sampler.input, times);
+
+        const values = try allocator.alloc([N]f32, sampler.output.count);
+        defer allocator.free(values);
+        try convert.readAccessor([N]f32, sampler.output, values);
+
+        const keys_per_time: usize = if (sampler.interpolation == .cubic_spline) 3 else 1;
+        if (times.len == 0 or values.len < times.len * keys_per_time) return error.InvalidAccessor;
+
+        var cursor: usize = 0;
+        var previous: [N]f32 = undefined;
+        var frame: usize = 0;
+        while (frame < clip.num_frames) : (frame += 1) {
+            const time = if (clip.sample_rate > 0.0) @intToFloat(f32, frame) / clip.sample_rate else 0.0;
+            var value = evaluateSampler(N, times, values, sampler.interpolation, time, &cursor);
+            if (N == 4) {
+                // Consecutive frames in the same hemisphere: runtime interpolation takes the short path and
+                // quantization doesn't see sign flips.
+                value = normalize4(value);
+                if (frame > 0 and dot4(previous, value) < 0.0) {
+                    for (value) |*v| v.* = -v.*;
+                }
+                previous = value;
+            }
+            for (value) |v, k| {
+                const channel = @enumToInt(first_channel) + k;
+                clip.frames[(frame * num_channels + channel) * clip.stride + joint] = v;
+            }
+        }
+    }
+
+    fn findChannelJoint(skeleton: *const Skeleton, channel: cgltf.AnimationChannel) ?usize {
+        return skeleton.findJoint(channel.target_node orelse return null);
+    }
+};
+
+/// Local transforms of one skeleton instance (`[channel][joint]`, as in clip frames) and its model-space joint
+/// matrices (skeleton joint order).
+pub const Pose = struct {
+    stride: usize,
+    locals: []align(32) f32,
+    model: [][4][4]f32,
+
+    /// Starts in the rest pose.
+    pub fn init(allocator: std.mem.Allocator, skeleton: *const Skeleton) error{OutOfMemory}!Pose {
+        const stride = std.mem.alignForward(skeleton.num_joints, lanes);
+        const locals = try allocator.alignedAlloc(f32, 32, num_channels * stride);
+        errdefer allocator.free(locals);
+        const model = try allocator.alloc(Mat, skeleton.num_joints);
+
+        var pose = Pose{ .stride = stride, .locals = locals, .model = model };
+        var joint: usize = 0;
+        while (joint < stride) : (joint += 1) {
+            const transform = if (joint < skeleton.num_joints) skeleton.rest_pose[joint] else Transform{};
+            storeTransform(locals, stride, joint, transform);
+        }
+        computeModelMatrices(skeleton, &pose);
+        return pose;
+    }
+
+    pub fn deinit(pose: *Pose, allocator: std.mem.Allocator) void {
+        allocator.free(pose.locals);
+        allocator.free(pose.model);
+        pose.* = undefined;
+    }
+
+    pub fn getLocal(pose: Pose, joint: usize) Transform {
+        assert(joint < pose.model.len);
+        return loadTransform(pose.locals, pose.stride, joint);
+    }
+
+    pub fn setLocal(pose: *Pose, joint: usize, transform: Transform) void {
+        assert(joint < pose.model.len);
+        storeTransform(pose.locals, pose.stride, joint, transform);
+    }
+};
+
+/// Samples `clip` at `time` seconds (wrapped when `looping`, clamped otherwise) into local transforms of `pose`.
+/// Translations and scales are interpolated linearly, rotations with a corrected nlerp that stays within 0.001
+/// radians of slerp.
+pub fn sample(clip: *const Clip, time: f32, looping: bool, pose: *Pose) void {
+    assert(pose.stride == clip.stride);
+
+    var t = time;
+    if (looping and clip.duration > 0.0) t = @mod(t, clip.duration);
+    t = std.math.clamp(t, 0.0, clip.duration);
+
+    const position = t * clip.sample_rate;
+    const last_frame = clip.num_frames - 1;
+    const frame0 = std.math.min(@floatToInt(usize, position), last_frame);
+    const frame1 = std.math.min(frame0 + 1, last_frame);
+    const alpha = position - @intToFloat(f32, frame0);
+
+    if (clip.isQuantized()) {
+        sampleFrames(true, clip, frame0, frame1, alpha, pose);
+    } else {
+        sampleFrames(false, clip, frame0, frame1, alpha, pose);
+    }
+}
+
+fn sampleFrames(
+    comptime quantized: bool,
+    clip: *const Clip,
+    frame0: usize,
+    frame1: usize,
+    alpha: f32,
+    pose: *Pose,
+) void {
+    const a = @splat(lanes, alpha);
+    var joint: usize = 0;
+    while (joint < clip.stride) : (joint += lanes) {
+        inline for ([_]Channel{ .tx, .ty, .tz, .sx, .sy, .sz }) |channel| {
+            const v0 = loadLanes(quantized, clip, frame0, channel, joint);
+            const v1 = loadLanes(quantized, clip, frame1, channel, joint);
+            pose.locals[@enumToInt(channel) * clip.stride + joint ..][0..lanes].* = v0 + (v1 - v0) * a;
+        }
+
+        var q0: [4]F32xN = undefined;
+        var q1: [4]F32xN = undefined;
+        inline for ([_]Channel{ .rx, .ry, .rz, .rw }) |channel, k| {
+            q0[k] = loadLanes(quantized, clip, frame0, channel, joint);
+            q1[k] = loadLanes(quantized, clip, frame1, channel, joint);
+        }
+        const q = slerpLanes(q0, q1, alpha);
+        inline for ([_]Channel{ .rx, .ry, .rz, .rw }) |channel, k| {
+            pose.locals[@enumToInt(channel) * clip.stride + joint ..][0..lanes].* = q[k];
+        }
+    }
+}
+
+inline fn loadLanes(
+    comptime quantized: bool,
+    clip: *const Clip,
+    frame: usize,
+    comptime channel: Channel,
+    joint: usize,
+) F32xN {
+    const c = @enumToInt(channel) * clip.stride + joint;
+    const index = frame * num_channels * clip.stride + c;
+    if (!quantized) return clip.frames[index..][0..lanes].*;
+
+    var values: [lanes]f32 = undefined;
+    for (clip.quantized_frames[index..][0..lanes]) |q, k| values[k] = @intToFloat(f32, q);
+    const offsets: F32xN = clip.offsets[c..][0..lanes].*;
+    const scales: F32xN = clip.scales[c..][0..lanes].*;
+    return @as(F32xN, values) * scales + offsets;
+}
+
+/// Interpolates `lanes` quaternions at once. nlerp with the time correction fitted to slerp by A. Kapoulkine
+/// ("Approximating slerp"); no trigonometric functions, so it vectorizes.
+fn slerpLanes(q0: [4]F32xN, q1: [4]F32xN, t: f32) [4]F32xN {
+    const zero = @splat(lanes, @as(f32, 0.0));
+    const one = @splat(lanes, @as(f32, 1.0));
+
+    const cos_omega = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3];
+    const sign = @select(f32, cos_omega < zero, -one, one);
+    const d = cos_omega * sign;
+
+    const ka = @splat(lanes, @as(f32, 1.0904)) + d * (@splat(lanes, @as(f32, -3.2452)) +
+        d * (@splat(lanes, @as(f32, 3.55645)) - d * @splat(lanes, @as(f32, 1.43519))));
+    const kb = @splat(lanes, @as(f32, 0.848013)) + d * (@splat(lanes, @as(f32, -1.06021)) +
+        d * @splat(lanes, @as(f32, 0.215638)));
+    const k = ka * @splat(lanes, (t - 0.5) * (t - 0.5)) + kb;
+    const ot = @splat(lanes, t) + @splat(lanes, t * (t - 0.5) * (t - 1.0)) * k;
+
+    const s0 = one - ot;
+    const s1 = ot * sign;
+    var q: [4]F32xN = undefined;
+    for (q) |*v, i| v.* = q0[i] * s0 + q1[i] * s1;
+    const inv_len = one / @sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (q) |*v| v.* *= inv_len;
+    return q;
+}
+
+/// Model-space matrices (`pose.model`) from local transforms of `pose`.
+pub fn computeModelMatrices(skeleton: *const Skeleton, pose: *Pose) void {
+    const n = skeleton.num_joints;
+    assert(pose.model.len == n);
+
+    composeMatrices(pose.locals, pose.stride, 0, n, pose.model);
+
+    for (pose.model) |*model, i| {
+        var local = model.*;
+        if (skeleton.parent_offsets[i]) |offset| local = mulMat(local, offset);
+        const parent = skeleton.parents[i];
+        model.* = if (parent >= 0) mulMat(local, pose.model[@intCast(usize, parent)]) else local;
+    }
+}
+
+/// Local matrices (scale * rotation * translation) of transforms `first..last` stored as `[channel][index]` arrays
+/// `stride` apart (a multiple of `lanes`); `out[i]` receives the matrix of transform `first + i`. Transforms are
+/// converted `lanes` at a time.
+pub fn composeMatrices(channels: []const f32, stride: usize, first: usize, last: usize, out: [][4][4]f32) void {
+    assert(stride % lanes == 0 and last <= stride and out.len >= last - first);
+
+    const Load = struct {
+        fn channel(c: []const f32, s: usize, comptime ch: Channel, index: usize) F32xN {
+            return c[@enumToInt(ch) * s + index ..][0..lanes].*;
+        }
+    };
+    const one = @splat(lanes, @as(f32, 1.0));
+    const two = @splat(lanes, @as(f32, 2.0));
+
+    var group = first - first % lanes;
+    while (group < last) : (group += lanes) {
+        const x = Load.channel(channels, stride, .rx, group);
+        const y = Load.channel(channels, stride, .ry, group);
+        const z = Load.channel(channels, stride, .rz, group);
+        const w = Load.channel(channels, stride, .rw, group);
+        const sx = Load.channel(channels, stride, .sx, group);
+        const sy = Load.channel(channels, stride, .sy, group);
+        const sz = Load.channel(channels, stride, .sz, group);
+
+        const m: [9][lanes]f32 = .{
+            (one - two * (y * y + z * z)) * sx,
+            two * (x * y + z * w) * sx,
+            two * (x * z - y * w) * sx,
+            two * (x * y - z * w) * sy,
+            (one - two * (x * x + z * z)) * sy,
+            two * (y * z + x * w) * sy,
+            two * (x * z + y * w) * sz,
+            two * (y * z - x * w) * sz,
+            (one - two * (x * x + y * y)) * sz,
+        };
+        const t: [3][lanes]f32 = .{
+            Load.channel(channels, stride, .tx, group),
+            Load.channel(channels, stride, .ty, group),
+            Load.channel(channels, stride, .tz, group),
+        };
+
+        var lane = std.math.max(first, group) - group;
+        const end = std.math.min(group + lanes, last) - group;
+        while (lane < end) : (lane += 1) {
+            out[group + lane - first] = .{
+                .{ m[0][lane], m[1][lane], m[2][lane], 0.0 },
+                .{ m[3][lane], m[4][lane], m[5][lane], 0.0 },
+                .{ m[6][lane], m[7][lane], m[8][lane], 0.0 },
+                .{ t[0][lane], t[1][lane], t[2][lane], 1.0 },
+            };
+        }
+    }
+}
+
+/// `out[skin joint] = inverse bind matrix * model matrix`, in skin joint order (what vertex joint indices refer to).
+pub fn computeSkinningMatrices(skeleton: *const Skeleton, pose: *const Pose, out: [][4][4]f32) void {
+    assert(out.len >= skeleton.num_joints);
+    for (pose.model) |model, i| {
+        out[skeleton.skin_joints[i]] = mulMat(skeleton.inverse_bind_matrices[i], model);
+    }
+}
+
+pub const Instance = struct {
+    clip: *const Clip,
+    time: f32,
+    looping: bool = true,
+    pose: *Pose,
+    /// Receives skinning matrices when set.
+    skinning_matrices: ?[][4][4]f32 = null,
+};
+
+/// Samples clips and computes model (and skinning) matrices of `instances` of `skeleton` on up to `num_threads`
+/// threads (0 - one per CPU).
+pub fn animate(skeleton: *const Skeleton, instances: []const Instance, num_threads: u32) void {
+    const chunk_size = 16;
+
+    const Context = struct {
+        skeleton: *const Skeleton,
+        instances: []const Instance,
+
+        fn animateChunk(context: *const @This(), index: usize) void {
+            const first = index * chunk_size;
+            const last = std.math.min(first + chunk_size, context.instances.len);
+            for (context.instances[first..last]) |instance| {
+                sample(instance.clip, instance.time, instance.looping, instance.pose);
+                computeModelMatrices(context.skeleton, instance.pose);
+                if (instance.skinning_matrices) |out| computeSkinningMatrices(context.skeleton, instance.pose, out);
+            }
+        }
+    };
+
+    const context = Context{ .skeleton = skeleton, .instances = instances };
+    parallel.forEach((instances.len + chunk_size - 1) / chunk_size, num_threads, &context, Context.animateChunk);
+}
+
+/// Vertex streams of a skinned mesh. `joints` index skinning matrices, `weights` of a vertex sum to 1.
+pub const SkinnedMesh = struct {
+    positions: []const [3]f32,
+    normals: ?[]const [3]f32 = null,
+    joints: []const [4]u16,
+    weights: []const [4]f32,
+};
+
+/// Linear blend skinning of `mesh` into `out_positions` (and `out_normals` when the mesh has normals) on up to
+/// `num_threads` threads (0 - one per CPU). Normals are transformed by the blended matrix and renormalized, which is
+/// exact for rotations and uniform scales.
+pub fn skinVertices(
+    mesh: SkinnedMesh,
+    skinning_matrices: []const [4][4]f32,
+    out_positions: [][3]f32,
+    out_normals: ?[][3]f32,
+    num_threads: u32,
+) void {
+    const n = mesh.positions.len;
+    assert(mesh.joints.len == n and mesh.weights.len == n and out_positions.len >= n);
+    if (mesh.normals) |normals| assert(normals.len == n and out_normals.?.len >= n);
+
+    const chunk_size = 4 * 1024;
+
+    const Context = struct {
+        mesh: SkinnedMesh,
+        matrices: []const Mat,
+        out_positions: [][3]f32,
+        out_normals: ?[][3]f32,
+
+        fn skinChunk(context: *const @This(), index: usize) void {
+            const first = index * chunk_size;
+            const last = std.math.min(first + chunk_size, context.mesh.positions.len);
+            skinRange(context.mesh, context.matrices, first, last, context.out_positions, context.out_normals);
+        }
+    };
+
+    const context = Context{
+        .mesh = mesh,
+        .matrices = skinning_matrices,
+        .out_positions = out_positions,
+        .out_normals = out_normals,
+    };
+    parallel.forEach((n + chunk_size - 1) / chunk_size, num_threads, &context, Context.skinChunk);
+}
+
+fn skinRange(
+    mesh: SkinnedMesh,
+    matrices: []const Mat,
+    first: usize,
+    last: usize,
+    out_positions: [][3]f32,
+    out_normals: ?[][3]f32,
+) void {
+    var i = first;
+    while (i < last) : (i += 1) {
+        const joints = mesh.joints[i];
+        const weights = mesh.weights[i];
+
+        var rows = [_]F32x4{@splat(4, @as(f32, 0.0))} ** 4;
+        comptime var k = 0;
+        inline while (k < 4) : (k += 1) {
+            const m = &matrices[joints[k]];
+            const weight = @splat(4, weights[k]);
+            inline for (rows) |*row, r| row.* += weight * @as(F32x4, m[r]);
+        }
+
+        const p = mesh.positions[i];
+        const position = @splat(4, p[0]) * rows[0] + @splat(4, p[1]) * rows[1] + @splat(4, p[2]) * rows[2] + rows[3];
+        out_positions[i] = .{ position[0], position[1], position[2] };
+
+        if (mesh.normals) |normals| {
+            const nv = normals[i];
+            const normal = @splat(4, nv[0]) * rows[0] + @splat(4, nv[1]) * rows[1] + @splat(4, nv[2]) * rows[2];
+            const len_sq = @reduce(.Add, normal * normal);
+            const scale = if (len_sq > 0.0) 1.0 / @sqrt(len_sq) else 0.0;
+            out_normals.?[i] = .{ normal[0] * scale, normal[1] * scale, normal[2] * scale };
+        }
+    }
+}
+
+/// Writes `transform` to `[channel][index]` arrays `stride` apart.
+pub fn storeTransform(channels: []f32, stride: usize, index: usize, transform: Transform) void {
+    const t = transform.translation;
+    const r = transform.rotation;
+    const s = transform.scale;
+    const values = [num_channels]f32{ t[0], t[1], t[2], r[0], r[1], r[2], r[3], s[0], s[1], s[2] };
+    for (values) |v, channel| channels[channel * stride + index] = v;
+}
+
+pub fn loadTransform(channels: []const f32, stride: usize, index: usize) Transform {
+    var values: [num_channels]f32 = undefined;
+    for (values) |*v, channel| v.* = channels[channel * stride + index];
+    return .{ .translation = values[0..3].*, .rotation = values[3..7].*, .scale = values[7..10].* };
+}
+
+fn evaluateSampler(
+    comptime N: usize,
+    times: []const f32,
+    values: []const [N]f32,
+    interpolation: cgltf.InterpolationType,
+    time: f32,
+    cursor: *usize,
+) [N]f32 {
+    const cubic = interpolation == .cubic_spline;
+    const last = times.len - 1;
+    if (last == 0 or time <= times[0]) return values[if (cubic) 1 else 0];
+    if (time >= times[last]) return values[if (cubic) last * 3 + 1 else last];
+
+    // `times[k] <= time < times[k + 1]`; sample times only increase, so the search continues from the last key.
+    var k = cursor.*;
+    while (times[k + 1] <= time) k += 1;
+    cursor.* = k;
+
+    const dt = times[k + 1] - times[k];
+    const u = if (dt > 0.0) (time - times[k]) / dt else 0.0;
+    var result: [N]f32 = undefined;
+    switch (interpolation) {
+        .step => result = values[k],
+        .linear => {
+            if (N == 4) return slerp(values[k], values[k + 1], u);
+            for (result) |*r, c| r.* = values[k][c] + (values[k + 1][c] - values[k][c]) * u;
+        },
+        .cubic_spline => {
+            // Hermite spline over (in-tangent, value, out-tangent) triplets.
+            const p0 = values[k * 3 + 1];
+            const m0 = values[k * 3 + 2];
+            const p1 = values[(k + 1) * 3 + 1];
+            const m1 = values[(k + 1) * 3];
+            const u2 = u * u;
+            const u3 = u2 * u;
+            const h00 = 2.0 * u3 - 3.0 * u2 + 1.0;
+            const h10 = (u3 - 2.0 * u2 + u) * dt;
+            const h01 = -2.0 * u3 + 3.0 * u2;
+            const h11 = (u3 - u2) * dt;
+            for (result) |*r, c| r.* = h00 * p0[c] + h10 * m0[c] + h01 * p1[c] + h11 * m1[c];
+        },
+    }
+    return result;
+}
+
+fn slerp(q0: [4]f32, q1: [4]f32, t: f32) [4]f32 {
+    var cos_omega = dot4(q0, q1);
+    var sign: f32 = 1.0;
+    if (cos_omega < 0.0) {
+        cos_omega = -cos_omega;
+        sign = -1.0;
+    }
+    var s0 = 1.0 - t;
+    var s1 = t;
+    if (cos_omega < 1.0 - 0.00001) {
+        const omega = std.math.acos(cos_omega);
+        const sin_omega = @sin(omega);
+        s0 = @sin(s0 * omega) / sin_omega;
+        s1 = @sin(t * omega) / sin_omega;
+    }
+    s1 *= sign;
+    return normalize4(.{
+        q0[0] * s0 + q1[0] * s1,
+        q0[1] * s0 + q1[1] * s1,
+        q0[2] * s0 + q1[2] * s1,
+        q0[3] * s0 + q1[3] * s1,
+    });
+}
+
+fn dot4(a: [4]f32, b: [4]f32) f32 {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+}
+
+fn normalize4(q: [4]f32) [4]f32 {
+    const len = @sqrt(dot4(q, q));
+    if (len == 0.0) return .{ 0.0, 0.0, 0.0, 1.0 };
+    return .{ q[0] / len, q[1] / len, q[2] / len, q[3] / len };
+}
+
+/// glTF matrix (`cgltf.Node.transformLocal()`, `transformWorld()`, inverse bind matrices) as a row-major matrix.
+pub fn matFromArray(m: [16]f32) Mat {
+    return .{ m[0..4].*, m[4..8].*, m[8..12].*, m[12..16].* };
+}
+
+/// `a * b` (row vectors: `a` is applied first).
+pub fn mulMat(a: Mat, b: Mat) Mat {
+    const b0: F32x4 = b[0];
+    const b1: F32x4 = b[1];
+    const b2: F32x4 = b[2];
+    const b3: F32x4 = b[3];
+    var result: Mat = undefined;
+    for (a) |row, i| {
+        result[i] = @splat(4, row[0]) * b0 + @splat(4, row[1]) * b1 + @splat(4, row[2]) * b2 + @splat(4, row[3]) * b3;
+    }
+    return result;
+}
+
+const expect = std.testing.expect;
+
+fn expectApproxEq(a: []const f32, b: []const f32, tolerance: f32) !void {
+    for (a) |v, i| try expect(std.math.approxEqAbs(f32, v, b[i], tolerance));
+}
+
+test "zmesh.animation.sample_skin" {
+    const allocator = std.testing.allocator;
+
+    // Two-joint chain along +y; joint 1 turns 90 degrees about z over one second.
+    const half_sqrt2 = @sqrt(0.5);
+    const rest = [_]Transform{ .{}, .{ .translation = .{ 0.0, 2.0, 0.0 } } };
+    var inverse_bind = [2]Mat{ identity, identity };
+    inverse_bind[1][3][1] = -2.0;
+
+    var skeleton = try Skeleton.init(allocator, &.{ -1, 0 }, &inverse_bind, &rest);
+    defer skeleton.deinit(allocator);
+
+    var clip = try Clip.init(allocator, &skeleton, 2, 1.0);
+    defer clip.deinit(allocator);
+    clip.setTransform(1, 1, .{ .translation = .{ 0.0, 2.0, 0.0 }, .rotation = .{ 0.0, 0.0, half_sqrt2, half_sqrt2 } });
+
+    var pose = try Pose.init(allocator, &skeleton);
+    defer pose.deinit(allocator);
+
+    // Corrected nlerp halfway is within 0.001 radians of the exact 45 degree rotation.
+    sample(&clip, 0.5, false, &pose);
+    const half = std.math.pi / 8.0;
+    try expectApproxEq(&pose.getLocal(1).rotation, &[_]f32{ 0.0, 0.0, @sin(half), @cos(half) }, 0.0005);
+
+    sample(&clip, 1.0, false, &pose);
+    computeModelMatrices(&skeleton, &pose);
+    try expectApproxEq(&pose.model[1][0], &[_]f32{ 0.0, 1.0, 0.0, 0.0 }, 0.0001);
+    try expectApproxEq(&pose.model[1][3], &[_]f32{ 0.0, 2.0, 0.0, 1.0 }, 0.0001);
+
+    // A vertex 1 unit above joint 1, fully bound to it, swings to -x.
+    var skinning_matrices: [2]Mat = undefined;
+    computeSkinningMatrices(&skeleton, &pose, &skinning_matrices);
+    var positions: [1][3]f32 = undefined;
+    var normals: [1][3]f32 = undefined;
+    skinVertices(.{
+        .positions = &.{.{ 0.0, 3.0, 0.0 }},
+        .normals = &.{.{ 1.0, 0.0, 0.0 }},
+        .joints = &.{.{ 1, 0, 0, 0 }},
+        .weights = &.{.{ 1.0, 0.0, 0.0, 0.0 }},
+    }, &skinning_matrices, &positions, &normals, 1);
+    try expectApproxEq(&positions[0], &[_]f32{ -1.0, 2.0, 0.0 }, 0.0001);
+    try expectApproxEq(&normals[0], &[_]f32{ 0.0, 1.0, 0.0 }, 0.0001);
+
+    // Quantized clip, many instances on several threads.
+    try clip.quantize(allocator);
+    try expect(clip.isQuantized());
+    try expectApproxEq(&clip.getTransform(1, 1).rotation, &[_]f32{ 0.0, 0.0, half_sqrt2, half_sqrt2 }, 0.0001);
+    try expectApproxEq(&clip.getTransform(0, 1).translation, &rest[1].translation, 0.0);
+
+    var poses: [40]Pose = undefined;
+    var instances: [40]Instance = undefined;
+    var num_poses: usize = 0;
+    defer {
+        for (poses[0..num_poses]) |*p| p.deinit(allocator);
+    }
+    for (instances) |*instance, i| {
+        poses[i] = try Pose.init(allocator, &skeleton);
+        num_poses += 1;
+        instance.* = .{ .clip = &clip, .time = 2.0 + @intToFloat(f32, i) / 40.0, .pose = &poses[i] };
+    }
+    animate(&skeleton, &instances, 4);
+    for (instances) |instance| {
+        var expected = try Pose.init(allocator, &skeleton);
+        defer expected.deinit(allocator);
+        sample(&clip, instance.time, true, &expected);
+        computeModelMatrices(&skeleton, &expected);
+        for (expected.model[1]) |row, r| try expectApproxEq(&instance.pose.model[1][r], &row, 0.0);
+    }
+}
+
+test "zmesh.animation.gltf" {
+    const allocator = std.testing.allocator;
+
+    // Armature node (translated by +y) -> joint A -> joint B (+2 y). The skin lists B before A. Joint A turns 90
+    // degrees about z over one second.
+    const half_sqrt2 = @sqrt(0.5);
+    const times = [2]f32{ 0.0, 1.0 };
+    const rotations = [2][4]f32{ .{ 0.0, 0.0, 0.0, 1.0 }, .{ 0.0, 0.0, half_sqrt2, half_sqrt2 } };
+    var bin: [40]u8 = undefined;
+    std.mem.copy(u8, bin[0..8], std.mem.sliceAsBytes(times[0..]));
+    std.mem.copy(u8, bin[8..40], std.mem.sliceAsBytes(rotations[0..]));
+
+    var base64: [std.base64.standard.Encoder.calcSize(bin.len)]u8 = undefined;
+    const json = try std.fmt.allocPrint(allocator,
+        \\{{"asset":{{"version":"2.0"}},
+        \\"buffers":[{{"uri":"data:application/octet-stream;base64,{s}","byteLength":40}}],
+        \\"bufferViews":[{{"buffer":0,"byteLength":8}},{{"buffer":0,"byteOffset":8,"byteLength":32}}],
+        \\"accessors":[{{"bufferView":0,"componentType":5126,"count":2,"type":"SCALAR"}},
+        \\{{"bufferView":1,"componentType":5126,"count":2,"type":"VEC4"}}],
+        \\"nodes":[{{"translation":[0,1,0],"children":[1]}},{{"children":[2]}},{{"translation":[0,2,0]}}],
+        \\"skins":[{{"joints":[2,1]}}],
+        \\"animations":[{{"samplers":[{{"input":0,"output":1}}],
+        \\"channels":[{{"sampler":0,"target":{{"node":1,"path":"rotation"}}}}]}}]}}
+    , .{std.base64.standard.Encoder.encode(&base64, &bin)});
+    defer allocator.free(json);
+
+    const data = try cgltf.parse(.{}, json);
+    defer cgltf.free(data);
+    try cgltf.loadBuffers(.{}, data, "");
+
+    var skeleton = try Skeleton.initGltf(allocator, &data.skins.?[0]);
+    defer skeleton.deinit(allocator);
+    try expect(skeleton.num_joints == 2);
+    try expect(std.mem.eql(i32, skeleton.parents, &[_]i32{ -1, 0 }));
+    try expect(std.mem.eql(u32, skeleton.skin_joints, &[_]u32{ 1, 0 }));
+    try expect(skeleton.parent_offsets[0] != null and skeleton.parent_offsets[1] == null);
+
+    for ([_]bool{ false, true }) |quantize| {
+        var clip = try Clip.initGltf(allocator, &skeleton, &data.animations.?[0], .{ .quantize = quantize });
+        defer clip.deinit(allocator);
+        try expect(clip.num_frames == 31 and clip.duration == 1.0);
+
+        var pose = try Pose.init(allocator, &skeleton);
+        defer pose.deinit(allocator);
+        sample(&clip, 1.0, false, &pose);
+        computeModelMatrices(&skeleton, &pose);
+
+        // Joint B: armature (0, 1, 0) + (0, 2, 0) turned to -x.
+        try expectApproxEq(&pose.model[1][3], &[_]f32{ -2.0, 1.0, 0.0, 1.0 }, 0.0005);
+
+        var skinning_matrices: [2]Mat = undefined;
+        computeSkinningMatrices(&skeleton, &pose, &skinning_matrices);
+        try expectApproxEq(&skinning_matrices[0][3], &pose.model[1][3], 0.0);
+    }
+}
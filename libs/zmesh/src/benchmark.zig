@@ -0,0 +1,952 @@
+// -------------------------------------------------------------------------------------------------
+// zmesh - benchmarks
+// -------------------------------------------------------------------------------------------------
+// 'zig build benchmark' in the root project directory will build and run 'ReleaseFast' configuration.
+//
+// Multi-threaded allocation benchmarks: the same total amount of work is split between 1, 2, 4, ...
+// threads. All par_shapes and meshoptimizer allocations go through zmesh allocation bridge, so
+// with a contended bridge the time does not go down as threads are added.
+//
+// shape alloc: create and destroy small par_shapes meshes (almost only malloc/realloc/free)
+// mesh processing: generate, unweld and compute normals for a sphere, optimize it for vertex cache
+//
+// mesh decode: 1M vertex grid (positions, normals, texcoords) stored as raw float arrays vs.
+// `zmesh.codec` container. 'raw copy' is the cost of getting uncompressed data from memory (page
+// cache); decode throughput is reported for the decoded (output) bytes, compression ratio shows how
+// much less data has to come from disk.
+//
+// meshlet culling: 1M random meshlet bounds, frustum + normal cone tests. 'scalar' is a plain loop
+// over `zmesh.opt.Bounds` structs, 'simd' is `zmesh.culling.cull()` over SoA bounds, 'simd + hi-z'
+// adds occlusion against a 1024x1024 depth pyramid, 'views' culls 4 views with `cullViews()` on all
+// threads.
+//
+// spatial sort: 1M instances (position, radius, 64-byte transform) in random order vs. reordered
+// with `zmesh.opt.spatialSortArrays()`. 'cull' is `zmesh.culling.cull()` with Hi-Z (whole groups of
+// 8 are rejected early when neighbours are close to each other), 'iterate' reads the transforms
+// of all visible instances through the visible index list.
+//
+// skeletal animation: 4096 instances of a 64-joint skeleton playing a 2 second clip, sampled into
+// skinning matrices with `zmesh.animation.animate()` on 1 and on all threads, from f32 and from
+// quantized (16-bit) frames. 'skinning' is `skinVertices()` over 1M vertices with 4 weights each.
+//
+// scene transforms: world matrices of a 100K-node glTF hierarchy (3 children per node, 11 levels).
+// 'per node' is `cgltf.Node.transformWorld()` for every node (walks the parent chain), 'scene' is
+// `zmesh.scene.Scene.computeWorldMatrices()` (one pass over depth-sorted nodes), 'levels' is
+// `computeWorldMatricesParallel()` on all threads, 'dirty' is `update()` after moving 1% of nodes.
+//
+// shape build: 128 spheres and 128 cubes, scaled and translated, merged into one mesh. 'par_shapes'
+// creates, transforms and merges `zmesh.Shape` meshes one by one, 'shapes' is
+// `zmesh.shapes.buildAlloc()` (counted up front, generated in place, one arena per build).
+//
+// morph targets: 64 instances of a 20K-vertex mesh with 64 targets (each moving a window of at most
+// 1500 vertices), 8 targets active per instance, weights change every frame. 'dense' adds full
+// f32 delta arrays over all vertices, 'sparse' is `zmesh.morph.blendInstances()` on 1 and on all
+// threads (16-bit deltas of the moved vertex ranges only).
+// -------------------------------------------------------------------------------------------------
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    zmesh.init(allocator);
+    defer zmesh.deinit();
+
+    const max_num_threads = std.math.min(try std.Thread.getCpuCount(), 16);
+
+    try runBenchmark("shape alloc", shapeAllocWorker, 200_000, max_num_threads);
+    try runBenchmark("mesh processing", meshProcessingWorker, 400, max_num_threads);
+
+    try meshDecodeBenchmark(allocator, 1024);
+    try meshletCullBenchmark(allocator, 1_000_000);
+    try spatialSortBenchmark(allocator, 1_000_000);
+    try animationBenchmark(allocator, 4096, 1_000_000, @intCast(u32, max_num_threads));
+    try sceneTransformBenchmark(allocator, 100_000);
+    try shapeBuildBenchmark(allocator, 256);
+    try morphBenchmark(allocator, 20_000, 64, 64, @intCast(u32, max_num_threads));
+}
+
+const std = @import("std");
+const time = std.time;
+const Timer = time.Timer;
+const zmesh = @import("zmesh");
+
+fn runBenchmark(
+    comptime name: []const u8,
+    comptime worker: fn (u32) void,
+    comptime num_iterations: u32,
+    max_num_threads: usize,
+) !void {
+    var threads: [16]std.Thread = undefined;
+    var single_thread_time: u64 = 0;
+
+    var num_threads: usize = 1;
+    while (num_threads <= max_num_threads) : (num_threads *= 2) {
+        const iterations_per_thread = @intCast(u32, num_iterations / num_threads);
+
+        var timer = try Timer.start();
+        for (threads[0..num_threads]) |*thread| {
+            thread.* = try std.Thread.spawn(.{}, worker, .{iterations_per_thread});
+        }
+        for (threads[0..num_threads]) |thread| thread.join();
+        const elapsed = timer.read();
+
+        if (num_threads == 1) single_thread_time = elapsed;
+
+        std.debug.print("{s:>42} - {d:>2} thread(s): {d:.2}ms (speedup {d:.2}x)\n", .{
+            name,
+            num_threads,
+            @intToFloat(f64, elapsed) / time.ns_per_ms,
+            @intToFloat(f64, single_thread_time) / @intToFloat(f64, elapsed),
+        });
+    }
+}
+
+fn shapeAllocWorker(num_iterations: u32) void {
+    var i: u32 = 0;
+    while (i < num_iterations) : (i += 1) {
+        var cube = zmesh.Shape.initCube();
+        const tetrahedron = zmesh.Shape.initTetrahedron();
+        cube.merge(tetrahedron);
+        tetrahedron.deinit();
+        cube.deinit();
+    }
+}
+
+fn meshProcessingWorker(num_iterations: u32) void {
+    var indices: [64 * 64 * 6]u32 = undefined;
+    var optimized_indices: [64 * 64 * 6]u32 = undefined;
+
+    var i: u32 = 0;
+    while (i < num_iterations) : (i += 1) {
+        var sphere = zmesh.Shape.initParametricSphere(64, 64);
+        defer sphere.deinit();
+        sphere.unweld();
+        sphere.computeNormals();
+
+        const num_indices = std.math.min(sphere.indices.len, indices.len);
+        for (sphere.indices[0..num_indices]) |index, j| indices[j] = index;
+
+        zmesh.opt.optimizeVertexCache(
+            optimized_indices[0..num_indices],
+            indices[0..num_indices],
+            sphere.positions.len,
+        );
+    }
+}
+
+noinline fn meshDecodeBenchmark(allocator: std.mem.Allocator, comptime grid_size: comptime_int) !void {
+    const vertex_count = grid_size * grid_size;
+
+    const positions = try allocator.alloc([3]f32, vertex_count);
+    defer allocator.free(positions);
+    const normals = try allocator.alloc([3]f32, vertex_count);
+    defer allocator.free(normals);
+    const texcoords = try allocator.alloc([2]f32, vertex_count);
+    defer allocator.free(texcoords);
+    var indices = std.ArrayList(u32).init(allocator);
+    defer indices.deinit();
+    {
+        var z: u32 = 0;
+        while (z < grid_size) : (z += 1) {
+            var x: u32 = 0;
+            while (x < grid_size) : (x += 1) {
+                const i = z * grid_size + x;
+                const fx = @intToFloat(f32, x) / grid_size;
+                const fz = @intToFloat(f32, z) / grid_size;
+                const h = @sin(fx * 20.0) * @cos(fz * 15.0) * 0.05;
+                positions[i] = .{ fx, h, fz };
+                const nx = -@cos(fx * 20.0) * @cos(fz * 15.0);
+                const nz = @sin(fx * 20.0) * @sin(fz * 15.0) * 0.75;
+                const l = @sqrt(nx * nx + 1.0 + nz * nz);
+                normals[i] = .{ nx / l, 1.0 / l, nz / l };
+                texcoords[i] = .{ fx, fz };
+            }
+        }
+        z = 0;
+        while (z < grid_size - 1) : (z += 1) {
+            var x: u32 = 0;
+            while (x < grid_size - 1) : (x += 1) {
+                const i = z * grid_size + x;
+                try indices.appendSlice(&.{ i, i + grid_size, i + 1, i + 1, i + grid_size, i + grid_size + 1 });
+            }
+        }
+    }
+
+    const bytes = try zmesh.codec.encode(allocator, indices.items, vertex_count, &.{
+        zmesh.codec.VertexStream.initRaw([3]f32, positions),
+        zmesh.codec.VertexStream.initNormals(normals, 12),
+        zmesh.codec.VertexStream.initExponential(2, texcoords, 16),
+    });
+    defer allocator.free(bytes);
+
+    const raw_size = indices.items.len * 4 + vertex_count * (12 + 12 + 8);
+    const decoded_size = indices.items.len * 4 + vertex_count * (12 + 8 + 8);
+
+    const raw = try allocator.alloc(u8, raw_size);
+    defer allocator.free(raw);
+    @memset(raw.ptr, 0x55, raw.len);
+    const raw_copy = try allocator.alloc(u8, raw_size);
+    defer allocator.free(raw_copy);
+
+    const out_indices = try allocator.alloc(u32, indices.items.len);
+    defer allocator.free(out_indices);
+    const out_positions = try allocator.alloc([3]f32, vertex_count);
+    defer allocator.free(out_positions);
+    const out_normals = try allocator.alloc([4]i16, vertex_count);
+    defer allocator.free(out_normals);
+    const out_texcoords = try allocator.alloc([2]f32, vertex_count);
+    defer allocator.free(out_texcoords);
+
+    const num_iterations = 10;
+
+    var copy_time: u64 = 0;
+    var decode_time: u64 = 0;
+    var iteration: u32 = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        var timer = try Timer.start();
+        @memcpy(raw_copy.ptr, raw.ptr, raw.len);
+        copy_time += timer.lap();
+
+        const decoder = try zmesh.codec.Decoder.init(bytes);
+        try decoder.decodeIndices(u32, out_indices);
+        try decoder.decodeStream(0, std.mem.sliceAsBytes(out_positions));
+        try decoder.decodeStream(1, std.mem.sliceAsBytes(out_normals));
+        try decoder.decodeStream(2, std.mem.sliceAsBytes(out_texcoords));
+        decode_time += timer.read();
+    }
+
+    const gb = 1024.0 * 1024.0 * 1024.0;
+    std.debug.print("{s:>42} - raw {d} MB, compressed {d} MB ({d:.2}x)\n", .{
+        "mesh decode",
+        raw_size / (1024 * 1024),
+        bytes.len / (1024 * 1024),
+        @intToFloat(f64, raw_size) / @intToFloat(f64, bytes.len),
+    });
+    std.debug.print("{s:>42} - raw copy: {d:.2} GB/s, decode: {d:.2} GB/s\n", .{
+        "mesh decode",
+        @intToFloat(f64, raw_size * num_iterations) / gb / (@intToFloat(f64, copy_time) / time.ns_per_s),
+        @intToFloat(f64, decoded_size * num_iterations) / gb / (@intToFloat(f64, decode_time) / time.ns_per_s),
+    });
+}
+
+noinline fn meshletCullBenchmark(allocator: std.mem.Allocator, comptime num_meshlets: comptime_int) !void {
+    const culling = zmesh.culling;
+
+    const aos_bounds = try allocator.alloc(zmesh.opt.Bounds, num_meshlets);
+    defer allocator.free(aos_bounds);
+    var bounds = try culling.MeshletBounds.init(allocator, num_meshlets);
+    defer bounds.deinit(allocator);
+    {
+        var prng = std.rand.DefaultPrng.init(0);
+        const random = prng.random();
+        for (aos_bounds) |*b, i| {
+            b.* = std.mem.zeroes(zmesh.opt.Bounds);
+            b.center = .{
+                random.float(f32) * 200.0 - 100.0,
+                random.float(f32) * 200.0 - 100.0,
+                random.float(f32) * 200.0 - 100.0,
+            };
+            b.radius = 0.25 + random.float(f32) * 0.5;
+            var axis = [3]f32{ random.float(f32) - 0.5, random.float(f32) - 0.5, random.float(f32) - 0.5 };
+            const l = @sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            for (axis) |*a| a.* /= l;
+            b.cone_axis = axis;
+            b.cone_cutoff = 0.3 + random.float(f32) * 0.6;
+            bounds.set(i, b.*);
+        }
+    }
+
+    // 90 degree fov camera at the origin looking along +z (near 0.1, far 100).
+    const projection = [4][4]f32{
+        .{ 1.0, 0.0, 0.0, 0.0 },
+        .{ 0.0, 1.0, 0.0, 0.0 },
+        .{ 0.0, 0.0, 100.0 / 99.9, 1.0 },
+        .{ 0.0, 0.0, -10.0 / 99.9, 0.0 },
+    };
+    var view = culling.View{
+        .planes = culling.extractFrustumPlanes(projection),
+        .camera_position = .{ 0.0, 0.0, 0.0 },
+    };
+
+    var pyramid = try culling.DepthPyramid.init(allocator, 1024, 1024);
+    defer pyramid.deinit(allocator);
+    {
+        // Wall at depth 50 covering the left half of the screen.
+        const depth = try allocator.alloc(f32, 1024 * 1024);
+        defer allocator.free(depth);
+        for (depth) |*d, i| d.* = if (i % 1024 < 512) 50.0 else std.math.inf(f32);
+        pyramid.update(depth);
+    }
+
+    const num_views = 4;
+    const visible = try allocator.alloc(u32, num_meshlets * num_views);
+    defer allocator.free(visible);
+
+    const num_iterations = 10;
+    var count: usize = 0;
+    var timer = try Timer.start();
+
+    var iteration: u32 = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        count = meshletCullScalar(aos_bounds, view.planes, visible);
+    }
+    const scalar_time = timer.lap();
+    const scalar_count = count;
+
+    iteration = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        count = culling.cull(&bounds, view, visible[0..num_meshlets]);
+    }
+    const simd_time = timer.lap();
+    if (count != scalar_count) return error.MeshletCullMismatch;
+
+    view.occlusion = .{
+        .view = .{
+            .{ 1.0, 0.0, 0.0, 0.0 },
+            .{ 0.0, 1.0, 0.0, 0.0 },
+            .{ 0.0, 0.0, 1.0, 0.0 },
+            .{ 0.0, 0.0, 0.0, 1.0 },
+        },
+        .projection_scale = .{ 1.0, 1.0 },
+        .z_near = 0.1,
+        .pyramid = &pyramid,
+    };
+    _ = timer.lap();
+    iteration = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        count = culling.cull(&bounds, view, visible[0..num_meshlets]);
+    }
+    const hiz_time = timer.lap();
+    const hiz_count = count;
+
+    var views: [num_views]culling.View = undefined;
+    var visible_per_view: [num_views][]u32 = undefined;
+    for (views) |*v, i| {
+        v.* = view;
+        visible_per_view[i] = visible[i * num_meshlets ..][0..num_meshlets];
+    }
+    var counts: [num_views]usize = undefined;
+    _ = timer.lap();
+    iteration = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        try culling.cullViews(allocator, &bounds, views[0..], visible_per_view[0..], counts[0..], 0);
+    }
+    const views_time = timer.lap();
+    if (counts[num_views - 1] != hiz_count) return error.MeshletCullMismatch;
+
+    const meshlets_per_ms = struct {
+        fn get(n: usize, t: u64) f64 {
+            return @intToFloat(f64, n * num_iterations) / (@intToFloat(f64, t) / time.ns_per_ms);
+        }
+    }.get;
+    std.debug.print("{s:>42} - {d} visible, {d} visible with hi-z\n", .{ "meshlet culling", scalar_count, hiz_count });
+    std.debug.print("{s:>42} - scalar: {d:.2}ms, simd: {d:.2}ms ({d:.0} meshlets/ms), simd + hi-z: {d:.2}ms\n", .{
+        "meshlet culling",
+        @intToFloat(f64, scalar_time) / time.ns_per_ms / num_iterations,
+        @intToFloat(f64, simd_time) / time.ns_per_ms / num_iterations,
+        meshlets_per_ms(num_meshlets, simd_time),
+        @intToFloat(f64, hiz_time) / time.ns_per_ms / num_iterations,
+    });
+    std.debug.print("{s:>42} - {d} views: {d:.2}ms ({d:.0} meshlets/ms)\n", .{
+        "meshlet culling",
+        num_views,
+        @intToFloat(f64, views_time) / time.ns_per_ms / num_iterations,
+        meshlets_per_ms(num_meshlets * num_views, views_time),
+    });
+}
+
+fn meshletCullScalar(bounds: []const zmesh.opt.Bounds, planes: [6][4]f32, visible: []u32) usize {
+    var count: usize = 0;
+    for (bounds) |b, i| {
+        const c = b.center;
+        var inside = true;
+        for (planes) |p| {
+            if (p[0] * c[0] + p[1] * c[1] + p[2] * c[2] + p[3] + b.radius < 0.0) inside = false;
+        }
+        // Camera at the origin.
+        const len = @sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+        const d = c[0] * b.cone_axis[0] + c[1] * b.cone_axis[1] + c[2] * b.cone_axis[2];
+        if (inside and d <= b.cone_cutoff * len + b.radius) {
+            visible[count] = @intCast(u32, i);
+            count += 1;
+        }
+    }
+    return count;
+}
+
+noinline fn spatialSortBenchmark(allocator: std.mem.Allocator, comptime num_instances: comptime_int) !void {
+    const culling = zmesh.culling;
+
+    const positions = try allocator.alloc([3]f32, num_instances);
+    defer allocator.free(positions);
+    const radii = try allocator.alloc(f32, num_instances);
+    defer allocator.free(radii);
+    const transforms = try allocator.alloc([16]f32, num_instances);
+    defer allocator.free(transforms);
+    {
+        var prng = std.rand.DefaultPrng.init(0);
+        const random = prng.random();
+        for (positions) |*p, i| {
+            p.* = .{
+                random.float(f32) * 200.0 - 100.0,
+                random.float(f32) * 200.0 - 100.0,
+                random.float(f32) * 200.0 - 100.0,
+            };
+            radii[i] = 0.25 + random.float(f32) * 0.5;
+            transforms[i] = [_]f32{0.0} ** 16;
+            transforms[i][0] = 1.0;
+            transforms[i][5] = 1.0;
+            transforms[i][10] = 1.0;
+            transforms[i][15] = 1.0;
+            transforms[i][12] = p[0];
+            transforms[i][13] = p[1];
+            transforms[i][14] = p[2];
+        }
+    }
+
+    var bounds = try culling.MeshletBounds.init(allocator, num_instances);
+    defer bounds.deinit(allocator);
+    const visible = try allocator.alloc(u32, num_instances);
+    defer allocator.free(visible);
+
+    var pyramid = try culling.DepthPyramid.init(allocator, 1024, 1024);
+    defer pyramid.deinit(allocator);
+    {
+        const depth = try allocator.alloc(f32, 1024 * 1024);
+        defer allocator.free(depth);
+        for (depth) |*d, i| d.* = if (i % 1024 < 512) 50.0 else std.math.inf(f32);
+        pyramid.update(depth);
+    }
+    const identity = [4][4]f32{
+        .{ 1.0, 0.0, 0.0, 0.0 },
+        .{ 0.0, 1.0, 0.0, 0.0 },
+        .{ 0.0, 0.0, 1.0, 0.0 },
+        .{ 0.0, 0.0, 0.0, 1.0 },
+    };
+    const view = culling.View{
+        .planes = culling.extractFrustumPlanes(.{
+            .{ 1.0, 0.0, 0.0, 0.0 },
+            .{ 0.0, 1.0, 0.0, 0.0 },
+            .{ 0.0, 0.0, 100.0 / 99.9, 1.0 },
+            .{ 0.0, 0.0, -10.0 / 99.9, 0.0 },
+        }),
+        .camera_position = .{ 0.0, 0.0, 0.0 },
+        .cone_culling = false,
+        .occlusion = .{ .view = identity, .projection_scale = .{ 1.0, 1.0 }, .z_near = 0.1, .pyramid = &pyramid },
+    };
+
+    const num_iterations = 10;
+    var cull_times: [2]u64 = undefined;
+    var iterate_times: [2]u64 = undefined;
+    var sort_time: u64 = 0;
+
+    for (cull_times) |*cull_time, pass| {
+        if (pass == 1) {
+            var timer = try Timer.start();
+            try zmesh.opt.spatialSortArrays(allocator, [3]f32, positions, .{ positions, radii, transforms });
+            sort_time = timer.read();
+        }
+
+        for (positions) |p, i| {
+            var b = std.mem.zeroes(zmesh.opt.Bounds);
+            b.center = p;
+            b.radius = radii[i];
+            bounds.set(i, b);
+        }
+
+        var count: usize = 0;
+        var timer = try Timer.start();
+        var iteration: u32 = 0;
+        while (iteration < num_iterations) : (iteration += 1) {
+            count = culling.cull(&bounds, view, visible);
+        }
+        cull_time.* = timer.lap();
+
+        var sum: f32 = 0.0;
+        iteration = 0;
+        while (iteration < num_iterations) : (iteration += 1) {
+            for (visible[0..count]) |index| {
+                const t = &transforms[index];
+                sum += t[12] + t[13] + t[14] + t[0];
+            }
+        }
+        iterate_times[pass] = timer.lap();
+        std.mem.doNotOptimizeAway(&sum);
+    }
+
+    const ms = struct {
+        fn get(t: u64) f64 {
+            return @intToFloat(f64, t) / time.ns_per_ms / num_iterations;
+        }
+    }.get;
+    std.debug.print("{s:>42} - sort: {d:.2}ms\n", .{ "spatial sort", @intToFloat(f64, sort_time) / time.ns_per_ms });
+    std.debug.print("{s:>42} - cull: {d:.2}ms -> {d:.2}ms ({d:.2}x), iterate: {d:.2}ms -> {d:.2}ms ({d:.2}x)\n", .{
+        "spatial sort",
+        ms(cull_times[0]),
+        ms(cull_times[1]),
+        @intToFloat(f64, cull_times[0]) / @intToFloat(f64, cull_times[1]),
+        ms(iterate_times[0]),
+        ms(iterate_times[1]),
+        @intToFloat(f64, iterate_times[0]) / @intToFloat(f64, iterate_times[1]),
+    });
+}
+
+noinline fn animationBenchmark(
+    allocator: std.mem.Allocator,
+    comptime num_instances: comptime_int,
+    comptime num_vertices: comptime_int,
+    max_num_threads: u32,
+) !void {
+    const animation = zmesh.animation;
+    const num_joints = 64;
+
+    var prng = std.rand.DefaultPrng.init(0);
+    const random = prng.random();
+
+    // Spine with a branch every 8 joints.
+    var parents: [num_joints]i32 = undefined;
+    var inverse_bind_matrices: [num_joints][4][4]f32 = undefined;
+    var rest_pose: [num_joints]animation.Transform = undefined;
+    for (parents) |*parent, i| {
+        parent.* = if (i == 0) -1 else @intCast(i32, if (i % 8 == 0) i / 2 else i - 1);
+        inverse_bind_matrices[i] = .{
+            .{ 1.0, 0.0, 0.0, 0.0 },
+            .{ 0.0, 1.0, 0.0, 0.0 },
+            .{ 0.0, 0.0, 1.0, 0.0 },
+            .{ 0.0, -0.1 * @intToFloat(f32, i), 0.0, 1.0 },
+        };
+        rest_pose[i] = .{ .translation = .{ 0.0, 0.1, 0.0 } };
+    }
+    var skeleton = try animation.Skeleton.init(allocator, &parents, &inverse_bind_matrices, &rest_pose);
+    defer skeleton.deinit(allocator);
+
+    var clips: [2]animation.Clip = undefined;
+    clips[0] = try animation.Clip.init(allocator, &skeleton, 61, 2.0);
+    defer clips[0].deinit(allocator);
+    {
+        var frame: usize = 0;
+        while (frame < clips[0].num_frames) : (frame += 1) {
+            for (rest_pose) |rest, joint| {
+                const angle = 0.5 * (random.float(f32) - 0.5);
+                var transform = rest;
+                transform.rotation = .{ @sin(angle) * 0.6, @sin(angle) * 0.8, 0.0, @cos(angle) };
+                clips[0].setTransform(frame, joint, transform);
+            }
+        }
+    }
+    clips[1] = try animation.Clip.init(allocator, &skeleton, clips[0].num_frames, clips[0].duration);
+    defer clips[1].deinit(allocator);
+    std.mem.copy(f32, clips[1].frames, clips[0].frames);
+    try clips[1].quantize(allocator);
+
+    const poses = try allocator.alloc(animation.Pose, num_instances);
+    defer allocator.free(poses);
+    var num_poses: usize = 0;
+    defer {
+        for (poses[0..num_poses]) |*pose| pose.deinit(allocator);
+    }
+    while (num_poses < num_instances) : (num_poses += 1) {
+        poses[num_poses] = try animation.Pose.init(allocator, &skeleton);
+    }
+    const skinning_matrices = try allocator.alloc([4][4]f32, num_instances * num_joints);
+    defer allocator.free(skinning_matrices);
+
+    const instances = try allocator.alloc(animation.Instance, num_instances);
+    defer allocator.free(instances);
+
+    const num_iterations = 10;
+    const num_bones = num_instances * num_joints * num_iterations;
+    for (clips) |*clip| {
+        for ([_]u32{ 1, max_num_threads }) |num_threads| {
+            var timer = try Timer.start();
+            var iteration: u32 = 0;
+            while (iteration < num_iterations) : (iteration += 1) {
+                for (instances) |*instance, i| {
+                    instance.* = .{
+                        .clip = clip,
+                        .time = @intToFloat(f32, iteration) / 60.0 + @intToFloat(f32, i) * 0.01,
+                        .pose = &poses[i],
+                        .skinning_matrices = skinning_matrices[i * num_joints ..][0..num_joints],
+                    };
+                }
+                animation.animate(&skeleton, instances, num_threads);
+            }
+            const elapsed = timer.read();
+            std.debug.print("{s:>42} - {s}, {d:>2} thread(s): {d:.2}ms ({d:.0} bones/ms)\n", .{
+                "skeletal animation",
+                if (clip.isQuantized()) "quantized" else "f32",
+                num_threads,
+                @intToFloat(f64, elapsed) / time.ns_per_ms / num_iterations,
+                @intToFloat(f64, num_bones) / (@intToFloat(f64, elapsed) / time.ns_per_ms),
+            });
+        }
+    }
+
+    const positions = try allocator.alloc([3]f32, num_vertices);
+    defer allocator.free(positions);
+    const normals = try allocator.alloc([3]f32, num_vertices);
+    defer allocator.free(normals);
+    const joints = try allocator.alloc([4]u16, num_vertices);
+    defer allocator.free(joints);
+    const weights = try allocator.alloc([4]f32, num_vertices);
+    defer allocator.free(weights);
+    for (positions) |*p, i| {
+        p.* = .{ random.float(f32), random.float(f32) * 6.4, random.float(f32) };
+        normals[i] = .{ 0.0, 0.0, 1.0 };
+        const bone = @floatToInt(u16, p[1] * 10.0) % num_joints;
+        joints[i] = .{ bone, (bone + 1) % num_joints, (bone + 2) % num_joints, (bone + 3) % num_joints };
+        const w = random.float(f32);
+        weights[i] = .{ 0.4 + 0.4 * w, 0.5 - 0.4 * w, 0.07, 0.03 };
+    }
+    const out_positions = try allocator.alloc([3]f32, num_vertices);
+    defer allocator.free(out_positions);
+    const out_normals = try allocator.alloc([3]f32, num_vertices);
+    defer allocator.free(out_normals);
+
+    for ([_]u32{ 1, max_num_threads }) |num_threads| {
+        var timer = try Timer.start();
+        var iteration: u32 = 0;
+        while (iteration < num_iterations) : (iteration += 1) {
+            animation.skinVertices(.{
+                .positions = positions,
+                .normals = normals,
+                .joints = joints,
+                .weights = weights,
+            }, skinning_matrices[0..num_joints], out_positions, out_normals, num_threads);
+        }
+        const elapsed = timer.read();
+        std.debug.print("{s:>42} - {d:>2} thread(s): {d:.2}ms ({d:.0} vertices/ms)\n", .{
+            "skinning",
+            num_threads,
+            @intToFloat(f64, elapsed) / time.ns_per_ms / num_iterations,
+            @intToFloat(f64, num_vertices * num_iterations) / (@intToFloat(f64, elapsed) / time.ns_per_ms),
+        });
+    }
+}
+
+noinline fn sceneTransformBenchmark(allocator: std.mem.Allocator, comptime num_nodes: comptime_int) !void {
+    const cgltf = zmesh.io.cgltf;
+
+    var json = std.ArrayList(u8).init(allocator);
+    defer json.deinit();
+    {
+        var prng = std.rand.DefaultPrng.init(0);
+        const random = prng.random();
+        const writer = json.writer();
+        try writer.writeAll("{\"asset\":{\"version\":\"2.0\"},\"nodes\":[");
+        var i: usize = 0;
+        while (i < num_nodes) : (i += 1) {
+            const angle = random.float(f32);
+            try writer.print("{s}{{\"translation\":[{d:.3},1,0],\"rotation\":[0,{d:.4},0,{d:.4}]", .{
+                if (i == 0) "" else ",",
+                random.float(f32),
+                @sin(angle),
+                @cos(angle),
+            });
+            if (3 * i + 1 < num_nodes) {
+                try writer.print(",\"children\":[{d}", .{3 * i + 1});
+                var child = 3 * i + 2;
+                while (child < std.math.min(3 * i + 4, num_nodes)) : (child += 1) try writer.print(",{d}", .{child});
+                try writer.writeAll("]");
+            }
+            try writer.writeAll("}");
+        }
+        try writer.writeAll("]}");
+    }
+
+    const data = try cgltf.parse(.{}, json.items);
+    defer cgltf.free(data);
+    const nodes = data.nodes.?[0..data.nodes_count];
+
+    const num_iterations = 10;
+    var sum: f32 = 0.0;
+
+    var timer = try Timer.start();
+    var iteration: u32 = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        for (nodes) |node| sum += node.transformWorld()[12];
+    }
+    const per_node_time = timer.lap();
+
+    var scene = try zmesh.scene.Scene.initGltf(allocator, data);
+    defer scene.deinit(allocator);
+    const init_time = timer.lap();
+
+    iteration = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        scene.computeWorldMatrices();
+        sum += scene.world[scene.len - 1][3][0];
+    }
+    const scene_time = timer.lap();
+
+    iteration = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        scene.computeWorldMatricesParallel(0);
+        sum += scene.world[scene.len - 1][3][0];
+    }
+    const levels_time = timer.lap();
+
+    var prng = std.rand.DefaultPrng.init(1);
+    const random = prng.random();
+    var dirty_time: u64 = 0;
+    iteration = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        var moved: usize = 0;
+        while (moved < num_nodes / 100) : (moved += 1) {
+            const node = random.uintLessThan(usize, scene.len);
+            var transform = scene.getLocal(node);
+            transform.translation[1] += 0.01;
+            scene.setLocal(node, transform);
+        }
+        _ = timer.lap();
+        scene.update();
+        dirty_time += timer.lap();
+        sum += scene.world[scene.len - 1][3][0];
+    }
+    std.mem.doNotOptimizeAway(&sum);
+
+    const ms = struct {
+        fn get(t: u64) f64 {
+            return @intToFloat(f64, t) / time.ns_per_ms / num_iterations;
+        }
+    }.get;
+    std.debug.print("{s:>42} - {d} levels, flatten: {d:.2}ms\n", .{
+        "scene transforms",
+        scene.numLevels(),
+        @intToFloat(f64, init_time) / time.ns_per_ms,
+    });
+    std.debug.print("{s:>42} - per node: {d:.2}ms, scene: {d:.2}ms ({d:.2}x), levels: {d:.2}ms, dirty: {d:.2}ms\n", .{
+        "scene transforms",
+        ms(per_node_time),
+        ms(scene_time),
+        @intToFloat(f64, per_node_time) / @intToFloat(f64, scene_time),
+        ms(levels_time),
+        ms(dirty_time),
+    });
+}
+
+noinline fn shapeBuildBenchmark(allocator: std.mem.Allocator, comptime num_shapes: comptime_int) !void {
+    const slices = 16;
+    const stacks = 12;
+    const num_iterations = 100;
+
+    var items: [num_shapes]zmesh.shapes.Item = undefined;
+    for (items) |*item, i| {
+        const x = @intToFloat(f32, i % 16);
+        const y = @intToFloat(f32, i / 16);
+        item.* = .{
+            .primitive = if (i % 2 == 0) .{ .sphere = .{ .slices = slices, .stacks = stacks } } else .cube,
+            .transform = .{
+                .{ 0.5, 0.0, 0.0, 0.0 },
+                .{ 0.0, 0.5, 0.0, 0.0 },
+                .{ 0.0, 0.0, 0.5, 0.0 },
+                .{ x, y, 0.0, 1.0 },
+            },
+        };
+    }
+    var sum: f32 = 0.0;
+
+    var timer = try Timer.start();
+    var iteration: u32 = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        var scene = zmesh.Shape.initCube();
+        defer scene.deinit();
+        for (items) |item| {
+            var shape = switch (item.primitive) {
+                .cube => zmesh.Shape.initCube(),
+                else => zmesh.Shape.initParametricSphere(slices, stacks),
+            };
+            defer shape.deinit();
+            if (item.primitive == .cube) shape.computeNormals();
+            shape.scale(0.5, 0.5, 0.5);
+            shape.translate(item.transform[3][0], item.transform[3][1], 0.0);
+            scene.merge(shape);
+        }
+        sum += scene.positions[scene.positions.len - 1][0];
+    }
+    const par_shapes_time = timer.lap();
+
+    iteration = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        var arena_state = std.heap.ArenaAllocator.init(allocator);
+        defer arena_state.deinit();
+        const mesh = try zmesh.shapes.buildAlloc(arena_state.allocator(), &items, .{ .texcoords = false });
+        sum += mesh.positions[mesh.positions.len - 1][0];
+    }
+    const build_time = timer.lap();
+    std.mem.doNotOptimizeAway(&sum);
+
+    const ms = struct {
+        fn get(t: u64) f64 {
+            return @intToFloat(f64, t) / time.ns_per_ms / num_iterations;
+        }
+    }.get;
+    const counts = zmesh.shapes.count(&items);
+    std.debug.print("{s:>42} - {d} vertices, {d} indices ({s})\n", .{
+        "shape build",
+        counts.vertex_count,
+        counts.index_count,
+        @tagName(counts.indexFormat()),
+    });
+    std.debug.print("{s:>42} - par_shapes: {d:.3}ms, shapes: {d:.3}ms ({d:.2}x)\n", .{
+        "shape build",
+        ms(par_shapes_time),
+        ms(build_time),
+        @intToFloat(f64, par_shapes_time) / @intToFloat(f64, build_time),
+    });
+}
+
+noinline fn morphBenchmark(
+    allocator: std.mem.Allocator,
+    comptime num_vertices: comptime_int,
+    comptime num_targets: comptime_int,
+    comptime num_instances: comptime_int,
+    num_threads: u32,
+) !void {
+    const num_active = 8;
+    const num_frames = 10;
+
+    var prng = std.rand.DefaultPrng.init(0);
+    const random = prng.random();
+
+    const base_positions = try allocator.alloc([3]f32, num_vertices);
+    defer allocator.free(base_positions);
+    const base_normals = try allocator.alloc([3]f32, num_vertices);
+    defer allocator.free(base_normals);
+    for (base_positions) |*p, i| {
+        p.* = .{ random.float(f32), random.float(f32), random.float(f32) };
+        base_normals[i] = .{ 0.0, 0.0, 1.0 };
+    }
+
+    // Every target moves 80% of the vertices of a random window of 200 - 1500 vertices (like facial blend shapes).
+    const dense = try allocator.alloc([num_vertices][3]f32, 2 * num_targets);
+    defer allocator.free(dense);
+    var position_deltas: [num_targets][]const [3]f32 = undefined;
+    var normal_deltas: [num_targets][]const [3]f32 = undefined;
+    for (position_deltas) |*deltas, t| {
+        const positions = &dense[2 * t];
+        const normals = &dense[2 * t + 1];
+        std.mem.set([3]f32, positions, .{ 0.0, 0.0, 0.0 });
+        std.mem.set([3]f32, normals, .{ 0.0, 0.0, 0.0 });
+        const len = 200 + random.uintLessThan(usize, 1300);
+        const first = random.uintLessThan(usize, num_vertices - len);
+        for (positions[first..][0..len]) |*d, i| {
+            if (random.float(f32) < 0.2) continue;
+            d.* = .{ random.float(f32) * 0.01, random.float(f32) * 0.01, random.float(f32) * 0.01 };
+            normals[first + i] = .{ random.float(f32) * 0.1, 0.0, 0.0 };
+        }
+        deltas.* = positions;
+        normal_deltas[t] = normals;
+    }
+
+    var timer = try Timer.start();
+    var morph = try zmesh.morph.Morph.init(
+        allocator,
+        base_positions,
+        base_normals,
+        &position_deltas,
+        &normal_deltas,
+        .{},
+    );
+    defer morph.deinit(allocator);
+    const init_time = timer.lap();
+
+    var instances: [num_instances]zmesh.morph.Instance = undefined;
+    var num_initialized: usize = 0;
+    defer {
+        for (instances[0..num_initialized]) |*instance| instance.deinit(allocator);
+    }
+    for (instances) |*instance| {
+        instance.* = try zmesh.morph.Instance.init(allocator, &morph);
+        num_initialized += 1;
+    }
+
+    const Frame = struct {
+        fn setWeights(all: []zmesh.morph.Instance, frame: usize) void {
+            for (all) |instance, i| {
+                var k: usize = 0;
+                while (k < num_active) : (k += 1) {
+                    const t = (i * 7 + k * 13) % num_targets;
+                    instance.weights[t] = 0.5 + 0.5 * @sin(@intToFloat(f32, frame + k) * 0.3);
+                }
+            }
+        }
+    };
+
+    // Dense: every active target adds its deltas to all vertices.
+    const out_positions = try allocator.alloc([3]f32, num_vertices);
+    defer allocator.free(out_positions);
+    const out_normals = try allocator.alloc([3]f32, num_vertices);
+    defer allocator.free(out_normals);
+    var sum: f32 = 0.0;
+
+    _ = timer.lap();
+    var frame: usize = 0;
+    while (frame < num_frames) : (frame += 1) {
+        Frame.setWeights(&instances, frame);
+        for (instances) |instance| {
+            std.mem.copy([3]f32, out_positions, base_positions);
+            std.mem.copy([3]f32, out_normals, base_normals);
+            for (instance.weights) |weight, t| {
+                if (weight == 0.0) continue;
+                for (out_positions) |*p, v| {
+                    for (p) |*c, k| c.* += weight * dense[2 * t][v][k];
+                }
+                for (out_normals) |*n, v| {
+                    for (n) |*c, k| c.* += weight * dense[2 * t + 1][v][k];
+                }
+            }
+            sum += out_positions[num_vertices / 2][0];
+        }
+    }
+    const dense_time = timer.lap();
+
+    frame = 0;
+    while (frame < num_frames) : (frame += 1) {
+        Frame.setWeights(&instances, frame);
+        _ = timer.lap();
+        zmesh.morph.blendInstances(&morph, &instances, 1);
+        sum += instances[0].positions[num_vertices / 2][0];
+    }
+    const sparse_time = timer.lap();
+
+    frame = 0;
+    while (frame < num_frames) : (frame += 1) {
+        Frame.setWeights(&instances, frame + 1);
+        _ = timer.lap();
+        zmesh.morph.blendInstances(&morph, &instances, num_threads);
+        sum += instances[0].positions[num_vertices / 2][0];
+    }
+    const threads_time = timer.lap();
+    std.mem.doNotOptimizeAway(&sum);
+
+    var num_affected: usize = 0;
+    for (morph.targets) |target| num_affected += target.num_vertices;
+    const dense_bytes = 2 * num_targets * num_vertices * @sizeOf([3]f32);
+    const sparse_bytes = morph.deltas.len * @sizeOf(u16) + morph.ranges.len * @sizeOf(zmesh.morph.Range);
+
+    const ms = struct {
+        fn get(t: u64) f64 {
+            return @intToFloat(f64, t) / time.ns_per_ms / num_frames;
+        }
+    }.get;
+    std.debug.print("{s:>42} - {d} targets, {d:.1}% of vertices each, dense: {d:.1}MB, " ++
+        "sparse: {d:.1}MB (init: {d:.2}ms)\n", .{
+        "morph targets",
+        num_targets,
+        100.0 * @intToFloat(f64, num_affected) / @intToFloat(f64, num_targets * num_vertices),
+        @intToFloat(f64, dense_bytes) / (1024 * 1024),
+        @intToFloat(f64, sparse_bytes) / (1024 * 1024),
+        @intToFloat(f64, init_time) / time.ns_per_ms,
+    });
+    std.debug.print("{s:>42} - {d} instances: dense: {d:.2}ms, sparse: {d:.2}ms ({d:.2}x), {d} threads: {d:.2}ms\n", .{
+        "morph targets",
+        num_instances,
+        ms(dense_time),
+        ms(sparse_time),
+        @intToFloat(f64, dense_time) / @intToFloat(f64, sparse_time),
+        num_threads,
+        ms(threads_time),
+    });
+}
@@ -0,0 +1,490 @@
+// Persistent cache of processed meshes.
+//
+// A cache file holds everything needed to use a mesh without processing it again (vertex streams, indices, LOD
+// chain, meshlets and their bounds). Data is stored uncompressed, so `load()` maps the file and returns slices that
+// point straight into the mapping. Files are keyed by a hash of the source bytes and of the processing options
+// (`computeKey()`). A file with a different key or format version is stale; a file that fails structural checks or
+// the payload checksum is corrupt. `loadOrBuild()` rebuilds both.
+//
+// Layout (native endianness; a foreign one fails the magic check):
+//   Header : 48 bytes
+//   SectionHeader : 24 bytes, num_sections times
+//   section data, every section 16-byte aligned
+
+const std = @import("std");
+const assert = std.debug.assert;
+const opt = @import("zmeshoptimizer.zig");
+const MappedFile = @import("MappedFile.zig");
+
+pub const magic: u32 = 0x43534d5a; // "ZMSC"
+pub const version: u32 = 1;
+pub const max_num_streams = 16;
+
+const section_alignment = 16;
+const max_num_sections = max_num_streams + 7;
+
+pub const Key = u64;
+
+/// Hash of the source asset bytes and of the serialized processing options (e.g. `std.mem.asBytes(&options)` of an
+/// extern struct). Changing `version` invalidates all keys.
+pub fn computeKey(source: []const u8, options: []const u8) Key {
+    return std.hash.Wyhash.hash(std.hash.Wyhash.hash(version, source), options);
+}
+
+pub const file_name_len = 16 + ".zmc".len;
+
+pub fn getFileName(key: Key) [file_name_len]u8 {
+    var name: [file_name_len]u8 = undefined;
+    _ = std.fmt.bufPrint(name[0..], "{x:0>16}.zmc", .{key}) catch unreachable;
+    return name;
+}
+
+pub const Stream = struct {
+    /// Bytes per vertex.
+    stride: u32,
+    /// `vertex_count * stride` bytes.
+    data: []const u8,
+};
+
+pub const Lod = extern struct {
+    index_offset: u32,
+    index_count: u32,
+    relative_error: f32,
+    sloppy: u32,
+
+    pub fn fromLevel(level: opt.LodLevel) Lod {
+        return .{
+            .index_offset = level.index_offset,
+            .index_count = level.index_count,
+            .relative_error = level.relative_error,
+            .sloppy = @boolToInt(level.sloppy),
+        };
+    }
+};
+
+/// All parts except `vertex_count` are optional.
+pub const ProcessedMesh = struct {
+    vertex_count: u32,
+    streams: [max_num_streams]Stream = undefined,
+    num_streams: u32 = 0,
+    indices: []const u32 = &.{},
+    /// LOD levels index `lod_indices`; see `zmesh.opt.LodChain`.
+    lod_indices: []const u32 = &.{},
+    lods: []const Lod = &.{},
+    lod_error_scale: f32 = 0.0,
+    meshlets: []const opt.Meshlet = &.{},
+    meshlet_vertices: []const u32 = &.{},
+    meshlet_triangles: []const u8 = &.{},
+    meshlet_bounds: []const opt.Bounds = &.{},
+
+    pub fn addStream(mesh: *ProcessedMesh, comptime T: type, vertices: []const T) void {
+        assert(mesh.num_streams < max_num_streams and vertices.len == mesh.vertex_count);
+        mesh.streams[mesh.num_streams] = .{ .stride = @sizeOf(T), .data = std.mem.sliceAsBytes(vertices) };
+        mesh.num_streams += 1;
+    }
+
+    pub fn getStreams(mesh: *const ProcessedMesh) []const Stream {
+        return mesh.streams[0..mesh.num_streams];
+    }
+
+    pub fn getStream(mesh: ProcessedMesh, comptime T: type, stream_index: u32) []const T {
+        const stream = mesh.streams[stream_index];
+        assert(stream.stride == @sizeOf(T));
+        return std.mem.bytesAsSlice(T, @alignCast(@alignOf(T), stream.data));
+    }
+};
+
+const Header = extern struct {
+    magic: u32,
+    version: u32,
+    key: Key,
+    file_size: u64,
+    /// Wyhash of the section table and of all section data (padding excluded).
+    checksum: u64,
+    vertex_count: u32,
+    num_sections: u32,
+    lod_error_scale: f32,
+    reserved: u32 = 0,
+};
+
+const SectionKind = enum(u16) {
+    indices,
+    stream,
+    lod_indices,
+    lods,
+    meshlets,
+    meshlet_vertices,
+    meshlet_triangles,
+    meshlet_bounds,
+};
+
+const SectionHeader = extern struct {
+    kind: u16,
+    /// Stream index for `SectionKind.stream`.
+    index: u16,
+    element_size: u32,
+    offset: u64,
+    count: u64,
+};
+
+comptime {
+    assert(@sizeOf(Header) == 48 and @sizeOf(SectionHeader) == 24);
+}
+
+/// Writes the cache file atomically (a partially written file is never visible under `sub_path`).
+pub fn save(dir: std.fs.Dir, sub_path: []const u8, key: Key, mesh: ProcessedMesh) !void {
+    const Sections = struct {
+        headers: [max_num_sections]SectionHeader = undefined,
+        data: [max_num_sections][]const u8 = undefined,
+        len: usize = 0,
+
+        fn append(sections: *@This(), kind: SectionKind, index: u16, element_size: u32, bytes: []const u8) void {
+            if (bytes.len == 0) return;
+            sections.headers[sections.len] = .{
+                .kind = @enumToInt(kind),
+                .index = index,
+                .element_size = element_size,
+                .offset = 0,
+                .count = bytes.len / element_size,
+            };
+            sections.data[sections.len] = bytes;
+            sections.len += 1;
+        }
+    };
+    const asBytes = std.mem.sliceAsBytes;
+
+    var sections = Sections{};
+    for (mesh.getStreams()) |stream, i| {
+        assert(stream.data.len == @as(usize, stream.stride) * mesh.vertex_count);
+        sections.append(.stream, @intCast(u16, i), stream.stride, stream.data);
+    }
+    sections.append(.indices, 0, 4, asBytes(mesh.indices));
+    sections.append(.lod_indices, 0, 4, asBytes(mesh.lod_indices));
+    sections.append(.lods, 0, @sizeOf(Lod), asBytes(mesh.lods));
+    sections.append(.meshlets, 0, @sizeOf(opt.Meshlet), asBytes(mesh.meshlets));
+    sections.append(.meshlet_vertices, 0, 4, asBytes(mesh.meshlet_vertices));
+    sections.append(.meshlet_triangles, 0, 1, mesh.meshlet_triangles);
+    sections.append(.meshlet_bounds, 0, @sizeOf(opt.Bounds), asBytes(mesh.meshlet_bounds));
+
+    const headers = sections.headers[0..sections.len];
+    const table_end = @sizeOf(Header) + headers.len * @sizeOf(SectionHeader);
+
+    var offset: usize = table_end;
+    for (headers) |*section, i| {
+        offset = std.mem.alignForward(offset, section_alignment);
+        section.offset = offset;
+        offset += sections.data[i].len;
+    }
+
+    var hasher = std.hash.Wyhash.init(0);
+    hasher.update(asBytes(headers));
+    for (sections.data[0..sections.len]) |bytes| hasher.update(bytes);
+
+    const header = Header{
+        .magic = magic,
+        .version = version,
+        .key = key,
+        .file_size = offset,
+        .checksum = hasher.final(),
+        .vertex_count = mesh.vertex_count,
+        .num_sections = @intCast(u32, headers.len),
+        .lod_error_scale = mesh.lod_error_scale,
+    };
+
+    var file = try dir.atomicFile(sub_path, .{});
+    defer file.deinit();
+
+    var buffered = std.io.bufferedWriter(file.file.writer());
+    const writer = buffered.writer();
+    try writer.writeAll(std.mem.asBytes(&header));
+    try writer.writeAll(asBytes(headers));
+
+    var position: usize = table_end;
+    for (headers) |section, i| {
+        try writer.writeByteNTimes(0, @intCast(usize, section.offset) - position);
+        try writer.writeAll(sections.data[i]);
+        position = @intCast(usize, section.offset) + sections.data[i].len;
+    }
+    try buffered.flush();
+    try file.finish();
+}
+
+pub const LoadOptions = struct {
+    /// Hash all data and compare with the stored checksum (one pass over the file). Structural checks are always
+    /// done.
+    verify_checksum: bool = true,
+};
+
+/// `mesh` points into `file`.
+pub const CachedMesh = struct {
+    mesh: ProcessedMesh,
+    file: MappedFile,
+
+    pub fn deinit(cached: *CachedMesh) void {
+        cached.file.deinit();
+        cached.* = undefined;
+    }
+};
+
+const ParseError = error{ StaleCache, CorruptCache };
+
+/// Maps the cache file. Returns `error.StaleCache` for a file written with a different key or format version and
+/// `error.CorruptCache` for a file that fails validation.
+pub fn load(dir: std.fs.Dir, sub_path: []const u8, key: Key, options: LoadOptions) !CachedMesh {
+    const mapped = blk: {
+        const file = try dir.openFile(sub_path, .{});
+        defer file.close();
+        break :blk try MappedFile.initFile(file);
+    };
+    errdefer mapped.deinit();
+
+    return CachedMesh{ .mesh = try parse(mapped.bytes, key, options), .file = mapped };
+}
+
+/// Loads the mesh cached under `key` in `dir`. When the file is missing, stale or corrupt, `build(context)` is called,
+/// its result is saved and loaded back. Memory of the mesh returned by `build` stays owned by `context`.
+pub fn loadOrBuild(
+    dir: std.fs.Dir,
+    key: Key,
+    options: LoadOptions,
+    context: anytype,
+    comptime build: fn (@TypeOf(context)) anyerror!ProcessedMesh,
+) !CachedMesh {
+    const name = getFileName(key);
+    if (load(dir, name[0..], key, options)) |cached| {
+        return cached;
+    } else |err| switch (err) {
+        error.FileNotFound, error.StaleCache, error.CorruptCache => {},
+        else => return err,
+    }
+
+    try save(dir, name[0..], key, try build(context));
+    return load(dir, name[0..], key, options);
+}
+
+fn parse(bytes: []align(std.mem.page_size) const u8, key: Key, options: LoadOptions) ParseError!ProcessedMesh {
+    if (bytes.len < @sizeOf(Header)) return error.CorruptCache;
+    const header = @ptrCast(*const Header, bytes.ptr);
+
+    if (header.magic != magic) return error.CorruptCache;
+    if (header.version != version or header.key != key) return error.StaleCache;
+    if (header.file_size != bytes.len or header.num_sections > max_num_sections) return error.CorruptCache;
+
+    const table_end = @sizeOf(Header) + header.num_sections * @sizeOf(SectionHeader);
+    if (table_end > bytes.len) return error.CorruptCache;
+    const sections = std.mem.bytesAsSlice(SectionHeader, bytes[@sizeOf(Header)..table_end]);
+
+    var mesh = ProcessedMesh{ .vertex_count = header.vertex_count, .lod_error_scale = header.lod_error_scale };
+    var hasher = std.hash.Wyhash.init(0);
+    if (options.verify_checksum) hasher.update(bytes[@sizeOf(Header)..table_end]);
+
+    for (sections) |section| {
+        const kind = std.meta.intToEnum(SectionKind, section.kind) catch return error.CorruptCache;
+        const size = std.math.mul(u64, section.count, section.element_size) catch return error.CorruptCache;
+        const end = std.math.add(u64, section.offset, size) catch return error.CorruptCache;
+        if (section.offset < table_end or section.offset % section_alignment != 0 or end > bytes.len) {
+            return error.CorruptCache;
+        }
+        const data = @alignCast(section_alignment, bytes[@intCast(usize, section.offset)..@intCast(usize, end)]);
+        if (options.verify_checksum) hasher.update(data);
+
+        const expected_size: u32 = switch (kind) {
+            .indices, .lod_indices, .meshlet_vertices => 4,
+            .stream => section.element_size,
+            .lods => @sizeOf(Lod),
+            .meshlets => @sizeOf(opt.Meshlet),
+            .meshlet_triangles => 1,
+            .meshlet_bounds => @sizeOf(opt.Bounds),
+        };
+        if (section.element_size != expected_size or expected_size == 0) return error.CorruptCache;
+
+        switch (kind) {
+            .stream => {
+                if (section.index != mesh.num_streams or mesh.num_streams == max_num_streams or
+                    section.count != mesh.vertex_count)
+                {
+                    return error.CorruptCache;
+                }
+                mesh.streams[mesh.num_streams] = .{ .stride = section.element_size, .data = data };
+                mesh.num_streams += 1;
+            },
+            .indices => mesh.indices = std.mem.bytesAsSlice(u32, data),
+            .lod_indices => mesh.lod_indices = std.mem.bytesAsSlice(u32, data),
+            .lods => mesh.lods = std.mem.bytesAsSlice(Lod, data),
+            .meshlets => mesh.meshlets = std.mem.bytesAsSlice(opt.Meshlet, data),
+            .meshlet_vertices => mesh.meshlet_vertices = std.mem.bytesAsSlice(u32, data),
+            .meshlet_triangles => mesh.meshlet_triangles = data,
+            .meshlet_bounds => mesh.meshlet_bounds = std.mem.bytesAsSlice(opt.Bounds, data),
+        }
+    }
+
+    if (options.verify_checksum and hasher.final() != header.checksum) return error.CorruptCache;
+    return mesh;
+}
+
+const expect = std.testing.expect;
+
+test "zmesh.cache" {
+    const zmesh = @import("main.zig");
+    const allocator = std.testing.allocator;
+    zmesh.init(allocator);
+    defer zmesh.deinit();
+
+    const TestBuild = struct {
+        allocator: std.mem.Allocator,
+        num_builds: u32 = 0,
+        optimized: ?opt.OptimizedMesh = null,
+        chain: ?opt.LodChain = null,
+        lods: [4]Lod = undefined,
+        meshlets: []opt.Meshlet = @as([*]opt.Meshlet, undefined)[0..0],
+        meshlet_vertices: []u32 = @as([*]u32, undefined)[0..0],
+        meshlet_triangles: []u8 = @as([*]u8, undefined)[0..0],
+        meshlet_bounds: []opt.Bounds = @as([*]opt.Bounds, undefined)[0..0],
+
+        fn deinit(b: *@This()) void {
+            if (b.optimized) |*m| m.deinit(b.allocator);
+            if (b.chain) |*c| c.deinit(b.allocator);
+            b.allocator.free(b.meshlets);
+            b.allocator.free(b.meshlet_vertices);
+            b.allocator.free(b.meshlet_triangles);
+            b.allocator.free(b.meshlet_bounds);
+        }
+
+        fn build(b: *@This()) anyerror!ProcessedMesh {
+            b.deinit();
+            b.* = .{ .allocator = b.allocator, .num_builds = b.num_builds + 1 };
+
+            const sphere = zmesh.Shape.initParametricSphere(32, 32);
+            defer sphere.deinit();
+            const indices = try b.allocator.alloc(u32, sphere.indices.len);
+            defer b.allocator.free(indices);
+            for (sphere.indices) |index, i| indices[i] = index;
+
+            b.optimized = try opt.optimizeMesh(b.allocator, indices, @intCast(u32, sphere.positions.len), &.{
+                opt.Stream.init([3]f32, sphere.positions),
+                opt.Stream.init([3]f32, sphere.normals.?),
+            }, .{ .analyze = false });
+            const m = b.optimized.?;
+            const positions = m.getStream([3]f32, 0);
+
+            b.chain = try opt.generateLodChain(b.allocator, m.indices, [3]f32, positions, &.{
+                .{ .ratio = 0.5, .max_error = 0.01 },
+                .{ .ratio = 0.1, .max_error = 0.1 },
+            }, .{});
+            for (b.chain.?.levels) |level, i| b.lods[i] = Lod.fromLevel(level);
+
+            const max_meshlets = opt.buildMeshletsBound(m.indices.len, 64, 124);
+            b.meshlets = try b.allocator.alloc(opt.Meshlet, max_meshlets);
+            b.meshlet_vertices = try b.allocator.alloc(u32, max_meshlets * 64);
+            b.meshlet_triangles = try b.allocator.alloc(u8, max_meshlets * 124 * 3);
+            const num_meshlets = opt.buildMeshlets(
+                b.meshlets,
+                b.meshlet_vertices,
+                b.meshlet_triangles,
+                m.indices,
+                [3]f32,
+                positions,
+                64,
+                124,
+                0.0,
+            );
+            b.meshlet_bounds = try b.allocator.alloc(opt.Bounds, num_meshlets);
+            for (b.meshlet_bounds) |*bounds, i| {
+                const ml = b.meshlets[i];
+                bounds.* = opt.computeMeshletBounds(
+                    b.meshlet_vertices[ml.vertex_offset..][0..ml.vertex_count],
+                    b.meshlet_triangles[ml.triangle_offset..][0 .. ml.triangle_count * 3],
+                    [3]f32,
+                    positions,
+                );
+            }
+
+            var mesh = ProcessedMesh{
+                .vertex_count = m.vertex_count,
+                .indices = m.indices,
+                .lod_indices = b.chain.?.indices,
+                .lods = b.lods[0..b.chain.?.levels.len],
+                .lod_error_scale = b.chain.?.error_scale,
+                .meshlets = b.meshlets[0..num_meshlets],
+                .meshlet_vertices = b.meshlet_vertices,
+                .meshlet_triangles = b.meshlet_triangles,
+                .meshlet_bounds = b.meshlet_bounds,
+            };
+            mesh.addStream([3]f32, positions);
+            mesh.addStream([3]f32, m.getStream([3]f32, 1));
+            return mesh;
+        }
+    };
+
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var builder = TestBuild{ .allocator = allocator };
+    defer builder.deinit();
+
+    const key = computeKey("source asset bytes", "options");
+    try expect(key != computeKey("source asset bytes", "other options"));
+    const name = getFileName(key);
+
+    // Miss: built and saved.
+    {
+        var cached = try loadOrBuild(tmp.dir, key, .{}, &builder, TestBuild.build);
+        defer cached.deinit();
+        try expect(builder.num_builds == 1);
+
+        const mesh = cached.mesh;
+        const expected = builder.optimized.?;
+        try expect(mesh.vertex_count == expected.vertex_count);
+        try expect(mesh.num_streams == 2);
+        try expect(std.mem.eql(u32, mesh.indices, expected.indices));
+        try expect(std.mem.eql(u8, mesh.streams[1].data, expected.streams[1]));
+        try expect(std.mem.eql(u32, mesh.lod_indices, builder.chain.?.indices));
+        try expect(mesh.lods.len == 3 and mesh.lods[2].index_count == builder.chain.?.levels[2].index_count);
+        try expect(mesh.lod_error_scale == builder.chain.?.error_scale);
+        try expect(mesh.meshlets.len == builder.meshlet_bounds.len);
+        try expect(std.mem.eql(u8, std.mem.sliceAsBytes(mesh.meshlet_bounds), std.mem.sliceAsBytes(builder.meshlet_bounds)));
+        try expect(mesh.getStream([3]f32, 0)[7][1] == expected.getStream([3]f32, 0)[7][1]);
+
+        // Slices point into the mapping.
+        const begin = @ptrToInt(cached.file.bytes.ptr);
+        try expect(@ptrToInt(mesh.indices.ptr) > begin);
+        try expect(@ptrToInt(mesh.meshlet_triangles.ptr) < begin + cached.file.bytes.len);
+    }
+
+    // Hit: nothing is built.
+    {
+        var cached = try loadOrBuild(tmp.dir, key, .{}, &builder, TestBuild.build);
+        defer cached.deinit();
+        try expect(builder.num_builds == 1);
+    }
+
+    // Stale: different key.
+    try std.testing.expectError(error.StaleCache, load(tmp.dir, name[0..], key +% 1, .{}));
+
+    // Corrupt: one flipped byte in the data, then a truncated file.
+    {
+        const file = try tmp.dir.openFile(name[0..], .{ .mode = .read_write });
+        defer file.close();
+        const size = try file.getEndPos();
+        var byte: [1]u8 = undefined;
+        _ = try file.preadAll(byte[0..], size - 100);
+        byte[0] ^= 0x10;
+        try file.pwriteAll(byte[0..], size - 100);
+        try std.testing.expectError(error.CorruptCache, load(tmp.dir, name[0..], key, .{}));
+
+        // Without the checksum only structural damage is detected.
+        var cached = try load(tmp.dir, name[0..], key, .{ .verify_checksum = false });
+        cached.deinit();
+
+        try file.setEndPos(size - 8);
+        try std.testing.expectError(error.CorruptCache, load(tmp.dir, name[0..], key, .{ .verify_checksum = false }));
+    }
+
+    // Rebuilt.
+    {
+        var cached = try loadOrBuild(tmp.dir, key, .{}, &builder, TestBuild.build);
+        defer cached.deinit();
+        try expect(builder.num_builds == 2);
+        try expect(std.mem.eql(u32, cached.mesh.indices, builder.optimized.?.indices));
+    }
+}
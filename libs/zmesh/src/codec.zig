@@ -0,0 +1,393 @@
+// zmesh compressed mesh container.
+//
+// Index buffer is compressed with meshoptimizer index codec, every vertex stream with vertex codec. Before
+// compression a stream can be filtered (octahedral normals/tangents, quaternions, shared-exponent floats),
+// filters are undone in-place after decoding. Decoders use SSSE3/NEON code paths when available (selected at runtime
+// on x86).
+//
+// Layout (little-endian):
+//   Header { magic, version, vertex_count, index_count, num_streams, index_data_size } : 6 x u32
+//   StreamHeader { stride: u32, filter: u8, bits: u8, reserved: u16, data_size: u32 } : num_streams times
+//   encoded index data
+//   encoded vertex data of every stream (in stream order)
+
+const std = @import("std");
+const assert = std.debug.assert;
+const opt = @import("zmeshoptimizer.zig");
+
+pub const magic: u32 = 0x48534d5a; // "ZMSH"
+pub const version: u32 = 1;
+pub const max_num_streams = 16;
+
+const header_size = 6 * @sizeOf(u32);
+const stream_header_size = 3 * @sizeOf(u32);
+
+pub const Error = error{
+    InvalidData,
+    UnsupportedVersion,
+};
+
+pub const Filter = enum(u8) {
+    none,
+    /// Unit vectors; decoded as snorm8x4 (`stride == 4`) or snorm16x4 (`stride == 8`) with w preserved.
+    octahedral,
+    /// Unit quaternions; decoded as snorm16x4.
+    quaternion,
+    /// Floats; all components of a vertex share the exponent. Decoded as f32.
+    exponential,
+};
+
+pub const VertexStream = struct {
+    /// Bytes per vertex of the decoded stream.
+    stride: u32,
+    filter: Filter = .none,
+    /// Filter precision: octahedral 1-16, quaternion 4-16, exponential 1-24 (mantissa bits).
+    bits: u8 = 0,
+    /// `filter == .none`: `vertex_count * stride` bytes, stored as-is.
+    raw: []const u8 = &.{},
+    /// Filtered streams: `components` floats per vertex.
+    floats: []const f32 = &.{},
+    components: u32 = 0,
+
+    pub fn initRaw(comptime T: type, vertices: []const T) VertexStream {
+        comptime assert(@sizeOf(T) % 4 == 0 and @sizeOf(T) <= 256);
+        return .{ .stride = @sizeOf(T), .raw = std.mem.sliceAsBytes(vertices) };
+    }
+
+    /// Decoded as snorm8x4 (`bits <= 8`) or snorm16x4 with w = 0.
+    pub fn initNormals(normals: []const [3]f32, bits: u8) VertexStream {
+        assert(bits >= 1 and bits <= 16);
+        return .{
+            .stride = if (bits <= 8) 4 else 8,
+            .filter = .octahedral,
+            .bits = bits,
+            .floats = @ptrCast([*]const f32, normals.ptr)[0 .. normals.len * 3],
+            .components = 3,
+        };
+    }
+
+    /// Tangents with handedness in w; decoded as snorm8x4 (`bits <= 8`) or snorm16x4.
+    pub fn initTangents(tangents: []const [4]f32, bits: u8) VertexStream {
+        assert(bits >= 1 and bits <= 16);
+        return .{
+            .stride = if (bits <= 8) 4 else 8,
+            .filter = .octahedral,
+            .bits = bits,
+            .floats = @ptrCast([*]const f32, tangents.ptr)[0 .. tangents.len * 4],
+            .components = 4,
+        };
+    }
+
+    /// Unit quaternions (x, y, z, w); decoded as snorm16x4.
+    pub fn initRotations(rotations: []const [4]f32, bits: u8) VertexStream {
+        assert(bits >= 4 and bits <= 16);
+        return .{
+            .stride = 8,
+            .filter = .quaternion,
+            .bits = bits,
+            .floats = @ptrCast([*]const f32, rotations.ptr)[0 .. rotations.len * 4],
+            .components = 4,
+        };
+    }
+
+    /// Decoded as `[N]f32` with `bits` of mantissa precision.
+    pub fn initExponential(comptime N: u32, values: []const [N]f32, bits: u8) VertexStream {
+        comptime assert(N >= 1 and N <= 64);
+        assert(bits >= 1 and bits <= 24);
+        return .{
+            .stride = N * 4,
+            .filter = .exponential,
+            .bits = bits,
+            .floats = @ptrCast([*]const f32, values.ptr)[0 .. values.len * N],
+            .components = N,
+        };
+    }
+};
+
+/// Returns the encoded mesh (free with `allocator`). All streams must have `vertex_count` vertices.
+pub fn encode(
+    allocator: std.mem.Allocator,
+    indices: []const u32,
+    vertex_count: u32,
+    streams: []const VertexStream,
+) error{OutOfMemory}![]u8 {
+    assert(indices.len % 3 == 0);
+    assert(streams.len <= max_num_streams);
+
+    var bound: usize = header_size + streams.len * stream_header_size;
+    bound += opt.encodeIndexBufferBound(indices.len, vertex_count);
+    var max_stride: usize = 0;
+    for (streams) |stream| {
+        assert(stream.stride > 0 and stream.stride % 4 == 0 and stream.stride <= 256);
+        bound += opt.encodeVertexBufferBound(vertex_count, stream.stride);
+        max_stride = std.math.max(max_stride, stream.stride);
+    }
+
+    const buffer = try allocator.alloc(u8, bound);
+    errdefer allocator.free(buffer);
+
+    const filtered = try allocator.alignedAlloc(u8, 4, @as(usize, vertex_count) * max_stride);
+    defer allocator.free(filtered);
+
+    var offset: usize = header_size + streams.len * stream_header_size;
+
+    const index_data_size = opt.encodeIndexBuffer(buffer[offset..], indices);
+    assert(index_data_size > 0);
+    offset += index_data_size;
+
+    writeU32(buffer, 0, magic);
+    writeU32(buffer, 4, version);
+    writeU32(buffer, 8, vertex_count);
+    writeU32(buffer, 12, @intCast(u32, indices.len));
+    writeU32(buffer, 16, @intCast(u32, streams.len));
+    writeU32(buffer, 20, @intCast(u32, index_data_size));
+
+    for (streams) |stream, i| {
+        const data = filterStream(stream, vertex_count, filtered);
+
+        const data_size = opt.encodeVertexBuffer(buffer[offset..], data, stream.stride);
+        assert(data_size > 0);
+        offset += data_size;
+
+        const h = header_size + i * stream_header_size;
+        writeU32(buffer, h, stream.stride);
+        buffer[h + 4] = @enumToInt(stream.filter);
+        buffer[h + 5] = stream.bits;
+        buffer[h + 6] = 0;
+        buffer[h + 7] = 0;
+        writeU32(buffer, h + 8, @intCast(u32, data_size));
+    }
+
+    return allocator.shrink(buffer, offset);
+}
+
+/// Returns the stored (pre-compression) representation of `stream`, filtered streams are written to `storage`.
+fn filterStream(stream: VertexStream, vertex_count: u32, storage: []align(4) u8) []const u8 {
+    const size = @as(usize, vertex_count) * stream.stride;
+    switch (stream.filter) {
+        .none => {
+            assert(stream.raw.len == size);
+            return stream.raw;
+        },
+        .octahedral => {
+            assert(stream.floats.len == @as(usize, vertex_count) * stream.components);
+            if (stream.components == 4) {
+                opt.encodeFilterOct(storage[0..size], stream.stride, stream.bits, stream.floats);
+            } else {
+                // Filter needs 4 floats per vector; expand in chunks.
+                assert(stream.components == 3);
+                var chunk: [256 * 4]f32 = undefined;
+                var first: usize = 0;
+                while (first < vertex_count) : (first += chunk.len / 4) {
+                    const n = std.math.min(chunk.len / 4, vertex_count - first);
+                    var i: usize = 0;
+                    while (i < n) : (i += 1) {
+                        const v = stream.floats[(first + i) * 3 ..][0..3];
+                        chunk[i * 4 ..][0..4].* = .{ v[0], v[1], v[2], 0.0 };
+                    }
+                    opt.encodeFilterOct(
+                        storage[first * stream.stride ..][0 .. n * stream.stride],
+                        stream.stride,
+                        stream.bits,
+                        chunk[0 .. n * 4],
+                    );
+                }
+            }
+        },
+        .quaternion => {
+            assert(stream.floats.len == @as(usize, vertex_count) * 4);
+            opt.encodeFilterQuat(storage[0..size], stream.bits, stream.floats);
+        },
+        .exponential => {
+            assert(stream.floats.len * 4 == size);
+            opt.encodeFilterExp(storage[0..size], stream.stride, stream.bits, stream.floats);
+        },
+    }
+    return storage[0..size];
+}
+
+pub const StreamInfo = struct {
+    stride: u32,
+    filter: Filter,
+    bits: u8,
+    data: []const u8,
+};
+
+/// Validates the container and gives access to its streams. Nothing is copied, `bytes` must stay alive while the
+/// decoder is used.
+pub const Decoder = struct {
+    vertex_count: u32,
+    index_count: u32,
+    num_streams: u32,
+    streams: [max_num_streams]StreamInfo,
+    index_data: []const u8,
+
+    pub fn init(bytes: []const u8) Error!Decoder {
+        if (bytes.len < header_size or readU32(bytes, 0) != magic) return error.InvalidData;
+        if (readU32(bytes, 4) != version) return error.UnsupportedVersion;
+
+        var decoder = Decoder{
+            .vertex_count = readU32(bytes, 8),
+            .index_count = readU32(bytes, 12),
+            .num_streams = readU32(bytes, 16),
+            .streams = undefined,
+            .index_data = undefined,
+        };
+        if (decoder.index_count % 3 != 0 or decoder.num_streams > max_num_streams) return error.InvalidData;
+
+        var offset: usize = header_size + decoder.num_streams * stream_header_size;
+        if (offset > bytes.len) return error.InvalidData;
+
+        const index_data_size = readU32(bytes, 20);
+        if (index_data_size > bytes.len - offset) return error.InvalidData;
+        decoder.index_data = bytes[offset..][0..index_data_size];
+        offset += index_data_size;
+
+        for (decoder.streams[0..decoder.num_streams]) |*stream, i| {
+            const h = header_size + i * stream_header_size;
+            stream.stride = readU32(bytes, h);
+            stream.filter = std.meta.intToEnum(Filter, bytes[h + 4]) catch return error.InvalidData;
+            stream.bits = bytes[h + 5];
+
+            const stride_ok = stream.stride > 0 and stream.stride % 4 == 0 and stream.stride <= 256;
+            const filter_ok = switch (stream.filter) {
+                .none, .exponential => true,
+                .octahedral => stream.stride == 4 or stream.stride == 8,
+                .quaternion => stream.stride == 8,
+            };
+            if (!stride_ok or !filter_ok) return error.InvalidData;
+
+            const data_size = readU32(bytes, h + 8);
+            if (data_size > bytes.len - offset) return error.InvalidData;
+            stream.data = bytes[offset..][0..data_size];
+            offset += data_size;
+        }
+        if (offset != bytes.len) return error.InvalidData;
+
+        return decoder;
+    }
+
+    pub fn getStreams(decoder: *const Decoder) []const StreamInfo {
+        return decoder.streams[0..decoder.num_streams];
+    }
+
+    /// `destination.len` must be `index_count`.
+    pub fn decodeIndices(decoder: Decoder, comptime T: type, destination: []T) Error!void {
+        assert(destination.len == decoder.index_count);
+        if (T == u16) assert(decoder.vertex_count <= 0x10000);
+        try opt.decodeIndexBuffer(T, destination, decoder.index_data);
+    }
+
+    /// `destination.len` must be `vertex_count * stride`, destination must be 4-byte aligned. Stream filter is
+    /// undone in-place.
+    pub fn decodeStream(decoder: Decoder, stream_index: u32, destination: []u8) Error!void {
+        assert(stream_index < decoder.num_streams);
+        const stream = decoder.streams[stream_index];
+        assert(destination.len == @as(usize, decoder.vertex_count) * stream.stride);
+        assert(@ptrToInt(destination.ptr) % 4 == 0);
+
+        try opt.decodeVertexBuffer(destination, stream.stride, stream.data);
+        switch (stream.filter) {
+            .none => {},
+            .octahedral => opt.decodeFilterOct(destination, stream.stride),
+            .quaternion => opt.decodeFilterQuat(destination),
+            .exponential => opt.decodeFilterExp(destination, stream.stride),
+        }
+    }
+};
+
+inline fn readU32(bytes: []const u8, offset: usize) u32 {
+    return std.mem.readIntLittle(u32, bytes[offset..][0..4]);
+}
+
+inline fn writeU32(bytes: []u8, offset: usize, value: u32) void {
+    std.mem.writeIntLittle(u32, bytes[offset..][0..4], value);
+}
+
+const expect = std.testing.expect;
+
+test "zmesh.codec" {
+    const zmesh = @import("main.zig");
+    zmesh.init(std.testing.allocator);
+    defer zmesh.deinit();
+
+    var sphere = zmesh.Shape.initParametricSphere(24, 16);
+    defer sphere.deinit();
+    sphere.unweld();
+    sphere.computeNormals();
+
+    const allocator = std.testing.allocator;
+    const vertex_count = @intCast(u32, sphere.positions.len);
+
+    const indices = try allocator.alloc(u32, sphere.indices.len);
+    defer allocator.free(indices);
+    for (sphere.indices) |index, i| indices[i] = index;
+
+    const rotations = try allocator.alloc([4]f32, vertex_count);
+    defer allocator.free(rotations);
+    for (rotations) |*q, i| {
+        const a = @intToFloat(f32, i) * 0.01;
+        q.* = .{ 0.0, @sin(a), 0.0, @cos(a) };
+    }
+
+    const bytes = try encode(allocator, indices, vertex_count, &.{
+        VertexStream.initRaw([3]f32, sphere.positions),
+        VertexStream.initNormals(sphere.normals.?, 12),
+        VertexStream.initExponential(3, sphere.positions, 20),
+        VertexStream.initRotations(rotations, 12),
+    });
+    defer allocator.free(bytes);
+
+    try expect(bytes.len < indices.len * 4 + vertex_count * (12 + 12 + 12 + 16));
+
+    const decoder = try Decoder.init(bytes);
+    try expect(decoder.vertex_count == vertex_count);
+    try expect(decoder.index_count == indices.len);
+    try expect(decoder.getStreams().len == 4);
+
+    {
+        const decoded = try allocator.alloc(u16, indices.len);
+        defer allocator.free(decoded);
+        try decoder.decodeIndices(u16, decoded);
+        for (decoded) |index, i| try expect(index == indices[i]);
+    }
+    {
+        const decoded = try allocator.alloc([3]f32, vertex_count);
+        defer allocator.free(decoded);
+
+        try decoder.decodeStream(0, std.mem.sliceAsBytes(decoded));
+        for (decoded) |p, i| try expect(std.mem.eql(f32, &p, &sphere.positions[i]));
+
+        try decoder.decodeStream(2, std.mem.sliceAsBytes(decoded));
+        for (decoded) |p, i| {
+            for (p) |c, j| try expect(std.math.approxEqAbs(f32, c, sphere.positions[i][j], 1e-5));
+        }
+    }
+    {
+        const decoded = try allocator.alloc([4]i16, vertex_count);
+        defer allocator.free(decoded);
+
+        try decoder.decodeStream(1, std.mem.sliceAsBytes(decoded));
+        for (decoded) |n, i| {
+            for (sphere.normals.?[i]) |c, j| {
+                try expect(std.math.approxEqAbs(f32, @intToFloat(f32, n[j]) / 32767.0, c, 0.005));
+            }
+        }
+
+        try decoder.decodeStream(3, std.mem.sliceAsBytes(decoded));
+        for (decoded) |q, i| {
+            // Double cover: q and -q are the same rotation.
+            var dot: f32 = 0.0;
+            for (rotations[i]) |c, j| dot += c * @intToFloat(f32, q[j]) / 32767.0;
+            try expect(std.math.approxEqAbs(f32, @fabs(dot), 1.0, 0.002));
+        }
+    }
+
+    try std.testing.expectError(error.InvalidData, Decoder.init(bytes[0 .. bytes.len - 1]));
+    {
+        const corrupted = try allocator.dupe(u8, bytes);
+        defer allocator.free(corrupted);
+        corrupted[4] = 2;
+        try std.testing.expectError(error.UnsupportedVersion, Decoder.init(corrupted));
+    }
+}
@@ -0,0 +1,332 @@
+// glTF accessor conversion: widens and normalizes any component type to the requested output type.
+//
+// Integer to f32 conversion is done on blocks of up to 16 components with vector ops (exact for 8/16-bit
+// integers: x is placed in the mantissa of 2^23 and 2^23 is subtracted). Reads are strided, so interleaved
+// vertex buffers are handled without an intermediate copy.
+
+const std = @import("std");
+const assert = std.debug.assert;
+const cgltf = @import("zcgltf.zig");
+
+pub const Error = error{
+    AccessorTypeMismatch,
+    UnsupportedConversion,
+    InvalidAccessor,
+};
+
+/// Reads all `accessor.count` elements into `out`. `T` is a scalar (f32, u32, u16, u8, i16, i8) or an array of them
+/// with as many elements as the accessor type has components (e.g. `[3]f32` for vec3).
+///
+/// f32 output accepts every component type (normalized to [0, 1] or [-1, 1] when the accessor is normalized).
+/// Unsigned integer output accepts unsigned sources (narrowing is range-checked), signed output only the same type.
+/// Sparse substitutions are applied on top of the dense data (zeros when there is no buffer view).
+pub fn readAccessor(comptime T: type, accessor: *const cgltf.Accessor, out: []T) Error!void {
+    const N = numComponents(T);
+    assert(out.len == accessor.count);
+    if (accessor.type.numComponents() != N) return error.AccessorTypeMismatch;
+
+    const normalized = accessor.normalized != 0;
+
+    if (accessor.buffer_view) |buffer_view| {
+        const src = getBufferViewData(buffer_view) orelse return error.InvalidAccessor;
+        try convert(T, accessor.component_type, normalized, src + accessor.offset, accessor.stride, out);
+    } else {
+        std.mem.set(T, out, std.mem.zeroes(T));
+    }
+
+    if (accessor.is_sparse != 0) {
+        const sparse = &accessor.sparse;
+        const indices = (getBufferViewData(sparse.indices_buffer_view) orelse return error.InvalidAccessor) +
+            sparse.indices_byte_offset;
+        const values = (getBufferViewData(sparse.values_buffer_view) orelse return error.InvalidAccessor) +
+            sparse.values_byte_offset;
+        const value_size = N * (componentSize(accessor.component_type) orelse return error.InvalidAccessor);
+
+        var i: usize = 0;
+        while (i < sparse.count) : (i += 1) {
+            const index: usize = switch (sparse.indices_component_type) {
+                .r_8u => indices[i],
+                .r_16u => std.mem.readIntLittle(u16, (indices + i * 2)[0..2]),
+                .r_32u => std.mem.readIntLittle(u32, (indices + i * 4)[0..4]),
+                else => return error.InvalidAccessor,
+            };
+            if (index >= out.len) return error.InvalidAccessor;
+            try convert(T, accessor.component_type, normalized, values + i * value_size, value_size, out[index..][0..1]);
+        }
+    }
+}
+
+/// Buffer view memory (extension-provided data has priority), null when the buffer is not loaded.
+pub fn getBufferViewData(buffer_view: *const cgltf.BufferView) ?[*]const u8 {
+    if (buffer_view.data) |data| return @ptrCast([*]const u8, data);
+    const data = buffer_view.buffer.data orelse return null;
+    return @ptrCast([*]const u8, data) + buffer_view.offset;
+}
+
+pub fn numComponents(comptime T: type) comptime_int {
+    return switch (@typeInfo(T)) {
+        .Array => |array| array.len,
+        else => 1,
+    };
+}
+
+pub fn ComponentOf(comptime T: type) type {
+    const C = switch (@typeInfo(T)) {
+        .Array => |array| array.child,
+        else => T,
+    };
+    switch (C) {
+        f32, u32, u16, u8, i16, i8 => {},
+        else => @compileError("Unsupported accessor component type: " ++ @typeName(C)),
+    }
+    return C;
+}
+
+pub fn componentType(comptime C: type) cgltf.ComponentType {
+    return switch (C) {
+        f32 => .r_32f,
+        u32 => .r_32u,
+        u16 => .r_16u,
+        u8 => .r_8u,
+        i16 => .r_16,
+        i8 => .r_8,
+        else => @compileError("Unsupported accessor component type: " ++ @typeName(C)),
+    };
+}
+
+fn componentSize(component_type: cgltf.ComponentType) ?usize {
+    return switch (component_type) {
+        .r_8, .r_8u => 1,
+        .r_16, .r_16u => 2,
+        .r_32u, .r_32f => 4,
+        .invalid => null,
+    };
+}
+
+fn convert(
+    comptime T: type,
+    component_type: cgltf.ComponentType,
+    normalized: bool,
+    src: [*]const u8,
+    stride: usize,
+    out: []T,
+) Error!void {
+    return switch (component_type) {
+        .r_8 => convertFrom(T, i8, normalized, src, stride, out),
+        .r_8u => convertFrom(T, u8, normalized, src, stride, out),
+        .r_16 => convertFrom(T, i16, normalized, src, stride, out),
+        .r_16u => convertFrom(T, u16, normalized, src, stride, out),
+        .r_32u => convertFrom(T, u32, normalized, src, stride, out),
+        .r_32f => convertFrom(T, f32, normalized, src, stride, out),
+        .invalid => error.InvalidAccessor,
+    };
+}
+
+fn convertFrom(
+    comptime T: type,
+    comptime S: type,
+    normalized: bool,
+    src: [*]const u8,
+    stride: usize,
+    out: []T,
+) Error!void {
+    const D = ComponentOf(T);
+    const N = numComponents(T);
+
+    if (D == S) {
+        if (stride == @sizeOf(T)) {
+            @memcpy(@ptrCast([*]u8, out.ptr), src, out.len * @sizeOf(T));
+        } else {
+            for (out) |*element, e| element.* = @ptrCast(*align(1) const T, src + e * stride).*;
+        }
+    } else if (D == f32 and S == u32) {
+        const scale: f32 = if (normalized) 1.0 / 4294967295.0 else 1.0;
+        const out_flat = @ptrCast([*]f32, out.ptr);
+        for (out) |_, e| {
+            const element = @ptrCast(*align(1) const [N]u32, src + e * stride);
+            comptime var c = 0;
+            inline while (c < N) : (c += 1) {
+                out_flat[e * N + c] = @intToFloat(f32, element[c]) * scale;
+            }
+        }
+    } else if (D == f32) {
+        intToFloat(N, S, normalized, src, stride, @ptrCast([*]f32, out.ptr), out.len);
+    } else if (comptime isUnsignedInt(D) and isUnsignedInt(S)) {
+        for (out) |*element, e| {
+            const src_element = @ptrCast(*align(1) const [N]S, src + e * stride);
+            const dst_element = @ptrCast(*[N]D, element);
+            comptime var c = 0;
+            inline while (c < N) : (c += 1) {
+                dst_element[c] = if (@bitSizeOf(S) <= @bitSizeOf(D))
+                    src_element[c]
+                else
+                    std.math.cast(D, src_element[c]) orelse return error.UnsupportedConversion;
+            }
+        }
+    } else {
+        return error.UnsupportedConversion;
+    }
+}
+
+fn isUnsignedInt(comptime X: type) bool {
+    return switch (@typeInfo(X)) {
+        .Int => |info| info.signedness == .unsigned,
+        else => false,
+    };
+}
+
+/// 8/16-bit integers to f32. Components are gathered into blocks of up to 16 lanes, converted and stored together.
+fn intToFloat(
+    comptime N: comptime_int,
+    comptime S: type,
+    normalized: bool,
+    src: [*]const u8,
+    stride: usize,
+    out: [*]f32,
+    count: usize,
+) void {
+    comptime assert(@bitSizeOf(S) <= 16);
+    const is_signed = @typeInfo(S).Int.signedness == .signed;
+
+    const E = if (N >= 16) 1 else 16 / N; // elements per block
+    const L = E * N; // lanes per block
+
+    // Signed values are biased into [0, 65535] so every lane fits in the mantissa.
+    const bias: i32 = if (is_signed) 0x8000 else 0;
+    const scale: f32 = if (normalized) 1.0 / @intToFloat(f32, std.math.maxInt(S)) else 1.0;
+
+    const exponent = @splat(L, @as(u32, 0x4b000000)); // 2^23
+    const offset = @splat(L, @as(f32, 8388608.0 + @intToFloat(f32, bias)));
+    const scale_v = @splat(L, scale);
+    const minus_one = @splat(L, @as(f32, -1.0));
+
+    var e: usize = 0;
+    while (e + E <= count) : (e += E) {
+        var lanes: [L]u32 = undefined;
+        comptime var j = 0;
+        inline while (j < E) : (j += 1) {
+            const element = @ptrCast(*align(1) const [N]S, src + (e + j) * stride);
+            comptime var c = 0;
+            inline while (c < N) : (c += 1) {
+                lanes[j * N + c] = @intCast(u32, @as(i32, element[c]) + bias);
+            }
+        }
+        const bits = @as(@Vector(L, u32), lanes) | exponent;
+        var v = (@bitCast(@Vector(L, f32), bits) - offset) * scale_v;
+        if (is_signed and normalized) v = @maximum(v, minus_one);
+        (out + e * N)[0..L].* = v;
+    }
+
+    while (e < count) : (e += 1) {
+        const element = @ptrCast(*align(1) const [N]S, src + e * stride);
+        comptime var c = 0;
+        inline while (c < N) : (c += 1) {
+            var f = @intToFloat(f32, element[c]) * scale;
+            if (is_signed and normalized) f = std.math.max(f, -1.0);
+            out[e * N + c] = f;
+        }
+    }
+}
+
+const expect = std.testing.expect;
+
+fn testAccessor(
+    buffer: *cgltf.Buffer,
+    buffer_view: *cgltf.BufferView,
+    data: *const anyopaque,
+    component_type: cgltf.ComponentType,
+    accessor_type: cgltf.Type,
+    offset: usize,
+    stride: usize,
+    count: usize,
+) cgltf.Accessor {
+    buffer.data = @intToPtr(*anyopaque, @ptrToInt(data));
+    buffer_view.buffer = buffer;
+    buffer_view.data = null;
+    buffer_view.offset = 0;
+
+    var accessor: cgltf.Accessor = undefined;
+    accessor.component_type = component_type;
+    accessor.normalized = 1;
+    accessor.type = accessor_type;
+    accessor.offset = offset;
+    accessor.count = count;
+    accessor.stride = stride;
+    accessor.buffer_view = buffer_view;
+    accessor.is_sparse = 0;
+    return accessor;
+}
+
+test "zmesh.convert" {
+    var buffer: cgltf.Buffer = undefined;
+    var buffer_view: cgltf.BufferView = undefined;
+
+    // Interleaved: { u16x2 normalized texcoord, i8x4 normalized normal } * 37 (covers vector blocks and tail).
+    const Vertex = extern struct {
+        uv: [2]u16,
+        normal: [4]i8,
+    };
+    var vertices: [37]Vertex = undefined;
+    for (vertices) |*v, i| {
+        v.uv = .{ @intCast(u16, i * 1000), @intCast(u16, 65535 - i) };
+        v.normal = .{ -128, -127, @intCast(i8, i), 127 };
+    }
+    {
+        const accessor = testAccessor(&buffer, &buffer_view, &vertices, .r_16u, .vec2, 0, @sizeOf(Vertex), 37);
+
+        var out: [37][2]f32 = undefined;
+        try readAccessor([2]f32, &accessor, out[0..]);
+        for (out) |uv, i| {
+            try expect(std.math.approxEqAbs(f32, uv[0], @intToFloat(f32, i * 1000) / 65535.0, 1e-6));
+            try expect(std.math.approxEqAbs(f32, uv[1], @intToFloat(f32, 65535 - i) / 65535.0, 1e-6));
+        }
+
+        var out_u32: [37][2]u32 = undefined;
+        try readAccessor([2]u32, &accessor, out_u32[0..]);
+        try expect(out_u32[36][0] == 36000 and out_u32[36][1] == 65535 - 36);
+
+        var out_u8: [37][2]u8 = undefined;
+        try std.testing.expectError(error.UnsupportedConversion, readAccessor([2]u8, &accessor, out_u8[0..]));
+    }
+    {
+        const offset = @offsetOf(Vertex, "normal");
+        const accessor = testAccessor(&buffer, &buffer_view, &vertices, .r_8, .vec4, offset, @sizeOf(Vertex), 37);
+
+        var out: [37][4]f32 = undefined;
+        try readAccessor([4]f32, &accessor, out[0..]);
+        for (out) |n, i| {
+            try expect(n[0] == -1.0 and std.math.approxEqAbs(f32, n[1], -1.0, 1e-6));
+            try expect(std.math.approxEqAbs(f32, n[2], @intToFloat(f32, i) / 127.0, 1e-6));
+            try expect(std.math.approxEqAbs(f32, n[3], 1.0, 1e-6));
+        }
+
+        var out3: [37][3]f32 = undefined;
+        try std.testing.expectError(error.AccessorTypeMismatch, readAccessor([3]f32, &accessor, out3[0..]));
+    }
+
+    // Sparse: no buffer view (zeros) and 2 substituted u8 values.
+    {
+        const sparse_indices = [2]u16{ 1, 3 };
+        const sparse_values = [2]u8{ 7, 9 };
+        var indices_buffer: cgltf.Buffer = undefined;
+        var indices_view: cgltf.BufferView = undefined;
+        var values_buffer: cgltf.Buffer = undefined;
+        var values_view: cgltf.BufferView = undefined;
+
+        var accessor = testAccessor(&indices_buffer, &indices_view, &sparse_indices, .r_8u, .scalar, 0, 1, 5);
+        _ = testAccessor(&values_buffer, &values_view, &sparse_values, .r_8u, .scalar, 0, 1, 5);
+        accessor.normalized = 0;
+        accessor.buffer_view = null;
+        accessor.is_sparse = 1;
+        accessor.sparse.count = 2;
+        accessor.sparse.indices_buffer_view = &indices_view;
+        accessor.sparse.indices_byte_offset = 0;
+        accessor.sparse.indices_component_type = .r_16u;
+        accessor.sparse.values_buffer_view = &values_view;
+        accessor.sparse.values_byte_offset = 0;
+
+        var out: [5]f32 = undefined;
+        try readAccessor(f32, &accessor, out[0..]);
+        try expect(std.mem.eql(f32, &out, &[_]f32{ 0.0, 7.0, 0.0, 9.0, 0.0 }));
+    }
+}
@@ -0,0 +1,564 @@
+// Meshlet (cluster) culling on the CPU: frustum, normal cone (backface) and optional Hi-Z occlusion tests over
+// meshlet bounds stored as a structure of arrays, `lanes` meshlets at a time.
+//
+// Conventions (the same as zmath): row vectors (`p * view`), left-handed view space (+x right, +y up, +z forward),
+// clip space z in [0, 1].
+
+const std = @import("std");
+const assert = std.debug.assert;
+const opt = @import("zmeshoptimizer.zig");
+const parallel = @import("parallel.zig");
+
+pub const lanes = 8;
+const F32xN = @Vector(lanes, f32);
+
+/// Bounding spheres and normal cones of meshlets, one array per component. Arrays are padded to a multiple of
+/// `lanes`; padding never passes the frustum test.
+pub const MeshletBounds = struct {
+    len: usize,
+    center_x: []f32,
+    center_y: []f32,
+    center_z: []f32,
+    radius: []f32,
+    cone_axis_x: []f32,
+    cone_axis_y: []f32,
+    cone_axis_z: []f32,
+    cone_cutoff: []f32,
+    data: []align(32) f32,
+
+    pub fn init(allocator: std.mem.Allocator, len: usize) error{OutOfMemory}!MeshletBounds {
+        const padded_len = std.mem.alignForward(len, lanes);
+        const data = try allocator.alignedAlloc(f32, 32, padded_len * 8);
+        std.mem.set(f32, data, 0.0);
+
+        var bounds = MeshletBounds{
+            .len = len,
+            .center_x = data[0 * padded_len ..][0..padded_len],
+            .center_y = data[1 * padded_len ..][0..padded_len],
+            .center_z = data[2 * padded_len ..][0..padded_len],
+            .radius = data[3 * padded_len ..][0..padded_len],
+            .cone_axis_x = data[4 * padded_len ..][0..padded_len],
+            .cone_axis_y = data[5 * padded_len ..][0..padded_len],
+            .cone_axis_z = data[6 * padded_len ..][0..padded_len],
+            .cone_cutoff = data[7 * padded_len ..][0..padded_len],
+            .data = data,
+        };
+        std.mem.set(f32, bounds.radius[len..], -std.math.inf(f32));
+        std.mem.set(f32, bounds.cone_cutoff, 1.0);
+        return bounds;
+    }
+
+    pub fn deinit(bounds: *MeshletBounds, allocator: std.mem.Allocator) void {
+        allocator.free(bounds.data);
+        bounds.* = undefined;
+    }
+
+    pub fn set(bounds: MeshletBounds, index: usize, b: opt.Bounds) void {
+        assert(index < bounds.len);
+        bounds.center_x[index] = b.center[0];
+        bounds.center_y[index] = b.center[1];
+        bounds.center_z[index] = b.center[2];
+        bounds.radius[index] = b.radius;
+        bounds.cone_axis_x[index] = b.cone_axis[0];
+        bounds.cone_axis_y[index] = b.cone_axis[1];
+        bounds.cone_axis_z[index] = b.cone_axis[2];
+        bounds.cone_cutoff[index] = b.cone_cutoff;
+    }
+
+    /// Computes bounds of `meshlets` (output of `zmesh.opt.buildMeshlets()`) and stores them starting at `first`.
+    pub fn setMeshlets(
+        bounds: MeshletBounds,
+        first: usize,
+        meshlets: []const opt.Meshlet,
+        meshlet_vertices: []const u32,
+        meshlet_triangles: []const u8,
+        comptime T: type,
+        vertices: []const T,
+    ) void {
+        assert(first + meshlets.len <= bounds.len);
+        for (meshlets) |m, i| {
+            bounds.set(first + i, opt.computeMeshletBounds(
+                meshlet_vertices[m.vertex_offset..][0..m.vertex_count],
+                meshlet_triangles[m.triangle_offset..][0 .. m.triangle_count * 3],
+                T,
+                vertices,
+            ));
+        }
+    }
+};
+
+/// Hierarchical depth buffer. Every texel of level `n + 1` stores the farthest depth of the (up to) 2x2 texels it
+/// covers in level `n`; level sizes are rounded up so a texel of level `n` always covers texels
+/// `[x << n, (x + 1) << n)` of level 0.
+pub const DepthPyramid = struct {
+    pub const Level = struct {
+        width: u32,
+        height: u32,
+        texels: []f32,
+    };
+
+    levels: []Level,
+    data: []f32,
+
+    pub fn init(allocator: std.mem.Allocator, width: u32, height: u32) error{OutOfMemory}!DepthPyramid {
+        assert(width > 0 and height > 0);
+        const num_levels = @as(usize, std.math.log2_int_ceil(u32, std.math.max(width, height))) + 1;
+
+        const levels = try allocator.alloc(Level, num_levels);
+        errdefer allocator.free(levels);
+
+        var size: usize = 0;
+        var w = width;
+        var h = height;
+        for (levels) |*level| {
+            level.* = .{ .width = w, .height = h, .texels = undefined };
+            size += @as(usize, w) * h;
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+
+        const data = try allocator.alloc(f32, size);
+        var offset: usize = 0;
+        for (levels) |*level| {
+            level.texels = data[offset..][0 .. @as(usize, level.width) * level.height];
+            offset += level.texels.len;
+        }
+        return DepthPyramid{ .levels = levels, .data = data };
+    }
+
+    pub fn deinit(pyramid: *DepthPyramid, allocator: std.mem.Allocator) void {
+        allocator.free(pyramid.data);
+        allocator.free(pyramid.levels);
+        pyramid.* = undefined;
+    }
+
+    /// `depth` is the linear view space depth of occluders (row-major, top row first, `width * height` values); use
+    /// `std.math.inf(f32)` where nothing was rendered.
+    pub fn update(pyramid: DepthPyramid, depth: []const f32) void {
+        std.mem.copy(f32, pyramid.levels[0].texels, depth[0..pyramid.levels[0].texels.len]);
+
+        for (pyramid.levels[1..]) |level, i| {
+            const src = pyramid.levels[i];
+            var y: u32 = 0;
+            while (y < level.height) : (y += 1) {
+                const y0 = y * 2;
+                const y1 = std.math.min(y0 + 1, src.height - 1);
+                var x: u32 = 0;
+                while (x < level.width) : (x += 1) {
+                    const x0 = x * 2;
+                    const x1 = std.math.min(x0 + 1, src.width - 1);
+                    level.texels[y * level.width + x] = std.math.max(
+                        std.math.max(src.texels[y0 * src.width + x0], src.texels[y0 * src.width + x1]),
+                        std.math.max(src.texels[y1 * src.width + x0], src.texels[y1 * src.width + x1]),
+                    );
+                }
+            }
+        }
+    }
+
+    /// `rect` is `{ min_u, min_v, max_u, max_v }` in [0, 1] texture space (v down). True when `depth` is behind
+    /// every occluder in `rect`; at most four texels are read.
+    pub fn isOccluded(pyramid: DepthPyramid, rect: [4]f32, depth: f32) bool {
+        const base = pyramid.levels[0];
+        const x0 = toTexel(rect[0], base.width);
+        const y0 = toTexel(rect[1], base.height);
+        const x1 = toTexel(rect[2], base.width);
+        const y1 = toTexel(rect[3], base.height);
+
+        // Smallest level where the rect covers at most 2x2 texels.
+        const span = std.math.max(x1 - x0, y1 - y0) + 1;
+        const n = std.math.min(std.math.log2_int_ceil(u32, span), @intCast(u5, pyramid.levels.len - 1));
+        const level = pyramid.levels[n];
+
+        const row0 = (y0 >> n) * level.width;
+        const row1 = (y1 >> n) * level.width;
+        const max_depth = std.math.max(
+            std.math.max(level.texels[row0 + (x0 >> n)], level.texels[row0 + (x1 >> n)]),
+            std.math.max(level.texels[row1 + (x0 >> n)], level.texels[row1 + (x1 >> n)]),
+        );
+        return depth > max_depth;
+    }
+
+    fn toTexel(t: f32, size: u32) u32 {
+        const texel = @floatToInt(u32, std.math.clamp(t, 0.0, 1.0) * @intToFloat(f32, size));
+        return std.math.min(texel, size - 1);
+    }
+};
+
+pub const Occlusion = struct {
+    /// Bounds space to view space transform.
+    view: [4][4]f32,
+    /// `[0][0]` and `[1][1]` of the perspective projection matrix.
+    projection_scale: [2]f32,
+    z_near: f32,
+    pyramid: *const DepthPyramid,
+};
+
+pub const View = struct {
+    /// Planes `{ a, b, c, d }` with normals pointing inside: a point is inside when `a * x + b * y + c * z + d >= 0`.
+    /// `xyz` must be normalized (see `extractFrustumPlanes()`).
+    planes: [6][4]f32,
+    camera_position: [3]f32,
+    /// Reject meshlets whose normal cone faces away from the camera.
+    cone_culling: bool = true,
+    occlusion: ?Occlusion = null,
+};
+
+/// Frustum planes of a bounds space to clip space transform (`view * projection`).
+pub fn extractFrustumPlanes(view_projection: [4][4]f32) [6][4]f32 {
+    const m = view_projection;
+    const col = struct {
+        fn get(mat: [4][4]f32, c: usize) [4]f32 {
+            return .{ mat[0][c], mat[1][c], mat[2][c], mat[3][c] };
+        }
+    }.get;
+    const c0 = col(m, 0);
+    const c1 = col(m, 1);
+    const c2 = col(m, 2);
+    const c3 = col(m, 3);
+
+    var planes: [6][4]f32 = undefined;
+    for (planes) |*plane, p| {
+        var k: usize = 0;
+        while (k < 4) : (k += 1) {
+            plane[k] = switch (p) {
+                0 => c3[k] + c0[k], // left
+                1 => c3[k] - c0[k], // right
+                2 => c3[k] + c1[k], // bottom
+                3 => c3[k] - c1[k], // top
+                4 => c2[k], // near
+                else => c3[k] - c2[k], // far
+            };
+        }
+        const len = @sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        for (plane) |*v| v.* /= len;
+    }
+    return planes;
+}
+
+/// Writes indices of visible meshlets (ascending) to `visible` (room for `bounds.len` indices), returns their count.
+pub fn cull(bounds: *const MeshletBounds, view: View, visible: []u32) usize {
+    return cullRange(bounds, view, 0, bounds.len, visible);
+}
+
+/// `cull()` for every view on up to `num_threads` threads (0 - one per CPU); meshlets are split into chunks so a
+/// single view scales as well. `visible[i]` receives the visible meshlets of `views[i]`, `counts[i]` their count.
+pub fn cullViews(
+    allocator: std.mem.Allocator,
+    bounds: *const MeshletBounds,
+    views: []const View,
+    visible: []const []u32,
+    counts: []usize,
+    num_threads: u32,
+) error{OutOfMemory}!void {
+    assert(visible.len >= views.len and counts.len >= views.len);
+
+    const chunk_size = 16 * 1024;
+    const num_chunks = std.math.max((bounds.len + chunk_size - 1) / chunk_size, 1);
+
+    const chunk_counts = try allocator.alloc(usize, views.len * num_chunks);
+    defer allocator.free(chunk_counts);
+
+    const Context = struct {
+        bounds: *const MeshletBounds,
+        views: []const View,
+        visible: []const []u32,
+        chunk_counts: []usize,
+        num_chunks: usize,
+
+        fn cullChunk(context: *const @This(), index: usize) void {
+            const view_index = index / context.num_chunks;
+            const first = (index % context.num_chunks) * chunk_size;
+            const last = std.math.min(first + chunk_size, context.bounds.len);
+            context.chunk_counts[index] = cullRange(
+                context.bounds,
+                context.views[view_index],
+                first,
+                last,
+                context.visible[view_index][first..],
+            );
+        }
+    };
+
+    const context = Context{
+        .bounds = bounds,
+        .views = views,
+        .visible = visible,
+        .chunk_counts = chunk_counts,
+        .num_chunks = num_chunks,
+    };
+    parallel.forEach(chunk_counts.len, num_threads, &context, Context.cullChunk);
+
+    // Compact chunk results; destination never overlaps a chunk that wasn't moved yet.
+    for (views) |_, view_index| {
+        var count: usize = 0;
+        for (chunk_counts[view_index * num_chunks ..][0..num_chunks]) |chunk_count, chunk| {
+            const src = visible[view_index][chunk * chunk_size ..][0..chunk_count];
+            std.mem.copy(u32, visible[view_index][count..], src);
+            count += chunk_count;
+        }
+        counts[view_index] = count;
+    }
+}
+
+fn cullRange(bounds: *const MeshletBounds, view: View, first: usize, last: usize, visible: []u32) usize {
+    assert(first % lanes == 0 and visible.len >= last - first);
+
+    var planes: [6][4]F32xN = undefined;
+    for (view.planes) |plane, p| {
+        for (plane) |v, k| planes[p][k] = @splat(lanes, v);
+    }
+    const camera_x = @splat(lanes, view.camera_position[0]);
+    const camera_y = @splat(lanes, view.camera_position[1]);
+    const camera_z = @splat(lanes, view.camera_position[2]);
+    const zero = @splat(lanes, @as(f32, 0.0));
+
+    var count: usize = 0;
+    var i = first;
+    while (i < last) : (i += lanes) {
+        const cx: F32xN = bounds.center_x[i..][0..lanes].*;
+        const cy: F32xN = bounds.center_y[i..][0..lanes].*;
+        const cz: F32xN = bounds.center_z[i..][0..lanes].*;
+        const r: F32xN = bounds.radius[i..][0..lanes].*;
+
+        // Meshlet is visible when `score >= 0`: minimum over the signed distances to all planes (plus radius) and the
+        // cone test.
+        var score = planes[0][0] * cx + planes[0][1] * cy + planes[0][2] * cz + planes[0][3] + r;
+        comptime var p = 1;
+        inline while (p < 6) : (p += 1) {
+            score = @minimum(score, planes[p][0] * cx + planes[p][1] * cy + planes[p][2] * cz + planes[p][3] + r);
+        }
+
+        if (view.cone_culling) {
+            // Backfacing when `dot(center - camera, axis) >= cutoff * length(center - camera) + radius`.
+            const dx = cx - camera_x;
+            const dy = cy - camera_y;
+            const dz = cz - camera_z;
+            const ax: F32xN = bounds.cone_axis_x[i..][0..lanes].*;
+            const ay: F32xN = bounds.cone_axis_y[i..][0..lanes].*;
+            const az: F32xN = bounds.cone_axis_z[i..][0..lanes].*;
+            const cutoff: F32xN = bounds.cone_cutoff[i..][0..lanes].*;
+            const len = @sqrt(dx * dx + dy * dy + dz * dz);
+            score = @minimum(score, cutoff * len + r - (dx * ax + dy * ay + dz * az));
+        }
+
+        const mask = score >= zero;
+        if (!@reduce(.Or, mask)) continue;
+
+        var occluded = [_]bool{false} ** lanes;
+        if (view.occlusion) |occlusion| occluded = testOcclusion(occlusion, cx, cy, cz, r);
+
+        const passed: [lanes]u32 = @select(u32, mask, @splat(lanes, @as(u32, 1)), @splat(lanes, @as(u32, 0)));
+        const num = std.math.min(lanes, last - i);
+        var lane: usize = 0;
+        while (lane < num) : (lane += 1) {
+            visible[count] = @intCast(u32, i + lane);
+            count += passed[lane] & @as(u32, @boolToInt(!occluded[lane]));
+        }
+    }
+    return count;
+}
+
+/// Projects bounding spheres to screen-space rectangles (2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D
+/// Sphere, Mara and McGuire) and tests them against the depth pyramid. Spheres that cross the near plane are never
+/// occluded.
+fn testOcclusion(occlusion: Occlusion, cx: F32xN, cy: F32xN, cz: F32xN, r: F32xN) [lanes]bool {
+    const v = occlusion.view;
+    const vx = cx * @splat(lanes, v[0][0]) + cy * @splat(lanes, v[1][0]) + cz * @splat(lanes, v[2][0]) +
+        @splat(lanes, v[3][0]);
+    const vy = cx * @splat(lanes, v[0][1]) + cy * @splat(lanes, v[1][1]) + cz * @splat(lanes, v[2][1]) +
+        @splat(lanes, v[3][1]);
+    const vz = cx * @splat(lanes, v[0][2]) + cy * @splat(lanes, v[1][2]) + cz * @splat(lanes, v[2][2]) +
+        @splat(lanes, v[3][2]);
+
+    const zero = @splat(lanes, @as(f32, 0.0));
+    const half = @splat(lanes, @as(f32, 0.5));
+    const lx = @sqrt(@maximum(vx * vx + vz * vz - r * r, zero));
+    const ly = @sqrt(@maximum(vy * vy + vz * vz - r * r, zero));
+    const px = @splat(lanes, occlusion.projection_scale[0]);
+    const py = @splat(lanes, occlusion.projection_scale[1]);
+
+    const min_x = px * (vx * lx - vz * r) / (vz * lx + vx * r);
+    const max_x = px * (vx * lx + vz * r) / (vz * lx - vx * r);
+    const min_y = py * (vy * ly - vz * r) / (vz * ly + vy * r);
+    const max_y = py * (vy * ly + vz * r) / (vz * ly - vy * r);
+
+    const min_u: [lanes]f32 = min_x * half + half;
+    const max_u: [lanes]f32 = max_x * half + half;
+    const min_v: [lanes]f32 = half - max_y * half;
+    const max_v: [lanes]f32 = half - min_y * half;
+    const depth: [lanes]f32 = vz - r;
+
+    var occluded: [lanes]bool = undefined;
+    for (occluded) |*o, lane| {
+        o.* = depth[lane] > occlusion.z_near and
+            occlusion.pyramid.isOccluded(.{ min_u[lane], min_v[lane], max_u[lane], max_v[lane] }, depth[lane]);
+    }
+    return occluded;
+}
+
+const expect = std.testing.expect;
+
+fn testPerspective() [4][4]f32 {
+    // 90 degree fov, aspect ratio 1, near 0.1, far 100 (zmath.perspectiveFovLh()).
+    const near = 0.1;
+    const far = 100.0;
+    return .{
+        .{ 1.0, 0.0, 0.0, 0.0 },
+        .{ 0.0, 1.0, 0.0, 0.0 },
+        .{ 0.0, 0.0, far / (far - near), 1.0 },
+        .{ 0.0, 0.0, -near * far / (far - near), 0.0 },
+    };
+}
+
+test "zmesh.culling.frustum_cone_occlusion" {
+    const allocator = std.testing.allocator;
+
+    const spheres = [_][4]f32{
+        .{ 0.0, 0.0, 10.0, 1.0 }, // 0: in front
+        .{ 0.0, 0.0, -10.0, 1.0 }, // 1: behind
+        .{ 50.0, 0.0, 10.0, 1.0 }, // 2: right of the frustum
+        .{ 10.5, 0.0, 10.0, 1.0 }, // 3: crosses the right plane
+        .{ 0.0, 0.0, 10.0, 1.0 }, // 4: in front, backfacing cone
+        .{ -5.0, 0.0, 10.0, 1.0 }, // 5: behind the occluder (left half)
+        .{ 5.0, 0.0, 10.0, 1.0 }, // 6: right half, no occluder
+        .{ -2.0, 0.0, 3.0, 1.0 }, // 7: in front of the occluder
+        .{ 0.0, 0.0, 0.5, 1.0 }, // 8: crosses the near plane
+    };
+
+    var bounds = try MeshletBounds.init(allocator, spheres.len);
+    defer bounds.deinit(allocator);
+    try expect(bounds.center_x.len == 16);
+
+    for (spheres) |s, i| {
+        var b = std.mem.zeroes(opt.Bounds);
+        b.center = .{ s[0], s[1], s[2] };
+        b.radius = s[3];
+        // Normals face the camera (visible) unless the sphere is marked as backfacing.
+        b.cone_axis = if (i == 4) .{ 0.0, 0.0, 1.0 } else .{ 0.0, 0.0, -1.0 };
+        b.cone_cutoff = 0.5;
+        bounds.set(i, b);
+    }
+
+    var view = View{
+        .planes = extractFrustumPlanes(testPerspective()),
+        .camera_position = .{ 0.0, 0.0, 0.0 },
+        .cone_culling = false,
+    };
+
+    var visible: [spheres.len]u32 = undefined;
+    var count = cull(&bounds, view, visible[0..]);
+    try expect(std.mem.eql(u32, visible[0..count], &.{ 0, 3, 4, 5, 6, 7, 8 }));
+
+    view.cone_culling = true;
+    count = cull(&bounds, view, visible[0..]);
+    try expect(std.mem.eql(u32, visible[0..count], &.{ 0, 3, 5, 6, 7, 8 }));
+
+    // Occluder at depth 5 covering the left half of the screen.
+    var pyramid = try DepthPyramid.init(allocator, 64, 48);
+    defer pyramid.deinit(allocator);
+    try expect(pyramid.levels.len == 7);
+    try expect(pyramid.levels[6].width == 1 and pyramid.levels[6].height == 1);
+    {
+        var depth: [64 * 48]f32 = undefined;
+        for (depth) |*d, i| d.* = if (i % 64 < 32) 5.0 else std.math.inf(f32);
+        pyramid.update(depth[0..]);
+    }
+    try expect(pyramid.levels[1].texels[0] == 5.0);
+    try expect(pyramid.levels[6].texels[0] == std.math.inf(f32));
+
+    view.occlusion = .{
+        .view = .{
+            .{ 1.0, 0.0, 0.0, 0.0 },
+            .{ 0.0, 1.0, 0.0, 0.0 },
+            .{ 0.0, 0.0, 1.0, 0.0 },
+            .{ 0.0, 0.0, 0.0, 1.0 },
+        },
+        .projection_scale = .{ 1.0, 1.0 },
+        .z_near = 0.1,
+        .pyramid = &pyramid,
+    };
+    count = cull(&bounds, view, visible[0..]);
+    try expect(std.mem.eql(u32, visible[0..count], &.{ 0, 3, 6, 7, 8 }));
+}
+
+test "zmesh.culling.meshlets" {
+    const zmesh = @import("main.zig");
+    const allocator = std.testing.allocator;
+    zmesh.init(allocator);
+    defer zmesh.deinit();
+
+    const sphere = zmesh.Shape.initParametricSphere(64, 64);
+    defer sphere.deinit();
+
+    const indices = try allocator.alloc(u32, sphere.indices.len);
+    defer allocator.free(indices);
+    for (sphere.indices) |index, i| indices[i] = index;
+
+    const max_vertices = 64;
+    const max_triangles = 124;
+    const max_meshlets = opt.buildMeshletsBound(indices.len, max_vertices, max_triangles);
+    const meshlets = try allocator.alloc(opt.Meshlet, max_meshlets);
+    defer allocator.free(meshlets);
+    const meshlet_vertices = try allocator.alloc(u32, max_meshlets * max_vertices);
+    defer allocator.free(meshlet_vertices);
+    const meshlet_triangles = try allocator.alloc(u8, max_meshlets * max_triangles * 3);
+    defer allocator.free(meshlet_triangles);
+
+    const num_meshlets = opt.buildMeshlets(
+        meshlets,
+        meshlet_vertices,
+        meshlet_triangles,
+        indices,
+        [3]f32,
+        sphere.positions,
+        max_vertices,
+        max_triangles,
+        0.5,
+    );
+
+    // Many copies of the sphere (all in the frustum) so `cullViews()` has to merge several chunks.
+    const num_copies = 200;
+    var bounds = try MeshletBounds.init(allocator, num_meshlets * num_copies);
+    defer bounds.deinit(allocator);
+    {
+        var copy: usize = 0;
+        while (copy < num_copies) : (copy += 1) {
+            bounds.setMeshlets(
+                copy * num_meshlets,
+                meshlets[0..num_meshlets],
+                meshlet_vertices,
+                meshlet_triangles,
+                [3]f32,
+                sphere.positions,
+            );
+        }
+        for (bounds.center_z[0..bounds.len]) |*z, i| z.* += 5.0 + 1.8 * @intToFloat(f32, i / num_meshlets % 50);
+        for (bounds.center_x[0..bounds.len]) |*x, i| x.* += @intToFloat(f32, i / num_meshlets / 50) - 2.0;
+    }
+    try expect(bounds.len > 16 * 1024);
+
+    const views = [_]View{
+        .{ .planes = extractFrustumPlanes(testPerspective()), .camera_position = .{ 0.0, 0.0, 0.0 } },
+        .{
+            .planes = extractFrustumPlanes(testPerspective()),
+            .camera_position = .{ 0.0, 0.0, 0.0 },
+            .cone_culling = false,
+        },
+    };
+
+    const visible = try allocator.alloc(u32, bounds.len * (views.len + 1));
+    defer allocator.free(visible);
+    const visible_per_view = [_][]u32{ visible[0..bounds.len], visible[bounds.len..][0..bounds.len] };
+    var counts: [views.len]usize = undefined;
+    try cullViews(allocator, &bounds, views[0..], visible_per_view[0..], counts[0..], 4);
+
+    // Without cone culling everything is in the frustum; the back of every sphere is culled with it.
+    try expect(counts[1] == bounds.len);
+    try expect(counts[0] < bounds.len * 3 / 4 and counts[0] > bounds.len / 4);
+
+    const expected = visible[bounds.len * 2 ..][0..bounds.len];
+    const expected_count = cull(&bounds, views[0], expected);
+    try expect(expected_count == counts[0]);
+    try expect(std.mem.eql(u32, expected[0..expected_count], visible_per_view[0][0..counts[0]]));
+}
@@ -1,6 +1,10 @@
 const std = @import("std");
 const assert = std.debug.assert;
 const mem = @import("memory.zig");
+const MappedFile = @import("MappedFile.zig");
+const convert = @import("convert.zig");
+const parallel = @import("parallel.zig");
+const opt = @import("zmeshoptimizer.zig");
 pub const cgltf = @import("zcgltf.zig");
 
 pub fn parseAndLoadFile(gltf_path: [:0]const u8) cgltf.Error!*cgltf.Data {
@@ -15,10 +19,371 @@ pub fn parseAndLoadFile(gltf_path: [:0]const u8) cgltf.Error!*cgltf.Data {
     errdefer cgltf.free(data);
 
     try cgltf.loadBuffers(options, data, gltf_path);
+    try decodeMeshoptCompression(data, 0);
 
     return data;
 }
 
+/// Decodes `EXT_meshopt_compression` buffer views (vertex/index codecs and filters) into `BufferView.data`, which
+/// takes precedence over the (fallback) buffer and is released by `cgltf.free()`. Views are decoded in parallel on up
+/// to `num_threads` threads (0 - one per CPU). Called by `parseAndLoadFile()` and `parseAndMapFile()`.
+pub fn decodeMeshoptCompression(data: *cgltf.Data, num_threads: u32) error{ OutOfMemory, InvalidGltf }!void {
+    const buffer_views = if (data.buffer_views) |views| views[0..data.buffer_views_count] else return;
+
+    // Validation and allocation are done up front: cgltf allocation callbacks don't need to be thread-safe and codec
+    // parameters are only asserted by meshoptimizer. Views which already have data are left alone.
+    var num_pending: usize = 0;
+    for (buffer_views) |*view| {
+        if (view.has_meshopt_compression == 0 or view.data != null) continue;
+
+        const mc = &view.meshopt_compression;
+        const mode_ok = switch (mc.mode) {
+            .attributes => mc.stride > 0 and mc.stride % 4 == 0 and mc.stride <= 256,
+            .triangles => (mc.stride == 2 or mc.stride == 4) and mc.count % 3 == 0 and mc.filter == .none,
+            .indices => (mc.stride == 2 or mc.stride == 4) and mc.filter == .none,
+            .invalid => false,
+        };
+        const filter_ok = switch (mc.filter) {
+            .none, .exponential => true,
+            .octahedral => mc.stride == 4 or mc.stride == 8,
+            .quaternion => mc.stride == 8,
+        };
+        if (!mode_ok or !filter_ok or mc.buffer.data == null or
+            mc.size > mc.buffer.size or mc.offset > mc.buffer.size - mc.size or
+            mc.count > std.math.maxInt(usize) / mc.stride)
+        {
+            return error.InvalidGltf;
+        }
+        if (mc.count > 0) num_pending += 1;
+    }
+    if (num_pending == 0) return;
+
+    const memory = data.memory;
+    const pending_memory = memory.alloc.?(memory.user_data, num_pending * @sizeOf(*cgltf.BufferView)) orelse
+        return error.OutOfMemory;
+    defer memory.free.?(memory.user_data, pending_memory);
+    const pending = @ptrCast(
+        [*]*cgltf.BufferView,
+        @alignCast(@alignOf(*cgltf.BufferView), pending_memory),
+    )[0..num_pending];
+
+    num_pending = 0;
+    for (buffer_views) |*view| {
+        if (view.has_meshopt_compression == 0 or view.data != null or view.meshopt_compression.count == 0) continue;
+
+        const mc = &view.meshopt_compression;
+        view.data = memory.alloc.?(memory.user_data, mc.count * mc.stride) orelse return error.OutOfMemory;
+        pending[num_pending] = view;
+        num_pending += 1;
+    }
+
+    const Context = struct {
+        pending: []*cgltf.BufferView,
+        failed: bool = false,
+
+        fn decode(context: *@This(), index: usize) void {
+            decodeBufferView(context.pending[index]) catch @atomicStore(bool, &context.failed, true, .Monotonic);
+        }
+    };
+    var context = Context{ .pending = pending };
+    parallel.forEach(pending.len, num_threads, &context, Context.decode);
+
+    if (context.failed) return error.InvalidGltf;
+}
+
+fn decodeBufferView(view: *cgltf.BufferView) error{InvalidData}!void {
+    const mc = &view.meshopt_compression;
+    const src = (@ptrCast([*]const u8, mc.buffer.data.?) + mc.offset)[0..mc.size];
+    const dst = @ptrCast([*]u8, view.data.?)[0 .. mc.count * mc.stride];
+
+    switch (mc.mode) {
+        .attributes => try opt.decodeVertexBuffer(dst, mc.stride, src),
+        .triangles => if (mc.stride == 2)
+            try opt.decodeIndexBuffer(u16, std.mem.bytesAsSlice(u16, @alignCast(2, dst)), src)
+        else
+            try opt.decodeIndexBuffer(u32, std.mem.bytesAsSlice(u32, @alignCast(4, dst)), src),
+        .indices => if (mc.stride == 2)
+            try opt.decodeIndexSequence(u16, std.mem.bytesAsSlice(u16, @alignCast(2, dst)), src)
+        else
+            try opt.decodeIndexSequence(u32, std.mem.bytesAsSlice(u32, @alignCast(4, dst)), src),
+        .invalid => unreachable,
+    }
+
+    switch (mc.filter) {
+        .none => {},
+        .octahedral => opt.decodeFilterOct(dst, mc.stride),
+        .quaternion => opt.decodeFilterQuat(dst),
+        .exponential => opt.decodeFilterExp(dst, mc.stride),
+    }
+}
+
+/// glTF/GLB file and its external buffers mapped into memory. cgltf buffers point into the mappings (GLB BIN chunk,
+/// external .bin files), only base64 data URIs and meshopt-compressed buffer views are decoded into allocated memory.
+pub const MappedGltf = struct {
+    data: *cgltf.Data,
+    /// `files[0]` is the glTF/GLB file.
+    files: []MappedFile,
+
+    pub fn deinit(mapped: *MappedGltf, allocator: std.mem.Allocator) void {
+        cgltf.free(mapped.data);
+        for (mapped.files) |file| file.deinit();
+        allocator.free(mapped.files);
+        mapped.* = undefined;
+    }
+};
+
+pub fn parseAndMapFile(allocator: std.mem.Allocator, gltf_path: [:0]const u8) !MappedGltf {
+    const options = cgltf.Options{
+        .memory = .{
+            .alloc = mem.zmeshAllocUser,
+            .free = mem.zmeshFreeUser,
+        },
+    };
+
+    var files = std.ArrayList(MappedFile).init(allocator);
+    defer files.deinit();
+    errdefer {
+        for (files.items) |file| file.deinit();
+    }
+
+    try files.ensureUnusedCapacity(1);
+    files.appendAssumeCapacity(try MappedFile.init(gltf_path));
+
+    const data = try cgltf.parse(options, files.items[0].bytes);
+    errdefer cgltf.free(data);
+
+    if (data.buffers) |buffers| {
+        for (buffers[0..data.buffers_count]) |*buffer| {
+            if (buffer.data != null or buffer.uri == null or buffer.size == 0) continue;
+
+            const uri = std.mem.sliceTo(buffer.uri.?, 0);
+            if (std.mem.startsWith(u8, uri, "data:") or std.mem.indexOf(u8, uri, "://") != null) continue;
+
+            const decoded_uri = try allocator.dupeZ(u8, uri);
+            defer allocator.free(decoded_uri);
+            const path = try std.fs.path.join(allocator, &.{
+                std.fs.path.dirname(gltf_path) orelse ".",
+                cgltf.decodeUri(decoded_uri),
+            });
+            defer allocator.free(path);
+
+            try files.ensureUnusedCapacity(1);
+            const file = try MappedFile.init(path);
+            files.appendAssumeCapacity(file);
+            if (file.bytes.len < buffer.size) return error.DataTooShort;
+
+            buffer.data = @intToPtr(*anyopaque, @ptrToInt(file.bytes.ptr));
+            buffer.data_free_method = .none;
+        }
+    }
+
+    // Points GLB buffer at the BIN chunk and decodes data URIs; mapped buffers are skipped.
+    try cgltf.loadBuffers(options, data, gltf_path);
+    try decodeMeshoptCompression(data, 0);
+
+    return MappedGltf{ .data = data, .files = files.toOwnedSlice() };
+}
+
+/// Accessor data as `[]const T`. `items` alias buffer memory (no copy) when the accessor layout matches `T` exactly;
+/// otherwise they are converted into memory allocated with `allocator` and `owned` is set.
+pub fn AccessorSlice(comptime T: type) type {
+    return struct {
+        items: []const T,
+        owned: bool,
+
+        pub fn deinit(slice: @This(), allocator: std.mem.Allocator) void {
+            if (slice.owned) allocator.free(slice.items);
+        }
+    };
+}
+
+/// `T` is a scalar (f32, u32, u16, u8, i16, i8) or an array of them matching accessor type (e.g. `[3]f32` for vec3).
+/// See `readAccessor()` for supported conversions.
+pub fn getAccessorSlice(
+    comptime T: type,
+    allocator: std.mem.Allocator,
+    accessor: *const cgltf.Accessor,
+) (error{OutOfMemory} || convert.Error)!AccessorSlice(T) {
+    if (accessor.type.numComponents() != convert.numComponents(T)) return error.AccessorTypeMismatch;
+
+    if (accessor.is_sparse == 0 and
+        accessor.component_type == convert.componentType(convert.ComponentOf(T)) and
+        accessor.stride == @sizeOf(T))
+    {
+        if (accessor.buffer_view) |buffer_view| {
+            if (convert.getBufferViewData(buffer_view)) |data| {
+                const address = @ptrToInt(data) + accessor.offset;
+                if (address % @alignOf(T) == 0) {
+                    return AccessorSlice(T){
+                        .items = @intToPtr([*]const T, address)[0..accessor.count],
+                        .owned = false,
+                    };
+                }
+            }
+        }
+    }
+
+    const items = try allocator.alloc(T, accessor.count);
+    errdefer allocator.free(items);
+    try convert.readAccessor(T, accessor, items);
+
+    return AccessorSlice(T){ .items = items, .owned = true };
+}
+
+/// Reads `accessor.count` elements into `out`, widening and normalizing components (SIMD for 8/16-bit integers).
+/// f32 output accepts every component type (e.g. `KHR_mesh_quantization` attributes), unsigned integer output
+/// accepts unsigned sources. Strided (interleaved) and sparse accessors are supported.
+pub const readAccessor = convert.readAccessor;
+
+pub const MeshPrimitiveRange = struct {
+    index_offset: u32,
+    index_count: u32,
+    vertex_offset: u32,
+    vertex_count: u32,
+};
+
+pub const MeshAttributes = struct {
+    normals: bool = true,
+    texcoords0: bool = true,
+    tangents: bool = false,
+};
+
+/// All primitives of a glTF mesh in shared arrays. Indices of every primitive are relative to its `vertex_offset`.
+/// Requested attributes which a primitive doesn't have are zero-filled.
+pub const MeshData = struct {
+    indices: []u32,
+    positions: [][3]f32,
+    normals: ?[][3]f32,
+    texcoords0: ?[][2]f32,
+    tangents: ?[][4]f32,
+    primitives: []MeshPrimitiveRange,
+
+    pub fn deinit(mesh_data: *MeshData, allocator: std.mem.Allocator) void {
+        allocator.free(mesh_data.indices);
+        allocator.free(mesh_data.positions);
+        if (mesh_data.normals) |normals| allocator.free(normals);
+        if (mesh_data.texcoords0) |texcoords0| allocator.free(texcoords0);
+        if (mesh_data.tangents) |tangents| allocator.free(tangents);
+        allocator.free(mesh_data.primitives);
+        mesh_data.* = undefined;
+    }
+};
+
+/// Converts all primitives of a mesh, on up to `num_threads` threads (0 - one per CPU).
+pub fn loadMesh(
+    allocator: std.mem.Allocator,
+    data: *cgltf.Data,
+    mesh_index: u32,
+    attributes: MeshAttributes,
+    num_threads: u32,
+) (error{ OutOfMemory, MissingPositions } || convert.Error)!MeshData {
+    assert(mesh_index < data.meshes_count);
+    const mesh = &data.meshes.?[mesh_index];
+    const prims = mesh.primitives[0..mesh.primitives_count];
+
+    var num_indices: u32 = 0;
+    var num_vertices: u32 = 0;
+    const ranges = blk: {
+        const prim_ranges = try allocator.alloc(MeshPrimitiveRange, prims.len);
+        // Owned by `mesh_data` (and freed by its errdefer) once this block is left.
+        errdefer allocator.free(prim_ranges);
+
+        for (prims) |*prim, i| {
+            const positions = findAttribute(prim, .position, 0) orelse return error.MissingPositions;
+            const vertex_count = @intCast(u32, positions.count);
+            const index_count = if (prim.indices) |indices| @intCast(u32, indices.count) else vertex_count;
+            prim_ranges[i] = .{
+                .index_offset = num_indices,
+                .index_count = index_count,
+                .vertex_offset = num_vertices,
+                .vertex_count = vertex_count,
+            };
+            num_indices += index_count;
+            num_vertices += vertex_count;
+        }
+        break :blk prim_ranges;
+    };
+
+    var mesh_data = MeshData{
+        .indices = @as([*]u32, undefined)[0..0],
+        .positions = @as([*][3]f32, undefined)[0..0],
+        .normals = null,
+        .texcoords0 = null,
+        .tangents = null,
+        .primitives = ranges,
+    };
+    errdefer mesh_data.deinit(allocator);
+
+    mesh_data.indices = try allocator.alloc(u32, num_indices);
+    mesh_data.positions = try allocator.alloc([3]f32, num_vertices);
+    if (attributes.normals) mesh_data.normals = try allocator.alloc([3]f32, num_vertices);
+    if (attributes.texcoords0) mesh_data.texcoords0 = try allocator.alloc([2]f32, num_vertices);
+    if (attributes.tangents) mesh_data.tangents = try allocator.alloc([4]f32, num_vertices);
+
+    const results = try allocator.alloc(convert.Error!void, prims.len);
+    defer allocator.free(results);
+
+    const Context = struct {
+        prims: []cgltf.Primitive,
+        mesh_data: *const MeshData,
+        results: []convert.Error!void,
+
+        fn load(context: *const @This(), index: usize) void {
+            context.results[index] = loadPrimitive(
+                &context.prims[index],
+                context.mesh_data.*,
+                context.mesh_data.primitives[index],
+            );
+        }
+    };
+    const context = Context{ .prims = prims, .mesh_data = &mesh_data, .results = results };
+    parallel.forEach(prims.len, num_threads, &context, Context.load);
+
+    for (results) |result| try result;
+
+    return mesh_data;
+}
+
+fn findAttribute(prim: *const cgltf.Primitive, attribute_type: cgltf.AttributeType, index: i32) ?*cgltf.Accessor {
+    for (prim.attributes[0..prim.attributes_count]) |attrib| {
+        if (attrib.type == attribute_type and attrib.index == index) return attrib.data;
+    }
+    return null;
+}
+
+fn loadPrimitive(prim: *const cgltf.Primitive, mesh_data: MeshData, range: MeshPrimitiveRange) convert.Error!void {
+    const indices = mesh_data.indices[range.index_offset..][0..range.index_count];
+    if (prim.indices) |accessor| {
+        try convert.readAccessor(u32, accessor, indices);
+    } else {
+        for (indices) |*index, i| index.* = @intCast(u32, i);
+    }
+
+    const positions = mesh_data.positions[range.vertex_offset..][0..range.vertex_count];
+    try convert.readAccessor([3]f32, findAttribute(prim, .position, 0).?, positions);
+    try loadOptionalAttribute([3]f32, prim, .normal, mesh_data.normals, range);
+    try loadOptionalAttribute([2]f32, prim, .texcoord, mesh_data.texcoords0, range);
+    try loadOptionalAttribute([4]f32, prim, .tangent, mesh_data.tangents, range);
+}
+
+fn loadOptionalAttribute(
+    comptime T: type,
+    prim: *const cgltf.Primitive,
+    attribute_type: cgltf.AttributeType,
+    maybe_out: ?[]T,
+    range: MeshPrimitiveRange,
+) convert.Error!void {
+    if (maybe_out) |out| {
+        const dst = out[range.vertex_offset..][0..range.vertex_count];
+        if (findAttribute(prim, attribute_type, 0)) |accessor| {
+            if (accessor.count != range.vertex_count) return error.InvalidAccessor;
+            try convert.readAccessor(T, accessor, dst);
+        } else {
+            std.mem.set(T, dst, std.mem.zeroes(T));
+        }
+    }
+}
+
 pub fn appendMeshPrimitive(
     data: *cgltf.Data,
     mesh_index: u32,
@@ -40,42 +405,10 @@ pub fn appendMeshPrimitive(
 
     // Indices.
     {
-        try indices.ensureTotalCapacity(indices.items.len + num_indices);
-
-        const accessor = prim.indices.?;
-        const buffer_view = accessor.buffer_view.?;
-
-        assert(accessor.stride == buffer_view.stride or buffer_view.stride == 0);
-        assert(accessor.stride * accessor.count == buffer_view.size);
-        assert(buffer_view.buffer.data != null);
-
-        const data_addr = @alignCast(4, @ptrCast([*]const u8, buffer_view.buffer.data) +
-            accessor.offset + buffer_view.offset);
-
-        if (accessor.stride == 1) {
-            assert(accessor.component_type == .r_8u);
-            const src = @ptrCast([*]const u8, data_addr);
-            var i: u32 = 0;
-            while (i < num_indices) : (i += 1) {
-                indices.appendAssumeCapacity(src[i]);
-            }
-        } else if (accessor.stride == 2) {
-            assert(accessor.component_type == .r_16u);
-            const src = @ptrCast([*]const u16, data_addr);
-            var i: u32 = 0;
-            while (i < num_indices) : (i += 1) {
-                indices.appendAssumeCapacity(src[i]);
-            }
-        } else if (accessor.stride == 4) {
-            assert(accessor.component_type == .r_32u);
-            const src = @ptrCast([*]const u32, data_addr);
-            var i: u32 = 0;
-            while (i < num_indices) : (i += 1) {
-                indices.appendAssumeCapacity(src[i]);
-            }
-        } else {
-            unreachable;
-        }
+        try indices.ensureUnusedCapacity(num_indices);
+        const dst = indices.items.ptr[indices.items.len .. indices.items.len + num_indices];
+        try convert.readAccessor(u32, prim.indices.?, dst);
+        indices.items.len += num_indices;
     }
 
     // Attributes.
@@ -83,40 +416,279 @@ pub fn appendMeshPrimitive(
         const attributes = prim.attributes[0..prim.attributes_count];
         for (attributes) |attrib| {
             const accessor = attrib.data;
-            assert(accessor.component_type == .r_32f);
-
-            const buffer_view = accessor.buffer_view.?;
-            assert(buffer_view.buffer.data != null);
-
-            assert(accessor.stride == buffer_view.stride or buffer_view.stride == 0);
-            assert(accessor.stride * accessor.count == buffer_view.size);
-
-            const data_addr = @ptrCast([*]const u8, buffer_view.buffer.data) +
-                accessor.offset + buffer_view.offset;
+            assert(accessor.count == num_vertices);
 
             if (attrib.type == .position) {
-                assert(accessor.type == .vec3);
-                const slice = @ptrCast([*]const [3]f32, @alignCast(4, data_addr))[0..num_vertices];
-                try positions.appendSlice(slice);
+                try appendAccessor([3]f32, positions, accessor);
             } else if (attrib.type == .normal) {
-                if (normals) |n| {
-                    assert(accessor.type == .vec3);
-                    const slice = @ptrCast([*]const [3]f32, @alignCast(4, data_addr))[0..num_vertices];
-                    try n.appendSlice(slice);
-                }
-            } else if (attrib.type == .texcoord) {
-                if (texcoords0) |tc| {
-                    assert(accessor.type == .vec2);
-                    const slice = @ptrCast([*]const [2]f32, @alignCast(4, data_addr))[0..num_vertices];
-                    try tc.appendSlice(slice);
-                }
+                if (normals) |n| try appendAccessor([3]f32, n, accessor);
+            } else if (attrib.type == .texcoord and attrib.index == 0) {
+                if (texcoords0) |tc| try appendAccessor([2]f32, tc, accessor);
             } else if (attrib.type == .tangent) {
-                if (tangents) |tan| {
-                    assert(accessor.type == .vec4);
-                    const slice = @ptrCast([*]const [4]f32, @alignCast(4, data_addr))[0..num_vertices];
-                    try tan.appendSlice(slice);
-                }
+                if (tangents) |tan| try appendAccessor([4]f32, tan, accessor);
             }
         }
     }
 }
+
+fn appendAccessor(comptime T: type, list: *std.ArrayList(T), accessor: *const cgltf.Accessor) !void {
+    try list.ensureUnusedCapacity(accessor.count);
+    try convert.readAccessor(T, accessor, list.items.ptr[list.items.len .. list.items.len + accessor.count]);
+    list.items.len += accessor.count;
+}
+
+const expect = std.testing.expect;
+
+test "zmesh.io.mapped" {
+    const zmesh = @import("main.zig");
+    zmesh.init(std.testing.allocator);
+    defer zmesh.deinit();
+
+    const allocator = std.testing.allocator;
+
+    const json_fmt =
+        \\{{"asset":{{"version":"2.0"}},"buffers":[{{{s}"byteLength":56}}],
+        \\"bufferViews":[{{"buffer":0,"byteLength":36}},{{"buffer":0,"byteOffset":36,"byteLength":6}},
+        \\{{"buffer":0,"byteOffset":44,"byteLength":12}}],
+        \\"accessors":[{{"bufferView":0,"componentType":5126,"count":3,"type":"VEC3"}},
+        \\{{"bufferView":1,"componentType":5123,"count":3,"type":"SCALAR"}},
+        \\{{"bufferView":2,"componentType":5123,"normalized":true,"count":3,"type":"VEC2"}}],
+        \\"meshes":[{{"primitives":[{{"attributes":{{"POSITION":0,"TEXCOORD_0":2}},"indices":1}}]}}]}}
+    ;
+    const positions = [3][3]f32{ .{ 0.0, 0.0, 0.0 }, .{ 1.0, 0.0, 0.0 }, .{ 0.0, 1.0, 0.0 } };
+    const indices = [3]u16{ 0, 1, 2 };
+    const texcoords = [3][2]u16{ .{ 0, 0 }, .{ 0xffff, 0 }, .{ 0, 0x8000 } };
+
+    var bin: [56]u8 = [_]u8{0} ** 56;
+    std.mem.copy(u8, bin[0..36], std.mem.sliceAsBytes(positions[0..]));
+    std.mem.copy(u8, bin[36..42], std.mem.sliceAsBytes(indices[0..]));
+    std.mem.copy(u8, bin[44..56], std.mem.sliceAsBytes(texcoords[0..]));
+
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const tmp_path = try tmp.dir.realpathAlloc(allocator, ".");
+    defer allocator.free(tmp_path);
+
+    // GLB: buffer 0 is the BIN chunk.
+    {
+        const json = try std.fmt.allocPrint(allocator, json_fmt, .{""});
+        defer allocator.free(json);
+        const json_len = std.mem.alignForward(json.len, 4);
+
+        const file = try tmp.dir.createFile("mesh.glb", .{});
+        defer file.close();
+        const writer = file.writer();
+        try writer.writeIntLittle(u32, 0x46546c67);
+        try writer.writeIntLittle(u32, 2);
+        try writer.writeIntLittle(u32, @intCast(u32, 12 + 8 + json_len + 8 + bin.len));
+        try writer.writeIntLittle(u32, @intCast(u32, json_len));
+        try writer.writeIntLittle(u32, 0x4e4f534a);
+        try writer.writeAll(json);
+        try writer.writeByteNTimes(' ', json_len - json.len);
+        try writer.writeIntLittle(u32, bin.len);
+        try writer.writeIntLittle(u32, 0x004e4942);
+        try writer.writeAll(&bin);
+    }
+    // glTF with an external (percent-encoded) buffer file.
+    {
+        const json = try std.fmt.allocPrint(allocator, json_fmt, .{"\"uri\":\"mesh%20data.bin\","});
+        defer allocator.free(json);
+        try tmp.dir.writeFile("mesh.gltf", json);
+        try tmp.dir.writeFile("mesh data.bin", &bin);
+    }
+
+    for ([_][]const u8{ "mesh.glb", "mesh.gltf" }) |name| {
+        const path = try std.fs.path.joinZ(allocator, &.{ tmp_path, name });
+        defer allocator.free(path);
+
+        var mapped = try parseAndMapFile(allocator, path);
+        defer mapped.deinit(allocator);
+
+        const mapped_bytes = mapped.files[mapped.files.len - 1].bytes;
+        const prim = &mapped.data.meshes.?[0].primitives[0];
+
+        const pos = try getAccessorSlice([3]f32, allocator, prim.attributes[0].data);
+        defer pos.deinit(allocator);
+        try expect(!pos.owned);
+        try expect(@ptrToInt(pos.items.ptr) >= @ptrToInt(mapped_bytes.ptr));
+        try expect(@ptrToInt(pos.items.ptr) < @ptrToInt(mapped_bytes.ptr) + mapped_bytes.len);
+        try expect(std.mem.eql(f32, &pos.items[1], &positions[1]));
+
+        const ind16 = try getAccessorSlice(u16, allocator, prim.indices.?);
+        defer ind16.deinit(allocator);
+        try expect(!ind16.owned and std.mem.eql(u16, ind16.items, &indices));
+
+        const ind32 = try getAccessorSlice(u32, allocator, prim.indices.?);
+        defer ind32.deinit(allocator);
+        try expect(ind32.owned and ind32.items[2] == 2);
+
+        const uv = try getAccessorSlice([2]f32, allocator, prim.attributes[1].data);
+        defer uv.deinit(allocator);
+        try expect(uv.owned and uv.items[1][0] == 1.0 and uv.items[1][1] == 0.0);
+        try expect(std.math.approxEqAbs(f32, uv.items[2][1], 0.5, 0.0001));
+
+        try std.testing.expectError(
+            error.AccessorTypeMismatch,
+            getAccessorSlice([2]f32, allocator, prim.attributes[0].data),
+        );
+
+        var mesh_data = try loadMesh(allocator, mapped.data, 0, .{ .tangents = true }, 2);
+        defer mesh_data.deinit(allocator);
+        try expect(mesh_data.primitives.len == 1 and mesh_data.primitives[0].index_count == 3);
+        try expect(std.mem.eql(u32, mesh_data.indices, &[_]u32{ 0, 1, 2 }));
+        try expect(std.mem.eql(f32, &mesh_data.positions[2], &positions[2]));
+        try expect(mesh_data.normals.?[0][1] == 0.0 and mesh_data.tangents.?[2][3] == 0.0);
+        try expect(mesh_data.texcoords0.?[1][0] == 1.0);
+
+        // Every allocation failure is reported without leaks or double frees.
+        var fail_index: usize = 0;
+        while (true) : (fail_index += 1) {
+            var failing = std.testing.FailingAllocator.init(allocator, fail_index);
+            if (loadMesh(failing.allocator(), mapped.data, 0, .{ .tangents = true }, 2)) |result| {
+                var loaded = result;
+                loaded.deinit(failing.allocator());
+                break;
+            } else |err| try expect(err == error.OutOfMemory);
+        }
+    }
+}
+
+test "zmesh.io.meshopt_compression" {
+    const zmesh = @import("main.zig");
+    zmesh.init(std.testing.allocator);
+    defer zmesh.deinit();
+
+    const allocator = std.testing.allocator;
+
+    var sphere = zmesh.Shape.initParametricSphere(16, 12);
+    defer sphere.deinit();
+
+    const vertex_count = sphere.positions.len;
+    const index_count = sphere.indices.len;
+
+    const indices = try allocator.alloc(u32, index_count);
+    defer allocator.free(indices);
+    for (sphere.indices) |index, i| indices[i] = index;
+
+    const normals = try allocator.alloc(f32, vertex_count * 4);
+    defer allocator.free(normals);
+    for (sphere.normals.?) |n, i| normals[i * 4 ..][0..4].* = .{ n[0], n[1], n[2], 0.0 };
+
+    const oct_normals = try allocator.alignedAlloc(u8, 4, vertex_count * 8);
+    defer allocator.free(oct_normals);
+    opt.encodeFilterOct(oct_normals, 8, 12, normals);
+
+    // Buffer 0 holds encoded views (4-byte aligned), buffer 1 is the uncompressed fallback (not loaded).
+    var bin = std.ArrayList(u8).init(allocator);
+    defer bin.deinit();
+    var offsets: [4]usize = undefined;
+    var sizes: [4]usize = undefined;
+    for (offsets) |*offset, i| {
+        offset.* = std.mem.alignForward(bin.items.len, 4);
+        try bin.resize(offset.* + opt.encodeVertexBufferBound(vertex_count, 12) +
+            opt.encodeIndexBufferBound(index_count, vertex_count) +
+            opt.encodeIndexSequenceBound(index_count, vertex_count));
+
+        const dst = bin.items[offset.*..];
+        sizes[i] = switch (i) {
+            0 => opt.encodeVertexBuffer(dst, std.mem.sliceAsBytes(sphere.positions), 12),
+            1 => opt.encodeVertexBuffer(dst, oct_normals, 8),
+            2 => opt.encodeIndexBuffer(dst, indices),
+            else => opt.encodeIndexSequence(dst, indices),
+        };
+        try expect(sizes[i] > 0);
+        bin.shrinkRetainingCapacity(offset.* + sizes[i]);
+    }
+
+    const view_fmt =
+        \\{{"buffer":1,"byteLength":{d},{s}"extensions":{{"EXT_meshopt_compression":{{"buffer":0,
+        \\"byteOffset":{d},"byteLength":{d},"byteStride":{d},"count":{d},"mode":"{s}"{s}}}}}}}
+    ;
+    var views: [4][]u8 = undefined;
+    views[0] = try std.fmt.allocPrint(allocator, view_fmt, .{
+        vertex_count * 12, "\"byteStride\":12,", offsets[0], sizes[0], 12, vertex_count, "ATTRIBUTES", "",
+    });
+    views[1] = try std.fmt.allocPrint(allocator, view_fmt, .{
+        vertex_count * 8, "\"byteStride\":8,", offsets[1], sizes[1], 8, vertex_count, "ATTRIBUTES",
+        ",\"filter\":\"OCTAHEDRAL\"",
+    });
+    views[2] = try std.fmt.allocPrint(allocator, view_fmt, .{
+        index_count * 4, "", offsets[2], sizes[2], 4, index_count, "TRIANGLES", "",
+    });
+    views[3] = try std.fmt.allocPrint(allocator, view_fmt, .{
+        index_count * 2, "", offsets[3], sizes[3], 2, index_count, "INDICES", "",
+    });
+    defer {
+        for (views) |view| allocator.free(view);
+    }
+
+    const json = try std.fmt.allocPrint(allocator,
+        \\{{"asset":{{"version":"2.0"}},"extensionsUsed":["EXT_meshopt_compression"],
+        \\"buffers":[{{"byteLength":{d}}},{{"byteLength":{d},"extensions":{{"EXT_meshopt_compression":{{"fallback":true}}}}}}],
+        \\"bufferViews":[{s},{s},{s},{s}],
+        \\"accessors":[{{"bufferView":0,"componentType":5126,"count":{d},"type":"VEC3"}},
+        \\{{"bufferView":1,"componentType":5122,"normalized":true,"count":{d},"type":"VEC4"}},
+        \\{{"bufferView":2,"componentType":5125,"count":{d},"type":"SCALAR"}},
+        \\{{"bufferView":3,"componentType":5123,"count":{d},"type":"SCALAR"}}]}}
+    , .{
+        bin.items.len,
+        vertex_count * 12 + vertex_count * 8 + index_count * 6,
+        views[0],
+        views[1],
+        views[2],
+        views[3],
+        vertex_count,
+        vertex_count,
+        index_count,
+        index_count,
+    });
+    defer allocator.free(json);
+
+    const options = cgltf.Options{
+        .memory = .{
+            .alloc = mem.zmeshAllocUser,
+            .free = mem.zmeshFreeUser,
+        },
+    };
+    const data = try cgltf.parse(options, json);
+    defer cgltf.free(data);
+
+    data.buffers.?[0].data = bin.items.ptr;
+    try decodeMeshoptCompression(data, 2);
+    // Already decoded views are skipped.
+    try decodeMeshoptCompression(data, 2);
+
+    const accessors = data.accessors.?;
+    {
+        const decoded = try allocator.alloc([3]f32, vertex_count);
+        defer allocator.free(decoded);
+        try readAccessor([3]f32, &accessors[0], decoded);
+        for (decoded) |p, i| try expect(std.mem.eql(f32, &p, &sphere.positions[i]));
+    }
+    {
+        const decoded = try allocator.alloc([4]f32, vertex_count);
+        defer allocator.free(decoded);
+        try readAccessor([4]f32, &accessors[1], decoded);
+        for (decoded) |n, i| {
+            for (sphere.normals.?[i]) |c, j| try expect(std.math.approxEqAbs(f32, n[j], c, 0.005));
+        }
+    }
+    {
+        const decoded = try allocator.alloc(u32, index_count);
+        defer allocator.free(decoded);
+        try readAccessor(u32, &accessors[2], decoded);
+        try expect(std.mem.eql(u32, decoded, indices));
+        try readAccessor(u32, &accessors[3], decoded);
+        try expect(std.mem.eql(u32, decoded, indices));
+    }
+
+    // Ranges that would wrap around the address space are rejected.
+    const view = &data.buffer_views.?[0];
+    data.memory.free.?(data.memory.user_data, view.data);
+    view.data = null;
+    view.meshopt_compression.offset = std.math.maxInt(usize) - 1;
+    try std.testing.expectError(error.InvalidGltf, decodeMeshoptCompression(data, 2));
+    view.meshopt_compression.offset = 0;
+    view.meshopt_compression.count = std.math.maxInt(usize) / 4;
+    try std.testing.expectError(error.InvalidGltf, decodeMeshoptCompression(data, 2));
+}
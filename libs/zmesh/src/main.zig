@@ -3,9 +3,17 @@
 pub const Shape = @import("Shape.zig");
 pub const io = @import("io.zig");
 pub const opt = @import("zmeshoptimizer.zig");
+pub const codec = @import("codec.zig");
+pub const culling = @import("culling.zig");
+pub const cache = @import("cache.zig");
+pub const animation = @import("animation.zig");
+pub const scene = @import("scene.zig");
+pub const shapes = @import("shapes.zig");
+pub const morph = @import("morph.zig");
 
 const std = @import("std");
 const mem = @import("memory.zig");
+const convert = @import("convert.zig");
 
 pub fn init(alloc: std.mem.Allocator) void {
     mem.init(alloc);
@@ -15,6 +23,25 @@ pub fn deinit() void {
     mem.deinit();
 }
 
+pub const MemoryLibrary = mem.Library;
+pub const MemoryStats = mem.Stats;
+
+/// Bytes and allocations made by the given library. Requires `memory_stats` build option.
+pub fn getMemoryStats(library: MemoryLibrary) MemoryStats {
+    return mem.getStats(library);
+}
+
 comptime {
     _ = Shape;
+    _ = io;
+    _ = mem;
+    _ = opt;
+    _ = codec;
+    _ = culling;
+    _ = cache;
+    _ = animation;
+    _ = scene;
+    _ = shapes;
+    _ = morph;
+    _ = convert;
 }
@@ -1,22 +1,69 @@
+// Allocation bridge for par_shapes, meshoptimizer and cgltf.
+//
+// Every block is preceded by a 16 byte header which stores requested size, size class and the library which
+// allocated the block, so no pointer -> size map is needed. Blocks up to `max_small_size` (header included) come from
+// power-of-two size classes carved from chunks. Each thread has its own free lists and its own chunk to carve from;
+// when a free list grows too long, half of it is pushed to a global per-class list which other threads take as
+// a whole (lock-free push / pop-all, no ABA problem). Larger blocks go directly to the user allocator.
+//
+// No global lock is taken, so the allocator passed to `init()` must be thread-safe when zmesh is used from multiple
+// threads (`std.heap.GeneralPurposeAllocator`, `std.heap.c_allocator` and `std.heap.page_allocator` are).
+// Chunks are released in `deinit()`.
 const builtin = @import("builtin");
 const std = @import("std");
-const Mutex = std.Thread.Mutex;
+const assert = std.debug.assert;
+
+pub const Library = enum(u8) {
+    par_shapes,
+    meshoptimizer,
+    cgltf,
+};
+
+pub const Stats = struct {
+    bytes_in_use: usize,
+    num_live_allocs: usize,
+    num_total_allocs: usize,
+};
+
+const stats_enabled: bool = blk: {
+    if (!builtin.is_test) {
+        const options = @import("zmesh_options");
+        if (@hasDecl(options, "memory_stats")) {
+            break :blk options.memory_stats;
+        }
+        break :blk false;
+    } else break :blk true;
+};
 
 pub fn init(alloc: std.mem.Allocator) void {
-    std.debug.assert(allocator == null and allocations == null);
+    std.debug.assert(allocator == null);
     allocator = alloc;
-    allocations = std.AutoHashMap(usize, usize).init(allocator.?);
-    allocations.?.ensureTotalCapacity(32) catch unreachable;
+    resetGlobalState();
     zmesh_setAllocator(zmeshAlloc, zmeshClearAlloc, zmeshReAlloc, zmeshFree);
-    meshopt_setAllocator(zmeshAlloc, zmeshFree);
+    meshopt_setAllocator(zmeshMeshoptAlloc, zmeshMeshoptFree);
 }
 
 pub fn deinit() void {
-    allocations.?.deinit();
-    allocations = null;
+    var chunk = @intToPtr(?*Chunk, @atomicRmw(usize, &chunks, .Xchg, 0, .Acquire));
+    while (chunk) |c| {
+        chunk = c.next;
+        allocator.?.free(@ptrCast([*]align(alignment) u8, @alignCast(alignment, c))[0..chunk_size]);
+    }
+    resetGlobalState();
     allocator = null;
 }
 
+/// Requires `memory_stats` build option (always enabled in tests).
+pub fn getStats(library: Library) Stats {
+    if (!stats_enabled) @compileError("zmesh: `memory_stats` build option is disabled");
+    const c = &counters[@enumToInt(library)];
+    return .{
+        .bytes_in_use = @atomicLoad(usize, &c.bytes_in_use, .Monotonic),
+        .num_live_allocs = @atomicLoad(usize, &c.num_live_allocs, .Monotonic),
+        .num_total_allocs = @atomicLoad(usize, &c.num_total_allocs, .Monotonic),
+    };
+}
+
 const MallocFn = if (builtin.zig_backend == .stage1)
     fn (size: usize) callconv(.C) ?*anyopaque
 else
@@ -49,25 +96,222 @@ extern fn meshopt_setAllocator(
     deallocate: FreeFn,
 ) void;
 
+const alignment = 16;
+const header_size = 16;
+const num_size_classes = 11; // 32 B - 32 KB (header included)
+const min_size_class_log2 = 5;
+const max_small_size = 1 << (min_size_class_log2 + num_size_classes - 1);
+const max_cached_blocks = 64; // per size class, per thread
+const size_class_large: u8 = 0xff;
+const chunk_size = 1024 * 1024;
+
+const Header = extern struct {
+    size: usize, // requested size
+    size_class: u8,
+    library: Library,
+    _pad: [header_size - @sizeOf(usize) - 2]u8 = undefined,
+
+    comptime {
+        assert(@sizeOf(Header) == header_size);
+    }
+};
+
+// Overlays the header of a free block.
+const FreeBlock = struct {
+    next: ?*FreeBlock,
+};
+
+// Placed at the beginning of every chunk (first `header_size` bytes).
+const Chunk = struct {
+    next: ?*Chunk,
+};
+
+const ThreadCache = struct {
+    generation: u32 = 0,
+    free_lists: [num_size_classes]?*FreeBlock = [_]?*FreeBlock{null} ** num_size_classes,
+    num_free: [num_size_classes]u32 = [_]u32{0} ** num_size_classes,
+    carve_ptr: usize = 0,
+    carve_end: usize = 0,
+};
+
+const Counters = struct {
+    bytes_in_use: usize align(64) = 0,
+    num_live_allocs: usize = 0,
+    num_total_allocs: usize = 0,
+};
+
 var allocator: ?std.mem.Allocator = null;
-var allocations: ?std.AutoHashMap(usize, usize) = null;
-var mutex: Mutex = .{};
 
-export fn zmeshAlloc(size: usize) callconv(.C) ?*anyopaque {
-    mutex.lock();
-    defer mutex.unlock();
+// Thread caches from before the last `init()`/`deinit()` point to released chunks and are dropped on first use.
+var generation: u32 = 0;
+threadlocal var thread_cache: ThreadCache = .{};
+
+// Lists of `FreeBlock` and `Chunk` stored as `usize` for atomic access (0 - empty).
+var global_free_lists: [num_size_classes]usize = [_]usize{0} ** num_size_classes;
+var chunks: usize = 0;
+
+var counters: [@typeInfo(Library).Enum.fields.len]Counters = [_]Counters{.{}} ** @typeInfo(Library).Enum.fields.len;
+
+fn resetGlobalState() void {
+    for (global_free_lists) |*list| @atomicStore(usize, list, 0, .Release);
+    for (counters) |*c| c.* = .{};
+    _ = @atomicRmw(u32, &generation, .Add, 1, .Release);
+}
+
+fn getThreadCache() *ThreadCache {
+    const current_generation = @atomicLoad(u32, &generation, .Acquire);
+    if (thread_cache.generation != current_generation) {
+        thread_cache = .{ .generation = current_generation };
+    }
+    return &thread_cache;
+}
 
-    var slice = allocator.?.allocBytes(
-        @sizeOf(usize),
-        size,
-        0,
-        @returnAddress(),
-    ) catch @panic("zmesh: out of memory");
+inline fn getHeader(ptr: *anyopaque) *Header {
+    return @intToPtr(*Header, @ptrToInt(ptr) - header_size);
+}
 
-    allocations.?.put(@ptrToInt(slice.ptr), size) catch
-        @panic("zmesh: out of memory");
+inline fn sizeClass(size_with_header: usize) u8 {
+    if (size_with_header > max_small_size) return size_class_large;
+    if (size_with_header <= (1 << min_size_class_log2)) return 0;
+    const log2 = std.math.log2_int_ceil(usize, size_with_header);
+    return @intCast(u8, log2 - min_size_class_log2);
+}
 
-    return slice.ptr;
+inline fn sizeClassBytes(size_class: u8) usize {
+    return @as(usize, 1) << @intCast(std.math.Log2Int(usize), size_class + min_size_class_log2);
+}
+
+fn pushGlobal(comptime T: type, list: *usize, first: *T, last: *T) void {
+    var head = @atomicLoad(usize, list, .Monotonic);
+    while (true) {
+        last.next = @intToPtr(?*T, head);
+        head = @cmpxchgWeak(usize, list, head, @ptrToInt(first), .Release, .Monotonic) orelse return;
+    }
+}
+
+fn allocSmall(size_class: u8) [*]align(alignment) u8 {
+    const cache = getThreadCache();
+
+    if (cache.free_lists[size_class] == null) {
+        // Take all blocks freed to the global list by other threads.
+        const list = @atomicRmw(usize, &global_free_lists[size_class], .Xchg, 0, .Acquire);
+        if (list != 0) {
+            var num: u32 = 0;
+            var block = @intToPtr(?*FreeBlock, list);
+            while (block) |b| : (block = b.next) num += 1;
+            cache.free_lists[size_class] = @intToPtr(?*FreeBlock, list);
+            cache.num_free[size_class] = num;
+        }
+    }
+
+    if (cache.free_lists[size_class]) |block| {
+        cache.free_lists[size_class] = block.next;
+        cache.num_free[size_class] -= 1;
+        return @ptrCast([*]align(alignment) u8, @alignCast(alignment, block));
+    }
+
+    const block_size = sizeClassBytes(size_class);
+    if (cache.carve_ptr + block_size > cache.carve_end) {
+        const memory = allocator.?.allocBytes(alignment, chunk_size, 0, @returnAddress()) catch
+            @panic("zmesh: out of memory");
+        const chunk = @ptrCast(*Chunk, @alignCast(@alignOf(Chunk), memory.ptr));
+        pushGlobal(Chunk, &chunks, chunk, chunk);
+        // Remainder of the previous chunk is not reused.
+        cache.carve_ptr = @ptrToInt(memory.ptr) + header_size;
+        cache.carve_end = @ptrToInt(memory.ptr) + chunk_size;
+    }
+    const ptr = cache.carve_ptr;
+    cache.carve_ptr += block_size;
+    return @intToPtr([*]align(alignment) u8, ptr);
+}
+
+fn freeSmall(header: *Header) void {
+    const size_class = header.size_class;
+    const cache = getThreadCache();
+
+    const block = @ptrCast(*FreeBlock, @alignCast(@alignOf(FreeBlock), header));
+    block.next = cache.free_lists[size_class];
+    cache.free_lists[size_class] = block;
+    cache.num_free[size_class] += 1;
+
+    if (cache.num_free[size_class] > max_cached_blocks) {
+        // Give the older half to other threads.
+        var last = block;
+        var i: u32 = 1;
+        while (i < max_cached_blocks / 2) : (i += 1) last = last.next.?;
+        const rest = last.next.?;
+        var rest_last = rest;
+        while (rest_last.next) |next| rest_last = next;
+
+        pushGlobal(FreeBlock, &global_free_lists[size_class], rest, rest_last);
+        last.next = null;
+        cache.num_free[size_class] = max_cached_blocks / 2;
+    }
+}
+
+fn allocTagged(size: usize, library: Library) ?*anyopaque {
+    const size_class = sizeClass(size + header_size);
+    const memory: [*]align(alignment) u8 = if (size_class != size_class_large)
+        allocSmall(size_class)
+    else
+        @alignCast(alignment, (allocator.?.allocBytes(alignment, size + header_size, 0, @returnAddress()) catch
+            @panic("zmesh: out of memory")).ptr);
+
+    const header = @ptrCast(*Header, memory);
+    header.* = .{ .size = size, .size_class = size_class, .library = library };
+
+    if (stats_enabled) {
+        const c = &counters[@enumToInt(library)];
+        _ = @atomicRmw(usize, &c.bytes_in_use, .Add, size, .Monotonic);
+        _ = @atomicRmw(usize, &c.num_live_allocs, .Add, 1, .Monotonic);
+        _ = @atomicRmw(usize, &c.num_total_allocs, .Add, 1, .Monotonic);
+    }
+    return @ptrCast(*anyopaque, memory + header_size);
+}
+
+fn freeTagged(ptr: *anyopaque) void {
+    const header = getHeader(ptr);
+
+    if (stats_enabled) {
+        const c = &counters[@enumToInt(header.library)];
+        _ = @atomicRmw(usize, &c.bytes_in_use, .Sub, header.size, .Monotonic);
+        _ = @atomicRmw(usize, &c.num_live_allocs, .Sub, 1, .Monotonic);
+    }
+
+    if (header.size_class != size_class_large) {
+        freeSmall(header);
+    } else {
+        const memory = @ptrCast([*]align(alignment) u8, @alignCast(alignment, header));
+        allocator.?.free(memory[0 .. header.size + header_size]);
+    }
+}
+
+fn reallocTagged(ptr: ?*anyopaque, size: usize, library: Library) ?*anyopaque {
+    if (ptr == null) return allocTagged(size, library);
+
+    const header = getHeader(ptr.?);
+    if (header.size_class != size_class_large and size + header_size <= sizeClassBytes(header.size_class)) {
+        if (stats_enabled) {
+            const c = &counters[@enumToInt(header.library)];
+            _ = @atomicRmw(usize, &c.bytes_in_use, .Sub, header.size, .Monotonic);
+            _ = @atomicRmw(usize, &c.bytes_in_use, .Add, size, .Monotonic);
+        }
+        header.size = size;
+        return ptr;
+    }
+
+    const new_ptr = allocTagged(size, header.library);
+    @memcpy(
+        @ptrCast([*]u8, new_ptr.?),
+        @ptrCast([*]const u8, ptr.?),
+        std.math.min(size, header.size),
+    );
+    freeTagged(ptr.?);
+    return new_ptr;
+}
+
+export fn zmeshAlloc(size: usize) callconv(.C) ?*anyopaque {
+    return allocTagged(size, .par_shapes);
 }
 
 export fn zmeshClearAlloc(num: usize, size: usize) callconv(.C) ?*anyopaque {
@@ -79,57 +323,99 @@ export fn zmeshClearAlloc(num: usize, size: usize) callconv(.C) ?*anyopaque {
     return null;
 }
 
+export fn zmeshReAlloc(ptr: ?*anyopaque, size: usize) callconv(.C) ?*anyopaque {
+    return reallocTagged(ptr, size, .par_shapes);
+}
+
+export fn zmeshFree(ptr: ?*anyopaque) callconv(.C) void {
+    if (ptr != null) {
+        freeTagged(ptr.?);
+    }
+}
+
+export fn zmeshMeshoptAlloc(size: usize) callconv(.C) ?*anyopaque {
+    return allocTagged(size, .meshoptimizer);
+}
+
+export fn zmeshMeshoptFree(ptr: ?*anyopaque) callconv(.C) void {
+    zmeshFree(ptr);
+}
+
 pub export fn zmeshAllocUser(user: ?*anyopaque, size: usize) callconv(.C) ?*anyopaque {
     _ = user;
-    return zmeshAlloc(size);
+    return allocTagged(size, .cgltf);
 }
 
-export fn zmeshReAlloc(ptr: ?*anyopaque, size: usize) callconv(.C) ?*anyopaque {
-    mutex.lock();
-    defer mutex.unlock();
+pub export fn zmeshFreeUser(user: ?*anyopaque, ptr: ?*anyopaque) callconv(.C) void {
+    _ = user;
+    zmeshFree(ptr);
+}
 
-    const old_len = if (ptr != null)
-        allocations.?.get(@ptrToInt(ptr.?)).?
-    else
-        0;
+const expect = std.testing.expect;
 
-    var old_mem = if (old_len > 0)
-        @ptrCast([*]u8, ptr)[0..old_len]
-    else
-        @as([*]u8, undefined)[0..0];
+fn testWorker(seed: u64) void {
+    var prng = std.rand.DefaultPrng.init(seed);
+    const random = prng.random();
 
-    var slice = allocator.?.reallocBytes(
-        old_mem,
-        @sizeOf(usize),
-        size,
-        @sizeOf(usize),
-        0,
-        @returnAddress(),
-    ) catch @panic("zmesh: out of memory");
+    var ptrs: [64]?[*]u8 = [_]?[*]u8{null} ** 64;
+    var sizes: [64]usize = undefined;
 
-    if (ptr != null) {
-        const removed = allocations.?.remove(@ptrToInt(ptr.?));
-        std.debug.assert(removed);
+    var i: u32 = 0;
+    while (i < 4000) : (i += 1) {
+        const slot = random.uintLessThan(usize, ptrs.len);
+        if (ptrs[slot]) |ptr| {
+            // Every block is filled with its slot index - check nobody else wrote to it.
+            for (ptr[0..sizes[slot]]) |byte| assert(byte == @truncate(u8, slot));
+            if (random.boolean()) {
+                zmeshFree(@ptrCast(*anyopaque, ptr));
+                ptrs[slot] = null;
+            } else {
+                const size = random.uintLessThan(usize, 2 * max_small_size);
+                const new_ptr = @ptrCast([*]u8, zmeshReAlloc(@ptrCast(*anyopaque, ptr), size).?);
+                for (new_ptr[0..std.math.min(size, sizes[slot])]) |byte| assert(byte == @truncate(u8, slot));
+                @memset(new_ptr, @truncate(u8, slot), size);
+                ptrs[slot] = new_ptr;
+                sizes[slot] = size;
+            }
+        } else {
+            const size = if (random.uintLessThan(u32, 16) == 0)
+                random.uintLessThan(usize, 4 * max_small_size)
+            else
+                random.uintLessThan(usize, 512);
+            const ptr = @ptrCast([*]u8, zmeshAlloc(size).?);
+            assert(@ptrToInt(ptr) % alignment == 0);
+            @memset(ptr, @truncate(u8, slot), size);
+            ptrs[slot] = ptr;
+            sizes[slot] = size;
+        }
+    }
+    for (ptrs) |ptr| {
+        if (ptr) |p| zmeshFree(@ptrCast(*anyopaque, p));
     }
+}
 
-    allocations.?.put(@ptrToInt(slice.ptr), size) catch
-        @panic("zmesh: out of memory");
+test "zmesh.memory" {
+    init(std.testing.allocator);
+    defer deinit();
 
-    return slice.ptr;
-}
+    testWorker(1);
+    try expect(getStats(.par_shapes).bytes_in_use == 0);
+    try expect(getStats(.par_shapes).num_live_allocs == 0);
+    try expect(getStats(.par_shapes).num_total_allocs > 0);
 
-export fn zmeshFree(ptr: ?*anyopaque) callconv(.C) void {
-    if (ptr != null) {
-        mutex.lock();
-        defer mutex.unlock();
+    const cgltf_ptr = zmeshAllocUser(null, 100);
+    try expect(getStats(.cgltf).bytes_in_use == 100);
+    zmeshFreeUser(null, cgltf_ptr);
+    try expect(getStats(.cgltf).bytes_in_use == 0);
 
-        const size = allocations.?.fetchRemove(@ptrToInt(ptr.?)).?.value;
-        const slice = @ptrCast([*]u8, ptr.?)[0..size];
-        allocator.?.free(slice);
+    if (builtin.single_threaded) return;
+
+    var threads: [4]std.Thread = undefined;
+    for (threads) |*thread, i| {
+        thread.* = try std.Thread.spawn(.{}, testWorker, .{@as(u64, i + 2)});
     }
-}
+    for (threads) |thread| thread.join();
 
-pub export fn zmeshFreeUser(user: ?*anyopaque, ptr: ?*anyopaque) callconv(.C) void {
-    _ = user;
-    zmeshFree(ptr);
+    try expect(getStats(.par_shapes).bytes_in_use == 0);
+    try expect(getStats(.par_shapes).num_live_allocs == 0);
 }
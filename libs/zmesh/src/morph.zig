@@ -0,0 +1,435 @@
+// Morph targets (blend shapes) on the CPU: glTF target deltas converted to sparse, quantized streams and blended into
+// per-instance vertex buffers.
+//
+// A target stores only the vertex ranges it moves. Runs of non-zero deltas separated by less than `max_gap` zero
+// vertices are merged into one range, and deltas are 16-bit integers with one scale per target and attribute. A blend
+// restores from the base mesh and then accumulates only the ranges of targets which are (or were, in the previous
+// blend) active. Blended normals are not renormalized.
+
+const std = @import("std");
+const assert = std.debug.assert;
+const cgltf = @import("zcgltf.zig");
+const convert = @import("convert.zig");
+const parallel = @import("parallel.zig");
+
+pub const Error = error{ OutOfMemory, MissingPositions } || convert.Error;
+
+pub const Options = struct {
+    /// Deltas with an absolute value up to this are treated as zero.
+    threshold: f32 = 0.0,
+    /// Zero vertices between two runs of non-zero deltas which are stored instead of starting a new range.
+    max_gap: u32 = 8,
+};
+
+/// Vertices `[first, first + count)` of a target. Quantized deltas start at `Morph.deltas[offset]`: `3 * count`
+/// position components, followed by `3 * count` normal components when the target has normals.
+pub const Range = struct {
+    first: u32,
+    count: u32,
+    offset: u32,
+};
+
+pub const Target = struct {
+    first_range: u32,
+    num_ranges: u32,
+    /// `delta = (q - 0x8000) * scale` for a stored value `q`.
+    position_scale: f32,
+    normal_scale: f32,
+    has_normals: bool,
+    num_vertices: u32,
+};
+
+pub const Morph = struct {
+    num_vertices: u32,
+    positions: [][3]f32,
+    normals: ?[][3]f32,
+    targets: []Target,
+    ranges: []Range,
+    deltas: []u16,
+
+    /// `position_deltas[t]` (and `normal_deltas[t]` when not null) has one delta per vertex of target `t`. An empty
+    /// slice in `normal_deltas` means the target has no normal deltas.
+    pub fn init(
+        allocator: std.mem.Allocator,
+        base_positions: []const [3]f32,
+        base_normals: ?[]const [3]f32,
+        position_deltas: []const []const [3]f32,
+        normal_deltas: ?[]const []const [3]f32,
+        options: Options,
+    ) error{OutOfMemory}!Morph {
+        const num_vertices = base_positions.len;
+        if (base_normals) |n| assert(n.len == num_vertices);
+        if (normal_deltas) |nd| assert(base_normals != null and nd.len == position_deltas.len);
+
+        const positions = try allocator.dupe([3]f32, base_positions);
+        errdefer allocator.free(positions);
+        const normals: ?[][3]f32 = if (base_normals) |n| try allocator.dupe([3]f32, n) else null;
+        errdefer if (normals) |n| allocator.free(n);
+        const targets = try allocator.alloc(Target, position_deltas.len);
+        errdefer allocator.free(targets);
+
+        var ranges = std.ArrayList(Range).init(allocator);
+        defer ranges.deinit();
+        var deltas = std.ArrayList(u16).init(allocator);
+        defer deltas.deinit();
+
+        for (position_deltas) |target_positions, t| {
+            assert(target_positions.len == num_vertices);
+            const target_normals: []const [3]f32 = if (normal_deltas) |n| n[t] else &.{};
+            assert(target_normals.len == 0 or target_normals.len == num_vertices);
+
+            const position_scale = computeScale(target_positions, options.threshold);
+            const normal_scale = computeScale(target_normals, options.threshold);
+            const has_normals = normal_scale != 0.0;
+
+            // Ranges of vertices whose deltas quantize to a non-zero value.
+            const first_range = ranges.items.len;
+            var num_affected: u32 = 0;
+            var v: u32 = 0;
+            while (v < num_vertices) : (v += 1) {
+                const moves = quantizes(target_positions[v], position_scale, options.threshold) or
+                    (has_normals and quantizes(target_normals[v], normal_scale, options.threshold));
+                if (!moves) continue;
+                num_affected += 1;
+
+                if (ranges.items.len > first_range) {
+                    const last = &ranges.items[ranges.items.len - 1];
+                    if (v - (last.first + last.count) <= options.max_gap) {
+                        last.count = v + 1 - last.first;
+                        continue;
+                    }
+                }
+                try ranges.append(.{ .first = v, .count = 1, .offset = 0 });
+            }
+
+            for (ranges.items[first_range..]) |*range| {
+                range.offset = @intCast(u32, deltas.items.len);
+                try appendQuantized(&deltas, target_positions[range.first..][0..range.count], position_scale);
+                if (has_normals) {
+                    try appendQuantized(&deltas, target_normals[range.first..][0..range.count], normal_scale);
+                }
+            }
+
+            targets[t] = .{
+                .first_range = @intCast(u32, first_range),
+                .num_ranges = @intCast(u32, ranges.items.len - first_range),
+                .position_scale = position_scale,
+                .normal_scale = normal_scale,
+                .has_normals = has_normals,
+                .num_vertices = num_affected,
+            };
+        }
+
+        return Morph{
+            .num_vertices = @intCast(u32, num_vertices),
+            .positions = positions,
+            .normals = normals,
+            .targets = targets,
+            .ranges = ranges.toOwnedSlice(),
+            .deltas = deltas.toOwnedSlice(),
+        };
+    }
+
+    /// Base mesh and morph targets of a glTF primitive (POSITION and NORMAL; tangent deltas are ignored).
+    pub fn initGltf(allocator: std.mem.Allocator, primitive: *const cgltf.Primitive, options: Options) Error!Morph {
+        const attributes = primitive.attributes[0..primitive.attributes_count];
+        const position_accessor = findAccessor(attributes, .position) orelse return error.MissingPositions;
+        const normal_accessor = findAccessor(attributes, .normal);
+        const num_vertices = position_accessor.count;
+        const num_targets = primitive.targets_count;
+
+        // Base and delta streams of all targets in one temporary allocation.
+        const num_streams = (1 + num_targets) * @as(usize, if (normal_accessor != null) 2 else 1);
+        const streams = try allocator.alloc([3]f32, num_streams * num_vertices);
+        defer allocator.free(streams);
+        const slices = try allocator.alloc([]const [3]f32, 2 * num_targets);
+        defer allocator.free(slices);
+
+        var next: usize = 0;
+        const base_positions = streams[0..num_vertices];
+        try convert.readAccessor([3]f32, position_accessor, base_positions);
+        next += num_vertices;
+
+        var base_normals: ?[][3]f32 = null;
+        if (normal_accessor) |accessor| {
+            if (accessor.count != num_vertices) return error.InvalidAccessor;
+            base_normals = streams[next..][0..num_vertices];
+            try convert.readAccessor([3]f32, accessor, base_normals.?);
+            next += num_vertices;
+        }
+
+        const position_deltas = slices[0..num_targets];
+        const normal_deltas = slices[num_targets..];
+        const targets = if (primitive.targets) |p| p[0..num_targets] else &[_]cgltf.MorphTarget{};
+        for (targets) |target, t| {
+            const target_attributes: []const cgltf.Attribute =
+                if (target.attributes) |a| a[0..target.attributes_count] else &.{};
+
+            const out_positions = streams[next..][0..num_vertices];
+            next += num_vertices;
+            if (findAccessor(target_attributes, .position)) |accessor| {
+                if (accessor.count != num_vertices) return error.InvalidAccessor;
+                try convert.readAccessor([3]f32, accessor, out_positions);
+            } else {
+                std.mem.set([3]f32, out_positions, .{ 0.0, 0.0, 0.0 });
+            }
+            position_deltas[t] = out_positions;
+
+            normal_deltas[t] = &.{};
+            if (base_normals != null) {
+                if (findAccessor(target_attributes, .normal)) |accessor| {
+                    if (accessor.count != num_vertices) return error.InvalidAccessor;
+                    const out_normals = streams[next..][0..num_vertices];
+                    next += num_vertices;
+                    try convert.readAccessor([3]f32, accessor, out_normals);
+                    normal_deltas[t] = out_normals;
+                }
+            }
+        }
+
+        return Morph.init(
+            allocator,
+            base_positions,
+            base_normals,
+            position_deltas,
+            if (base_normals != null) normal_deltas else null,
+            options,
+        );
+    }
+
+    pub fn deinit(morph: *Morph, allocator: std.mem.Allocator) void {
+        allocator.free(morph.positions);
+        if (morph.normals) |normals| allocator.free(normals);
+        allocator.free(morph.targets);
+        allocator.free(morph.ranges);
+        allocator.free(morph.deltas);
+        morph.* = undefined;
+    }
+
+    pub fn getRanges(morph: Morph, target_index: usize) []const Range {
+        const target = morph.targets[target_index];
+        return morph.ranges[target.first_range..][0..target.num_ranges];
+    }
+};
+
+/// Blended vertices of one mesh instance. Set `weights` (one per target) and call `blend()`.
+pub const Instance = struct {
+    weights: []f32,
+    positions: [][3]f32,
+    normals: ?[][3]f32,
+    /// Weights of the last blend.
+    applied_weights: []f32,
+
+    /// Starts with all weights zero and the base mesh in `positions` and `normals`.
+    pub fn init(allocator: std.mem.Allocator, morph: *const Morph) error{OutOfMemory}!Instance {
+        const weights = try allocator.alloc(f32, 2 * morph.targets.len);
+        errdefer allocator.free(weights);
+        std.mem.set(f32, weights, 0.0);
+        const positions = try allocator.dupe([3]f32, morph.positions);
+        errdefer allocator.free(positions);
+        const normals: ?[][3]f32 = if (morph.normals) |n| try allocator.dupe([3]f32, n) else null;
+
+        return Instance{
+            .weights = weights[0..morph.targets.len],
+            .positions = positions,
+            .normals = normals,
+            .applied_weights = weights[morph.targets.len..],
+        };
+    }
+
+    pub fn deinit(instance: *Instance, allocator: std.mem.Allocator) void {
+        allocator.free(instance.weights.ptr[0 .. 2 * instance.weights.len]);
+        allocator.free(instance.positions);
+        if (instance.normals) |normals| allocator.free(normals);
+        instance.* = undefined;
+    }
+};
+
+/// Updates `instance.positions` and `instance.normals` for `instance.weights`. Vertices not moved by any target
+/// active now or in the previous blend are not accessed; nothing is done when the weights did not change.
+pub fn blend(morph: *const Morph, instance: *Instance) void {
+    assert(instance.weights.len == morph.targets.len and instance.positions.len == morph.num_vertices);
+    if (std.mem.eql(f32, instance.weights, instance.applied_weights)) return;
+
+    const out_positions = @ptrCast([*]f32, instance.positions.ptr);
+    const out_normals: ?[*]f32 = if (instance.normals) |normals| @ptrCast([*]f32, normals.ptr) else null;
+
+    for (morph.targets) |_, t| {
+        if (instance.weights[t] == 0.0 and instance.applied_weights[t] == 0.0) continue;
+        for (morph.getRanges(t)) |range| {
+            std.mem.copy(
+                [3]f32,
+                instance.positions[range.first..][0..range.count],
+                morph.positions[range.first..][0..range.count],
+            );
+            if (instance.normals) |normals| {
+                const base_normals = morph.normals.?[range.first..][0..range.count];
+                std.mem.copy([3]f32, normals[range.first..][0..range.count], base_normals);
+            }
+        }
+    }
+
+    for (morph.targets) |target, t| {
+        const weight = instance.weights[t];
+        if (weight == 0.0) continue;
+        for (morph.getRanges(t)) |range| {
+            const len = 3 * range.count;
+            const deltas = morph.deltas[range.offset..];
+            accumulate(out_positions[3 * range.first ..][0..len], deltas[0..len], weight * target.position_scale);
+            if (out_normals != null and target.has_normals) {
+                const normal_scale = weight * target.normal_scale;
+                accumulate(out_normals.?[3 * range.first ..][0..len], deltas[len..][0..len], normal_scale);
+            }
+        }
+    }
+
+    std.mem.copy(f32, instance.applied_weights, instance.weights);
+}
+
+/// `blend()` for many instances of the same mesh on up to `num_threads` threads (0 - one per CPU).
+pub fn blendInstances(morph: *const Morph, instances: []Instance, num_threads: u32) void {
+    const Context = struct {
+        morph: *const Morph,
+        instances: []Instance,
+
+        fn blendOne(context: *const @This(), index: usize) void {
+            blend(context.morph, &context.instances[index]);
+        }
+    };
+    const context = Context{ .morph = morph, .instances = instances };
+    parallel.forEach(instances.len, num_threads, &context, Context.blendOne);
+}
+
+/// `out[i] += (deltas[i] - 0x8000) * scale`. Stored values are placed in the mantissa of 2^23 to convert them to
+/// floats with vector ops (see convert.zig).
+fn accumulate(out: []f32, deltas: []const u16, scale: f32) void {
+    assert(out.len == deltas.len);
+    const L = 16;
+    const exponent = @splat(L, @as(u32, 0x4b000000)); // 2^23
+    const offset = @splat(L, @as(f32, 8388608.0 + 32768.0));
+    const scale_v = @splat(L, scale);
+
+    var i: usize = 0;
+    while (i + L <= out.len) : (i += L) {
+        var lanes: [L]u32 = undefined;
+        for (deltas[i..][0..L]) |q, k| lanes[k] = q;
+        const bits = @as(@Vector(L, u32), lanes) | exponent;
+        const d = (@bitCast(@Vector(L, f32), bits) - offset) * scale_v;
+        out[i..][0..L].* = @as(@Vector(L, f32), out[i..][0..L].*) + d;
+    }
+    while (i < out.len) : (i += 1) {
+        out[i] += (@intToFloat(f32, deltas[i]) - 32768.0) * scale;
+    }
+}
+
+fn computeScale(deltas: []const [3]f32, threshold: f32) f32 {
+    var max: f32 = 0.0;
+    for (deltas) |d| {
+        for (d) |c| max = std.math.max(max, @fabs(c));
+    }
+    return if (max > threshold) max / 32767.0 else 0.0;
+}
+
+fn quantize(value: f32, scale: f32) i32 {
+    return @floatToInt(i32, std.math.clamp(@round(value / scale), -32767.0, 32767.0));
+}
+
+fn quantizes(delta: [3]f32, scale: f32, threshold: f32) bool {
+    if (scale == 0.0) return false;
+    for (delta) |c| {
+        if (@fabs(c) > threshold and quantize(c, scale) != 0) return true;
+    }
+    return false;
+}
+
+fn appendQuantized(deltas: *std.ArrayList(u16), values: []const [3]f32, scale: f32) error{OutOfMemory}!void {
+    try deltas.ensureUnusedCapacity(3 * values.len);
+    for (values) |value| {
+        for (value) |c| deltas.appendAssumeCapacity(@intCast(u16, quantize(c, scale) + 0x8000));
+    }
+}
+
+fn findAccessor(attributes: []const cgltf.Attribute, attribute_type: cgltf.AttributeType) ?*cgltf.Accessor {
+    for (attributes) |attribute| {
+        if (attribute.type == attribute_type and attribute.index == 0) return attribute.data;
+    }
+    return null;
+}
+
+const expect = std.testing.expect;
+
+test "zmesh.morph.blend" {
+    const allocator = std.testing.allocator;
+
+    const num_vertices = 40;
+    var base_positions: [num_vertices][3]f32 = undefined;
+    var base_normals: [num_vertices][3]f32 = undefined;
+    for (base_positions) |*p, i| p.* = .{ @intToFloat(f32, i), 0.0, 0.0 };
+    for (base_normals) |*n| n.* = .{ 0.0, 0.0, 1.0 };
+
+    // Target 0 moves vertices 2..5 and 9 (merged into one range) and 30; target 1 moves vertices 20..39 and their
+    // normals; target 2 moves nothing.
+    var deltas: [3][num_vertices][3]f32 = undefined;
+    for (deltas) |*target| std.mem.set([3]f32, target, .{ 0.0, 0.0, 0.0 });
+    var normal_deltas = deltas;
+    for ([_]usize{ 2, 3, 4, 5, 9, 30 }) |v| deltas[0][v] = .{ 0.0, 1.0, 0.5 };
+    for (deltas[1][20..]) |*d, i| d.* = .{ 0.0, 0.0, @intToFloat(f32, i) * 0.1 };
+    for (normal_deltas[1][20..]) |*d| d.* = .{ 1.0, 0.0, -1.0 };
+
+    const position_slices = [_][]const [3]f32{ &deltas[0], &deltas[1], &deltas[2] };
+    const normal_slices = [_][]const [3]f32{ &normal_deltas[0], &normal_deltas[1], &normal_deltas[2] };
+    var morph = try Morph.init(allocator, &base_positions, &base_normals, &position_slices, &normal_slices, .{});
+    defer morph.deinit(allocator);
+
+    try expect(morph.getRanges(0).len == 2);
+    try expect(morph.getRanges(0)[0].first == 2 and morph.getRanges(0)[0].count == 8);
+    try expect(morph.getRanges(1).len == 1 and morph.getRanges(1)[0].count == 20);
+    try expect(morph.getRanges(2).len == 0);
+    try expect(!morph.targets[0].has_normals and morph.targets[1].has_normals);
+    try expect(morph.targets[0].num_vertices == 6 and morph.targets[1].num_vertices == 20);
+
+    const Reference = struct {
+        fn check(instance: Instance, d: *const [3][num_vertices][3]f32, nd: *const [3][num_vertices][3]f32) !void {
+            for (instance.positions) |p, v| {
+                for (p) |c, k| {
+                    var expected: f32 = if (k == 0) @intToFloat(f32, v) else 0.0;
+                    for (instance.weights) |w, t| expected += w * d[t][v][k];
+                    try expect(std.math.approxEqAbs(f32, c, expected, 0.001));
+                }
+                for (instance.normals.?[v]) |c, k| {
+                    var expected: f32 = if (k == 2) 1.0 else 0.0;
+                    for (instance.weights) |w, t| expected += w * nd[t][v][k];
+                    try expect(std.math.approxEqAbs(f32, c, expected, 0.001));
+                }
+            }
+        }
+    };
+
+    var instance = try Instance.init(allocator, &morph);
+    defer instance.deinit(allocator);
+    instance.weights[0] = 0.5;
+    instance.weights[1] = 1.0;
+    blend(&morph, &instance);
+    try Reference.check(instance, &deltas, &normal_deltas);
+
+    // Target 1 turned off: its vertices go back to the base mesh.
+    instance.weights[0] = -1.0;
+    instance.weights[1] = 0.0;
+    blend(&morph, &instance);
+    try Reference.check(instance, &deltas, &normal_deltas);
+    try expect(instance.positions[25][2] == 0.0 and instance.normals.?[25][0] == 0.0);
+
+    var instances: [17]Instance = undefined;
+    var num_instances: usize = 0;
+    defer {
+        for (instances[0..num_instances]) |*i| i.deinit(allocator);
+    }
+    for (instances) |*i, n| {
+        i.* = try Instance.init(allocator, &morph);
+        num_instances += 1;
+        i.weights[0] = @intToFloat(f32, n) / 16.0;
+        i.weights[1] = 1.0 - @intToFloat(f32, n) / 16.0;
+    }
+    blendInstances(&morph, &instances, 4);
+    for (instances) |i| try Reference.check(i, &deltas, &normal_deltas);
+}
@@ -0,0 +1,44 @@
+const builtin = @import("builtin");
+const std = @import("std");
+
+const max_num_threads = 64;
+
+/// Calls `func(context, index)` for every `index` in `[0, num_items)` on up to `num_threads` threads (0 - one per
+/// CPU); the calling thread is one of them. Items are handed out one at a time so uneven item costs balance out.
+/// When a thread can't be spawned the remaining threads do the work.
+pub fn forEach(
+    num_items: usize,
+    num_threads: u32,
+    context: anytype,
+    comptime func: fn (@TypeOf(context), usize) void,
+) void {
+    const Context = @TypeOf(context);
+    const Worker = struct {
+        fn run(next_item: *usize, count: usize, ctx: Context) void {
+            while (true) {
+                const index = @atomicRmw(usize, next_item, .Add, 1, .Monotonic);
+                if (index >= count) return;
+                func(ctx, index);
+            }
+        }
+    };
+
+    var next_item: usize = 0;
+    var threads: [max_num_threads - 1]std.Thread = undefined;
+    var num_spawned: usize = 0;
+
+    const num_workers = getNumThreads(num_items, num_threads) - 1;
+    while (num_spawned < num_workers) : (num_spawned += 1) {
+        threads[num_spawned] = std.Thread.spawn(.{}, Worker.run, .{ &next_item, num_items, context }) catch break;
+    }
+
+    Worker.run(&next_item, num_items, context);
+    for (threads[0..num_spawned]) |thread| thread.join();
+}
+
+/// Upper bound of threads (including the calling thread) that `forEach()` runs `num_items` items on.
+pub fn getNumThreads(num_items: usize, num_threads: u32) usize {
+    if (builtin.single_threaded or num_items <= 1) return 1;
+    const wanted: usize = if (num_threads == 0) (std.Thread.getCpuCount() catch 1) else num_threads;
+    return std.math.max(std.math.min(std.math.min(wanted, num_items), max_num_threads), 1);
+}
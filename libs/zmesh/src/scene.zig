@@ -0,0 +1,288 @@
+// Scene graph transforms: node hierarchies (e.g. all nodes of a glTF file) flattened into arrays sorted by depth,
+// so world matrices of all nodes are computed in one pass without walking parent chains (`cgltf.Node.transformWorld()`
+// multiplies the whole chain for every node).
+//
+// Local transforms are stored as a structure of arrays (`[channel][node]`, the layout of `zmesh.animation` poses).
+// Conventions are the same as zmath: row vectors, `world = local * parent world`.
+
+const std = @import("std");
+const assert = std.debug.assert;
+const cgltf = @import("zcgltf.zig");
+const animation = @import("animation.zig");
+const parallel = @import("parallel.zig");
+
+pub const Transform = animation.Transform;
+const Mat = [4][4]f32;
+
+pub const Error = error{ OutOfMemory, InvalidHierarchy };
+
+pub const Scene = struct {
+    len: usize,
+    stride: usize,
+    /// Parent of every node (-1 for roots). Nodes are sorted by depth, so parents come before their children.
+    parents: []i32,
+    /// Nodes of depth `d` are `level_offsets[d]..level_offsets[d + 1]`.
+    level_offsets: []u32,
+    /// Index of every node in the source array (`data.nodes` for `initGltf()`) and the node of every source index.
+    source_indices: []u32,
+    node_indices: []u32,
+    /// Local transforms, `[channel][node]` with `stride` (a multiple of `animation.lanes`).
+    locals: []align(32) f32,
+    /// World matrices; valid after `computeWorldMatrices()` (or a variant).
+    world: [][4][4]f32,
+    /// Nodes whose local transform changed since the last update (`update()` recomputes their subtrees).
+    dirty: []bool,
+
+    /// `parents[i]` is the source index of the parent of source node `i` (-1 for roots), in any order.
+    pub fn init(allocator: std.mem.Allocator, parents: []const i32, transforms: []const Transform) Error!Scene {
+        const n = parents.len;
+        assert(transforms.len == n);
+
+        // Children of every node (counting sort by parent), then nodes in breadth-first order: every level is
+        // contiguous and follows the previous one.
+        const child_offsets = try allocator.alloc(u32, n + 1);
+        defer allocator.free(child_offsets);
+        const children = try allocator.alloc(u32, n);
+        defer allocator.free(children);
+        std.mem.set(u32, child_offsets, 0);
+        for (parents) |parent| {
+            if (parent >= 0 and @intCast(usize, parent) >= n) return error.InvalidHierarchy;
+            if (parent >= 0) child_offsets[@intCast(usize, parent) + 1] += 1;
+        }
+        for (child_offsets[1..]) |*offset, i| offset.* += child_offsets[i];
+        {
+            const fill = try allocator.dupe(u32, child_offsets[0..n]);
+            defer allocator.free(fill);
+            for (parents) |parent, i| {
+                if (parent < 0) continue;
+                children[fill[@intCast(usize, parent)]] = @intCast(u32, i);
+                fill[@intCast(usize, parent)] += 1;
+            }
+        }
+
+        var scene = Scene{
+            .len = n,
+            .stride = std.mem.alignForward(n, animation.lanes),
+            .parents = try allocator.alloc(i32, n),
+            .level_offsets = @as([*]u32, undefined)[0..0],
+            .source_indices = @as([*]u32, undefined)[0..0],
+            .node_indices = @as([*]u32, undefined)[0..0],
+            .locals = @as([*]align(32) f32, undefined)[0..0],
+            .world = @as([*]Mat, undefined)[0..0],
+            .dirty = @as([*]bool, undefined)[0..0],
+        };
+        errdefer scene.deinit(allocator);
+        scene.source_indices = try allocator.alloc(u32, n);
+        scene.node_indices = try allocator.alloc(u32, n);
+        scene.locals = try allocator.alignedAlloc(f32, 32, animation.num_channels * scene.stride);
+        scene.world = try allocator.alloc(Mat, n);
+        scene.dirty = try allocator.alloc(bool, n);
+
+        var levels = std.ArrayList(u32).init(allocator);
+        defer levels.deinit();
+
+        var count: usize = 0;
+        for (parents) |parent, i| {
+            if (parent >= 0) continue;
+            scene.source_indices[count] = @intCast(u32, i);
+            count += 1;
+        }
+        var level_begin: usize = 0;
+        while (level_begin < count) {
+            try levels.append(@intCast(u32, level_begin));
+            const level_end = count;
+            for (scene.source_indices[level_begin..level_end]) |source| {
+                for (children[child_offsets[source]..child_offsets[source + 1]]) |child| {
+                    scene.source_indices[count] = child;
+                    count += 1;
+                }
+            }
+            level_begin = level_end;
+        }
+        // Nodes which are not reachable from a root are part of a cycle.
+        if (count != n) return error.InvalidHierarchy;
+        try levels.append(@intCast(u32, n));
+        scene.level_offsets = levels.toOwnedSlice();
+
+        for (scene.source_indices) |source, node| scene.node_indices[source] = @intCast(u32, node);
+        for (scene.source_indices) |source, node| {
+            const parent = parents[source];
+            scene.parents[node] = if (parent >= 0) @intCast(i32, scene.node_indices[@intCast(usize, parent)]) else -1;
+            animation.storeTransform(scene.locals, scene.stride, node, transforms[source]);
+        }
+        var padding = n;
+        while (padding < scene.stride) : (padding += 1) {
+            animation.storeTransform(scene.locals, scene.stride, padding, .{});
+        }
+
+        scene.computeWorldMatrices();
+        return scene;
+    }
+
+    /// All nodes of `data`; source indices are indices in `data.nodes`.
+    pub fn initGltf(allocator: std.mem.Allocator, data: *const cgltf.Data) Error!Scene {
+        const nodes = if (data.nodes) |n| n[0..data.nodes_count] else &[_]cgltf.Node{};
+
+        const parents = try allocator.alloc(i32, nodes.len);
+        defer allocator.free(parents);
+        const transforms = try allocator.alloc(Transform, nodes.len);
+        defer allocator.free(transforms);
+
+        for (nodes) |*node, i| {
+            parents[i] = if (node.parent) |parent|
+                @intCast(i32, (@ptrToInt(parent) - @ptrToInt(nodes.ptr)) / @sizeOf(cgltf.Node))
+            else
+                -1;
+            transforms[i] = Transform.fromNode(node);
+        }
+        return init(allocator, parents, transforms);
+    }
+
+    pub fn deinit(scene: *Scene, allocator: std.mem.Allocator) void {
+        allocator.free(scene.parents);
+        allocator.free(scene.level_offsets);
+        allocator.free(scene.source_indices);
+        allocator.free(scene.node_indices);
+        allocator.free(scene.locals);
+        allocator.free(scene.world);
+        allocator.free(scene.dirty);
+        scene.* = undefined;
+    }
+
+    pub fn numLevels(scene: Scene) usize {
+        return scene.level_offsets.len - 1;
+    }
+
+    pub fn getLocal(scene: Scene, node: usize) Transform {
+        assert(node < scene.len);
+        return animation.loadTransform(scene.locals, scene.stride, node);
+    }
+
+    /// Marks the subtree of `node` for `update()`.
+    pub fn setLocal(scene: *Scene, node: usize, transform: Transform) void {
+        assert(node < scene.len);
+        animation.storeTransform(scene.locals, scene.stride, node, transform);
+        scene.dirty[node] = true;
+    }
+
+    /// World matrices of all nodes in one pass.
+    pub fn computeWorldMatrices(scene: *Scene) void {
+        scene.computeRange(0, scene.len);
+        std.mem.set(bool, scene.dirty, false);
+    }
+
+    /// World matrices level by level; nodes of a level are split between up to `num_threads` threads (0 - one per
+    /// CPU). Levels with less than `chunk_size` nodes don't spawn threads.
+    pub fn computeWorldMatricesParallel(scene: *Scene, num_threads: u32) void {
+        const Context = struct {
+            scene: *Scene,
+            first: usize,
+            last: usize,
+
+            fn computeChunk(context: *const @This(), index: usize) void {
+                const first = context.first + index * chunk_size;
+                context.scene.computeRange(first, std.math.min(first + chunk_size, context.last));
+            }
+        };
+
+        var level: usize = 0;
+        while (level < scene.numLevels()) : (level += 1) {
+            const context = Context{
+                .scene = scene,
+                .first = scene.level_offsets[level],
+                .last = scene.level_offsets[level + 1],
+            };
+            const num_chunks = (context.last - context.first + chunk_size - 1) / chunk_size;
+            parallel.forEach(num_chunks, num_threads, &context, Context.computeChunk);
+        }
+        std.mem.set(bool, scene.dirty, false);
+    }
+
+    /// Recomputes world matrices of dirty nodes and their descendants only.
+    pub fn update(scene: *Scene) void {
+        for (scene.parents) |parent, node| {
+            if (parent >= 0 and scene.dirty[@intCast(usize, parent)]) scene.dirty[node] = true;
+            if (scene.dirty[node]) scene.computeRange(node, node + 1);
+        }
+        std.mem.set(bool, scene.dirty, false);
+    }
+
+    pub const chunk_size = 4 * 1024;
+
+    /// Parents of `first..last` must be up to date.
+    fn computeRange(scene: *Scene, first: usize, last: usize) void {
+        animation.composeMatrices(scene.locals, scene.stride, first, last, scene.world[first..last]);
+        for (scene.world[first..last]) |*world, i| {
+            const parent = scene.parents[first + i];
+            if (parent >= 0) world.* = animation.mulMat(world.*, scene.world[@intCast(usize, parent)]);
+        }
+    }
+};
+
+const expect = std.testing.expect;
+
+fn expectMatApproxEq(a: Mat, b: Mat) !void {
+    for (a) |row, r| {
+        for (row) |v, c| try expect(std.math.approxEqAbs(f32, v, b[r][c], 0.0001));
+    }
+}
+
+test "zmesh.scene.world_matrices" {
+    const allocator = std.testing.allocator;
+
+    // glTF nodes listed children first: 2 (root, matrix) -> 0 (rotated 90 degrees about z) -> 1 (translated).
+    const json =
+        \\{"asset":{"version":"2.0"},
+        \\"nodes":[{"rotation":[0,0,0.70710678,0.70710678],"scale":[2,2,2],"children":[1]},
+        \\{"translation":[1,0,0]},
+        \\{"matrix":[1,0,0,0,0,1,0,0,0,0,1,0,5,0,0,1],"children":[0]},
+        \\{"translation":[0,0,3]}]}
+    ;
+    const data = try cgltf.parse(.{}, json);
+    defer cgltf.free(data);
+
+    var scene = try Scene.initGltf(allocator, data);
+    defer scene.deinit(allocator);
+
+    try expect(scene.numLevels() == 3);
+    try expect(std.mem.eql(u32, scene.level_offsets, &[_]u32{ 0, 2, 3, 4 }));
+    try expect(std.mem.eql(u32, scene.source_indices, &[_]u32{ 2, 3, 0, 1 }));
+    try expect(std.mem.eql(i32, scene.parents, &[_]i32{ -1, -1, 0, 2 }));
+
+    const nodes = data.nodes.?[0..data.nodes_count];
+    for (nodes) |node, i| {
+        try expectMatApproxEq(scene.world[scene.node_indices[i]], animation.matFromArray(node.transformWorld()));
+    }
+
+    // Node 1 at (5, 0, 0) + 2 * (1, 0, 0) turned to +y.
+    try expectMatApproxEq(scene.world[scene.node_indices[1]], .{
+        .{ 0.0, 2.0, 0.0, 0.0 },
+        .{ -2.0, 0.0, 0.0, 0.0 },
+        .{ 0.0, 0.0, 2.0, 0.0 },
+        .{ 5.0, 2.0, 0.0, 1.0 },
+    });
+
+    // Only the moved subtree is recomputed.
+    const untouched = scene.world[scene.node_indices[3]];
+    scene.world[scene.node_indices[3]][3][0] = 100.0;
+    var transform = scene.getLocal(scene.node_indices[0]);
+    transform.rotation = .{ 0.0, 0.0, 0.0, 1.0 };
+    scene.setLocal(scene.node_indices[0], transform);
+    scene.update();
+    try expect(scene.world[scene.node_indices[3]][3][0] == 100.0);
+    try expectMatApproxEq(scene.world[scene.node_indices[1]], .{
+        .{ 2.0, 0.0, 0.0, 0.0 },
+        .{ 0.0, 2.0, 0.0, 0.0 },
+        .{ 0.0, 0.0, 2.0, 0.0 },
+        .{ 7.0, 0.0, 0.0, 1.0 },
+    });
+
+    scene.world[scene.node_indices[3]] = untouched;
+    const expected = try allocator.dupe(Mat, scene.world);
+    defer allocator.free(expected);
+    std.mem.set(Mat, scene.world, std.mem.zeroes(Mat));
+    scene.computeWorldMatricesParallel(4);
+    for (expected) |m, i| try expectMatApproxEq(scene.world[i], m);
+
+    try std.testing.expectError(error.InvalidHierarchy, Scene.init(allocator, &.{ 1, 0 }, &.{ .{}, .{} }));
+}
@@ -0,0 +1,438 @@
+// Procedural shapes generated straight into caller buffers. Unlike `Shape` (par_shapes), which makes a full pass and
+// usually a reallocation for every transform, merge and normal computation, vertex and index counts are known before
+// anything is generated: `count()` sizes the buffers, `build()` writes every primitive with its transform applied
+// and analytic normals in a single pass. Index type (u16 or u32) is chosen at runtime.
+//
+// Parametric primitives use the vertex layout, texture coordinates and winding of their par_shapes counterparts.
+// Transforms are row-vector affine matrices (zmath layout); mirroring transforms flip the winding so faces stay
+// front-facing.
+
+const std = @import("std");
+const assert = std.debug.assert;
+
+const Mat = [4][4]f32;
+
+pub const identity = Mat{
+    .{ 1.0, 0.0, 0.0, 0.0 },
+    .{ 0.0, 1.0, 0.0, 0.0 },
+    .{ 0.0, 0.0, 1.0, 0.0 },
+    .{ 0.0, 0.0, 0.0, 1.0 },
+};
+
+/// `slices` and `stacks` must be >= 1.
+pub const Grid = struct {
+    slices: u32,
+    stacks: u32,
+};
+
+pub const Primitive = union(enum) {
+    /// [0, 1]^3 with flat faces (24 vertices).
+    cube,
+    /// [0, 1]^2 in the z = 0 plane, facing +z.
+    plane: Grid,
+    /// Unit sphere, poles on the z axis. Degenerate triangles at the poles are not generated.
+    sphere: Grid,
+    /// Radius 1, z in [0, 1], no caps.
+    cylinder: Grid,
+    /// Radius 1 at z = 0, apex at z = 1, no cap. Degenerate triangles at the apex are not generated.
+    cone: Grid,
+    /// Major radius 1 in the z = 0 plane.
+    torus: struct { slices: u32, stacks: u32, minor_radius: f32 },
+};
+
+pub const Item = struct {
+    primitive: Primitive,
+    transform: [4][4]f32 = identity,
+};
+
+pub const IndexFormat = enum { u16, u32 };
+
+pub const Indices = union(IndexFormat) {
+    u16: []u16,
+    u32: []u32,
+
+    pub fn len(indices: Indices) usize {
+        return switch (indices) {
+            .u16 => |i| i.len,
+            .u32 => |i| i.len,
+        };
+    }
+};
+
+pub const Counts = struct {
+    vertex_count: usize = 0,
+    index_count: usize = 0,
+
+    /// Smallest index type which addresses all vertices.
+    pub fn indexFormat(counts: Counts) IndexFormat {
+        return if (counts.vertex_count <= 1 << 16) .u16 else .u32;
+    }
+};
+
+pub fn countPrimitive(primitive: Primitive) Counts {
+    return switch (primitive) {
+        .cube => .{ .vertex_count = 24, .index_count = 36 },
+        .plane, .cylinder => |grid| countGrid(grid.slices, grid.stacks, .{}),
+        .sphere => |grid| countGrid(grid.slices, grid.stacks, sphere_poles),
+        .cone => |grid| countGrid(grid.slices, grid.stacks, cone_poles),
+        .torus => |torus| countGrid(torus.slices, torus.stacks, .{}),
+    };
+}
+
+/// Exact number of vertices and indices `build()` writes for `items`.
+pub fn count(items: []const Item) Counts {
+    var counts = Counts{};
+    for (items) |item| {
+        const c = countPrimitive(item.primitive);
+        counts.vertex_count += c.vertex_count;
+        counts.index_count += c.index_count;
+    }
+    return counts;
+}
+
+/// Destination streams; each must have room for `count(items)` elements. Indices are relative to the first vertex.
+pub const Output = struct {
+    positions: [][3]f32,
+    normals: ?[][3]f32 = null,
+    texcoords: ?[][2]f32 = null,
+    indices: Indices,
+};
+
+/// Generates `items` into `output`, returns the number of vertices and indices written.
+pub fn build(items: []const Item, output: Output) Counts {
+    const counts = count(items);
+    assert(output.positions.len >= counts.vertex_count and output.indices.len() >= counts.index_count);
+    if (output.normals) |normals| assert(normals.len >= counts.vertex_count);
+    if (output.texcoords) |texcoords| assert(texcoords.len >= counts.vertex_count);
+
+    switch (output.indices) {
+        .u16 => |indices| {
+            assert(counts.vertex_count <= 1 << 16);
+            buildItems(u16, items, output, indices);
+        },
+        .u32 => |indices| buildItems(u32, items, output, indices),
+    }
+    return counts;
+}
+
+pub const MeshOptions = struct {
+    normals: bool = true,
+    texcoords: bool = true,
+    /// Smallest type which fits when null.
+    index_format: ?IndexFormat = null,
+};
+
+/// Streams allocated by `buildAlloc()`; with an arena allocator `deinit()` is not needed.
+pub const Mesh = struct {
+    positions: [][3]f32,
+    normals: ?[][3]f32,
+    texcoords: ?[][2]f32,
+    indices: Indices,
+
+    pub fn deinit(mesh: *Mesh, allocator: std.mem.Allocator) void {
+        allocator.free(mesh.positions);
+        if (mesh.normals) |normals| allocator.free(normals);
+        if (mesh.texcoords) |texcoords| allocator.free(texcoords);
+        switch (mesh.indices) {
+            .u16 => |indices| allocator.free(indices),
+            .u32 => |indices| allocator.free(indices),
+        }
+        mesh.* = undefined;
+    }
+};
+
+/// `build()` into streams of exactly the right size allocated from `allocator`.
+pub fn buildAlloc(allocator: std.mem.Allocator, items: []const Item, options: MeshOptions) error{OutOfMemory}!Mesh {
+    const counts = count(items);
+
+    const positions = try allocator.alloc([3]f32, counts.vertex_count);
+    errdefer allocator.free(positions);
+    const normals: ?[][3]f32 = if (options.normals) try allocator.alloc([3]f32, counts.vertex_count) else null;
+    errdefer if (normals) |n| allocator.free(n);
+    const texcoords: ?[][2]f32 = if (options.texcoords) try allocator.alloc([2]f32, counts.vertex_count) else null;
+    errdefer if (texcoords) |t| allocator.free(t);
+    const indices: Indices = switch (options.index_format orelse counts.indexFormat()) {
+        .u16 => .{ .u16 = try allocator.alloc(u16, counts.index_count) },
+        .u32 => .{ .u32 = try allocator.alloc(u32, counts.index_count) },
+    };
+
+    _ = build(items, .{ .positions = positions, .normals = normals, .texcoords = texcoords, .indices = indices });
+    return Mesh{ .positions = positions, .normals = normals, .texcoords = texcoords, .indices = indices };
+}
+
+/// Grid rows which collapse to a point (`u` = 0 and `u` = 1).
+const Poles = struct {
+    first: bool = false,
+    last: bool = false,
+};
+
+const sphere_poles = Poles{ .first = true, .last = true };
+const cone_poles = Poles{ .last = true };
+
+fn countGrid(slices: u32, stacks: u32, poles: Poles) Counts {
+    const num_poles = @as(usize, @boolToInt(poles.first)) + @boolToInt(poles.last);
+    const num_triangles = 2 * @as(usize, slices) * stacks - num_poles * slices;
+    return .{ .vertex_count = (@as(usize, slices) + 1) * (stacks + 1), .index_count = 3 * num_triangles };
+}
+
+fn Writer(comptime Index: type) type {
+    return struct {
+        output: Output,
+        indices: []Index,
+        vertex: usize = 0,
+        index: usize = 0,
+        // Per item.
+        base_vertex: usize = 0,
+        transform: Mat = identity,
+        normal_matrix: [3][3]f32 = undefined,
+        flip: bool = false,
+
+        const Self = @This();
+
+        fn begin(w: *Self, transform: Mat) void {
+            w.base_vertex = w.vertex;
+            w.transform = transform;
+
+            // Normals are transformed by the inverse transpose of the upper 3x3, i.e. its cofactor matrix (scaled by
+            // the determinant, which renormalization cancels, except for its sign).
+            const m = transform;
+            const c = [3][3]f32{
+                .{
+                    m[1][1] * m[2][2] - m[1][2] * m[2][1],
+                    m[1][2] * m[2][0] - m[1][0] * m[2][2],
+                    m[1][0] * m[2][1] - m[1][1] * m[2][0],
+                },
+                .{
+                    m[2][1] * m[0][2] - m[2][2] * m[0][1],
+                    m[2][2] * m[0][0] - m[2][0] * m[0][2],
+                    m[2][0] * m[0][1] - m[2][1] * m[0][0],
+                },
+                .{
+                    m[0][1] * m[1][2] - m[0][2] * m[1][1],
+                    m[0][2] * m[1][0] - m[0][0] * m[1][2],
+                    m[0][0] * m[1][1] - m[0][1] * m[1][0],
+                },
+            };
+            const det = m[0][0] * c[0][0] + m[0][1] * c[0][1] + m[0][2] * c[0][2];
+            w.flip = det < 0.0;
+            const sign: f32 = if (w.flip) -1.0 else 1.0;
+            for (w.normal_matrix) |*row, i| {
+                for (row) |*v, j| v.* = c[i][j] * sign;
+            }
+        }
+
+        inline fn addVertex(w: *Self, p: [3]f32, n: [3]f32, uv: [2]f32) void {
+            const t = w.transform;
+            w.output.positions[w.vertex] = .{
+                p[0] * t[0][0] + p[1] * t[1][0] + p[2] * t[2][0] + t[3][0],
+                p[0] * t[0][1] + p[1] * t[1][1] + p[2] * t[2][1] + t[3][1],
+                p[0] * t[0][2] + p[1] * t[1][2] + p[2] * t[2][2] + t[3][2],
+            };
+            if (w.output.normals) |normals| {
+                const nm = w.normal_matrix;
+                const x = n[0] * nm[0][0] + n[1] * nm[1][0] + n[2] * nm[2][0];
+                const y = n[0] * nm[0][1] + n[1] * nm[1][1] + n[2] * nm[2][1];
+                const z = n[0] * nm[0][2] + n[1] * nm[1][2] + n[2] * nm[2][2];
+                const len_sq = x * x + y * y + z * z;
+                const scale = if (len_sq > 0.0) 1.0 / @sqrt(len_sq) else 0.0;
+                normals[w.vertex] = .{ x * scale, y * scale, z * scale };
+            }
+            if (w.output.texcoords) |texcoords| texcoords[w.vertex] = uv;
+            w.vertex += 1;
+        }
+
+        /// Vertex numbers are relative to the first vertex of the current item.
+        inline fn addTriangle(w: *Self, a: usize, b: usize, c: usize) void {
+            const base = w.base_vertex;
+            w.indices[w.index] = @intCast(Index, base + a);
+            w.indices[w.index + 1] = @intCast(Index, base + (if (w.flip) c else b));
+            w.indices[w.index + 2] = @intCast(Index, base + (if (w.flip) b else c));
+            w.index += 3;
+        }
+    };
+}
+
+fn buildItems(comptime Index: type, items: []const Item, output: Output, indices: []Index) void {
+    var w = Writer(Index){ .output = output, .indices = indices };
+    for (items) |item| {
+        w.begin(item.transform);
+        switch (item.primitive) {
+            .cube => addCube(Index, &w),
+            .plane => |grid| addGrid(Index, &w, grid.slices, grid.stacks, .{}, {}, evalPlane),
+            .sphere => |grid| addGrid(Index, &w, grid.slices, grid.stacks, sphere_poles, {}, evalSphere),
+            .cylinder => |grid| addGrid(Index, &w, grid.slices, grid.stacks, .{}, {}, evalCylinder),
+            .cone => |grid| addGrid(Index, &w, grid.slices, grid.stacks, cone_poles, {}, evalCone),
+            .torus => |torus| addGrid(Index, &w, torus.slices, torus.stacks, .{}, torus.minor_radius, evalTorus),
+        }
+    }
+}
+
+const Surface = struct {
+    position: [3]f32,
+    normal: [3]f32,
+};
+
+/// par_shapes parametric surface layout: `(stacks + 1) x (slices + 1)` vertices, `u = stack / stacks`,
+/// `v = slice / slices`. Triangles with two vertices in a row that collapses to a point (`poles`) are skipped.
+fn addGrid(
+    comptime Index: type,
+    w: *Writer(Index),
+    slices: u32,
+    stacks: u32,
+    comptime poles: Poles,
+    params: anytype,
+    comptime eval: fn (@TypeOf(params), f32, f32) Surface,
+) void {
+    assert(slices >= 1 and stacks >= 1);
+    var stack: u32 = 0;
+    while (stack <= stacks) : (stack += 1) {
+        const u = @intToFloat(f32, stack) / @intToFloat(f32, stacks);
+        var slice: u32 = 0;
+        while (slice <= slices) : (slice += 1) {
+            const v = @intToFloat(f32, slice) / @intToFloat(f32, slices);
+            const s = eval(params, u, v);
+            w.addVertex(s.position, s.normal, .{ u, v });
+        }
+    }
+
+    const row = @as(usize, slices) + 1;
+    stack = 0;
+    while (stack < stacks) : (stack += 1) {
+        const first = stack * row;
+        var slice: usize = 0;
+        while (slice < slices) : (slice += 1) {
+            if (!poles.first or stack != 0) w.addTriangle(first + slice + row, first + slice + 1, first + slice);
+            if (!poles.last or stack != stacks - 1) {
+                w.addTriangle(first + slice + row, first + slice + 1 + row, first + slice + 1);
+            }
+        }
+    }
+}
+
+fn evalPlane(_: void, u: f32, v: f32) Surface {
+    return .{ .position = .{ u, v, 0.0 }, .normal = .{ 0.0, 0.0, 1.0 } };
+}
+
+fn evalSphere(_: void, u: f32, v: f32) Surface {
+    const phi = u * std.math.pi;
+    const theta = v * 2.0 * std.math.pi;
+    const p = [3]f32{ @cos(theta) * @sin(phi), @sin(theta) * @sin(phi), @cos(phi) };
+    return .{ .position = p, .normal = p };
+}
+
+fn evalCylinder(_: void, u: f32, v: f32) Surface {
+    const theta = v * 2.0 * std.math.pi;
+    return .{ .position = .{ @sin(theta), @cos(theta), u }, .normal = .{ @sin(theta), @cos(theta), 0.0 } };
+}
+
+fn evalCone(_: void, u: f32, v: f32) Surface {
+    const theta = v * 2.0 * std.math.pi;
+    const r = 1.0 - u;
+    return .{
+        .position = .{ r * @sin(theta), r * @cos(theta), u },
+        .normal = .{ @sin(theta), @cos(theta), 1.0 },
+    };
+}
+
+fn evalTorus(minor_radius: f32, u: f32, v: f32) Surface {
+    const theta = u * 2.0 * std.math.pi;
+    const phi = v * 2.0 * std.math.pi;
+    const n = [3]f32{ @cos(theta) * @cos(phi), @sin(theta) * @cos(phi), @sin(phi) };
+    return .{
+        .position = .{ @cos(theta) + minor_radius * n[0], @sin(theta) + minor_radius * n[1], minor_radius * n[2] },
+        .normal = n,
+    };
+}
+
+fn addCube(comptime Index: type, w: *Writer(Index)) void {
+    // Corners and faces of `par_shapes_create_cube()`.
+    const corners = [8][3]f32{
+        .{ 0.0, 0.0, 0.0 }, .{ 0.0, 1.0, 0.0 }, .{ 1.0, 1.0, 0.0 }, .{ 1.0, 0.0, 0.0 },
+        .{ 0.0, 0.0, 1.0 }, .{ 0.0, 1.0, 1.0 }, .{ 1.0, 1.0, 1.0 }, .{ 1.0, 0.0, 1.0 },
+    };
+    const faces = [6][4]u8{
+        .{ 7, 6, 5, 4 }, .{ 0, 1, 2, 3 }, .{ 6, 7, 3, 2 },
+        .{ 5, 6, 2, 1 }, .{ 4, 5, 1, 0 }, .{ 7, 4, 0, 3 },
+    };
+    const normals = [6][3]f32{
+        .{ 0.0, 0.0, 1.0 },  .{ 0.0, 0.0, -1.0 }, .{ 1.0, 0.0, 0.0 },
+        .{ 0.0, 1.0, 0.0 },  .{ -1.0, 0.0, 0.0 }, .{ 0.0, -1.0, 0.0 },
+    };
+    const uvs = [4][2]f32{ .{ 0.0, 0.0 }, .{ 1.0, 0.0 }, .{ 1.0, 1.0 }, .{ 0.0, 1.0 } };
+
+    for (faces) |face, f| {
+        for (face) |corner, k| w.addVertex(corners[corner], normals[f], uvs[k]);
+        const first = f * 4;
+        w.addTriangle(first, first + 1, first + 2);
+        w.addTriangle(first + 2, first + 3, first);
+    }
+}
+
+const expect = std.testing.expect;
+
+test "zmesh.shapes.build" {
+    const allocator = std.testing.allocator;
+
+    var translate_scale = identity;
+    translate_scale[0][0] = 2.0;
+    translate_scale[3] = .{ 10.0, 0.0, 0.0, 1.0 };
+    var mirror = identity;
+    mirror[0][0] = -1.0;
+
+    const items = [_]Item{
+        .{ .primitive = .cube },
+        .{ .primitive = .{ .sphere = .{ .slices = 8, .stacks = 6 } }, .transform = translate_scale },
+        .{ .primitive = .{ .plane = .{ .slices = 2, .stacks = 3 } }, .transform = mirror },
+        .{ .primitive = .{ .torus = .{ .slices = 6, .stacks = 5, .minor_radius = 0.25 } } },
+        .{ .primitive = .{ .cone = .{ .slices = 5, .stacks = 2 } } },
+    };
+    const counts = count(&items);
+    try expect(counts.vertex_count == 24 + 9 * 7 + 3 * 4 + 7 * 6 + 6 * 3);
+    try expect(counts.index_count == 36 + 3 * (2 * 8 * 6 - 2 * 8) + 3 * 12 + 3 * 60 + 3 * (2 * 5 * 2 - 5));
+    try expect(counts.indexFormat() == .u16);
+
+    var mesh = try buildAlloc(allocator, &items, .{ .index_format = .u32 });
+    defer mesh.deinit(allocator);
+    const indices = mesh.indices.u32;
+    try expect(indices.len == counts.index_count);
+
+    // Every triangle faces the way its vertex normals point (outward; mirrored plane still faces its normal).
+    var i: usize = 0;
+    while (i < indices.len) : (i += 3) {
+        const a = mesh.positions[indices[i]];
+        const b = mesh.positions[indices[i + 1]];
+        const c = mesh.positions[indices[i + 2]];
+        const e0 = [3]f32{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const e1 = [3]f32{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        const face = [3]f32{
+            e0[1] * e1[2] - e0[2] * e1[1],
+            e0[2] * e1[0] - e0[0] * e1[2],
+            e0[0] * e1[1] - e0[1] * e1[0],
+        };
+        var n = [3]f32{ 0.0, 0.0, 0.0 };
+        for (indices[i..][0..3]) |index| {
+            for (n) |*v, k| v.* += mesh.normals.?[index][k];
+        }
+        try expect(face[0] * n[0] + face[1] * n[1] + face[2] * n[2] > 0.0);
+    }
+
+    // Sphere: scaled by 2 along x and moved to x = 10; normals are transformed by the inverse transpose.
+    const sphere_first = 24;
+    for (mesh.positions[sphere_first..][0..63]) |p, k| {
+        const local = [3]f32{ (p[0] - 10.0) / 2.0, p[1], p[2] };
+        const len_sq = local[0] * local[0] + local[1] * local[1] + local[2] * local[2];
+        try expect(std.math.approxEqAbs(f32, len_sq, 1.0, 0.0001));
+        const n = mesh.normals.?[sphere_first + k];
+        const expected = [3]f32{ local[0] / 2.0, local[1], local[2] };
+        const len = @sqrt(expected[0] * expected[0] + expected[1] * expected[1] + expected[2] * expected[2]);
+        for (n) |v, c| try expect(std.math.approxEqAbs(f32, v, expected[c] / len, 0.0001));
+    }
+
+    // Same geometry with u16 indices into caller buffers.
+    var positions: [256][3]f32 = undefined;
+    var indices16: [1024]u16 = undefined;
+    const written = build(&items, .{ .positions = &positions, .indices = .{ .u16 = &indices16 } });
+    try expect(written.vertex_count == counts.vertex_count and written.index_count == counts.index_count);
+    for (indices16[0..written.index_count]) |index, k| try expect(index == indices[k]);
+    for (positions[0..written.vertex_count]) |p, k| try expect(std.mem.eql(f32, &p, &mesh.positions[k]));
+}
@@ -763,6 +763,12 @@ pub fn validate(data: *Data) Result {
     return cgltf_validate(data);
 }
 
+/// Decodes percent-encoded characters in-place; returns the decoded part of `uri`.
+pub fn decodeUri(uri: [:0]u8) [:0]u8 {
+    const len = cgltf_decode_uri(uri.ptr);
+    return uri[0..len :0];
+}
+
 extern fn cgltf_parse(
     options: ?*const Options,
     data: ?*const anyopaque,
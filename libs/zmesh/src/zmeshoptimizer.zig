@@ -2,6 +2,7 @@
 
 const std = @import("std");
 const assert = std.debug.assert;
+const parallel = @import("parallel.zig");
 
 // Indexing
 pub inline fn generateVertexRemap(
@@ -20,6 +21,34 @@ pub inline fn generateVertexRemap(
     );
 }
 
+/// One vertex attribute stream; the first `size` bytes of every `stride`-sized element are compared/copied.
+pub const Stream = extern struct {
+    data: *const anyopaque,
+    size: usize,
+    stride: usize,
+
+    pub fn init(comptime T: type, vertices: []const T) Stream {
+        return .{ .data = vertices.ptr, .size = @sizeOf(T), .stride = @sizeOf(T) };
+    }
+};
+
+pub inline fn generateVertexRemapMulti(
+    destination: []u32,
+    indices: ?[]const u32,
+    vertex_count: usize,
+    streams: []const Stream,
+) usize {
+    assert(destination.len >= vertex_count);
+    return meshopt_generateVertexRemapMulti(
+        destination.ptr,
+        if (indices) |ind| ind.ptr else null,
+        if (indices) |ind| ind.len else vertex_count,
+        vertex_count,
+        streams.ptr,
+        streams.len,
+    );
+}
+
 pub inline fn remapVertexBuffer(
     comptime T: type,
     destination: []T,
@@ -49,6 +78,43 @@ pub inline fn remapIndexBuffer(
     );
 }
 
+/// Only the first `vertex_size` bytes of `T` define a vertex of the shadow index buffer (e.g. position).
+pub inline fn generateShadowIndexBuffer(
+    destination: []u32,
+    indices: []const u32,
+    comptime T: type,
+    vertices: []const T,
+    vertex_size: usize,
+) void {
+    assert(destination.len >= indices.len and vertex_size <= @sizeOf(T));
+    meshopt_generateShadowIndexBuffer(
+        destination.ptr,
+        indices.ptr,
+        indices.len,
+        vertices.ptr,
+        vertices.len,
+        vertex_size,
+        @sizeOf(T),
+    );
+}
+
+pub inline fn generateShadowIndexBufferMulti(
+    destination: []u32,
+    indices: []const u32,
+    vertex_count: usize,
+    streams: []const Stream,
+) void {
+    assert(destination.len >= indices.len);
+    meshopt_generateShadowIndexBufferMulti(
+        destination.ptr,
+        indices.ptr,
+        indices.len,
+        vertex_count,
+        streams.ptr,
+        streams.len,
+    );
+}
+
 // Vertex cache optimization
 pub inline fn optimizeVertexCache(
     destination: []u32,
@@ -140,6 +206,11 @@ pub inline fn optimizeVertexFetch(
     );
 }
 
+/// `destination.len` is the vertex count; unused vertices are mapped to `~0`. Returns the number of used vertices.
+pub inline fn optimizeVertexFetchRemap(destination: []u32, indices: []const u32) usize {
+    return meshopt_optimizeVertexFetchRemap(destination.ptr, indices.ptr, indices.len, destination.len);
+}
+
 pub const VertexFetchStatistics = extern struct {
     bytes_fetched: u32,
     overfetch: f32,
@@ -153,6 +224,104 @@ pub inline fn analyzeVertexFetch(
     return meshopt_analyzeVertexFetch(indices.ptr, indices.len, vertex_count, vertex_size);
 }
 
+// Simplification (position must be the first field of `T`)
+pub inline fn simplify(
+    destination: []u32,
+    indices: []const u32,
+    comptime T: type,
+    vertices: []const T,
+    target_index_count: usize,
+    target_error: f32,
+    result_error: ?*f32,
+) usize {
+    assert(destination.len >= indices.len);
+    return meshopt_simplify(
+        destination.ptr,
+        indices.ptr,
+        indices.len,
+        vertices.ptr,
+        vertices.len,
+        @sizeOf(T),
+        target_index_count,
+        target_error,
+        result_error,
+    );
+}
+
+pub inline fn simplifySloppy(
+    destination: []u32,
+    indices: []const u32,
+    comptime T: type,
+    vertices: []const T,
+    target_index_count: usize,
+    target_error: f32,
+    result_error: ?*f32,
+) usize {
+    assert(destination.len >= indices.len);
+    return meshopt_simplifySloppy(
+        destination.ptr,
+        indices.ptr,
+        indices.len,
+        vertices.ptr,
+        vertices.len,
+        @sizeOf(T),
+        target_index_count,
+        target_error,
+        result_error,
+    );
+}
+
+pub inline fn simplifyScale(comptime T: type, vertices: []const T) f32 {
+    return meshopt_simplifyScale(vertices.ptr, vertices.len, @sizeOf(T));
+}
+
+// Spatial sorting (position must be the first field of `T`)
+/// `destination[i]` is the new (Morton order) position of element `i`.
+pub inline fn spatialSortRemap(destination: []u32, comptime T: type, vertices: []const T) void {
+    assert(destination.len >= vertices.len);
+    meshopt_spatialSortRemap(destination.ptr, vertices.ptr, vertices.len, @sizeOf(T));
+}
+
+/// In-place sorting (`destination.ptr == indices.ptr`) is supported.
+pub inline fn spatialSortTriangles(
+    destination: []u32,
+    indices: []const u32,
+    comptime T: type,
+    vertices: []const T,
+) void {
+    assert(destination.len >= indices.len);
+    meshopt_spatialSortTriangles(destination.ptr, indices.ptr, indices.len, vertices.ptr, vertices.len, @sizeOf(T));
+}
+
+/// Moves element `i` of every slice in `arrays` (a tuple of mutable slices, all `remap.len` long) to `remap[i]`.
+/// All arrays are permuted together, in place, in a single pass over `remap`; `remap` is left as identity.
+pub fn remapArrays(remap: []u32, arrays: anytype) void {
+    inline for (arrays) |array| assert(array.len == remap.len);
+
+    for (remap) |_, i| {
+        while (remap[i] != i) {
+            const j = remap[i];
+            inline for (arrays) |array| std.mem.swap(std.meta.Elem(@TypeOf(array)), &array[i], &array[j]);
+            remap[i] = remap[j];
+            remap[j] = j;
+        }
+    }
+}
+
+/// Reorders `arrays` (see `remapArrays()`) by Morton order of `positions`, which may be one of `arrays`. Use for
+/// point clouds, instance and particle data that is iterated or culled in bulk.
+pub fn spatialSortArrays(
+    allocator: std.mem.Allocator,
+    comptime T: type,
+    positions: []const T,
+    arrays: anytype,
+) error{OutOfMemory}!void {
+    const remap = try allocator.alloc(u32, positions.len);
+    defer allocator.free(remap);
+    spatialSortRemap(remap, T, positions);
+    remapArrays(remap, arrays);
+}
+
 // Mesh shading
 pub inline fn buildMeshletsBound(index_count: usize, max_vertices: usize, max_triangles: usize) usize {
     return meshopt_buildMeshletsBound(index_count, max_vertices, max_triangles);
@@ -191,6 +360,659 @@ pub inline fn buildMeshlets(
     );
 }
 
+pub const Bounds = extern struct {
+    center: [3]f32,
+    radius: f32,
+    cone_apex: [3]f32,
+    cone_axis: [3]f32,
+    cone_cutoff: f32,
+    cone_axis_s8: [3]i8,
+    cone_cutoff_s8: i8,
+};
+
+pub inline fn computeClusterBounds(indices: []const u32, comptime T: type, vertices: []const T) Bounds {
+    assert(indices.len <= 512 * 3);
+    return meshopt_computeClusterBounds(indices.ptr, indices.len, vertices.ptr, vertices.len, @sizeOf(T));
+}
+
+/// `meshlet_vertices` and `meshlet_triangles` are the ranges of a single meshlet (see `Meshlet`).
+pub inline fn computeMeshletBounds(
+    meshlet_vertices: []const u32,
+    meshlet_triangles: []const u8,
+    comptime T: type,
+    vertices: []const T,
+) Bounds {
+    return meshopt_computeMeshletBounds(
+        meshlet_vertices.ptr,
+        meshlet_triangles.ptr,
+        meshlet_triangles.len / 3,
+        vertices.ptr,
+        vertices.len,
+        @sizeOf(T),
+    );
+}
+
+// Vertex/index buffer compression
+pub inline fn encodeIndexBufferBound(index_count: usize, vertex_count: usize) usize {
+    return meshopt_encodeIndexBufferBound(index_count, vertex_count);
+}
+
+/// Returns the number of bytes written to `buffer` (0 when `buffer` is too small).
+pub inline fn encodeIndexBuffer(buffer: []u8, indices: []const u32) usize {
+    assert(indices.len % 3 == 0);
+    return meshopt_encodeIndexBuffer(buffer.ptr, buffer.len, indices.ptr, indices.len);
+}
+
+pub inline fn decodeIndexBuffer(comptime T: type, destination: []T, buffer: []const u8) error{InvalidData}!void {
+    comptime assert(T == u16 or T == u32);
+    if (meshopt_decodeIndexBuffer(destination.ptr, destination.len, @sizeOf(T), buffer.ptr, buffer.len) != 0)
+        return error.InvalidData;
+}
+
+pub inline fn encodeIndexSequenceBound(index_count: usize, vertex_count: usize) usize {
+    return meshopt_encodeIndexSequenceBound(index_count, vertex_count);
+}
+
+/// Arbitrary index sequences (not just triangle lists). Returns the number of bytes written to `buffer` (0 when
+/// `buffer` is too small).
+pub inline fn encodeIndexSequence(buffer: []u8, indices: []const u32) usize {
+    return meshopt_encodeIndexSequence(buffer.ptr, buffer.len, indices.ptr, indices.len);
+}
+
+pub inline fn decodeIndexSequence(comptime T: type, destination: []T, buffer: []const u8) error{InvalidData}!void {
+    comptime assert(T == u16 or T == u32);
+    if (meshopt_decodeIndexSequence(destination.ptr, destination.len, @sizeOf(T), buffer.ptr, buffer.len) != 0)
+        return error.InvalidData;
+}
+
+pub inline fn encodeVertexBufferBound(vertex_count: usize, vertex_size: usize) usize {
+    return meshopt_encodeVertexBufferBound(vertex_count, vertex_size);
+}
+
+/// `vertex_size` must be a multiple of 4 (up to 256). Returns the number of bytes written to `buffer` (0 when
+/// `buffer` is too small).
+pub inline fn encodeVertexBuffer(buffer: []u8, vertices: []const u8, vertex_size: usize) usize {
+    assert(vertex_size % 4 == 0 and vertex_size <= 256);
+    assert(vertices.len % vertex_size == 0);
+    return meshopt_encodeVertexBuffer(
+        buffer.ptr,
+        buffer.len,
+        vertices.ptr,
+        vertices.len / vertex_size,
+        vertex_size,
+    );
+}
+
+pub inline fn decodeVertexBuffer(destination: []u8, vertex_size: usize, buffer: []const u8) error{InvalidData}!void {
+    assert(vertex_size % 4 == 0 and vertex_size <= 256);
+    assert(destination.len % vertex_size == 0);
+    if (meshopt_decodeVertexBuffer(
+        destination.ptr,
+        destination.len / vertex_size,
+        vertex_size,
+        buffer.ptr,
+        buffer.len,
+    ) != 0) return error.InvalidData;
+}
+
+// Vertex buffer filters (decoding works in-place on the output of `decodeVertexBuffer()`)
+/// `stride` is 4 (8-bit components) or 8 (16-bit components); `data` holds 4 floats per vector.
+pub inline fn encodeFilterOct(destination: []u8, stride: usize, bits: u32, data: []const f32) void {
+    assert(stride == 4 or stride == 8);
+    assert(bits >= 1 and bits <= 16);
+    assert(data.len == destination.len / stride * 4);
+    meshopt_encodeFilterOct(destination.ptr, destination.len / stride, stride, @intCast(c_int, bits), data.ptr);
+}
+
+/// `data` holds 4 floats per quaternion; each encoded quaternion takes 8 bytes.
+pub inline fn encodeFilterQuat(destination: []u8, bits: u32, data: []const f32) void {
+    assert(bits >= 4 and bits <= 16);
+    assert(data.len == destination.len / 8 * 4);
+    meshopt_encodeFilterQuat(destination.ptr, destination.len / 8, 8, @intCast(c_int, bits), data.ptr);
+}
+
+/// `data` holds `stride / 4` floats per vector; all components of a vector share the exponent.
+pub inline fn encodeFilterExp(destination: []u8, stride: usize, bits: u32, data: []const f32) void {
+    assert(stride % 4 == 0);
+    assert(bits >= 1 and bits <= 24);
+    assert(data.len == destination.len / 4);
+    meshopt_encodeFilterExp(destination.ptr, destination.len / stride, stride, @intCast(c_int, bits), data.ptr);
+}
+
+pub inline fn decodeFilterOct(buffer: []u8, stride: usize) void {
+    assert(stride == 4 or stride == 8);
+    assert(@ptrToInt(buffer.ptr) % @alignOf(i16) == 0);
+    meshopt_decodeFilterOct(buffer.ptr, buffer.len / stride, stride);
+}
+
+pub inline fn decodeFilterQuat(buffer: []u8) void {
+    assert(@ptrToInt(buffer.ptr) % @alignOf(i16) == 0);
+    meshopt_decodeFilterQuat(buffer.ptr, buffer.len / 8, 8);
+}
+
+pub inline fn decodeFilterExp(buffer: []u8, stride: usize) void {
+    assert(stride % 4 == 0);
+    assert(@ptrToInt(buffer.ptr) % @alignOf(u32) == 0);
+    meshopt_decodeFilterExp(buffer.ptr, buffer.len / stride, stride);
+}
+
+// LOD chain generation
+pub const LodLevelDesc = struct {
+    /// Target index count relative to the source mesh.
+    ratio: f32,
+    /// Maximum error relative to mesh extents (see `simplifyScale()`), including error of all previous levels.
+    max_error: f32,
+};
+
+pub const LodLevel = struct {
+    index_offset: u32,
+    index_count: u32,
+    /// Relative error of this level: upper bound (sum) of errors of all simplification steps so far.
+    /// Multiply by `LodChain.error_scale` to get error in mesh units.
+    relative_error: f32,
+    /// `simplifySloppy()` was used because `simplify()` could not get close to the target index count.
+    sloppy: bool,
+};
+
+pub const LodChainOptions = struct {
+    /// `simplifySloppy()` is tried when `simplify()` leaves more than `target * sloppy_threshold` indices.
+    sloppy_threshold: f32 = 1.25,
+    optimize_vertex_cache: bool = true,
+};
+
+/// All levels index the same (source) vertex buffer. `levels[0]` is the source mesh, `levels[i + 1]` is generated
+/// from `levels[i]` according to `level_descs[i]`.
+pub const LodChain = struct {
+    indices: []u32,
+    levels: []LodLevel,
+    error_scale: f32,
+
+    pub fn deinit(chain: *LodChain, allocator: std.mem.Allocator) void {
+        allocator.free(chain.indices);
+        allocator.free(chain.levels);
+        chain.* = undefined;
+    }
+
+    pub fn getLevelIndices(chain: LodChain, level: usize) []u32 {
+        const l = chain.levels[level];
+        return chain.indices[l.index_offset..][0..l.index_count];
+    }
+};
+
+pub fn generateLodChain(
+    allocator: std.mem.Allocator,
+    indices: []const u32,
+    comptime T: type,
+    vertices: []const T,
+    level_descs: []const LodLevelDesc,
+    options: LodChainOptions,
+) error{OutOfMemory}!LodChain {
+    assert(indices.len % 3 == 0);
+
+    const levels = try allocator.alloc(LodLevel, level_descs.len + 1);
+    errdefer allocator.free(levels);
+
+    var all_indices = std.ArrayList(u32).init(allocator);
+    errdefer all_indices.deinit();
+    try all_indices.appendSlice(indices);
+
+    var sloppy_indices = @as([*]u32, undefined)[0..0];
+    defer allocator.free(sloppy_indices);
+
+    levels[0] = .{
+        .index_offset = 0,
+        .index_count = @intCast(u32, indices.len),
+        .relative_error = 0.0,
+        .sloppy = false,
+    };
+
+    for (level_descs) |desc, i| {
+        assert(desc.ratio >= 0.0 and desc.ratio <= 1.0);
+        const prev = levels[i];
+        const target_index_count = @floatToInt(usize, @intToFloat(f32, indices.len) * desc.ratio) / 3 * 3;
+        const target_error = std.math.max(desc.max_error - prev.relative_error, 0.0);
+
+        try all_indices.ensureUnusedCapacity(prev.index_count);
+        const src = all_indices.items[prev.index_offset..][0..prev.index_count];
+        const dst = all_indices.allocatedSlice()[all_indices.items.len..][0..prev.index_count];
+
+        var result_error: f32 = 0.0;
+        var count = simplify(dst, src, T, vertices, target_index_count, target_error, &result_error);
+        var sloppy = false;
+
+        if (@intToFloat(f32, count) > @intToFloat(f32, target_index_count) * options.sloppy_threshold) {
+            if (sloppy_indices.len == 0) sloppy_indices = try allocator.alloc(u32, indices.len);
+
+            var sloppy_error: f32 = 0.0;
+            const sloppy_count = simplifySloppy(
+                sloppy_indices[0..src.len],
+                src,
+                T,
+                vertices,
+                target_index_count,
+                target_error,
+                &sloppy_error,
+            );
+            if (sloppy_count > 0 and sloppy_count < count) {
+                std.mem.copy(u32, dst, sloppy_indices[0..sloppy_count]);
+                count = sloppy_count;
+                result_error = sloppy_error;
+                sloppy = true;
+            }
+        }
+
+        if (options.optimize_vertex_cache) {
+            // In-place optimization is supported.
+            optimizeVertexCache(dst[0..count], dst[0..count], vertices.len);
+        }
+
+        levels[i + 1] = .{
+            .index_offset = @intCast(u32, all_indices.items.len),
+            .index_count = @intCast(u32, count),
+            .relative_error = prev.relative_error + result_error,
+            .sloppy = sloppy,
+        };
+        all_indices.items.len += count;
+    }
+
+    return LodChain{
+        .indices = all_indices.toOwnedSlice(),
+        .levels = levels,
+        .error_scale = simplifyScale(T, vertices),
+    };
+}
+
+pub fn LodChainInput(comptime T: type) type {
+    return struct {
+        indices: []const u32,
+        vertices: []const T,
+    };
+}
+
+/// Generates LOD chains for `meshes` in parallel on up to `num_threads` threads (0 - one per CPU). `allocator` must be
+/// thread-safe. On error no chains are returned.
+pub fn generateLodChains(
+    allocator: std.mem.Allocator,
+    comptime T: type,
+    meshes: []const LodChainInput(T),
+    level_descs: []const LodLevelDesc,
+    options: LodChainOptions,
+    chains: []LodChain,
+    num_threads: u32,
+) error{OutOfMemory}!void {
+    assert(chains.len >= meshes.len);
+
+    const Context = struct {
+        allocator: std.mem.Allocator,
+        meshes: []const LodChainInput(T),
+        level_descs: []const LodLevelDesc,
+        options: LodChainOptions,
+        chains: []LodChain,
+        out_of_memory: bool = false,
+
+        fn generate(context: *@This(), index: usize) void {
+            const mesh = context.meshes[index];
+            context.chains[index] = generateLodChain(
+                context.allocator,
+                mesh.indices,
+                T,
+                mesh.vertices,
+                context.level_descs,
+                context.options,
+            ) catch {
+                @atomicStore(bool, &context.out_of_memory, true, .Monotonic);
+                return;
+            };
+        }
+    };
+
+    for (chains[0..meshes.len]) |*chain| {
+        chain.* = .{
+            .indices = @as([*]u32, undefined)[0..0],
+            .levels = @as([*]LodLevel, undefined)[0..0],
+            .error_scale = 0.0,
+        };
+    }
+
+    var context = Context{
+        .allocator = allocator,
+        .meshes = meshes,
+        .level_descs = level_descs,
+        .options = options,
+        .chains = chains[0..meshes.len],
+    };
+    parallel.forEach(meshes.len, num_threads, &context, Context.generate);
+
+    if (context.out_of_memory) {
+        for (chains[0..meshes.len]) |*chain| chain.deinit(allocator);
+        return error.OutOfMemory;
+    }
+}
+
+// Mesh optimization pipeline
+pub const MeshOptimizationOptions = struct {
+    /// Stream whose first 12 bytes are the vertex position (`[3]f32`), used by overdraw optimization. `null` skips
+    /// overdraw optimization.
+    position_stream: ?u32 = 0,
+    overdraw_threshold: f32 = 1.05,
+    /// Streams that define a vertex of the shadow index buffer (usually only the position stream). When empty no
+    /// shadow index buffer is generated.
+    shadow_streams: []const u32 = &.{},
+    /// Fill `OptimizedMesh.before` and `OptimizedMesh.after`.
+    analyze: bool = true,
+    cache_size: u32 = 16,
+};
+
+pub const MeshStats = struct {
+    cache: VertexCacheStatistics = .{ .vertices_transformed = 0, .warps_executed = 0, .acmr = 0.0, .atvr = 0.0 },
+    fetch: VertexFetchStatistics = .{ .bytes_fetched = 0, .overfetch = 0.0 },
+};
+
+pub const OptimizedMesh = struct {
+    indices: []u32,
+    /// Empty when `MeshOptimizationOptions.shadow_streams` is empty.
+    shadow_indices: []u32,
+    vertex_count: u32,
+    /// One tightly packed (`Stream.size` bytes per vertex), 16-byte aligned buffer per input stream.
+    streams: [][]align(16) u8,
+    before: MeshStats,
+    after: MeshStats,
+    vertex_data: []align(16) u8,
+
+    pub const empty = OptimizedMesh{
+        .indices = @as([*]u32, undefined)[0..0],
+        .shadow_indices = @as([*]u32, undefined)[0..0],
+        .vertex_count = 0,
+        .streams = @as([*][]align(16) u8, undefined)[0..0],
+        .before = .{},
+        .after = .{},
+        .vertex_data = @as([*]align(16) u8, undefined)[0..0],
+    };
+
+    pub fn deinit(mesh: *OptimizedMesh, allocator: std.mem.Allocator) void {
+        allocator.free(mesh.indices);
+        allocator.free(mesh.shadow_indices);
+        allocator.free(mesh.streams);
+        allocator.free(mesh.vertex_data);
+        mesh.* = undefined;
+    }
+
+    pub fn getStream(mesh: OptimizedMesh, comptime T: type, stream_index: u32) []T {
+        return std.mem.bytesAsSlice(T, mesh.streams[stream_index]);
+    }
+};
+
+/// Deduplicates vertices (all streams), optimizes for vertex cache, overdraw and vertex fetch in one call. Scratch
+/// memory is kept between calls so one `MeshOptimizer` can process any number of meshes without per-stage allocations.
+pub const MeshOptimizer = struct {
+    allocator: std.mem.Allocator,
+    remap: std.ArrayListUnmanaged(u32) = .{},
+    fetch_remap: std.ArrayListUnmanaged(u32) = .{},
+    indices: [2]std.ArrayListUnmanaged(u32) = .{ .{}, .{} },
+    positions: std.ArrayListUnmanaged([3]f32) = .{},
+
+    pub fn init(allocator: std.mem.Allocator) MeshOptimizer {
+        return .{ .allocator = allocator };
+    }
+
+    pub fn deinit(optimizer: *MeshOptimizer) void {
+        optimizer.remap.deinit(optimizer.allocator);
+        optimizer.fetch_remap.deinit(optimizer.allocator);
+        optimizer.indices[0].deinit(optimizer.allocator);
+        optimizer.indices[1].deinit(optimizer.allocator);
+        optimizer.positions.deinit(optimizer.allocator);
+        optimizer.* = undefined;
+    }
+
+    /// Result is allocated with `allocator`, scratch memory with the optimizer's allocator.
+    pub fn optimize(
+        optimizer: *MeshOptimizer,
+        allocator: std.mem.Allocator,
+        indices: []const u32,
+        vertex_count: u32,
+        streams: []const Stream,
+        options: MeshOptimizationOptions,
+    ) error{OutOfMemory}!OptimizedMesh {
+        assert(indices.len % 3 == 0);
+        assert(streams.len > 0 and streams.len <= max_num_streams);
+        assert(options.shadow_streams.len <= streams.len);
+        if (options.position_stream) |p| assert(p < streams.len and streams[p].size >= @sizeOf([3]f32));
+
+        var vertex_size: usize = 0;
+        for (streams) |stream| vertex_size += stream.size;
+
+        var mesh = OptimizedMesh.empty;
+        errdefer mesh.deinit(allocator);
+
+        if (options.analyze) mesh.before = analyzeMesh(indices, vertex_count, vertex_size, options.cache_size);
+
+        const remap = try resizeScratch(u32, optimizer.allocator, &optimizer.remap, vertex_count);
+        const unique_count = generateVertexRemapMulti(remap, indices, vertex_count, streams);
+
+        var src = try resizeScratch(u32, optimizer.allocator, &optimizer.indices[0], indices.len);
+        var dst = try resizeScratch(u32, optimizer.allocator, &optimizer.indices[1], indices.len);
+        remapIndexBuffer(src, indices, remap);
+        optimizeVertexCache(dst, src, unique_count);
+
+        if (options.position_stream) |p| {
+            const positions = try resizeScratch([3]f32, optimizer.allocator, &optimizer.positions, unique_count);
+            remapStream(std.mem.sliceAsBytes(positions), @sizeOf([3]f32), streams[p], remap);
+            std.mem.swap([]u32, &src, &dst);
+            optimizeOverdraw(dst, src, [3]f32, positions, options.overdraw_threshold);
+        }
+
+        // Compose both remaps so every stream is copied only once, straight from the source.
+        const fetch_remap = try resizeScratch(u32, optimizer.allocator, &optimizer.fetch_remap, unique_count);
+        mesh.vertex_count = @intCast(u32, optimizeVertexFetchRemap(fetch_remap, dst));
+        for (remap) |*r| {
+            if (r.* != ~@as(u32, 0)) r.* = fetch_remap[r.*];
+        }
+
+        mesh.indices = try allocator.alloc(u32, indices.len);
+        remapIndexBuffer(mesh.indices, dst, fetch_remap);
+
+        var data_size: usize = 0;
+        for (streams) |stream| data_size += std.mem.alignForward(stream.size * mesh.vertex_count, 16);
+        mesh.vertex_data = try allocator.alignedAlloc(u8, 16, data_size);
+        mesh.streams = try allocator.alloc([]align(16) u8, streams.len);
+
+        var offset: usize = 0;
+        for (streams) |stream, i| {
+            const size = stream.size * mesh.vertex_count;
+            mesh.streams[i] = @alignCast(16, mesh.vertex_data[offset..][0..size]);
+            remapStream(mesh.streams[i], stream.size, stream, remap);
+            offset += std.mem.alignForward(size, 16);
+        }
+
+        if (options.shadow_streams.len > 0) {
+            var shadow_streams: [max_num_streams]Stream = undefined;
+            for (options.shadow_streams) |stream_index, i| {
+                const size = streams[stream_index].size;
+                shadow_streams[i] = .{ .data = mesh.streams[stream_index].ptr, .size = size, .stride = size };
+            }
+            mesh.shadow_indices = try allocator.alloc(u32, indices.len);
+            generateShadowIndexBufferMulti(
+                mesh.shadow_indices,
+                mesh.indices,
+                mesh.vertex_count,
+                shadow_streams[0..options.shadow_streams.len],
+            );
+            optimizeVertexCache(mesh.shadow_indices, mesh.shadow_indices, mesh.vertex_count);
+        }
+
+        if (options.analyze) mesh.after = analyzeMesh(mesh.indices, mesh.vertex_count, vertex_size, options.cache_size);
+        return mesh;
+    }
+
+    const max_num_streams = 16;
+
+    fn resizeScratch(
+        comptime T: type,
+        allocator: std.mem.Allocator,
+        list: *std.ArrayListUnmanaged(T),
+        len: usize,
+    ) error{OutOfMemory}![]T {
+        try list.resize(allocator, len);
+        return list.items;
+    }
+
+    /// Copies every vertex `i` of `stream` with `remap[i] != ~0` to `dst[remap[i] * size]`.
+    fn remapStream(dst: []u8, size: usize, stream: Stream, remap: []const u32) void {
+        const src = @ptrCast([*]const u8, stream.data);
+        for (remap) |r, i| {
+            if (r == ~@as(u32, 0)) continue;
+            std.mem.copy(u8, dst[@as(usize, r) * size ..][0..size], src[i * stream.stride ..][0..size]);
+        }
+    }
+
+    fn analyzeMesh(indices: []const u32, vertex_count: usize, vertex_size: usize, cache_size: u32) MeshStats {
+        if (indices.len == 0) return .{};
+        return .{
+            .cache = analyzeVertexCache(indices, vertex_count, cache_size, 0, 0),
+            .fetch = analyzeVertexFetch(indices, vertex_count, vertex_size),
+        };
+    }
+};
+
+pub fn optimizeMesh(
+    allocator: std.mem.Allocator,
+    indices: []const u32,
+    vertex_count: u32,
+    streams: []const Stream,
+    options: MeshOptimizationOptions,
+) error{OutOfMemory}!OptimizedMesh {
+    var optimizer = MeshOptimizer.init(allocator);
+    defer optimizer.deinit();
+    return optimizer.optimize(allocator, indices, vertex_count, streams, options);
+}
+
+pub const MeshInput = struct {
+    indices: []const u32,
+    vertex_count: u32,
+    streams: []const Stream,
+};
+
+/// Sums over all meshes of a batch (zero when `MeshOptimizationOptions.analyze` is false).
+pub const MeshBatchStats = struct {
+    pub const Totals = struct {
+        triangle_count: u64 = 0,
+        vertex_count: u64 = 0,
+        vertex_bytes: u64 = 0,
+        vertices_transformed: u64 = 0,
+        bytes_fetched: u64 = 0,
+
+        pub fn getAcmr(totals: Totals) f32 {
+            if (totals.triangle_count == 0) return 0.0;
+            return @intToFloat(f32, totals.vertices_transformed) / @intToFloat(f32, totals.triangle_count);
+        }
+
+        pub fn getAtvr(totals: Totals) f32 {
+            if (totals.vertex_count == 0) return 0.0;
+            return @intToFloat(f32, totals.vertices_transformed) / @intToFloat(f32, totals.vertex_count);
+        }
+
+        pub fn getOverfetch(totals: Totals) f32 {
+            if (totals.vertex_bytes == 0) return 0.0;
+            return @intToFloat(f32, totals.bytes_fetched) / @intToFloat(f32, totals.vertex_bytes);
+        }
+
+        fn add(totals: *Totals, index_count: usize, vertex_count: usize, vertex_size: usize, stats: MeshStats) void {
+            totals.triangle_count += index_count / 3;
+            totals.vertex_count += vertex_count;
+            totals.vertex_bytes += vertex_count * vertex_size;
+            totals.vertices_transformed += stats.cache.vertices_transformed;
+            totals.bytes_fetched += stats.fetch.bytes_fetched;
+        }
+    };
+
+    before: Totals = .{},
+    after: Totals = .{},
+};
+
+/// Optimizes `meshes` in parallel on up to `num_threads` threads (0 - one per CPU); every thread reuses the scratch
+/// memory of one `MeshOptimizer`. `allocator` must be thread-safe. On error no meshes are returned.
+pub fn optimizeMeshes(
+    allocator: std.mem.Allocator,
+    meshes: []const MeshInput,
+    options: MeshOptimizationOptions,
+    results: []OptimizedMesh,
+    num_threads: u32,
+) error{OutOfMemory}!MeshBatchStats {
+    assert(results.len >= meshes.len);
+
+    const Slot = struct {
+        busy: bool = false,
+        optimizer: MeshOptimizer,
+    };
+
+    const Context = struct {
+        allocator: std.mem.Allocator,
+        meshes: []const MeshInput,
+        options: MeshOptimizationOptions,
+        results: []OptimizedMesh,
+        slots: []Slot,
+        out_of_memory: bool = false,
+
+        fn optimize(context: *@This(), index: usize) void {
+            const slot = context.acquireSlot();
+            defer @atomicStore(bool, &slot.busy, false, .Release);
+
+            const mesh = context.meshes[index];
+            context.results[index] = slot.optimizer.optimize(
+                context.allocator,
+                mesh.indices,
+                mesh.vertex_count,
+                mesh.streams,
+                context.options,
+            ) catch {
+                @atomicStore(bool, &context.out_of_memory, true, .Monotonic);
+                return;
+            };
+        }
+
+        /// `forEach()` never runs more items at once than there are slots, so this spins only briefly.
+        fn acquireSlot(context: *@This()) *Slot {
+            while (true) {
+                for (context.slots) |*slot| {
+                    if (@cmpxchgStrong(bool, &slot.busy, false, true, .Acquire, .Monotonic) == null) return slot;
+                }
+            }
+        }
+    };
+
+    const slots = try allocator.alloc(Slot, parallel.getNumThreads(meshes.len, num_threads));
+    for (slots) |*slot| slot.* = .{ .optimizer = MeshOptimizer.init(allocator) };
+    defer {
+        for (slots) |*slot| slot.optimizer.deinit();
+        allocator.free(slots);
+    }
+
+    for (results[0..meshes.len]) |*result| result.* = OptimizedMesh.empty;
+
+    var context = Context{
+        .allocator = allocator,
+        .meshes = meshes,
+        .options = options,
+        .results = results[0..meshes.len],
+        .slots = slots,
+    };
+    parallel.forEach(meshes.len, num_threads, &context, Context.optimize);
+
+    if (context.out_of_memory) {
+        for (results[0..meshes.len]) |*result| result.deinit(allocator);
+        return error.OutOfMemory;
+    }
+
+    var stats = MeshBatchStats{};
+    for (meshes) |mesh, i| {
+        var vertex_size: usize = 0;
+        for (mesh.streams) |stream| vertex_size += stream.size;
+        stats.before.add(mesh.indices.len, mesh.vertex_count, vertex_size, results[i].before);
+        stats.after.add(results[i].indices.len, results[i].vertex_count, vertex_size, results[i].after);
+    }
+    return stats;
+}
+
 extern fn meshopt_generateVertexRemap(
     destination: [*]u32,
     indices: ?[*]const u32,
@@ -199,6 +1021,14 @@ extern fn meshopt_generateVertexRemap(
     vertex_count: usize,
     vertex_size: usize,
 ) usize;
+extern fn meshopt_generateVertexRemapMulti(
+    destination: [*]u32,
+    indices: ?[*]const u32,
+    index_count: usize,
+    vertex_count: usize,
+    streams: [*]const Stream,
+    stream_count: usize,
+) usize;
 extern fn meshopt_remapVertexBuffer(
     destination: *anyopaque,
     vertices: *const anyopaque,
@@ -212,6 +1042,23 @@ extern fn meshopt_remapIndexBuffer(
     index_count: usize,
     remap: [*]const u32,
 ) void;
+extern fn meshopt_generateShadowIndexBuffer(
+    destination: [*]u32,
+    indices: [*]const u32,
+    index_count: usize,
+    vertices: *const anyopaque,
+    vertex_count: usize,
+    vertex_size: usize,
+    vertex_stride: usize,
+) void;
+extern fn meshopt_generateShadowIndexBufferMulti(
+    destination: [*]u32,
+    indices: [*]const u32,
+    index_count: usize,
+    vertex_count: usize,
+    streams: [*]const Stream,
+    stream_count: usize,
+) void;
 extern fn meshopt_optimizeVertexCache(
     destination: [*]u32,
     indices: [*]const u32,
@@ -250,6 +1097,12 @@ extern fn meshopt_optimizeVertexFetch(
     vertex_count: usize,
     vertex_size: usize,
 ) usize;
+extern fn meshopt_optimizeVertexFetchRemap(
+    destination: [*]u32,
+    indices: [*]const u32,
+    index_count: usize,
+    vertex_count: usize,
+) usize;
 extern fn meshopt_analyzeVertexFetch(
     indices: [*]const u32,
     index_count: usize,
@@ -274,3 +1127,342 @@ extern fn meshopt_buildMeshlets(
     max_triangles: usize,
     cone_weight: f32,
 ) usize;
+extern fn meshopt_computeClusterBounds(
+    indices: [*]const u32,
+    index_count: usize,
+    vertices: *const anyopaque,
+    vertex_count: usize,
+    vertex_size: usize,
+) Bounds;
+extern fn meshopt_computeMeshletBounds(
+    meshlet_vertices: [*]const u32,
+    meshlet_triangles: [*]const u8,
+    triangle_count: usize,
+    vertices: *const anyopaque,
+    vertex_count: usize,
+    vertex_size: usize,
+) Bounds;
+extern fn meshopt_simplify(
+    destination: [*]u32,
+    indices: [*]const u32,
+    index_count: usize,
+    vertex_positions: *const anyopaque,
+    vertex_count: usize,
+    vertex_positions_stride: usize,
+    target_index_count: usize,
+    target_error: f32,
+    result_error: ?*f32,
+) usize;
+extern fn meshopt_simplifySloppy(
+    destination: [*]u32,
+    indices: [*]const u32,
+    index_count: usize,
+    vertex_positions: *const anyopaque,
+    vertex_count: usize,
+    vertex_positions_stride: usize,
+    target_index_count: usize,
+    target_error: f32,
+    result_error: ?*f32,
+) usize;
+extern fn meshopt_simplifyScale(
+    vertex_positions: *const anyopaque,
+    vertex_count: usize,
+    vertex_positions_stride: usize,
+) f32;
+extern fn meshopt_spatialSortRemap(
+    destination: [*]u32,
+    vertices: *const anyopaque,
+    vertex_count: usize,
+    vertex_size: usize,
+) void;
+extern fn meshopt_spatialSortTriangles(
+    destination: [*]u32,
+    indices: [*]const u32,
+    index_count: usize,
+    vertices: *const anyopaque,
+    vertex_count: usize,
+    vertex_size: usize,
+) void;
+extern fn meshopt_encodeIndexBufferBound(index_count: usize, vertex_count: usize) usize;
+extern fn meshopt_encodeIndexBuffer(
+    buffer: [*]u8,
+    buffer_size: usize,
+    indices: [*]const u32,
+    index_count: usize,
+) usize;
+extern fn meshopt_decodeIndexBuffer(
+    destination: *anyopaque,
+    index_count: usize,
+    index_size: usize,
+    buffer: [*]const u8,
+    buffer_size: usize,
+) c_int;
+extern fn meshopt_encodeIndexSequenceBound(index_count: usize, vertex_count: usize) usize;
+extern fn meshopt_encodeIndexSequence(
+    buffer: [*]u8,
+    buffer_size: usize,
+    indices: [*]const u32,
+    index_count: usize,
+) usize;
+extern fn meshopt_decodeIndexSequence(
+    destination: *anyopaque,
+    index_count: usize,
+    index_size: usize,
+    buffer: [*]const u8,
+    buffer_size: usize,
+) c_int;
+extern fn meshopt_encodeVertexBufferBound(vertex_count: usize, vertex_size: usize) usize;
+extern fn meshopt_encodeVertexBuffer(
+    buffer: [*]u8,
+    buffer_size: usize,
+    vertices: *const anyopaque,
+    vertex_count: usize,
+    vertex_size: usize,
+) usize;
+extern fn meshopt_decodeVertexBuffer(
+    destination: *anyopaque,
+    vertex_count: usize,
+    vertex_size: usize,
+    buffer: [*]const u8,
+    buffer_size: usize,
+) c_int;
+extern fn meshopt_encodeFilterOct(
+    destination: *anyopaque,
+    count: usize,
+    stride: usize,
+    bits: c_int,
+    data: [*]const f32,
+) void;
+extern fn meshopt_encodeFilterQuat(
+    destination: *anyopaque,
+    count: usize,
+    stride: usize,
+    bits: c_int,
+    data: [*]const f32,
+) void;
+extern fn meshopt_encodeFilterExp(
+    destination: *anyopaque,
+    count: usize,
+    stride: usize,
+    bits: c_int,
+    data: [*]const f32,
+) void;
+extern fn meshopt_decodeFilterOct(buffer: *anyopaque, count: usize, stride: usize) void;
+extern fn meshopt_decodeFilterQuat(buffer: *anyopaque, count: usize, stride: usize) void;
+extern fn meshopt_decodeFilterExp(buffer: *anyopaque, count: usize, stride: usize) void;
+
+const expect = std.testing.expect;
+
+test "zmesh.lod_chain" {
+    const zmesh = @import("main.zig");
+    zmesh.init(std.testing.allocator);
+    defer zmesh.deinit();
+
+    var meshes: [3]LodChainInput([3]f32) = undefined;
+    var mesh_indices: [3][]u32 = undefined;
+    var shapes: [3]zmesh.Shape = undefined;
+    for (shapes) |*shape, i| {
+        shape.* = zmesh.Shape.initParametricSphere(32 + @intCast(i32, i) * 8, 32);
+        mesh_indices[i] = try std.testing.allocator.alloc(u32, shape.indices.len);
+        for (shape.indices) |index, j| mesh_indices[i][j] = index;
+        meshes[i] = .{ .indices = mesh_indices[i], .vertices = shape.positions };
+    }
+    defer {
+        for (shapes) |shape, i| {
+            std.testing.allocator.free(mesh_indices[i]);
+            shape.deinit();
+        }
+    }
+
+    const level_descs = [_]LodLevelDesc{
+        .{ .ratio = 0.5, .max_error = 0.01 },
+        .{ .ratio = 0.25, .max_error = 0.05 },
+        .{ .ratio = 0.05, .max_error = 1.0 },
+    };
+
+    var chains: [3]LodChain = undefined;
+    try generateLodChains(std.testing.allocator, [3]f32, meshes[0..], level_descs[0..], .{}, chains[0..], 2);
+    defer {
+        for (chains) |*chain| chain.deinit(std.testing.allocator);
+    }
+
+    for (chains) |chain, i| {
+        try expect(chain.levels.len == level_descs.len + 1);
+        try expect(chain.levels[0].index_count == meshes[i].indices.len);
+        try expect(chain.error_scale > 0.0);
+
+        var level: usize = 1;
+        while (level < chain.levels.len) : (level += 1) {
+            const l = chain.levels[level];
+            try expect(l.index_count > 0 and l.index_count % 3 == 0);
+            try expect(l.index_count <= chain.levels[level - 1].index_count);
+            try expect(l.relative_error >= chain.levels[level - 1].relative_error);
+            for (chain.getLevelIndices(level)) |index| try expect(index < meshes[i].vertices.len);
+        }
+        try expect(chain.levels[chain.levels.len - 1].index_count < meshes[i].indices.len / 4);
+    }
+}
+
+test "zmesh.optimize_mesh" {
+    const zmesh = @import("main.zig");
+    zmesh.init(std.testing.allocator);
+    defer zmesh.deinit();
+
+    const num_meshes = 3;
+    var shapes: [num_meshes]zmesh.Shape = undefined;
+    var positions: [num_meshes][][3]f32 = undefined;
+    var normals: [num_meshes][][3]f32 = undefined;
+    var indices: [num_meshes][]u32 = undefined;
+    var streams: [num_meshes][2]Stream = undefined;
+    var meshes: [num_meshes]MeshInput = undefined;
+    var areas: [num_meshes]f32 = undefined;
+
+    // Unwelded spheres: every corner is a separate vertex.
+    for (shapes) |*shape, i| {
+        shape.* = zmesh.Shape.initParametricSphere(24 + @intCast(i32, i) * 8, 16);
+        const n = shape.indices.len;
+        positions[i] = try std.testing.allocator.alloc([3]f32, n);
+        normals[i] = try std.testing.allocator.alloc([3]f32, n);
+        indices[i] = try std.testing.allocator.alloc(u32, n);
+        for (shape.indices) |index, j| {
+            positions[i][j] = shape.positions[index];
+            normals[i][j] = shape.normals.?[index];
+            indices[i][j] = @intCast(u32, j);
+        }
+        areas[i] = computeTestArea(indices[i], positions[i]);
+        streams[i] = .{ Stream.init([3]f32, positions[i]), Stream.init([3]f32, normals[i]) };
+        meshes[i] = .{ .indices = indices[i], .vertex_count = @intCast(u32, n), .streams = streams[i][0..] };
+    }
+    defer {
+        for (shapes) |shape, i| {
+            std.testing.allocator.free(positions[i]);
+            std.testing.allocator.free(normals[i]);
+            std.testing.allocator.free(indices[i]);
+            shape.deinit();
+        }
+    }
+
+    var results: [num_meshes]OptimizedMesh = undefined;
+    const stats = try optimizeMeshes(
+        std.testing.allocator,
+        meshes[0..],
+        .{ .shadow_streams = &.{0} },
+        results[0..],
+        2,
+    );
+    defer {
+        for (results) |*result| result.deinit(std.testing.allocator);
+    }
+
+    for (results) |result, i| {
+        try expect(result.indices.len == indices[i].len);
+        try expect(result.shadow_indices.len == indices[i].len);
+        try expect(result.vertex_count <= shapes[i].positions.len);
+        try expect(result.streams.len == 2);
+
+        const result_positions = result.getStream([3]f32, 0);
+        try expect(result_positions.len == result.vertex_count);
+        try expect(result.getStream([3]f32, 1).len == result.vertex_count);
+        for (result.indices) |index| try expect(index < result.vertex_count);
+        for (result.shadow_indices) |index| try expect(index < result.vertex_count);
+        try expect(std.math.approxEqRel(f32, computeTestArea(result.indices, result_positions), areas[i], 1e-4));
+        try expect(std.math.approxEqRel(f32, computeTestArea(result.shadow_indices, result_positions), areas[i], 1e-4));
+
+        try expect(result.after.cache.acmr < result.before.cache.acmr);
+        try expect(result.after.fetch.bytes_fetched <= result.before.fetch.bytes_fetched);
+    }
+    try expect(stats.after.getAcmr() < stats.before.getAcmr());
+    try expect(stats.after.vertex_count < stats.before.vertex_count);
+    try expect(stats.before.triangle_count == stats.after.triangle_count);
+
+    // Overdraw optimization only reorders triangles, the vertex count doesn't change without it.
+    var mesh = try optimizeMesh(
+        std.testing.allocator,
+        indices[0],
+        meshes[0].vertex_count,
+        streams[0][0..],
+        .{ .position_stream = null, .analyze = false },
+    );
+    defer mesh.deinit(std.testing.allocator);
+    try expect(mesh.vertex_count == results[0].vertex_count);
+    try expect(mesh.shadow_indices.len == 0);
+    try expect(mesh.after.cache.vertices_transformed == 0);
+}
+
+test "zmesh.spatial_sort" {
+    const zmesh = @import("main.zig");
+    const allocator = std.testing.allocator;
+    zmesh.init(allocator);
+    defer zmesh.deinit();
+
+    const num_points = 10_000;
+    const original = try allocator.alloc([3]f32, num_points);
+    defer allocator.free(original);
+    const positions = try allocator.alloc([3]f32, num_points);
+    defer allocator.free(positions);
+    const ids = try allocator.alloc(u32, num_points);
+    defer allocator.free(ids);
+
+    var prng = std.rand.DefaultPrng.init(0);
+    const random = prng.random();
+    for (original) |*p, i| {
+        p.* = .{ random.float(f32), random.float(f32), random.float(f32) };
+        positions[i] = p.*;
+        ids[i] = @intCast(u32, i);
+    }
+
+    try spatialSortArrays(allocator, [3]f32, positions, .{ positions, ids });
+
+    var seen = try allocator.alloc(bool, num_points);
+    defer allocator.free(seen);
+    std.mem.set(bool, seen, false);
+    for (ids) |id, i| {
+        try expect(!seen[id]);
+        seen[id] = true;
+        try expect(std.mem.eql(f32, positions[i][0..], original[id][0..]));
+    }
+
+    // Consecutive points are much closer to each other after sorting.
+    const Path = struct {
+        fn length(points: []const [3]f32) f32 {
+            var sum: f32 = 0.0;
+            for (points[1..]) |p, i| {
+                const d = [3]f32{ p[0] - points[i][0], p[1] - points[i][1], p[2] - points[i][2] };
+                sum += @sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            }
+            return sum;
+        }
+    };
+    try expect(Path.length(positions) * 5.0 < Path.length(original));
+
+    // Triangles: the same set, reordered.
+    const sphere = zmesh.Shape.initParametricSphere(16, 16);
+    defer sphere.deinit();
+    const indices = try allocator.alloc(u32, sphere.indices.len);
+    defer allocator.free(indices);
+    for (sphere.indices) |index, i| indices[i] = index;
+    const area = computeTestArea(indices, sphere.positions);
+
+    spatialSortTriangles(indices, indices, [3]f32, sphere.positions);
+    try expect(std.math.approxEqRel(f32, computeTestArea(indices, sphere.positions), area, 1e-4));
+    var sum: u64 = 0;
+    for (indices) |index| sum += index;
+    var expected_sum: u64 = 0;
+    for (sphere.indices) |index| expected_sum += index;
+    try expect(sum == expected_sum);
+}
+
+fn computeTestArea(indices: []const u32, positions: []const [3]f32) f32 {
+    var area: f32 = 0.0;
+    var i: usize = 0;
+    while (i < indices.len) : (i += 3) {
+        const a = positions[indices[i]];
+        const b = positions[indices[i + 1]];
+        const c = positions[indices[i + 2]];
+        const u = [3]f32{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const v = [3]f32{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        const n = [3]f32{ u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+        area += @sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5;
+    }
+    return area;
+}
@@ -26,6 +26,18 @@ pub fn buildTests(
     return tests;
 }
 
+pub fn buildBenchmarks(
+    b: *std.build.Builder,
+    target: std.zig.CrossTarget,
+) *std.build.LibExeObjStep {
+    const exe = b.addExecutable("znoise-benchmark", thisDir() ++ "/src/benchmark.zig");
+    exe.setBuildMode(std.builtin.Mode.ReleaseFast);
+    exe.setTarget(target);
+    exe.addPackage(pkg);
+    link(exe);
+    return exe;
+}
+
 fn buildLibrary(exe: *std.build.LibExeObjStep) *std.build.LibExeObjStep {
     const lib = exe.builder.addStaticLibrary("znoise", thisDir() ++ "/src/znoise.zig");
 
@@ -37,7 +49,8 @@ fn buildLibrary(exe: *std.build.LibExeObjStep) *std.build.LibExeObjStep {
 
     lib.addCSourceFile(
         thisDir() ++ "/libs/FastNoiseLite/FastNoiseLite.c",
-        &.{ "-std=c99", "-fno-sanitize=undefined" },
+        // No FMA contraction: keeps C results identical to the Zig batch functions (see src/fnl.zig).
+        &.{ "-std=c99", "-fno-sanitize=undefined", "-ffp-contract=off" },
     );
 
     return lib;
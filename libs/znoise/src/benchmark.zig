@@ -0,0 +1,235 @@
+// -------------------------------------------------------------------------------------------------
+// znoise - benchmarks
+// -------------------------------------------------------------------------------------------------
+// 'zig build benchmark' in the root project directory will build and run 'ReleaseFast' configuration.
+//
+// batch noise: every noise type (3 octave fBm) evaluated over a 512x512 2D grid and a 64x64x64 3D
+// grid. 'scalar' calls `FnlGenerator.noise2()` / `noise3()` for every sample, 'grid' is
+// `noise2Grid()` / `noise3Grid()` (4 or, with AVX, 8 samples at a time). Throughput is reported in
+// millions of samples per second.
+//
+// noise derivatives: value and gradient of 3 octave fBm over the same grids. 'finite differences'
+// evaluates `noise2Grid()` / `noise3Grid()` at the grid and at the grid shifted along every axis,
+// 'analytic' is `noise2GridDeriv()` / `noise3GridDeriv()`.
+//
+// specialized generator: `FnlGenerator.noise2()` / `noise3()` (C, settings switched on per sample)
+// against `znoise.Generator(config)` (types fixed at compile time) for every sample of the same
+// grids, and `domainWarp2()` / `domainWarp3()` for every domain warp type.
+// -------------------------------------------------------------------------------------------------
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    try batchNoiseBenchmark(allocator, .{ .width = 512, .height = 512 }, 2);
+    try batchNoiseBenchmark(allocator, .{ .width = 64, .height = 64, .depth = 64 }, 3);
+    try derivativeBenchmark(allocator, .{ .width = 512, .height = 512 }, 2);
+    try derivativeBenchmark(allocator, .{ .width = 64, .height = 64, .depth = 64 }, 3);
+    try specializedBenchmark(.{ .width = 512, .height = 512 }, 2);
+    try specializedBenchmark(.{ .width = 64, .height = 64, .depth = 64 }, 3);
+}
+
+const std = @import("std");
+const time = std.time;
+const Timer = time.Timer;
+const znoise = @import("znoise");
+const FnlGenerator = znoise.FnlGenerator;
+
+noinline fn batchNoiseBenchmark(allocator: std.mem.Allocator, grid: FnlGenerator.Grid, comptime dims: u32) !void {
+    const num_iterations = 4;
+    const num_samples = @as(usize, grid.width) * grid.height * grid.depth;
+
+    const out = try allocator.alloc(f32, num_samples);
+    defer allocator.free(out);
+
+    const noise_types = [_]FnlGenerator.NoiseType{
+        .opensimplex2,
+        .opensimplex2s,
+        .cellular,
+        .perlin,
+        .value_cubic,
+        .value,
+    };
+    for (noise_types) |noise_type| {
+        const gen = FnlGenerator{ .noise_type = noise_type, .fractal_type = .fbm };
+
+        var timer = try Timer.start();
+        var iteration: u32 = 0;
+        while (iteration < num_iterations) : (iteration += 1) {
+            var i: usize = 0;
+            var z: u32 = 0;
+            while (z < grid.depth) : (z += 1) {
+                var y: u32 = 0;
+                while (y < grid.height) : (y += 1) {
+                    var x: u32 = 0;
+                    while (x < grid.width) : (x += 1) {
+                        const fx = @intToFloat(f32, x);
+                        const fy = @intToFloat(f32, y);
+                        out[i] = if (dims == 2) gen.noise2(fx, fy) else gen.noise3(fx, fy, @intToFloat(f32, z));
+                        i += 1;
+                    }
+                }
+            }
+        }
+        const scalar_time = timer.lap();
+        const scalar_sum = checksum(out);
+
+        iteration = 0;
+        while (iteration < num_iterations) : (iteration += 1) {
+            if (dims == 2) gen.noise2Grid(grid, out) else gen.noise3Grid(grid, out);
+        }
+        const grid_time = timer.lap();
+        if (!std.math.approxEqAbs(f64, scalar_sum, checksum(out), 0.01)) return error.GridNoiseMismatch;
+
+        std.debug.print("{s:>42} - {d}D {s:>13}: scalar: {d:.1} Msamples/s, grid: {d:.1} Msamples/s ({d:.2}x)\n", .{
+            "batch noise",
+            dims,
+            @tagName(noise_type),
+            msamplesPerSecond(num_samples * num_iterations, scalar_time),
+            msamplesPerSecond(num_samples * num_iterations, grid_time),
+            @intToFloat(f64, scalar_time) / @intToFloat(f64, grid_time),
+        });
+    }
+}
+
+noinline fn derivativeBenchmark(allocator: std.mem.Allocator, grid: FnlGenerator.Grid, comptime dims: u32) !void {
+    const num_iterations = 4;
+    const num_samples = @as(usize, grid.width) * grid.height * grid.depth;
+    const h = 0.01;
+
+    const buffer = try allocator.alloc(f32, num_samples * 5);
+    defer allocator.free(buffer);
+    const values = buffer[0..num_samples];
+    const dx = buffer[num_samples..][0..num_samples];
+    const dy = buffer[2 * num_samples ..][0..num_samples];
+    const dz = buffer[3 * num_samples ..][0..num_samples];
+    const shifted = buffer[4 * num_samples ..][0..num_samples];
+
+    for ([_]FnlGenerator.NoiseType{ .opensimplex2, .perlin, .value }) |noise_type| {
+        const gen = FnlGenerator{ .noise_type = noise_type, .fractal_type = .fbm };
+
+        var timer = try Timer.start();
+        var iteration: u32 = 0;
+        while (iteration < num_iterations) : (iteration += 1) {
+            if (dims == 2) gen.noise2Grid(grid, values) else gen.noise3Grid(grid, values);
+            const gradient = [3][]f32{ dx, dy, dz };
+            var axis: u32 = 0;
+            while (axis < dims) : (axis += 1) {
+                var shifted_grid = grid;
+                shifted_grid.origin[axis] += h;
+                if (dims == 2) gen.noise2Grid(shifted_grid, shifted) else gen.noise3Grid(shifted_grid, shifted);
+                for (gradient[axis]) |*d, i| d.* = (shifted[i] - values[i]) / h;
+            }
+        }
+        const fd_time = timer.lap();
+
+        iteration = 0;
+        while (iteration < num_iterations) : (iteration += 1) {
+            if (dims == 2)
+                gen.noise2GridDeriv(grid, .{ .values = values, .dx = dx, .dy = dy })
+            else
+                gen.noise3GridDeriv(grid, .{ .values = values, .dx = dx, .dy = dy, .dz = dz });
+        }
+        const analytic_time = timer.lap();
+
+        std.debug.print("{s:>42} - {d}D {s:>13}: finite differences: {d:.1} Msamples/s, " ++
+            "analytic: {d:.1} Msamples/s ({d:.2}x)\n", .{
+            "noise derivatives",
+            dims,
+            @tagName(noise_type),
+            msamplesPerSecond(num_samples * num_iterations, fd_time),
+            msamplesPerSecond(num_samples * num_iterations, analytic_time),
+            @intToFloat(f64, fd_time) / @intToFloat(f64, analytic_time),
+        });
+    }
+}
+
+noinline fn specializedBenchmark(grid: FnlGenerator.Grid, comptime dims: u32) !void {
+    const noise_types = [_]FnlGenerator.NoiseType{
+        .opensimplex2,
+        .opensimplex2s,
+        .cellular,
+        .perlin,
+        .value_cubic,
+        .value,
+    };
+    inline for (noise_types) |noise_type| {
+        const c_gen = FnlGenerator{ .noise_type = noise_type, .fractal_type = .fbm };
+        const gen = znoise.Generator(.{ .noise_type = noise_type, .fractal_type = .fbm }).init(c_gen);
+        try compareSpecialized(grid, dims, false, @tagName(noise_type), &c_gen, &gen);
+    }
+
+    const warp_types = [_]FnlGenerator.DomainWarpType{ .opensimplex2, .opensimplex2_reduced, .basicgrid };
+    inline for (warp_types) |warp_type| {
+        const c_gen = FnlGenerator{ .domain_warp_type = warp_type, .fractal_type = .domain_warp_progressive };
+        const gen = znoise.Generator(.{
+            .domain_warp_type = warp_type,
+            .fractal_type = .domain_warp_progressive,
+        }).init(c_gen);
+        try compareSpecialized(grid, dims, true, @tagName(warp_type), &c_gen, &gen);
+    }
+}
+
+fn compareSpecialized(
+    grid: FnlGenerator.Grid,
+    comptime dims: u32,
+    comptime warp: bool,
+    name: []const u8,
+    c_gen: *const FnlGenerator,
+    gen: anytype,
+) !void {
+    const num_iterations = 4;
+    const num_samples = @as(usize, grid.width) * grid.height * grid.depth;
+
+    var timer = try Timer.start();
+    const c_sum = sampleGrid(c_gen, grid, dims, warp, num_iterations);
+    const c_time = timer.lap();
+    const specialized_sum = sampleGrid(gen, grid, dims, warp, num_iterations);
+    const specialized_time = timer.lap();
+    if (c_sum != specialized_sum) return error.SpecializedNoiseMismatch;
+
+    std.debug.print("{s:>42} - {d}D {s:>20}: C: {d:.1} Msamples/s, specialized: {d:.1} Msamples/s ({d:.2}x)\n", .{
+        if (warp) "specialized domain warp" else "specialized noise",
+        dims,
+        name,
+        msamplesPerSecond(num_samples * num_iterations, c_time),
+        msamplesPerSecond(num_samples * num_iterations, specialized_time),
+        @intToFloat(f64, c_time) / @intToFloat(f64, specialized_time),
+    });
+}
+
+/// Sum of noise values (or warped coordinates) over `grid`; `gen` is a `FnlGenerator` or a `znoise.Generator()`.
+fn sampleGrid(gen: anytype, grid: FnlGenerator.Grid, comptime dims: u32, comptime warp: bool, num_iterations: u32) f64 {
+    var sum: f64 = 0.0;
+    var iteration: u32 = 0;
+    while (iteration < num_iterations) : (iteration += 1) {
+        var z: u32 = 0;
+        while (z < grid.depth) : (z += 1) {
+            var y: u32 = 0;
+            while (y < grid.height) : (y += 1) {
+                var x: u32 = 0;
+                while (x < grid.width) : (x += 1) {
+                    var p = [3]f32{ @intToFloat(f32, x), @intToFloat(f32, y), @intToFloat(f32, z) };
+                    if (!warp) {
+                        sum += if (dims == 2) gen.noise2(p[0], p[1]) else gen.noise3(p[0], p[1], p[2]);
+                    } else {
+                        if (dims == 2) gen.domainWarp2(&p[0], &p[1]) else gen.domainWarp3(&p[0], &p[1], &p[2]);
+                        sum += p[0] + p[1] + p[2];
+                    }
+                }
+            }
+        }
+    }
+    return sum;
+}
+
+fn checksum(values: []const f32) f64 {
+    var sum: f64 = 0.0;
+    for (values) |v| sum += v;
+    return sum;
+}
+
+fn msamplesPerSecond(num_samples: usize, elapsed: u64) f64 {
+    return @intToFloat(f64, num_samples) / (@intToFloat(f64, elapsed) / time.ns_per_s) / 1_000_000.0;
+}
@@ -0,0 +1,2658 @@
+// Zig port of the FastNoiseLite 1.0.1 noise functions (MIT License, Copyright (c) 2020 Jordan Peck and Contributors),
+// evaluated on vectors of samples.
+//
+// Every operation is done in the same order and with the same rounding as in FastNoiseLite.h, so a lane returns
+// exactly what `fnlGetNoise2D()` / `fnlGetNoise3D()` return for the same settings (the C library is compiled with
+// `-ffp-contract=off`). Branches of the C code become per-lane selects; hash and table lookups are done lane by lane.
+//
+// Noise type, fractal type, 3D rotation, cellular distance function and domain warp type are comptime parameters
+// (`Config`); the batch functions switch on the generator settings once and then run a loop specialized for them.
+// `Generator()` fixes them for the whole generator.
+//
+// The `*Deriv` variants of the OpenSimplex2, Perlin and value kernels also return the analytic gradient; values are
+// computed exactly as in the plain kernels.
+
+const std = @import("std");
+const builtin = @import("builtin");
+const assert = std.debug.assert;
+const FnlGenerator = @import("znoise.zig").FnlGenerator;
+
+const cpu_arch = builtin.cpu.arch;
+const has_avx = if (cpu_arch == .x86_64) std.Target.x86.featureSetHas(builtin.cpu.features, .avx) else false;
+
+/// Samples evaluated together by the batch functions.
+pub const lanes = if (has_avx) 8 else 4;
+
+pub const Config = struct {
+    noise_type: FnlGenerator.NoiseType = .opensimplex2,
+    fractal_type: FnlGenerator.FractalType = .none,
+    rotation_type3: FnlGenerator.RotationType3 = .none,
+    cellular_distance_func: FnlGenerator.CellularDistanceFunc = .euclideansq,
+    domain_warp_type: FnlGenerator.DomainWarpType = .opensimplex2,
+};
+
+/// Sample positions of a regular grid: `origin + (offset + index) * step`, x varies fastest in the output. Samples
+/// with the same `offset + index` get bit-identical coordinates, so grids placed next to each other with `offset`
+/// (tiles) line up exactly.
+pub const Grid = struct {
+    origin: [3]f32 = .{ 0.0, 0.0, 0.0 },
+    offset: [3]i32 = .{ 0, 0, 0 },
+    step: f32 = 1.0,
+    width: u32,
+    height: u32,
+    /// Ignored by 2D functions.
+    depth: u32 = 1,
+
+    /// Coordinate of sample `index` along `axis` (0 - x, 1 - y, 2 - z).
+    pub fn coord(grid: Grid, axis: u32, index: usize) f32 {
+        return grid.origin[axis] + @intToFloat(f32, grid.offset[axis] +% @intCast(i32, index)) * grid.step;
+    }
+};
+
+const prime_x: i32 = 501125321;
+const prime_y: i32 = 1136930381;
+const prime_z: i32 = 1720413743;
+const prime_x2: i32 = @truncate(i32, @as(i64, prime_x) << 1);
+const prime_y2: i32 = @truncate(i32, @as(i64, prime_y) << 1);
+const prime_z2: i32 = @truncate(i32, @as(i64, prime_z) << 1);
+
+const sqrt3: f32 = 1.7320508075688772935274463415059;
+const f2: f32 = 0.5 * (sqrt3 - 1);
+const g2: f32 = (3 - sqrt3) / 6;
+const g2_c0: f32 = 2 * (1 - 2 * g2) * (1 / g2 - 2);
+const g2_c1: f32 = -2 * (1 - 2 * g2) * (1 - 2 * g2);
+const r3: f32 = 2.0 / 3.0;
+const two_thirds: f32 = @as(f32, 2.0) / @as(f32, 3.0);
+const value_cubic2_scale: f32 = 1 / (@as(f32, 1.5) * 1.5);
+const value_cubic3_scale: f32 = @as(f32, 1) / 1.5 * 1.5 * 1.5;
+
+/// `fnlGetNoise2D()` for every point of `grid` (`width * height` values).
+pub fn noise2Grid(gen: *const FnlGenerator, grid: Grid, out: []f32) void {
+    assert(out.len == @as(usize, grid.width) * grid.height);
+    dispatch(gen, 2, GridJob(2){ .gen = gen, .grid = grid, .out = out });
+}
+
+/// `fnlGetNoise3D()` for every point of `grid` (`width * height * depth` values).
+pub fn noise3Grid(gen: *const FnlGenerator, grid: Grid, out: []f32) void {
+    assert(out.len == @as(usize, grid.width) * grid.height * grid.depth);
+    dispatch(gen, 3, GridJob(3){ .gen = gen, .grid = grid, .out = out });
+}
+
+/// `fnlGetNoise2D()` for every `(xs[i], ys[i])`.
+pub fn noise2Array(gen: *const FnlGenerator, xs: []const f32, ys: []const f32, out: []f32) void {
+    assert(xs.len == out.len and ys.len == out.len);
+    dispatch(gen, 2, ArrayJob(2){ .gen = gen, .coords = .{ xs, ys }, .out = out });
+}
+
+/// `fnlGetNoise3D()` for every `(xs[i], ys[i], zs[i])`.
+pub fn noise3Array(gen: *const FnlGenerator, xs: []const f32, ys: []const f32, zs: []const f32, out: []f32) void {
+    assert(xs.len == out.len and ys.len == out.len and zs.len == out.len);
+    dispatch(gen, 3, ArrayJob(3){ .gen = gen, .coords = .{ xs, ys, zs }, .out = out });
+}
+
+/// Values and partial derivatives (gradient) of 2D noise with respect to x and y.
+pub const Derivatives2 = struct {
+    values: []f32,
+    dx: []f32,
+    dy: []f32,
+};
+
+/// Values and partial derivatives (gradient) of 3D noise with respect to x, y and z.
+pub const Derivatives3 = struct {
+    values: []f32,
+    dx: []f32,
+    dy: []f32,
+    dz: []f32,
+};
+
+/// True when `noise2Deriv()` / `noise3Deriv()` and the derivative grid functions support the settings of `gen`:
+/// OpenSimplex2, Perlin and value noise, no fractal, fBm or ridged fractal.
+pub fn supportsDerivatives(gen: *const FnlGenerator) bool {
+    const noise_supported = switch (gen.noise_type) {
+        .opensimplex2, .perlin, .value => true,
+        else => false,
+    };
+    return noise_supported and gen.fractal_type != .pingpong;
+}
+
+/// `fnlGetNoise2D()` and its analytic gradient: `.{ value, d/dx, d/dy }`. See `supportsDerivatives()`.
+pub fn noise2Deriv(gen: *const FnlGenerator, x: f32, y: f32) [3]f32 {
+    var result: [3]f32 = undefined;
+    dispatchDerivatives(gen, 2, PointJob(2){ .gen = gen, .p = .{ x, y }, .result = &result });
+    return result;
+}
+
+/// `fnlGetNoise3D()` and its analytic gradient: `.{ value, d/dx, d/dy, d/dz }`. See `supportsDerivatives()`.
+pub fn noise3Deriv(gen: *const FnlGenerator, x: f32, y: f32, z: f32) [4]f32 {
+    var result: [4]f32 = undefined;
+    dispatchDerivatives(gen, 3, PointJob(3){ .gen = gen, .p = .{ x, y, z }, .result = &result });
+    return result;
+}
+
+/// `noise2Grid()` with gradients. See `supportsDerivatives()`.
+pub fn noise2GridDeriv(gen: *const FnlGenerator, grid: Grid, out: Derivatives2) void {
+    const len = @as(usize, grid.width) * grid.height;
+    assert(out.values.len == len and out.dx.len == len and out.dy.len == len);
+    dispatchDerivatives(gen, 2, DerivativeGridJob(2){ .gen = gen, .grid = grid, .out = out });
+}
+
+/// `noise3Grid()` with gradients. See `supportsDerivatives()`.
+pub fn noise3GridDeriv(gen: *const FnlGenerator, grid: Grid, out: Derivatives3) void {
+    const len = @as(usize, grid.width) * grid.height * grid.depth;
+    assert(out.values.len == len and out.dx.len == len and out.dy.len == len and out.dz.len == len);
+    dispatchDerivatives(gen, 3, DerivativeGridJob(3){ .gen = gen, .grid = grid, .out = out });
+}
+
+inline fn storeLanes(dst: []f32, first: usize, v: @Vector(lanes, f32), count: usize) void {
+    const a: [lanes]f32 = v;
+    std.mem.copy(f32, dst[first..][0..count], a[0..count]);
+}
+
+/// Calls `job.evaluate(Gen, out_index, xs, y, z, count)` for every `lanes` samples of a grid row.
+fn forEachGridChunk(grid: Grid, comptime dims: u32, comptime Gen: type, job: anytype) void {
+    const width: usize = grid.width;
+    const depth: usize = if (dims == 3) grid.depth else 1;
+
+    var slice: usize = 0;
+    while (slice < depth) : (slice += 1) {
+        const z = Gen.splat(grid.coord(2, slice));
+        var row: usize = 0;
+        while (row < grid.height) : (row += 1) {
+            const y = Gen.splat(grid.coord(1, row));
+            const first = (slice * grid.height + row) * width;
+            var column: usize = 0;
+            while (column < width) : (column += lanes) {
+                var xs: [lanes]f32 = undefined;
+                for (xs) |*x, k| x.* = grid.coord(0, column + k);
+                job.evaluate(Gen, first + column, xs, y, z, std.math.min(lanes, width - column));
+            }
+        }
+    }
+}
+
+fn GridJob(comptime dims: u32) type {
+    return struct {
+        gen: *const FnlGenerator,
+        grid: Grid,
+        out: []f32,
+
+        fn run(job: @This(), comptime config: Config) void {
+            forEachGridChunk(job.grid, dims, Noise(lanes, config), job);
+        }
+
+        inline fn evaluate(
+            job: @This(),
+            comptime Gen: type,
+            first: usize,
+            xs: Gen.F,
+            y: Gen.F,
+            z: Gen.F,
+            count: usize,
+        ) void {
+            const values = if (dims == 2) Gen.noise2(job.gen, xs, y) else Gen.noise3(job.gen, xs, y, z);
+            storeLanes(job.out, first, values, count);
+        }
+    };
+}
+
+fn DerivativeGridJob(comptime dims: u32) type {
+    return struct {
+        gen: *const FnlGenerator,
+        grid: Grid,
+        out: if (dims == 2) Derivatives2 else Derivatives3,
+
+        fn run(job: @This(), comptime config: Config) void {
+            forEachGridChunk(job.grid, dims, Noise(lanes, config), job);
+        }
+
+        inline fn evaluate(
+            job: @This(),
+            comptime Gen: type,
+            first: usize,
+            xs: Gen.F,
+            y: Gen.F,
+            z: Gen.F,
+            count: usize,
+        ) void {
+            const r = if (dims == 2) Gen.noise2Deriv(job.gen, xs, y) else Gen.noise3Deriv(job.gen, xs, y, z);
+            storeLanes(job.out.values, first, r.v, count);
+            storeLanes(job.out.dx, first, r.d[0], count);
+            storeLanes(job.out.dy, first, r.d[1], count);
+            if (dims == 3) storeLanes(job.out.dz, first, r.d[2], count);
+        }
+    };
+}
+
+fn PointJob(comptime dims: u32) type {
+    return struct {
+        gen: *const FnlGenerator,
+        p: [dims]f32,
+        result: *[dims + 1]f32,
+
+        fn run(job: @This(), comptime config: Config) void {
+            const Gen = Noise(1, config);
+            const r = if (dims == 2)
+                Gen.noise2Deriv(job.gen, Gen.splat(job.p[0]), Gen.splat(job.p[1]))
+            else
+                Gen.noise3Deriv(job.gen, Gen.splat(job.p[0]), Gen.splat(job.p[1]), Gen.splat(job.p[2]));
+            job.result[0] = r.v[0];
+            for (r.d) |d, k| job.result[k + 1] = d[0];
+        }
+    };
+}
+
+fn ArrayJob(comptime dims: u32) type {
+    return struct {
+        gen: *const FnlGenerator,
+        coords: [dims][]const f32,
+        out: []f32,
+
+        fn run(job: @This(), comptime config: Config) void {
+            const Gen = Noise(lanes, config);
+            var i: usize = 0;
+            while (i < job.out.len) : (i += lanes) {
+                const n = std.math.min(lanes, job.out.len - i);
+                var c: [dims][lanes]f32 = undefined;
+                for (c) |*lane_values, d| {
+                    // The last chunk is padded with its first point.
+                    std.mem.set(f32, lane_values, job.coords[d][i]);
+                    std.mem.copy(f32, lane_values, job.coords[d][i..][0..n]);
+                }
+                const values: [lanes]f32 = if (dims == 2)
+                    Gen.noise2(job.gen, c[0], c[1])
+                else
+                    Gen.noise3(job.gen, c[0], c[1], c[2]);
+                std.mem.copy(f32, job.out[i..][0..n], values[0..n]);
+            }
+        }
+    };
+}
+
+/// Calls `job.run(config)` with the comptime configuration matching the settings of `gen`.
+fn dispatch(gen: *const FnlGenerator, comptime dims: u32, job: anytype) void {
+    switch (gen.noise_type) {
+        .opensimplex2 => dispatchFractal(gen, dims, .{ .noise_type = .opensimplex2 }, job),
+        .opensimplex2s => dispatchFractal(gen, dims, .{ .noise_type = .opensimplex2s }, job),
+        .perlin => dispatchFractal(gen, dims, .{ .noise_type = .perlin }, job),
+        .value_cubic => dispatchFractal(gen, dims, .{ .noise_type = .value_cubic }, job),
+        .value => dispatchFractal(gen, dims, .{ .noise_type = .value }, job),
+        .cellular => switch (gen.cellular_distance_func) {
+            .euclidean => dispatchFractal(gen, dims, cellular(.euclidean), job),
+            .euclideansq => dispatchFractal(gen, dims, cellular(.euclideansq), job),
+            .manhattan => dispatchFractal(gen, dims, cellular(.manhattan), job),
+            .hybrid => dispatchFractal(gen, dims, cellular(.hybrid), job),
+        },
+    }
+}
+
+/// `dispatch()` for the settings supported by the derivative functions.
+fn dispatchDerivatives(gen: *const FnlGenerator, comptime dims: u32, job: anytype) void {
+    assert(supportsDerivatives(gen));
+    switch (gen.noise_type) {
+        .opensimplex2 => dispatchDerivativeFractal(gen, dims, .{ .noise_type = .opensimplex2 }, job),
+        .perlin => dispatchDerivativeFractal(gen, dims, .{ .noise_type = .perlin }, job),
+        .value => dispatchDerivativeFractal(gen, dims, .{ .noise_type = .value }, job),
+        else => unreachable,
+    }
+}
+
+fn dispatchDerivativeFractal(gen: *const FnlGenerator, comptime dims: u32, comptime config: Config, job: anytype) void {
+    switch (gen.fractal_type) {
+        .fbm => dispatchRotation(gen, dims, withFractal(config, .fbm), job),
+        .ridged => dispatchRotation(gen, dims, withFractal(config, .ridged), job),
+        .pingpong => unreachable,
+        .none, .domain_warp_progressive, .domain_warp_independent => dispatchRotation(gen, dims, config, job),
+    }
+}
+
+fn dispatchFractal(gen: *const FnlGenerator, comptime dims: u32, comptime config: Config, job: anytype) void {
+    switch (gen.fractal_type) {
+        .fbm => dispatchRotation(gen, dims, withFractal(config, .fbm), job),
+        .ridged => dispatchRotation(gen, dims, withFractal(config, .ridged), job),
+        .pingpong => dispatchRotation(gen, dims, withFractal(config, .pingpong), job),
+        // Domain warp fractals only affect domain warping.
+        .none, .domain_warp_progressive, .domain_warp_independent => dispatchRotation(gen, dims, config, job),
+    }
+}
+
+fn dispatchRotation(gen: *const FnlGenerator, comptime dims: u32, comptime config: Config, job: anytype) void {
+    if (dims == 2) return job.run(config);
+    switch (gen.rotation_type3) {
+        .none => job.run(config),
+        .improve_xy_planes => job.run(withRotation(config, .improve_xy_planes)),
+        .improve_xz_planes => job.run(withRotation(config, .improve_xz_planes)),
+    }
+}
+
+fn cellular(comptime distance_func: FnlGenerator.CellularDistanceFunc) Config {
+    return .{ .noise_type = .cellular, .cellular_distance_func = distance_func };
+}
+
+fn withFractal(comptime config: Config, comptime fractal_type: FnlGenerator.FractalType) Config {
+    var c = config;
+    c.fractal_type = fractal_type;
+    return c;
+}
+
+fn withRotation(comptime config: Config, comptime rotation_type3: FnlGenerator.RotationType3) Config {
+    var c = config;
+    c.rotation_type3 = rotation_type3;
+    return c;
+}
+
+/// FastNoiseLite generator with the noise, fractal, 3D rotation, cellular distance and domain warp types fixed at
+/// compile time, so every call runs straight-line code for `config`. Results are bit-identical to `FnlGenerator` with
+/// the same settings.
+pub fn Generator(comptime config: Config) type {
+    return struct {
+        const Self = @This();
+        const Scalar = Noise(1, config);
+
+        /// Runtime settings (seed, frequency, octaves, ...). The fields fixed by `config` are set by `init()`.
+        settings: FnlGenerator,
+
+        pub fn init(settings: FnlGenerator) Self {
+            var s = settings;
+            s.noise_type = config.noise_type;
+            s.fractal_type = config.fractal_type;
+            s.rotation_type3 = config.rotation_type3;
+            s.cellular_distance_func = config.cellular_distance_func;
+            s.domain_warp_type = config.domain_warp_type;
+            return .{ .settings = s };
+        }
+
+        pub fn noise2(self: *const Self, x: f32, y: f32) f32 {
+            return Scalar.noise2(&self.settings, Scalar.splat(x), Scalar.splat(y))[0];
+        }
+
+        pub fn noise3(self: *const Self, x: f32, y: f32, z: f32) f32 {
+            return Scalar.noise3(&self.settings, Scalar.splat(x), Scalar.splat(y), Scalar.splat(z))[0];
+        }
+
+        pub fn domainWarp2(self: *const Self, x: *f32, y: *f32) void {
+            var p = [2]Scalar.F{ Scalar.splat(x.*), Scalar.splat(y.*) };
+            Scalar.domainWarp2(&self.settings, &p);
+            x.* = p[0][0];
+            y.* = p[1][0];
+        }
+
+        pub fn domainWarp3(self: *const Self, x: *f32, y: *f32, z: *f32) void {
+            var p = [3]Scalar.F{ Scalar.splat(x.*), Scalar.splat(y.*), Scalar.splat(z.*) };
+            Scalar.domainWarp3(&self.settings, &p);
+            x.* = p[0][0];
+            y.* = p[1][0];
+            z.* = p[2][0];
+        }
+
+        /// `noise2Grid()` without the runtime dispatch.
+        pub fn noise2Grid(self: *const Self, grid: Grid, out: []f32) void {
+            assert(out.len == @as(usize, grid.width) * grid.height);
+            (GridJob(2){ .gen = &self.settings, .grid = grid, .out = out }).run(config);
+        }
+
+        /// `noise3Grid()` without the runtime dispatch.
+        pub fn noise3Grid(self: *const Self, grid: Grid, out: []f32) void {
+            assert(out.len == @as(usize, grid.width) * grid.height * grid.depth);
+            (GridJob(3){ .gen = &self.settings, .grid = grid, .out = out }).run(config);
+        }
+
+        /// `noise2Array()` without the runtime dispatch.
+        pub fn noise2Array(self: *const Self, xs: []const f32, ys: []const f32, out: []f32) void {
+            assert(xs.len == out.len and ys.len == out.len);
+            (ArrayJob(2){ .gen = &self.settings, .coords = .{ xs, ys }, .out = out }).run(config);
+        }
+
+        /// `noise3Array()` without the runtime dispatch.
+        pub fn noise3Array(self: *const Self, xs: []const f32, ys: []const f32, zs: []const f32, out: []f32) void {
+            assert(xs.len == out.len and ys.len == out.len and zs.len == out.len);
+            (ArrayJob(3){ .gen = &self.settings, .coords = .{ xs, ys, zs }, .out = out }).run(config);
+        }
+    };
+}
+
+/// `fnlGetNoise2D()` / `fnlGetNoise3D()` for `n` points at once, specialized for `config`. Settings that are not part
+/// of `config` (seed, frequency, octaves, gain, ...) are read from the generator.
+pub fn Noise(comptime n: u32, comptime config: Config) type {
+    return struct {
+        const K = Kernels(n);
+        pub const F = K.F;
+
+        const one = K.one;
+
+        pub inline fn splat(v: f32) F {
+            return @splat(n, v);
+        }
+
+        pub fn noise2(gen: *const FnlGenerator, x_in: F, y_in: F) F {
+            const p = transform2(gen, x_in, y_in);
+            return switch (config.fractal_type) {
+                .fbm, .ridged, .pingpong => fractal2(gen, p[0], p[1]),
+                else => single2(gen, gen.seed, p[0], p[1]),
+            };
+        }
+
+        pub fn noise3(gen: *const FnlGenerator, x_in: F, y_in: F, z_in: F) F {
+            const p = transform3(gen, x_in, y_in, z_in);
+            return switch (config.fractal_type) {
+                .fbm, .ridged, .pingpong => fractal3(gen, p[0], p[1], p[2]),
+                else => single3(gen, gen.seed, p[0], p[1], p[2]),
+            };
+        }
+
+        /// `noise2()` and its gradient with respect to `x_in`, `y_in`. OpenSimplex2, Perlin and value noise; no
+        /// fractal, fBm or ridged fractal.
+        pub fn noise2Deriv(gen: *const FnlGenerator, x_in: F, y_in: F) K.Dual(2) {
+            const p = transform2(gen, x_in, y_in);
+            var r = switch (config.fractal_type) {
+                .fbm, .ridged => fractalDeriv(2, gen, p),
+                else => singleDeriv(2, gen.seed, p),
+            };
+            if (config.noise_type == .opensimplex2) {
+                // Transposed Jacobian of the skew.
+                const t = (r.d[0] + r.d[1]) * splat(f2);
+                r.d[0] = r.d[0] + t;
+                r.d[1] = r.d[1] + t;
+            }
+            for (r.d) |*d| d.* = d.* * splat(gen.frequency);
+            return r;
+        }
+
+        /// `noise3()` and its gradient with respect to `x_in`, `y_in`, `z_in`. See `noise2Deriv()`.
+        pub fn noise3Deriv(gen: *const FnlGenerator, x_in: F, y_in: F, z_in: F) K.Dual(3) {
+            const p = transform3(gen, x_in, y_in, z_in);
+            var r = switch (config.fractal_type) {
+                .fbm, .ridged => fractalDeriv(3, gen, p),
+                else => singleDeriv(3, gen.seed, p),
+            };
+            r.d = inputGradient3(r.d);
+            for (r.d) |*d| d.* = d.* * splat(gen.frequency);
+            return r;
+        }
+
+        /// Frequency and skew of 2D OpenSimplex2(S).
+        inline fn transform2(gen: *const FnlGenerator, x_in: F, y_in: F) [2]F {
+            const simplex = config.noise_type == .opensimplex2 or config.noise_type == .opensimplex2s;
+            return skew2(x_in * splat(gen.frequency), y_in * splat(gen.frequency), simplex);
+        }
+
+        /// Frequency and 3D rotation (or the default OpenSimplex2(S) transform).
+        inline fn transform3(gen: *const FnlGenerator, x_in: F, y_in: F, z_in: F) [3]F {
+            const simplex = config.noise_type == .opensimplex2 or config.noise_type == .opensimplex2s;
+            const f = splat(gen.frequency);
+            return rotate3(x_in * f, y_in * f, z_in * f, simplex);
+        }
+
+        /// 3D rotation; without one, OpenSimplex2(S) noise and warp (`simplex`) rotate the lattice.
+        inline fn rotate3(x_in: F, y_in: F, z_in: F, comptime simplex: bool) [3]F {
+            var x = x_in;
+            var y = y_in;
+            var z = z_in;
+
+            switch (config.rotation_type3) {
+                .improve_xy_planes => {
+                    const xy = x + y;
+                    const s2 = xy * splat(-0.211324865405187);
+                    z = z * splat(0.577350269189626);
+                    x = x + (s2 - z);
+                    y = y + s2 - z;
+                    z = z + xy * splat(0.577350269189626);
+                },
+                .improve_xz_planes => {
+                    const xz = x + z;
+                    const s2 = xz * splat(-0.211324865405187);
+                    y = y * splat(0.577350269189626);
+                    x = x + (s2 - y);
+                    z = z + (s2 - y);
+                    y = y + xz * splat(0.577350269189626);
+                },
+                .none => if (simplex) {
+                    const r = (x + y + z) * splat(r3);
+                    x = r - x;
+                    y = r - y;
+                    z = r - z;
+                },
+            }
+            return .{ x, y, z };
+        }
+
+        /// `fnlDomainWarp2D()`: displaces `p` in place.
+        pub fn domainWarp2(gen: *const FnlGenerator, p: *[2]F) void {
+            var seed = gen.seed;
+            var amp = gen.domain_warp_amp * fractalBounding(gen);
+            var freq = gen.frequency;
+            const simplex = config.domain_warp_type != .basicgrid;
+
+            switch (config.fractal_type) {
+                .domain_warp_progressive => {
+                    var octave: i32 = 0;
+                    while (octave < gen.octaves) : (octave += 1) {
+                        singleWarp2(seed, amp, freq, skew2(p[0], p[1], simplex), p);
+                        seed +%= 1;
+                        amp *= gen.gain;
+                        freq *= gen.lacunarity;
+                    }
+                },
+                .domain_warp_independent => {
+                    const ps = skew2(p[0], p[1], simplex);
+                    var octave: i32 = 0;
+                    while (octave < gen.octaves) : (octave += 1) {
+                        singleWarp2(seed, amp, freq, ps, p);
+                        seed +%= 1;
+                        amp *= gen.gain;
+                        freq *= gen.lacunarity;
+                    }
+                },
+                else => singleWarp2(seed, amp, freq, skew2(p[0], p[1], simplex), p),
+            }
+        }
+
+        /// `fnlDomainWarp3D()`: displaces `p` in place.
+        pub fn domainWarp3(gen: *const FnlGenerator, p: *[3]F) void {
+            var seed = gen.seed;
+            var amp = gen.domain_warp_amp * fractalBounding(gen);
+            var freq = gen.frequency;
+            const simplex = config.domain_warp_type != .basicgrid;
+
+            switch (config.fractal_type) {
+                .domain_warp_progressive => {
+                    var octave: i32 = 0;
+                    while (octave < gen.octaves) : (octave += 1) {
+                        singleWarp3(seed, amp, freq, rotate3(p[0], p[1], p[2], simplex), p);
+                        seed +%= 1;
+                        amp *= gen.gain;
+                        freq *= gen.lacunarity;
+                    }
+                },
+                .domain_warp_independent => {
+                    const ps = rotate3(p[0], p[1], p[2], simplex);
+                    var octave: i32 = 0;
+                    while (octave < gen.octaves) : (octave += 1) {
+                        singleWarp3(seed, amp, freq, ps, p);
+                        seed +%= 1;
+                        amp *= gen.gain;
+                        freq *= gen.lacunarity;
+                    }
+                },
+                else => singleWarp3(seed, amp, freq, rotate3(p[0], p[1], p[2], simplex), p),
+            }
+        }
+
+        inline fn skew2(x: F, y: F, comptime simplex: bool) [2]F {
+            if (!simplex) return .{ x, y };
+            const t = (x + y) * splat(f2);
+            return .{ x + t, y + t };
+        }
+
+        inline fn singleWarp2(seed: i32, amp: f32, freq: f32, ps: [2]F, p: *[2]F) void {
+            switch (config.domain_warp_type) {
+                .opensimplex2 => K.warpSimplex2(false, seed, amp * 38.283687591552734375, freq, ps, p),
+                .opensimplex2_reduced => K.warpSimplex2(true, seed, amp * 16.0, freq, ps, p),
+                .basicgrid => K.warpBasicGrid2(seed, amp, freq, ps, p),
+            }
+        }
+
+        inline fn singleWarp3(seed: i32, amp: f32, freq: f32, ps: [3]F, p: *[3]F) void {
+            switch (config.domain_warp_type) {
+                .opensimplex2 => K.warpSimplex3(false, seed, amp * 32.69428253173828125, freq, ps, p),
+                .opensimplex2_reduced => K.warpSimplex3(true, seed, amp * 7.71604938271605, freq, ps, p),
+                .basicgrid => K.warpBasicGrid3(seed, amp, freq, ps, p),
+            }
+        }
+
+        /// Gradient with respect to the input of `transform3()` (without frequency) from the gradient `g` with
+        /// respect to its output.
+        inline fn inputGradient3(g: [3]F) [3]F {
+            switch (config.rotation_type3) {
+                .improve_xy_planes => {
+                    const s2 = (g[0] + g[1]) * splat(-0.211324865405187) + g[2] * splat(0.577350269189626);
+                    return .{ g[0] + s2, g[1] + s2, (g[2] - g[0] - g[1]) * splat(0.577350269189626) };
+                },
+                .improve_xz_planes => {
+                    const s2 = (g[0] + g[2]) * splat(-0.211324865405187) + g[1] * splat(0.577350269189626);
+                    return .{ g[0] + s2, (g[1] - g[0] - g[2]) * splat(0.577350269189626), g[2] + s2 };
+                },
+                .none => switch (config.noise_type) {
+                    .opensimplex2, .opensimplex2s => {
+                        const r = (g[0] + g[1] + g[2]) * splat(r3);
+                        return .{ r - g[0], r - g[1], r - g[2] };
+                    },
+                    else => return g,
+                },
+            }
+        }
+
+        fn single2(gen: *const FnlGenerator, seed: i32, x: F, y: F) F {
+            return switch (config.noise_type) {
+                .opensimplex2 => K.simplex2(seed, x, y),
+                .opensimplex2s => K.simplexS2(seed, x, y),
+                .cellular => K.cellular2(config.cellular_distance_func, gen, seed, x, y),
+                .perlin => K.perlin2(seed, x, y),
+                .value_cubic => K.valueCubic2(seed, x, y),
+                .value => K.value2(seed, x, y),
+            };
+        }
+
+        fn single3(gen: *const FnlGenerator, seed: i32, x: F, y: F, z: F) F {
+            return switch (config.noise_type) {
+                .opensimplex2 => K.simplex3(seed, x, y, z),
+                .opensimplex2s => K.simplexS3(seed, x, y, z),
+                .cellular => K.cellular3(config.cellular_distance_func, gen, seed, x, y, z),
+                .perlin => K.perlin3(seed, x, y, z),
+                .value_cubic => K.valueCubic3(seed, x, y, z),
+                .value => K.value3(seed, x, y, z),
+            };
+        }
+
+        fn fractal2(gen: *const FnlGenerator, x_in: F, y_in: F) F {
+            var x = x_in;
+            var y = y_in;
+            var seed = gen.seed;
+            var sum = K.zero;
+            var amp = splat(fractalBounding(gen));
+
+            var octave: i32 = 0;
+            while (octave < gen.octaves) : (octave += 1) {
+                const noise = single2(gen, seed, x, y);
+                seed +%= 1;
+                amp = octaveSum(gen, noise, &sum, amp, true);
+                x = x * splat(gen.lacunarity);
+                y = y * splat(gen.lacunarity);
+                amp = amp * splat(gen.gain);
+            }
+            return sum;
+        }
+
+        fn fractal3(gen: *const FnlGenerator, x_in: F, y_in: F, z_in: F) F {
+            var x = x_in;
+            var y = y_in;
+            var z = z_in;
+            var seed = gen.seed;
+            var sum = K.zero;
+            var amp = splat(fractalBounding(gen));
+
+            var octave: i32 = 0;
+            while (octave < gen.octaves) : (octave += 1) {
+                const noise = single3(gen, seed, x, y, z);
+                seed +%= 1;
+                amp = octaveSum(gen, noise, &sum, amp, false);
+                x = x * splat(gen.lacunarity);
+                y = y * splat(gen.lacunarity);
+                z = z * splat(gen.lacunarity);
+                amp = amp * splat(gen.gain);
+            }
+            return sum;
+        }
+
+        fn singleDeriv(comptime dims: u32, seed: i32, p: [dims]F) K.Dual(dims) {
+            if (dims == 2) return switch (config.noise_type) {
+                .opensimplex2 => K.simplex2Deriv(seed, p[0], p[1]),
+                .perlin => K.perlin2Deriv(seed, p[0], p[1]),
+                .value => K.value2Deriv(seed, p[0], p[1]),
+                else => unreachable,
+            };
+            return switch (config.noise_type) {
+                .opensimplex2 => K.simplex3Deriv(seed, p[0], p[1], p[2]),
+                .perlin => K.perlin3Deriv(seed, p[0], p[1], p[2]),
+                .value => K.value3Deriv(seed, p[0], p[1], p[2]),
+                else => unreachable,
+            };
+        }
+
+        /// `fractal2()` / `fractal3()` with the gradient: the chain rule through octave frequencies and weighted
+        /// amplitudes.
+        fn fractalDeriv(comptime dims: u32, gen: *const FnlGenerator, p_in: [dims]F) K.Dual(dims) {
+            var p = p_in;
+            var seed = gen.seed;
+            var sum = K.Dual(dims){ .v = K.zero, .d = [_]F{K.zero} ** dims };
+            var amp = splat(fractalBounding(gen));
+            var amp_d = [_]F{K.zero} ** dims;
+            var scale: f32 = 1.0;
+
+            var octave: i32 = 0;
+            while (octave < gen.octaves) : (octave += 1) {
+                var noise = singleDeriv(dims, seed, p);
+                seed +%= 1;
+                for (noise.d) |*d| d.* = d.* * splat(scale);
+                const weighted_amp = octaveSum(gen, noise.v, &sum.v, amp, dims == 2);
+                octaveSumDeriv(dims, gen, noise, &sum.d, amp, &amp_d, dims == 2);
+                for (p) |*c| c.* = c.* * splat(gen.lacunarity);
+                scale *= gen.lacunarity;
+                amp = weighted_amp * splat(gen.gain);
+                for (amp_d) |*d| d.* = d.* * splat(gen.gain);
+            }
+            return sum;
+        }
+
+        /// Gradient part of `octaveSum()`: adds the gradient of the octave to `sum_d` and replaces `amp_d` with the
+        /// gradient of the weighted amplitude.
+        inline fn octaveSumDeriv(
+            comptime dims: u32,
+            gen: *const FnlGenerator,
+            single: K.Dual(dims),
+            sum_d: *[dims]F,
+            amp: F,
+            amp_d: *[dims]F,
+            comptime clamp_fbm: bool,
+        ) void {
+            const weighted_strength = splat(gen.weighted_strength);
+            switch (config.fractal_type) {
+                .fbm => {
+                    const weight = if (clamp_fbm) K.fastMin(single.v + one, splat(2)) else single.v + one;
+                    const w = K.lerp(one, weight * splat(0.5), weighted_strength);
+                    const unclamped = if (clamp_fbm) single.v + one < splat(2) else @splat(n, true);
+                    comptime var k = 0;
+                    inline while (k < dims) : (k += 1) {
+                        const dw = K.selectF(unclamped, weighted_strength * splat(0.5) * single.d[k], K.zero);
+                        sum_d[k] = sum_d[k] + single.d[k] * amp + single.v * amp_d[k];
+                        amp_d[k] = amp_d[k] * w + amp * dw;
+                    }
+                },
+                .ridged => {
+                    const noise = K.fastAbs(single.v);
+                    const w = K.lerp(one, one - noise, weighted_strength);
+                    comptime var k = 0;
+                    inline while (k < dims) : (k += 1) {
+                        const dnoise = K.selectF(single.v < K.zero, -single.d[k], single.d[k]);
+                        sum_d[k] = sum_d[k] + splat(-2) * dnoise * amp + (noise * splat(-2) + one) * amp_d[k];
+                        amp_d[k] = amp_d[k] * w - amp * weighted_strength * dnoise;
+                    }
+                },
+                else => unreachable,
+            }
+        }
+
+        /// Adds one octave to `sum` and returns the weighted amplitude (before `gain` is applied).
+        inline fn octaveSum(gen: *const FnlGenerator, single: F, sum: *F, amp: F, comptime clamp_fbm: bool) F {
+            const weighted_strength = splat(gen.weighted_strength);
+            switch (config.fractal_type) {
+                .fbm => {
+                    sum.* = sum.* + single * amp;
+                    // FastNoiseLite clamps the weight only in 2D.
+                    const weight = if (clamp_fbm) K.fastMin(single + one, splat(2)) else single + one;
+                    return amp * K.lerp(one, weight * splat(0.5), weighted_strength);
+                },
+                .ridged => {
+                    const noise = K.fastAbs(single);
+                    sum.* = sum.* + (noise * splat(-2) + one) * amp;
+                    return amp * K.lerp(one, one - noise, weighted_strength);
+                },
+                .pingpong => {
+                    const noise = K.pingPong((single + one) * splat(gen.ping_pong_strength));
+                    sum.* = sum.* + (noise - splat(0.5)) * splat(2) * amp;
+                    return amp * K.lerp(one, noise, weighted_strength);
+                },
+                else => unreachable,
+            }
+        }
+    };
+}
+
+fn fractalBounding(gen: *const FnlGenerator) f32 {
+    const gain = if (gen.gain < 0) -gen.gain else gen.gain;
+    var amp = gain;
+    var amp_fractal: f32 = 1.0;
+    var i: i32 = 1;
+    while (i < gen.octaves) : (i += 1) {
+        amp_fractal += amp;
+        amp *= gain;
+    }
+    return 1.0 / amp_fractal;
+}
+
+/// Single-octave noise functions of FastNoiseLite (frequency and skew/rotation already applied) on `n` lanes.
+fn Kernels(comptime n: u32) type {
+    return struct {
+        const F = @Vector(n, f32);
+        const I = @Vector(n, i32);
+        const B = @Vector(n, bool);
+
+        const zero = sf(0.0);
+        const one = sf(1.0);
+
+        inline fn sf(v: f32) F {
+            return @splat(n, v);
+        }
+
+        inline fn si(v: i32) I {
+            return @splat(n, v);
+        }
+
+        inline fn andB(a: B, b: B) B {
+            return @select(bool, a, b, @splat(n, false));
+        }
+
+        inline fn orB(a: B, b: B) B {
+            return @select(bool, a, @splat(n, true), b);
+        }
+
+        inline fn notB(a: B) B {
+            return @select(bool, a, @splat(n, false), @splat(n, true));
+        }
+
+        inline fn selectF(mask: B, a: F, b: F) F {
+            return @select(f32, mask, a, b);
+        }
+
+        inline fn selectI(mask: B, a: I, b: I) I {
+            return @select(i32, mask, a, b);
+        }
+
+        inline fn shl(v: I, comptime s: u5) I {
+            return v << @splat(n, s);
+        }
+
+        inline fn shr(v: I, comptime s: u5) I {
+            return v >> @splat(n, s);
+        }
+
+        /// C `(int)f` (truncation).
+        inline fn toInt(v: F) I {
+            @setRuntimeSafety(false);
+            var r: [n]i32 = undefined;
+            comptime var i = 0;
+            inline while (i < n) : (i += 1) r[i] = @floatToInt(i32, v[i]);
+            return r;
+        }
+
+        inline fn toFloat(v: I) F {
+            var r: [n]f32 = undefined;
+            comptime var i = 0;
+            inline while (i < n) : (i += 1) r[i] = @intToFloat(f32, v[i]);
+            return r;
+        }
+
+        inline fn gather(table: []const f32, index: I) F {
+            var r: [n]f32 = undefined;
+            comptime var i = 0;
+            inline while (i < n) : (i += 1) r[i] = table[@bitCast(u32, index[i])];
+            return r;
+        }
+
+        /// `(int)f - 1` for negative `f`, including negative integers.
+        inline fn fastFloor(f: F) I {
+            const t = toInt(f);
+            return selectI(f >= zero, t, t -% si(1));
+        }
+
+        inline fn fastRound(f: F) I {
+            return selectI(f >= zero, toInt(f + sf(0.5)), toInt(f - sf(0.5)));
+        }
+
+        inline fn fastMin(a: F, b: F) F {
+            return selectF(a < b, a, b);
+        }
+
+        inline fn fastMax(a: F, b: F) F {
+            return selectF(a > b, a, b);
+        }
+
+        inline fn fastAbs(f: F) F {
+            return selectF(f < zero, -f, f);
+        }
+
+        inline fn fastSqrt(a: F) F {
+            const xhalf = sf(0.5) * a;
+            var r = @bitCast(F, si(0x5f3759df) -% shr(@bitCast(I, a), 1));
+            r = r * (sf(1.5) - xhalf * r * r);
+            return a * r;
+        }
+
+        inline fn lerp(a: F, b: F, t: F) F {
+            return a + t * (b - a);
+        }
+
+        inline fn interpHermite(t: F) F {
+            return t * t * (sf(3) - sf(2) * t);
+        }
+
+        inline fn interpQuintic(t: F) F {
+            return t * t * t * (t * (t * sf(6) - sf(15)) + sf(10));
+        }
+
+        inline fn interpHermiteDeriv(t: F) F {
+            return t * (sf(6) - sf(6) * t);
+        }
+
+        inline fn interpQuinticDeriv(t: F) F {
+            return t * t * (t * (t * sf(30) - sf(60)) + sf(30));
+        }
+
+        /// Value and gradient with respect to `dims` coordinates.
+        fn Dual(comptime dims: u32) type {
+            return struct {
+                v: F,
+                d: [dims]F,
+            };
+        }
+
+        inline fn constDual(comptime dims: u32, v: F) Dual(dims) {
+            return .{ .v = v, .d = [_]F{zero} ** dims };
+        }
+
+        inline fn scaleDual(comptime dims: u32, a: Dual(dims), s: f32) Dual(dims) {
+            var r = Dual(dims){ .v = a.v * sf(s), .d = undefined };
+            for (r.d) |*d, k| d.* = a.d[k] * sf(s);
+            return r;
+        }
+
+        /// `lerp()` with gradients; `t` depends only on coordinate `axis`, with derivative `dt`.
+        inline fn lerpDual(
+            comptime dims: u32,
+            a: Dual(dims),
+            b: Dual(dims),
+            t: F,
+            comptime axis: u32,
+            dt: F,
+        ) Dual(dims) {
+            var r = Dual(dims){ .v = lerp(a.v, b.v, t), .d = undefined };
+            for (r.d) |*d, k| d.* = lerp(a.d[k], b.d[k], t);
+            r.d[axis] = r.d[axis] + dt * (b.v - a.v);
+            return r;
+        }
+
+        inline fn cubicLerp(a: F, b: F, c: F, d: F, t: F) F {
+            const p = (d - c) - (a - b);
+            return t * t * t * p + t * t * ((a - b) - p) + t * (c - a) + b;
+        }
+
+        inline fn pingPong(t: F) F {
+            const r = t - toFloat(toInt(t * sf(0.5)) *% si(2));
+            return selectF(r < one, r, sf(2) - r);
+        }
+
+        inline fn hash2(seed: i32, xp: I, yp: I) I {
+            return (si(seed) ^ xp ^ yp) *% si(0x27d4eb2d);
+        }
+
+        inline fn hash3(seed: i32, xp: I, yp: I, zp: I) I {
+            return (si(seed) ^ xp ^ yp ^ zp) *% si(0x27d4eb2d);
+        }
+
+        inline fn valCoord2(seed: i32, xp: I, yp: I) F {
+            var hash = hash2(seed, xp, yp);
+            hash = hash *% hash;
+            hash ^= shl(hash, 19);
+            return toFloat(hash) * sf(1.0 / 2147483648.0);
+        }
+
+        inline fn valCoord3(seed: i32, xp: I, yp: I, zp: I) F {
+            var hash = hash3(seed, xp, yp, zp);
+            hash = hash *% hash;
+            hash ^= shl(hash, 19);
+            return toFloat(hash) * sf(1.0 / 2147483648.0);
+        }
+
+        inline fn gradVector2(seed: i32, xp: I, yp: I) [2]F {
+            var hash = hash2(seed, xp, yp);
+            hash ^= shr(hash, 15);
+            hash &= si(127 << 1);
+            return .{ gather(&gradients2, hash), gather(&gradients2, hash | si(1)) };
+        }
+
+        inline fn gradVector3(seed: i32, xp: I, yp: I, zp: I) [3]F {
+            var hash = hash3(seed, xp, yp, zp);
+            hash ^= shr(hash, 15);
+            hash &= si(63 << 2);
+            return .{ gather(&gradients3, hash), gather(&gradients3, hash | si(1)), gather(&gradients3, hash | si(2)) };
+        }
+
+        inline fn gradCoord2(seed: i32, xp: I, yp: I, xd: F, yd: F) F {
+            const g = gradVector2(seed, xp, yp);
+            return xd * g[0] + yd * g[1];
+        }
+
+        inline fn gradCoord3(seed: i32, xp: I, yp: I, zp: I, xd: F, yd: F, zd: F) F {
+            const g = gradVector3(seed, xp, yp, zp);
+            return xd * g[0] + yd * g[1] + zd * g[2];
+        }
+
+        inline fn gradCoordOut2(seed: i32, xp: I, yp: I) [2]F {
+            const hash = hash2(seed, xp, yp) & si(255 << 1);
+            return .{ gather(&rand_vecs2, hash), gather(&rand_vecs2, hash | si(1)) };
+        }
+
+        inline fn gradCoordOut3(seed: i32, xp: I, yp: I, zp: I) [3]F {
+            const hash = hash3(seed, xp, yp, zp) & si(255 << 2);
+            return .{ gather(&rand_vecs3, hash), gather(&rand_vecs3, hash | si(1)), gather(&rand_vecs3, hash | si(2)) };
+        }
+
+        inline fn gradCoordDual2(seed: i32, xp: I, yp: I, xd: F, yd: F) [2]F {
+            const hash = hash2(seed, xp, yp);
+            const index1 = hash & si(127 << 1);
+            const index2 = shr(hash, 7) & si(255 << 1);
+            const value = xd * gather(&gradients2, index1) + yd * gather(&gradients2, index1 | si(1));
+            return .{ value * gather(&rand_vecs2, index2), value * gather(&rand_vecs2, index2 | si(1)) };
+        }
+
+        inline fn gradCoordDual3(seed: i32, xp: I, yp: I, zp: I, xd: F, yd: F, zd: F) [3]F {
+            const hash = hash3(seed, xp, yp, zp);
+            const index1 = hash & si(63 << 2);
+            const index2 = shr(hash, 6) & si(255 << 2);
+            const value = xd * gather(&gradients3, index1) + yd * gather(&gradients3, index1 | si(1)) +
+                zd * gather(&gradients3, index1 | si(2));
+            return .{
+                value * gather(&rand_vecs3, index2),
+                value * gather(&rand_vecs3, index2 | si(1)),
+                value * gather(&rand_vecs3, index2 | si(2)),
+            };
+        }
+
+        /// `gradCoord2()` and its gradient with respect to the offset.
+        inline fn gradDual2(seed: i32, xp: I, yp: I, xd: F, yd: F) Dual(2) {
+            const g = gradVector2(seed, xp, yp);
+            return .{ .v = xd * g[0] + yd * g[1], .d = g };
+        }
+
+        /// `gradCoord3()` and its gradient with respect to the offset.
+        inline fn gradDual3(seed: i32, xp: I, yp: I, zp: I, xd: F, yd: F, zd: F) Dual(3) {
+            const g = gradVector3(seed, xp, yp, zp);
+            return .{ .v = xd * g[0] + yd * g[1] + zd * g[2], .d = g };
+        }
+
+        /// Contribution of a simplex vertex with attenuation `a` where `mask` is set, 0 elsewhere.
+        inline fn contribution(mask: B, a: F, grad: F) F {
+            return selectF(mask, (a * a) * (a * a) * grad, zero);
+        }
+
+        /// `value + contribution` where `mask` is set; `value` unchanged elsewhere.
+        inline fn addIf(mask: B, value: F, a: F, grad: F) F {
+            return selectF(mask, value + (a * a) * (a * a) * grad, value);
+        }
+
+        /// Adds the gradient of `contribution(mask, a, grad.v)` with respect to the vertex `offset` to `deriv`
+        /// (`a` is the radius squared minus the squared length of `offset`).
+        inline fn contributionDeriv(
+            comptime dims: u32,
+            mask: B,
+            a: F,
+            grad: Dual(dims),
+            offset: [dims]F,
+            deriv: *[dims]F,
+        ) void {
+            const a2 = a * a;
+            const a4 = a2 * a2;
+            const s = sf(-8) * a2 * a * grad.v;
+            for (deriv) |*d, k| d.* = selectF(mask, d.* + a4 * grad.d[k] + s * offset[k], d.*);
+        }
+
+        fn simplex2(seed: i32, x: F, y: F) F {
+            var i = fastFloor(x);
+            var j = fastFloor(y);
+            const xi = x - toFloat(i);
+            const yi = y - toFloat(j);
+
+            const t = (xi + yi) * sf(g2);
+            const x0 = xi - t;
+            const y0 = yi - t;
+
+            i *%= si(prime_x);
+            j *%= si(prime_y);
+
+            const a = sf(0.5) - x0 * x0 - y0 * y0;
+            const n0 = contribution(a > zero, a, gradCoord2(seed, i, j, x0, y0));
+
+            const c = sf(g2_c0) * t + (sf(g2_c1) + a);
+            const x2 = x0 + sf(2 * g2 - 1);
+            const y2 = y0 + sf(2 * g2 - 1);
+            const n2 = contribution(c > zero, c, gradCoord2(seed, i +% si(prime_x), j +% si(prime_y), x2, y2));
+
+            const upper = y0 > x0;
+            const x1 = selectF(upper, x0 + sf(g2), x0 + sf(g2 - 1));
+            const y1 = selectF(upper, y0 + sf(g2 - 1), y0 + sf(g2));
+            const b = sf(0.5) - x1 * x1 - y1 * y1;
+            const i1 = selectI(upper, i, i +% si(prime_x));
+            const j1 = selectI(upper, j +% si(prime_y), j);
+            const n1 = contribution(b > zero, b, gradCoord2(seed, i1, j1, x1, y1));
+
+            return (n0 + n1 + n2) * sf(99.83685446303647);
+        }
+
+        fn simplex3(seed_in: i32, x: F, y: F, z: F) F {
+            var seed = seed_in;
+            var i = fastRound(x);
+            var j = fastRound(y);
+            var k = fastRound(z);
+            var x0 = x - toFloat(i);
+            var y0 = y - toFloat(j);
+            var z0 = z - toFloat(k);
+
+            var x_sign = toInt(sf(-1) - x0) | si(1);
+            var y_sign = toInt(sf(-1) - y0) | si(1);
+            var z_sign = toInt(sf(-1) - z0) | si(1);
+
+            var ax0 = toFloat(x_sign) * -x0;
+            var ay0 = toFloat(y_sign) * -y0;
+            var az0 = toFloat(z_sign) * -z0;
+
+            i *%= si(prime_x);
+            j *%= si(prime_y);
+            k *%= si(prime_z);
+
+            var value = zero;
+            var a = (sf(0.6) - x0 * x0) - (y0 * y0 + z0 * z0);
+
+            comptime var l = 0;
+            inline while (true) : (l += 1) {
+                value = addIf(a > zero, value, a, gradCoord3(seed, i, j, k, x0, y0, z0));
+
+                const xs = toFloat(x_sign);
+                const ys = toFloat(y_sign);
+                const zs = toFloat(z_sign);
+                const use_x = andB(ax0 >= ay0, ax0 >= az0);
+                const use_y = andB(notB(use_x), andB(ay0 > ax0, ay0 >= az0));
+                const use_z = notB(orB(use_x, use_y));
+
+                const x1 = selectF(use_x, x0 + xs, x0);
+                const y1 = selectF(use_y, y0 + ys, y0);
+                const z1 = selectF(use_z, z0 + zs, z0);
+                const b1 = a + one;
+                const b = selectF(
+                    use_x,
+                    b1 - xs * sf(2) * x1,
+                    selectF(use_y, b1 - ys * sf(2) * y1, b1 - zs * sf(2) * z1),
+                );
+                const i1 = selectI(use_x, i -% x_sign *% si(prime_x), i);
+                const j1 = selectI(use_y, j -% y_sign *% si(prime_y), j);
+                const k1 = selectI(use_z, k -% z_sign *% si(prime_z), k);
+
+                value = addIf(b > zero, value, b, gradCoord3(seed, i1, j1, k1, x1, y1, z1));
+
+                if (l == 1) break;
+
+                ax0 = sf(0.5) - ax0;
+                ay0 = sf(0.5) - ay0;
+                az0 = sf(0.5) - az0;
+
+                x0 = xs * ax0;
+                y0 = ys * ay0;
+                z0 = zs * az0;
+
+                a = a + ((sf(0.75) - ax0) - (ay0 + az0));
+
+                i +%= shr(x_sign, 1) & si(prime_x);
+                j +%= shr(y_sign, 1) & si(prime_y);
+                k +%= shr(z_sign, 1) & si(prime_z);
+
+                x_sign = si(0) -% x_sign;
+                y_sign = si(0) -% y_sign;
+                z_sign = si(0) -% z_sign;
+
+                seed = ~seed;
+            }
+
+            return value * sf(32.69428253173828125);
+        }
+
+        /// `simplex2()` and its gradient.
+        fn simplex2Deriv(seed: i32, x: F, y: F) Dual(2) {
+            var i = fastFloor(x);
+            var j = fastFloor(y);
+            const xi = x - toFloat(i);
+            const yi = y - toFloat(j);
+
+            const t = (xi + yi) * sf(g2);
+            const x0 = xi - t;
+            const y0 = yi - t;
+
+            i *%= si(prime_x);
+            j *%= si(prime_y);
+
+            // Gradient with respect to the vertex offsets.
+            var d = [2]F{ zero, zero };
+
+            const a = sf(0.5) - x0 * x0 - y0 * y0;
+            const grad0 = gradDual2(seed, i, j, x0, y0);
+            const n0 = contribution(a > zero, a, grad0.v);
+            contributionDeriv(2, a > zero, a, grad0, [2]F{ x0, y0 }, &d);
+
+            const c = sf(g2_c0) * t + (sf(g2_c1) + a);
+            const x2 = x0 + sf(2 * g2 - 1);
+            const y2 = y0 + sf(2 * g2 - 1);
+            const grad2 = gradDual2(seed, i +% si(prime_x), j +% si(prime_y), x2, y2);
+            const n2 = contribution(c > zero, c, grad2.v);
+            contributionDeriv(2, c > zero, c, grad2, [2]F{ x2, y2 }, &d);
+
+            const upper = y0 > x0;
+            const x1 = selectF(upper, x0 + sf(g2), x0 + sf(g2 - 1));
+            const y1 = selectF(upper, y0 + sf(g2 - 1), y0 + sf(g2));
+            const b = sf(0.5) - x1 * x1 - y1 * y1;
+            const i1 = selectI(upper, i, i +% si(prime_x));
+            const j1 = selectI(upper, j +% si(prime_y), j);
+            const grad1 = gradDual2(seed, i1, j1, x1, y1);
+            const n1 = contribution(b > zero, b, grad1.v);
+            contributionDeriv(2, b > zero, b, grad1, [2]F{ x1, y1 }, &d);
+
+            // The offsets are `(xi, yi) - (xi + yi) * G2` plus a constant.
+            const s = (d[0] + d[1]) * sf(g2);
+            return scaleDual(2, .{ .v = n0 + n1 + n2, .d = .{ d[0] - s, d[1] - s } }, 99.83685446303647);
+        }
+
+        /// `simplex3()` and its gradient.
+        fn simplex3Deriv(seed_in: i32, x: F, y: F, z: F) Dual(3) {
+            var seed = seed_in;
+            var i = fastRound(x);
+            var j = fastRound(y);
+            var k = fastRound(z);
+            var x0 = x - toFloat(i);
+            var y0 = y - toFloat(j);
+            var z0 = z - toFloat(k);
+
+            var x_sign = toInt(sf(-1) - x0) | si(1);
+            var y_sign = toInt(sf(-1) - y0) | si(1);
+            var z_sign = toInt(sf(-1) - z0) | si(1);
+
+            var ax0 = toFloat(x_sign) * -x0;
+            var ay0 = toFloat(y_sign) * -y0;
+            var az0 = toFloat(z_sign) * -z0;
+
+            i *%= si(prime_x);
+            j *%= si(prime_y);
+            k *%= si(prime_z);
+
+            var value = zero;
+            // The offsets change with the input by identity.
+            var d = [3]F{ zero, zero, zero };
+            var a = (sf(0.6) - x0 * x0) - (y0 * y0 + z0 * z0);
+
+            comptime var l = 0;
+            inline while (true) : (l += 1) {
+                const grad0 = gradDual3(seed, i, j, k, x0, y0, z0);
+                value = addIf(a > zero, value, a, grad0.v);
+                contributionDeriv(3, a > zero, a, grad0, [3]F{ x0, y0, z0 }, &d);
+
+                const xs = toFloat(x_sign);
+                const ys = toFloat(y_sign);
+                const zs = toFloat(z_sign);
+                const use_x = andB(ax0 >= ay0, ax0 >= az0);
+                const use_y = andB(notB(use_x), andB(ay0 > ax0, ay0 >= az0));
+                const use_z = notB(orB(use_x, use_y));
+
+                const x1 = selectF(use_x, x0 + xs, x0);
+                const y1 = selectF(use_y, y0 + ys, y0);
+                const z1 = selectF(use_z, z0 + zs, z0);
+                const b1 = a + one;
+                const b = selectF(
+                    use_x,
+                    b1 - xs * sf(2) * x1,
+                    selectF(use_y, b1 - ys * sf(2) * y1, b1 - zs * sf(2) * z1),
+                );
+                const i1 = selectI(use_x, i -% x_sign *% si(prime_x), i);
+                const j1 = selectI(use_y, j -% y_sign *% si(prime_y), j);
+                const k1 = selectI(use_z, k -% z_sign *% si(prime_z), k);
+
+                const grad1 = gradDual3(seed, i1, j1, k1, x1, y1, z1);
+                value = addIf(b > zero, value, b, grad1.v);
+                contributionDeriv(3, b > zero, b, grad1, [3]F{ x1, y1, z1 }, &d);
+
+                if (l == 1) break;
+
+                ax0 = sf(0.5) - ax0;
+                ay0 = sf(0.5) - ay0;
+                az0 = sf(0.5) - az0;
+
+                x0 = xs * ax0;
+                y0 = ys * ay0;
+                z0 = zs * az0;
+
+                a = a + ((sf(0.75) - ax0) - (ay0 + az0));
+
+                i +%= shr(x_sign, 1) & si(prime_x);
+                j +%= shr(y_sign, 1) & si(prime_y);
+                k +%= shr(z_sign, 1) & si(prime_z);
+
+                x_sign = si(0) -% x_sign;
+                y_sign = si(0) -% y_sign;
+                z_sign = si(0) -% z_sign;
+
+                seed = ~seed;
+            }
+
+            return scaleDual(3, .{ .v = value, .d = d }, 32.69428253173828125);
+        }
+
+        fn simplexS2(seed: i32, x: F, y: F) F {
+            var i = fastFloor(x);
+            var j = fastFloor(y);
+            const xi = x - toFloat(i);
+            const yi = y - toFloat(j);
+
+            i *%= si(prime_x);
+            j *%= si(prime_y);
+            const i1 = i +% si(prime_x);
+            const j1 = j +% si(prime_y);
+
+            const t = (xi + yi) * sf(g2);
+            const x0 = xi - t;
+            const y0 = yi - t;
+
+            const a0 = sf(two_thirds) - x0 * x0 - y0 * y0;
+            var value = (a0 * a0) * (a0 * a0) * gradCoord2(seed, i, j, x0, y0);
+
+            const a1 = sf(g2_c0) * t + (sf(g2_c1) + a0);
+            const x1 = x0 - sf(1 - 2 * g2);
+            const y1 = y0 - sf(1 - 2 * g2);
+            value = value + (a1 * a1) * (a1 * a1) * gradCoord2(seed, i1, j1, x1, y1);
+
+            // The two remaining vertices depend on the triangle half and on the region of the point inside it;
+            // offsets are added (instead of subtracted) where FastNoiseLite subtracts their negation.
+            const xmyi = xi - yi;
+            const upper = t > sf(g2);
+
+            const far2 = selectB(upper, xi + xmyi > one, xi + xmyi < zero);
+            const x2 = x0 + selectF(
+                upper,
+                selectF(far2, sf(3 * g2 - 2), sf(g2)),
+                selectF(far2, sf(1 - g2), sf(g2 - 1)),
+            );
+            const y2 = y0 + selectF(
+                upper,
+                selectF(far2, sf(3 * g2 - 1), sf(g2 - 1)),
+                selectF(far2, -sf(g2), sf(g2)),
+            );
+            const i2 = selectI(
+                upper,
+                selectI(far2, i +% si(prime_x2), i),
+                selectI(far2, i -% si(prime_x), i +% si(prime_x)),
+            );
+            const j2 = selectI(upper, j +% si(prime_y), j);
+            const a2 = sf(two_thirds) - x2 * x2 - y2 * y2;
+            value = addIf(a2 > zero, value, a2, gradCoord2(seed, i2, j2, x2, y2));
+
+            const far3 = selectB(upper, yi - xmyi > one, yi < xmyi);
+            const x3 = x0 + selectF(
+                upper,
+                selectF(far3, sf(3 * g2 - 1), sf(g2 - 1)),
+                selectF(far3, -sf(g2), sf(g2)),
+            );
+            const y3 = y0 + selectF(
+                upper,
+                selectF(far3, sf(3 * g2 - 2), sf(g2)),
+                selectF(far3, -sf(g2 - 1), sf(g2 - 1)),
+            );
+            const i3 = selectI(upper, i +% si(prime_x), i);
+            const j3 = selectI(
+                upper,
+                selectI(far3, j +% si(prime_y2), j),
+                selectI(far3, j -% si(prime_y), j +% si(prime_y)),
+            );
+            const a3 = sf(two_thirds) - x3 * x3 - y3 * y3;
+            value = addIf(a3 > zero, value, a3, gradCoord2(seed, i3, j3, x3, y3));
+
+            return value * sf(18.24196194486065);
+        }
+
+        inline fn selectB(mask: B, a: B, b: B) B {
+            return @select(bool, mask, a, b);
+        }
+
+        fn simplexS3(seed: i32, x: F, y: F, z: F) F {
+            var i = fastFloor(x);
+            var j = fastFloor(y);
+            var k = fastFloor(z);
+            const xi = x - toFloat(i);
+            const yi = y - toFloat(j);
+            const zi = z - toFloat(k);
+
+            i *%= si(prime_x);
+            j *%= si(prime_y);
+            k *%= si(prime_z);
+            const seed2 = seed +% 1293373;
+
+            const x_mask = toInt(sf(-0.5) - xi);
+            const y_mask = toInt(sf(-0.5) - yi);
+            const z_mask = toInt(sf(-0.5) - zi);
+            const x_sign = toFloat(x_mask | si(1));
+            const y_sign = toFloat(y_mask | si(1));
+            const z_sign = toFloat(z_mask | si(1));
+
+            const x0 = xi + toFloat(x_mask);
+            const y0 = yi + toFloat(y_mask);
+            const z0 = zi + toFloat(z_mask);
+            const a0 = sf(0.75) - x0 * x0 - y0 * y0 - z0 * z0;
+            var value = (a0 * a0) * (a0 * a0) * gradCoord3(
+                seed,
+                i +% (x_mask & si(prime_x)),
+                j +% (y_mask & si(prime_y)),
+                k +% (z_mask & si(prime_z)),
+                x0,
+                y0,
+                z0,
+            );
+
+            const x1 = xi - sf(0.5);
+            const y1 = yi - sf(0.5);
+            const z1 = zi - sf(0.5);
+            const a1 = sf(0.75) - x1 * x1 - y1 * y1 - z1 * z1;
+            value = value + (a1 * a1) * (a1 * a1) * gradCoord3(
+                seed2,
+                i +% si(prime_x),
+                j +% si(prime_y),
+                k +% si(prime_z),
+                x1,
+                y1,
+                z1,
+            );
+
+            const x_flip0 = toFloat(shl(x_mask | si(1), 1)) * x1;
+            const y_flip0 = toFloat(shl(y_mask | si(1), 1)) * y1;
+            const z_flip0 = toFloat(shl(z_mask | si(1), 1)) * z1;
+            const x_flip1 = toFloat(si(-2) -% shl(x_mask, 2)) * x1 - one;
+            const y_flip1 = toFloat(si(-2) -% shl(y_mask, 2)) * y1 - one;
+            const z_flip1 = toFloat(si(-2) -% shl(z_mask, 2)) * z1 - one;
+
+            // Lattice coordinates of the first cube's vertices: `*0` are the nearest ones, `*_flip` the ones across.
+            const i0 = i +% (x_mask & si(prime_x));
+            const j0 = j +% (y_mask & si(prime_y));
+            const k0 = k +% (z_mask & si(prime_z));
+            const i_flip = i +% (~x_mask & si(prime_x));
+            const j_flip = j +% (~y_mask & si(prime_y));
+            const k_flip = k +% (~z_mask & si(prime_z));
+            // Second cube's vertices; `*_far` are the ones two cells away.
+            const i1 = i +% si(prime_x);
+            const j1 = j +% si(prime_y);
+            const k1 = k +% si(prime_z);
+            const i_far = i +% (x_mask & si(prime_x2));
+            const j_far = j +% (y_mask & si(prime_y2));
+            const k_far = k +% (z_mask & si(prime_z2));
+
+            const a2 = x_flip0 + a0;
+            const m2 = a2 > zero;
+            value = addIf(m2, value, a2, gradCoord3(seed, i_flip, j0, k0, x0 - x_sign, y0, z0));
+            const a3 = y_flip0 + z_flip0 + a0;
+            const m3 = andB(notB(m2), a3 > zero);
+            value = addIf(m3, value, a3, gradCoord3(seed, i0, j_flip, k_flip, x0, y0 - y_sign, z0 - z_sign));
+            const a4 = x_flip1 + a1;
+            const skip5 = andB(notB(m2), a4 > zero);
+            value = addIf(skip5, value, a4, gradCoord3(seed2, i_far, j1, k1, x_sign + x1, y1, z1));
+
+            const a6 = y_flip0 + a0;
+            const m6 = a6 > zero;
+            value = addIf(m6, value, a6, gradCoord3(seed, i0, j_flip, k0, x0, y0 - y_sign, z0));
+            const a7 = x_flip0 + z_flip0 + a0;
+            const m7 = andB(notB(m6), a7 > zero);
+            value = addIf(m7, value, a7, gradCoord3(seed, i_flip, j0, k_flip, x0 - x_sign, y0, z0 - z_sign));
+            const a8 = y_flip1 + a1;
+            const skip9 = andB(notB(m6), a8 > zero);
+            value = addIf(skip9, value, a8, gradCoord3(seed2, i1, j_far, k1, x1, y_sign + y1, z1));
+
+            const aa = z_flip0 + a0;
+            const ma = aa > zero;
+            value = addIf(ma, value, aa, gradCoord3(seed, i0, j0, k_flip, x0, y0, z0 - z_sign));
+            const ab = x_flip0 + y_flip0 + a0;
+            const mb = andB(notB(ma), ab > zero);
+            value = addIf(mb, value, ab, gradCoord3(seed, i_flip, j_flip, k0, x0 - x_sign, y0 - y_sign, z0));
+            const ac = z_flip1 + a1;
+            const skip_d = andB(notB(ma), ac > zero);
+            value = addIf(skip_d, value, ac, gradCoord3(seed2, i1, j1, k_far, x1, y1, z_sign + z1));
+
+            const a5 = y_flip1 + z_flip1 + a1;
+            const m5 = andB(notB(skip5), a5 > zero);
+            value = addIf(m5, value, a5, gradCoord3(seed2, i1, j_far, k_far, x1, y_sign + y1, z_sign + z1));
+            const a9 = x_flip1 + z_flip1 + a1;
+            const m9 = andB(notB(skip9), a9 > zero);
+            value = addIf(m9, value, a9, gradCoord3(seed2, i_far, j1, k_far, x_sign + x1, y1, z_sign + z1));
+            const ad = x_flip1 + y_flip1 + a1;
+            const md = andB(notB(skip_d), ad > zero);
+            value = addIf(md, value, ad, gradCoord3(seed2, i_far, j_far, k1, x_sign + x1, y_sign + y1, z1));
+
+            return value * sf(9.046026385208288);
+        }
+
+        fn cellularResult(
+            comptime distance_func: FnlGenerator.CellularDistanceFunc,
+            gen: *const FnlGenerator,
+            distance0_in: F,
+            distance1_in: F,
+            closest_hash: I,
+        ) F {
+            var distance0 = distance0_in;
+            var distance1 = distance1_in;
+            const return_type = gen.cellular_return_type;
+            if (distance_func == .euclidean and
+                @enumToInt(return_type) >= @enumToInt(FnlGenerator.CellularReturnType.distance))
+            {
+                distance0 = fastSqrt(distance0);
+                if (@enumToInt(return_type) >= @enumToInt(FnlGenerator.CellularReturnType.distance2))
+                    distance1 = fastSqrt(distance1);
+            }
+            return switch (return_type) {
+                .cellvalue => toFloat(closest_hash) * sf(1.0 / 2147483648.0),
+                .distance => distance0 - one,
+                .distance2 => distance1 - one,
+                .distance2add => (distance1 + distance0) * sf(0.5) - one,
+                .distance2sub => distance1 - distance0 - one,
+                .distance2mul => distance1 * distance0 * sf(0.5) - one,
+                .distance2div => distance0 / distance1 - one,
+            };
+        }
+
+        fn cellular2(
+            comptime distance_func: FnlGenerator.CellularDistanceFunc,
+            gen: *const FnlGenerator,
+            seed: i32,
+            x: F,
+            y: F,
+        ) F {
+            const xr = fastRound(x);
+            const yr = fastRound(y);
+
+            var distance0 = sf(std.math.f32_max);
+            var distance1 = sf(std.math.f32_max);
+            var closest_hash = si(0);
+
+            const jitter = sf(0.5 * gen.cellular_jitter_mod);
+
+            var xp = (xr -% si(1)) *% si(prime_x);
+            const yp_base = (yr -% si(1)) *% si(prime_y);
+
+            comptime var dx = -1;
+            inline while (dx <= 1) : (dx += 1) {
+                const xf = toFloat(xr +% si(dx));
+                var yp = yp_base;
+                comptime var dy = -1;
+                inline while (dy <= 1) : (dy += 1) {
+                    const hash = hash2(seed, xp, yp);
+                    const idx = hash & si(255 << 1);
+
+                    const vx = (xf - x) + gather(&rand_vecs2, idx) * jitter;
+                    const vy = (toFloat(yr +% si(dy)) - y) + gather(&rand_vecs2, idx | si(1)) * jitter;
+
+                    const new_distance = switch (distance_func) {
+                        .euclidean, .euclideansq => vx * vx + vy * vy,
+                        .manhattan => fastAbs(vx) + fastAbs(vy),
+                        .hybrid => (fastAbs(vx) + fastAbs(vy)) + (vx * vx + vy * vy),
+                    };
+
+                    distance1 = fastMax(fastMin(distance1, new_distance), distance0);
+                    const closer = new_distance < distance0;
+                    distance0 = selectF(closer, new_distance, distance0);
+                    closest_hash = selectI(closer, hash, closest_hash);
+                    yp +%= si(prime_y);
+                }
+                xp +%= si(prime_x);
+            }
+
+            return cellularResult(distance_func, gen, distance0, distance1, closest_hash);
+        }
+
+        fn cellular3(
+            comptime distance_func: FnlGenerator.CellularDistanceFunc,
+            gen: *const FnlGenerator,
+            seed: i32,
+            x: F,
+            y: F,
+            z: F,
+        ) F {
+            const xr = fastRound(x);
+            const yr = fastRound(y);
+            const zr = fastRound(z);
+
+            var distance0 = sf(std.math.f32_max);
+            var distance1 = sf(std.math.f32_max);
+            var closest_hash = si(0);
+
+            const jitter = sf(0.39614353 * gen.cellular_jitter_mod);
+
+            var xp = (xr -% si(1)) *% si(prime_x);
+            const yp_base = (yr -% si(1)) *% si(prime_y);
+            const zp_base = (zr -% si(1)) *% si(prime_z);
+
+            comptime var dx = -1;
+            inline while (dx <= 1) : (dx += 1) {
+                const xf = toFloat(xr +% si(dx));
+                var yp = yp_base;
+                comptime var dy = -1;
+                inline while (dy <= 1) : (dy += 1) {
+                    const yf = toFloat(yr +% si(dy));
+                    var zp = zp_base;
+                    comptime var dz = -1;
+                    inline while (dz <= 1) : (dz += 1) {
+                        const hash = hash3(seed, xp, yp, zp);
+                        const idx = hash & si(255 << 2);
+
+                        const vx = (xf - x) + gather(&rand_vecs3, idx) * jitter;
+                        const vy = (yf - y) + gather(&rand_vecs3, idx | si(1)) * jitter;
+                        const vz = (toFloat(zr +% si(dz)) - z) + gather(&rand_vecs3, idx | si(2)) * jitter;
+
+                        const new_distance = switch (distance_func) {
+                            .euclidean, .euclideansq => vx * vx + vy * vy + vz * vz,
+                            .manhattan => fastAbs(vx) + fastAbs(vy) + fastAbs(vz),
+                            .hybrid => (fastAbs(vx) + fastAbs(vy) + fastAbs(vz)) + (vx * vx + vy * vy + vz * vz),
+                        };
+
+                        distance1 = fastMax(fastMin(distance1, new_distance), distance0);
+                        const closer = new_distance < distance0;
+                        distance0 = selectF(closer, new_distance, distance0);
+                        closest_hash = selectI(closer, hash, closest_hash);
+                        zp +%= si(prime_z);
+                    }
+                    yp +%= si(prime_y);
+                }
+                xp +%= si(prime_x);
+            }
+
+            return cellularResult(distance_func, gen, distance0, distance1, closest_hash);
+        }
+
+        fn perlin2(seed: i32, x: F, y: F) F {
+            var x0 = fastFloor(x);
+            var y0 = fastFloor(y);
+
+            const xd0 = x - toFloat(x0);
+            const yd0 = y - toFloat(y0);
+            const xd1 = xd0 - one;
+            const yd1 = yd0 - one;
+
+            const xs = interpQuintic(xd0);
+            const ys = interpQuintic(yd0);
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+
+            const xf0 = lerp(gradCoord2(seed, x0, y0, xd0, yd0), gradCoord2(seed, x1, y0, xd1, yd0), xs);
+            const xf1 = lerp(gradCoord2(seed, x0, y1, xd0, yd1), gradCoord2(seed, x1, y1, xd1, yd1), xs);
+
+            return lerp(xf0, xf1, ys) * sf(1.4247691104677813);
+        }
+
+        fn perlin3(seed: i32, x: F, y: F, z: F) F {
+            var x0 = fastFloor(x);
+            var y0 = fastFloor(y);
+            var z0 = fastFloor(z);
+
+            const xd0 = x - toFloat(x0);
+            const yd0 = y - toFloat(y0);
+            const zd0 = z - toFloat(z0);
+            const xd1 = xd0 - one;
+            const yd1 = yd0 - one;
+            const zd1 = zd0 - one;
+
+            const xs = interpQuintic(xd0);
+            const ys = interpQuintic(yd0);
+            const zs = interpQuintic(zd0);
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            z0 *%= si(prime_z);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+            const z1 = z0 +% si(prime_z);
+
+            const xf00 = lerp(
+                gradCoord3(seed, x0, y0, z0, xd0, yd0, zd0),
+                gradCoord3(seed, x1, y0, z0, xd1, yd0, zd0),
+                xs,
+            );
+            const xf10 = lerp(
+                gradCoord3(seed, x0, y1, z0, xd0, yd1, zd0),
+                gradCoord3(seed, x1, y1, z0, xd1, yd1, zd0),
+                xs,
+            );
+            const xf01 = lerp(
+                gradCoord3(seed, x0, y0, z1, xd0, yd0, zd1),
+                gradCoord3(seed, x1, y0, z1, xd1, yd0, zd1),
+                xs,
+            );
+            const xf11 = lerp(
+                gradCoord3(seed, x0, y1, z1, xd0, yd1, zd1),
+                gradCoord3(seed, x1, y1, z1, xd1, yd1, zd1),
+                xs,
+            );
+
+            const yf0 = lerp(xf00, xf10, ys);
+            const yf1 = lerp(xf01, xf11, ys);
+
+            return lerp(yf0, yf1, zs) * sf(0.964921414852142333984375);
+        }
+
+        /// `perlin2()` and its gradient.
+        fn perlin2Deriv(seed: i32, x: F, y: F) Dual(2) {
+            var x0 = fastFloor(x);
+            var y0 = fastFloor(y);
+
+            const xd0 = x - toFloat(x0);
+            const yd0 = y - toFloat(y0);
+            const xd1 = xd0 - one;
+            const yd1 = yd0 - one;
+
+            const xs = interpQuintic(xd0);
+            const ys = interpQuintic(yd0);
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+
+            const dxs = interpQuinticDeriv(xd0);
+            const xf0 = lerpDual(2, gradDual2(seed, x0, y0, xd0, yd0), gradDual2(seed, x1, y0, xd1, yd0), xs, 0, dxs);
+            const xf1 = lerpDual(2, gradDual2(seed, x0, y1, xd0, yd1), gradDual2(seed, x1, y1, xd1, yd1), xs, 0, dxs);
+
+            return scaleDual(2, lerpDual(2, xf0, xf1, ys, 1, interpQuinticDeriv(yd0)), 1.4247691104677813);
+        }
+
+        /// `perlin3()` and its gradient.
+        fn perlin3Deriv(seed: i32, x: F, y: F, z: F) Dual(3) {
+            var x0 = fastFloor(x);
+            var y0 = fastFloor(y);
+            var z0 = fastFloor(z);
+
+            const xd0 = x - toFloat(x0);
+            const yd0 = y - toFloat(y0);
+            const zd0 = z - toFloat(z0);
+            const xd1 = xd0 - one;
+            const yd1 = yd0 - one;
+            const zd1 = zd0 - one;
+
+            const xs = interpQuintic(xd0);
+            const ys = interpQuintic(yd0);
+            const zs = interpQuintic(zd0);
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            z0 *%= si(prime_z);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+            const z1 = z0 +% si(prime_z);
+
+            const dxs = interpQuinticDeriv(xd0);
+            const xf00 = lerpDual(
+                3,
+                gradDual3(seed, x0, y0, z0, xd0, yd0, zd0),
+                gradDual3(seed, x1, y0, z0, xd1, yd0, zd0),
+                xs,
+                0,
+                dxs,
+            );
+            const xf10 = lerpDual(
+                3,
+                gradDual3(seed, x0, y1, z0, xd0, yd1, zd0),
+                gradDual3(seed, x1, y1, z0, xd1, yd1, zd0),
+                xs,
+                0,
+                dxs,
+            );
+            const xf01 = lerpDual(
+                3,
+                gradDual3(seed, x0, y0, z1, xd0, yd0, zd1),
+                gradDual3(seed, x1, y0, z1, xd1, yd0, zd1),
+                xs,
+                0,
+                dxs,
+            );
+            const xf11 = lerpDual(
+                3,
+                gradDual3(seed, x0, y1, z1, xd0, yd1, zd1),
+                gradDual3(seed, x1, y1, z1, xd1, yd1, zd1),
+                xs,
+                0,
+                dxs,
+            );
+
+            const dys = interpQuinticDeriv(yd0);
+            const yf0 = lerpDual(3, xf00, xf10, ys, 1, dys);
+            const yf1 = lerpDual(3, xf01, xf11, ys, 1, dys);
+
+            return scaleDual(3, lerpDual(3, yf0, yf1, zs, 2, interpQuinticDeriv(zd0)), 0.964921414852142333984375);
+        }
+
+        fn valueCubic2(seed: i32, x: F, y: F) F {
+            var x1 = fastFloor(x);
+            var y1 = fastFloor(y);
+
+            const xs = x - toFloat(x1);
+            const ys = y - toFloat(y1);
+
+            x1 *%= si(prime_x);
+            y1 *%= si(prime_y);
+            const xp = [4]I{ x1 -% si(prime_x), x1, x1 +% si(prime_x), x1 +% si(prime_x2) };
+            const yp = [4]I{ y1 -% si(prime_y), y1, y1 +% si(prime_y), y1 +% si(prime_y2) };
+
+            var rows: [4]F = undefined;
+            for (rows) |*row, r| {
+                row.* = cubicLerp(
+                    valCoord2(seed, xp[0], yp[r]),
+                    valCoord2(seed, xp[1], yp[r]),
+                    valCoord2(seed, xp[2], yp[r]),
+                    valCoord2(seed, xp[3], yp[r]),
+                    xs,
+                );
+            }
+            return cubicLerp(rows[0], rows[1], rows[2], rows[3], ys) * sf(value_cubic2_scale);
+        }
+
+        fn valueCubic3(seed: i32, x: F, y: F, z: F) F {
+            var x1 = fastFloor(x);
+            var y1 = fastFloor(y);
+            var z1 = fastFloor(z);
+
+            const xs = x - toFloat(x1);
+            const ys = y - toFloat(y1);
+            const zs = z - toFloat(z1);
+
+            x1 *%= si(prime_x);
+            y1 *%= si(prime_y);
+            z1 *%= si(prime_z);
+            const xp = [4]I{ x1 -% si(prime_x), x1, x1 +% si(prime_x), x1 +% si(prime_x2) };
+            const yp = [4]I{ y1 -% si(prime_y), y1, y1 +% si(prime_y), y1 +% si(prime_y2) };
+            const zp = [4]I{ z1 -% si(prime_z), z1, z1 +% si(prime_z), z1 +% si(prime_z2) };
+
+            var slices: [4]F = undefined;
+            for (slices) |*slice, s| {
+                var rows: [4]F = undefined;
+                for (rows) |*row, r| {
+                    row.* = cubicLerp(
+                        valCoord3(seed, xp[0], yp[r], zp[s]),
+                        valCoord3(seed, xp[1], yp[r], zp[s]),
+                        valCoord3(seed, xp[2], yp[r], zp[s]),
+                        valCoord3(seed, xp[3], yp[r], zp[s]),
+                        xs,
+                    );
+                }
+                slice.* = cubicLerp(rows[0], rows[1], rows[2], rows[3], ys);
+            }
+            return cubicLerp(slices[0], slices[1], slices[2], slices[3], zs) * sf(value_cubic3_scale);
+        }
+
+        fn value2(seed: i32, x: F, y: F) F {
+            var x0 = fastFloor(x);
+            var y0 = fastFloor(y);
+
+            const xs = interpHermite(x - toFloat(x0));
+            const ys = interpHermite(y - toFloat(y0));
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+
+            const xf0 = lerp(valCoord2(seed, x0, y0), valCoord2(seed, x1, y0), xs);
+            const xf1 = lerp(valCoord2(seed, x0, y1), valCoord2(seed, x1, y1), xs);
+
+            return lerp(xf0, xf1, ys);
+        }
+
+        fn value3(seed: i32, x: F, y: F, z: F) F {
+            var x0 = fastFloor(x);
+            var y0 = fastFloor(y);
+            var z0 = fastFloor(z);
+
+            const xs = interpHermite(x - toFloat(x0));
+            const ys = interpHermite(y - toFloat(y0));
+            const zs = interpHermite(z - toFloat(z0));
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            z0 *%= si(prime_z);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+            const z1 = z0 +% si(prime_z);
+
+            const xf00 = lerp(valCoord3(seed, x0, y0, z0), valCoord3(seed, x1, y0, z0), xs);
+            const xf10 = lerp(valCoord3(seed, x0, y1, z0), valCoord3(seed, x1, y1, z0), xs);
+            const xf01 = lerp(valCoord3(seed, x0, y0, z1), valCoord3(seed, x1, y0, z1), xs);
+            const xf11 = lerp(valCoord3(seed, x0, y1, z1), valCoord3(seed, x1, y1, z1), xs);
+
+            const yf0 = lerp(xf00, xf10, ys);
+            const yf1 = lerp(xf01, xf11, ys);
+
+            return lerp(yf0, yf1, zs);
+        }
+
+        /// `value2()` and its gradient.
+        fn value2Deriv(seed: i32, x: F, y: F) Dual(2) {
+            var x0 = fastFloor(x);
+            var y0 = fastFloor(y);
+
+            const xd = x - toFloat(x0);
+            const yd = y - toFloat(y0);
+            const xs = interpHermite(xd);
+            const ys = interpHermite(yd);
+            const dxs = interpHermiteDeriv(xd);
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+
+            const v00 = constDual(2, valCoord2(seed, x0, y0));
+            const v10 = constDual(2, valCoord2(seed, x1, y0));
+            const v01 = constDual(2, valCoord2(seed, x0, y1));
+            const v11 = constDual(2, valCoord2(seed, x1, y1));
+            const xf0 = lerpDual(2, v00, v10, xs, 0, dxs);
+            const xf1 = lerpDual(2, v01, v11, xs, 0, dxs);
+
+            return lerpDual(2, xf0, xf1, ys, 1, interpHermiteDeriv(yd));
+        }
+
+        /// `value3()` and its gradient.
+        fn value3Deriv(seed: i32, x: F, y: F, z: F) Dual(3) {
+            var x0 = fastFloor(x);
+            var y0 = fastFloor(y);
+            var z0 = fastFloor(z);
+
+            const xd = x - toFloat(x0);
+            const yd = y - toFloat(y0);
+            const zd = z - toFloat(z0);
+            const xs = interpHermite(xd);
+            const ys = interpHermite(yd);
+            const zs = interpHermite(zd);
+            const dxs = interpHermiteDeriv(xd);
+            const dys = interpHermiteDeriv(yd);
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            z0 *%= si(prime_z);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+            const z1 = z0 +% si(prime_z);
+
+            var yf: [2]Dual(3) = undefined;
+            for (yf) |*slice, s| {
+                const zp = if (s == 0) z0 else z1;
+                const v00 = constDual(3, valCoord3(seed, x0, y0, zp));
+                const v10 = constDual(3, valCoord3(seed, x1, y0, zp));
+                const v01 = constDual(3, valCoord3(seed, x0, y1, zp));
+                const v11 = constDual(3, valCoord3(seed, x1, y1, zp));
+                const xf0 = lerpDual(3, v00, v10, xs, 0, dxs);
+                const xf1 = lerpDual(3, v01, v11, xs, 0, dxs);
+                slice.* = lerpDual(3, xf0, xf1, ys, 1, dys);
+            }
+
+            return lerpDual(3, yf[0], yf[1], zs, 2, interpHermiteDeriv(zd));
+        }
+
+        /// Adds the warp vector of a simplex vertex with attenuation `a` to `v` where `mask` is set.
+        inline fn warpVertex(comptime dims: u32, mask: B, a: F, out: [dims]F, v: *[dims]F) void {
+            const aaaa = (a * a) * (a * a);
+            for (v) |*c, k| c.* = selectF(mask, c.* + aaaa * out[k], c.*);
+        }
+
+        fn warpSimplex2(comptime grad_only: bool, seed: i32, warp_amp: f32, frequency: f32, ps: [2]F, p: *[2]F) void {
+            const x = ps[0] * sf(frequency);
+            const y = ps[1] * sf(frequency);
+
+            var i = fastFloor(x);
+            var j = fastFloor(y);
+            const xi = x - toFloat(i);
+            const yi = y - toFloat(j);
+
+            const t = (xi + yi) * sf(g2);
+            const x0 = xi - t;
+            const y0 = yi - t;
+
+            i *%= si(prime_x);
+            j *%= si(prime_y);
+
+            var v = [2]F{ zero, zero };
+
+            const a = sf(0.5) - x0 * x0 - y0 * y0;
+            const out0 = if (grad_only) gradCoordOut2(seed, i, j) else gradCoordDual2(seed, i, j, x0, y0);
+            warpVertex(2, a > zero, a, out0, &v);
+
+            const c = sf(g2_c0) * t + (sf(g2_c1) + a);
+            const x2 = x0 + sf(2 * g2 - 1);
+            const y2 = y0 + sf(2 * g2 - 1);
+            const i2 = i +% si(prime_x);
+            const j2 = j +% si(prime_y);
+            const out2 = if (grad_only) gradCoordOut2(seed, i2, j2) else gradCoordDual2(seed, i2, j2, x2, y2);
+            warpVertex(2, c > zero, c, out2, &v);
+
+            const upper = y0 > x0;
+            const x1 = selectF(upper, x0 + sf(g2), x0 + sf(g2 - 1));
+            const y1 = selectF(upper, y0 + sf(g2 - 1), y0 + sf(g2));
+            const b = sf(0.5) - x1 * x1 - y1 * y1;
+            const i1 = selectI(upper, i, i +% si(prime_x));
+            const j1 = selectI(upper, j +% si(prime_y), j);
+            const out1 = if (grad_only) gradCoordOut2(seed, i1, j1) else gradCoordDual2(seed, i1, j1, x1, y1);
+            warpVertex(2, b > zero, b, out1, &v);
+
+            p[0] = p[0] + v[0] * sf(warp_amp);
+            p[1] = p[1] + v[1] * sf(warp_amp);
+        }
+
+        fn warpSimplex3(
+            comptime grad_only: bool,
+            seed_in: i32,
+            warp_amp: f32,
+            frequency: f32,
+            ps: [3]F,
+            p: *[3]F,
+        ) void {
+            var seed = seed_in;
+            const x = ps[0] * sf(frequency);
+            const y = ps[1] * sf(frequency);
+            const z = ps[2] * sf(frequency);
+
+            var i = fastRound(x);
+            var j = fastRound(y);
+            var k = fastRound(z);
+            var x0 = x - toFloat(i);
+            var y0 = y - toFloat(j);
+            var z0 = z - toFloat(k);
+
+            var x_sign = toInt(sf(-1) - x0) | si(1);
+            var y_sign = toInt(sf(-1) - y0) | si(1);
+            var z_sign = toInt(sf(-1) - z0) | si(1);
+
+            var ax0 = toFloat(x_sign) * -x0;
+            var ay0 = toFloat(y_sign) * -y0;
+            var az0 = toFloat(z_sign) * -z0;
+
+            i *%= si(prime_x);
+            j *%= si(prime_y);
+            k *%= si(prime_z);
+
+            var v = [3]F{ zero, zero, zero };
+            var a = (sf(0.6) - x0 * x0) - (y0 * y0 + z0 * z0);
+
+            comptime var l = 0;
+            inline while (true) : (l += 1) {
+                const out0 = if (grad_only)
+                    gradCoordOut3(seed, i, j, k)
+                else
+                    gradCoordDual3(seed, i, j, k, x0, y0, z0);
+                warpVertex(3, a > zero, a, out0, &v);
+
+                const xs = toFloat(x_sign);
+                const ys = toFloat(y_sign);
+                const zs = toFloat(z_sign);
+                const use_x = andB(ax0 >= ay0, ax0 >= az0);
+                const use_y = andB(notB(use_x), andB(ay0 > ax0, ay0 >= az0));
+                const use_z = notB(orB(use_x, use_y));
+
+                const x1 = selectF(use_x, x0 + xs, x0);
+                const y1 = selectF(use_y, y0 + ys, y0);
+                const z1 = selectF(use_z, z0 + zs, z0);
+                const b1 = a + one;
+                const b = selectF(
+                    use_x,
+                    b1 - xs * sf(2) * x1,
+                    selectF(use_y, b1 - ys * sf(2) * y1, b1 - zs * sf(2) * z1),
+                );
+                const i1 = selectI(use_x, i -% x_sign *% si(prime_x), i);
+                const j1 = selectI(use_y, j -% y_sign *% si(prime_y), j);
+                const k1 = selectI(use_z, k -% z_sign *% si(prime_z), k);
+
+                const out1 = if (grad_only)
+                    gradCoordOut3(seed, i1, j1, k1)
+                else
+                    gradCoordDual3(seed, i1, j1, k1, x1, y1, z1);
+                warpVertex(3, b > zero, b, out1, &v);
+
+                if (l == 1) break;
+
+                ax0 = sf(0.5) - ax0;
+                ay0 = sf(0.5) - ay0;
+                az0 = sf(0.5) - az0;
+
+                x0 = xs * ax0;
+                y0 = ys * ay0;
+                z0 = zs * az0;
+
+                a = a + ((sf(0.75) - ax0) - (ay0 + az0));
+
+                i +%= shr(x_sign, 1) & si(prime_x);
+                j +%= shr(y_sign, 1) & si(prime_y);
+                k +%= shr(z_sign, 1) & si(prime_z);
+
+                x_sign = si(0) -% x_sign;
+                y_sign = si(0) -% y_sign;
+                z_sign = si(0) -% z_sign;
+
+                seed +%= 1293373;
+            }
+
+            for (p) |*c, axis| c.* = c.* + v[axis] * sf(warp_amp);
+        }
+
+        fn warpBasicGrid2(seed: i32, warp_amp: f32, frequency: f32, ps: [2]F, p: *[2]F) void {
+            const xf = ps[0] * sf(frequency);
+            const yf = ps[1] * sf(frequency);
+
+            var x0 = fastFloor(xf);
+            var y0 = fastFloor(yf);
+
+            const xs = interpHermite(xf - toFloat(x0));
+            const ys = interpHermite(yf - toFloat(y0));
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+
+            const v00 = gradCoordOut2(seed, x0, y0);
+            const v10 = gradCoordOut2(seed, x1, y0);
+            const v01 = gradCoordOut2(seed, x0, y1);
+            const v11 = gradCoordOut2(seed, x1, y1);
+
+            for (p) |*c, axis| {
+                const l0x = lerp(v00[axis], v10[axis], xs);
+                const l1x = lerp(v01[axis], v11[axis], xs);
+                c.* = c.* + lerp(l0x, l1x, ys) * sf(warp_amp);
+            }
+        }
+
+        fn warpBasicGrid3(seed: i32, warp_amp: f32, frequency: f32, ps: [3]F, p: *[3]F) void {
+            const xf = ps[0] * sf(frequency);
+            const yf = ps[1] * sf(frequency);
+            const zf = ps[2] * sf(frequency);
+
+            var x0 = fastFloor(xf);
+            var y0 = fastFloor(yf);
+            var z0 = fastFloor(zf);
+
+            const xs = interpHermite(xf - toFloat(x0));
+            const ys = interpHermite(yf - toFloat(y0));
+            const zs = interpHermite(zf - toFloat(z0));
+
+            x0 *%= si(prime_x);
+            y0 *%= si(prime_y);
+            z0 *%= si(prime_z);
+            const x1 = x0 +% si(prime_x);
+            const y1 = y0 +% si(prime_y);
+            const z1 = z0 +% si(prime_z);
+
+            var layers: [2][3]F = undefined;
+            for (layers) |*layer, s| {
+                const zp = if (s == 0) z0 else z1;
+                const v00 = gradCoordOut3(seed, x0, y0, zp);
+                const v10 = gradCoordOut3(seed, x1, y0, zp);
+                const v01 = gradCoordOut3(seed, x0, y1, zp);
+                const v11 = gradCoordOut3(seed, x1, y1, zp);
+                for (layer) |*c, axis| {
+                    const l0x = lerp(v00[axis], v10[axis], xs);
+                    const l1x = lerp(v01[axis], v11[axis], xs);
+                    c.* = lerp(l0x, l1x, ys);
+                }
+            }
+
+            for (p) |*c, axis| c.* = c.* + lerp(layers[0][axis], layers[1][axis], zs) * sf(warp_amp);
+        }
+    };
+}
+
+// Lookup tables of FastNoiseLite.
+const gradients2 = [256]f32{
+    0.13052619, 0.9914449, 0.38268343, 0.9238795, 0.6087614, 0.7933533, 0.7933533, 0.6087614,
+    0.9238795, 0.38268343, 0.9914449, 0.13052619, 0.9914449, -0.13052619, 0.9238795, -0.38268343,
+    0.7933533, -0.6087614, 0.6087614, -0.7933533, 0.38268343, -0.9238795, 0.13052619, -0.9914449,
+    -0.13052619, -0.9914449, -0.38268343, -0.9238795, -0.6087614, -0.7933533, -0.7933533, -0.6087614,
+    -0.9238795, -0.38268343, -0.9914449, -0.13052619, -0.9914449, 0.13052619, -0.9238795, 0.38268343,
+    -0.7933533, 0.6087614, -0.6087614, 0.7933533, -0.38268343, 0.9238795, -0.13052619, 0.9914449,
+    0.13052619, 0.9914449, 0.38268343, 0.9238795, 0.6087614, 0.7933533, 0.7933533, 0.6087614,
+    0.9238795, 0.38268343, 0.9914449, 0.13052619, 0.9914449, -0.13052619, 0.9238795, -0.38268343,
+    0.7933533, -0.6087614, 0.6087614, -0.7933533, 0.38268343, -0.9238795, 0.13052619, -0.9914449,
+    -0.13052619, -0.9914449, -0.38268343, -0.9238795, -0.6087614, -0.7933533, -0.7933533, -0.6087614,
+    -0.9238795, -0.38268343, -0.9914449, -0.13052619, -0.9914449, 0.13052619, -0.9238795, 0.38268343,
+    -0.7933533, 0.6087614, -0.6087614, 0.7933533, -0.38268343, 0.9238795, -0.13052619, 0.9914449,
+    0.13052619, 0.9914449, 0.38268343, 0.9238795, 0.6087614, 0.7933533, 0.7933533, 0.6087614,
+    0.9238795, 0.38268343, 0.9914449, 0.13052619, 0.9914449, -0.13052619, 0.9238795, -0.38268343,
+    0.7933533, -0.6087614, 0.6087614, -0.7933533, 0.38268343, -0.9238795, 0.13052619, -0.9914449,
+    -0.13052619, -0.9914449, -0.38268343, -0.9238795, -0.6087614, -0.7933533, -0.7933533, -0.6087614,
+    -0.9238795, -0.38268343, -0.9914449, -0.13052619, -0.9914449, 0.13052619, -0.9238795, 0.38268343,
+    -0.7933533, 0.6087614, -0.6087614, 0.7933533, -0.38268343, 0.9238795, -0.13052619, 0.9914449,
+    0.13052619, 0.9914449, 0.38268343, 0.9238795, 0.6087614, 0.7933533, 0.7933533, 0.6087614,
+    0.9238795, 0.38268343, 0.9914449, 0.13052619, 0.9914449, -0.13052619, 0.9238795, -0.38268343,
+    0.7933533, -0.6087614, 0.6087614, -0.7933533, 0.38268343, -0.9238795, 0.13052619, -0.9914449,
+    -0.13052619, -0.9914449, -0.38268343, -0.9238795, -0.6087614, -0.7933533, -0.7933533, -0.6087614,
+    -0.9238795, -0.38268343, -0.9914449, -0.13052619, -0.9914449, 0.13052619, -0.9238795, 0.38268343,
+    -0.7933533, 0.6087614, -0.6087614, 0.7933533, -0.38268343, 0.9238795, -0.13052619, 0.9914449,
+    0.13052619, 0.9914449, 0.38268343, 0.9238795, 0.6087614, 0.7933533, 0.7933533, 0.6087614,
+    0.9238795, 0.38268343, 0.9914449, 0.13052619, 0.9914449, -0.13052619, 0.9238795, -0.38268343,
+    0.7933533, -0.6087614, 0.6087614, -0.7933533, 0.38268343, -0.9238795, 0.13052619, -0.9914449,
+    -0.13052619, -0.9914449, -0.38268343, -0.9238795, -0.6087614, -0.7933533, -0.7933533, -0.6087614,
+    -0.9238795, -0.38268343, -0.9914449, -0.13052619, -0.9914449, 0.13052619, -0.9238795, 0.38268343,
+    -0.7933533, 0.6087614, -0.6087614, 0.7933533, -0.38268343, 0.9238795, -0.13052619, 0.9914449,
+    0.38268343, 0.9238795, 0.9238795, 0.38268343, 0.9238795, -0.38268343, 0.38268343, -0.9238795,
+    -0.38268343, -0.9238795, -0.9238795, -0.38268343, -0.9238795, 0.38268343, -0.38268343, 0.9238795,
+};
+
+const rand_vecs2 = [512]f32{
+    -0.2700222, -0.9628541, 0.38630927, -0.9223693, 0.04444859, -0.9990117, -0.59925234, -0.80056024,
+    -0.781928, 0.62336874, 0.9464672, 0.32279992, -0.6514147, -0.7587219, 0.93784726, 0.34704837,
+    -0.8497876, -0.52712524, -0.87904257, 0.47674325, -0.8923003, -0.45144236, -0.37984443, -0.9250504,
+    -0.9951651, 0.09821638, 0.7724398, -0.635088, 0.75732833, -0.6530343, -0.9928005, -0.119780056,
+    -0.05326657, 0.99858034, 0.97542536, -0.22033007, -0.76650184, 0.64224213, 0.9916367, 0.12906061,
+    -0.99469686, 0.10285038, -0.53792053, -0.8429955, 0.50228155, -0.86470413, 0.45598215, -0.8899889,
+    -0.8659131, -0.50019443, 0.08794584, -0.9961253, -0.5051685, 0.8630207, 0.7753185, -0.6315704,
+    -0.69219446, 0.72171104, -0.51916593, -0.85467345, 0.8978623, -0.4402764, -0.17067741, 0.98532695,
+    -0.935343, -0.35374206, -0.99924046, 0.038967468, -0.2882064, -0.9575683, -0.96638113, 0.2571138,
+    -0.87597144, -0.48236302, -0.8303123, -0.55729836, 0.051101338, -0.99869347, -0.85583735, -0.51724505,
+    0.098870255, 0.9951003, 0.9189016, 0.39448678, -0.24393758, -0.96979094, -0.81214094, -0.5834613,
+    -0.99104315, 0.13354214, 0.8492424, -0.52800316, -0.9717839, -0.23587295, 0.9949457, 0.10041421,
+    0.6241065, -0.7813392, 0.6629103, 0.74869883, -0.7197418, 0.6942418, -0.8143371, -0.58039224,
+    0.10452105, -0.9945227, -0.10659261, -0.99430275, 0.44579968, -0.8951328, 0.105547406, 0.99441427,
+    -0.9927903, 0.11986445, -0.83343667, 0.55261505, 0.9115562, -0.4111756, 0.8285545, -0.55990845,
+    0.7217098, -0.6921958, 0.49404928, -0.8694339, -0.36523214, -0.9309165, -0.9696607, 0.24445485,
+    0.089255095, -0.9960088, 0.5354071, -0.8445941, -0.10535762, 0.9944344, -0.98902845, 0.1477251,
+    0.004856105, 0.9999882, 0.98855984, 0.15082914, 0.92861295, -0.37104982, -0.5832394, -0.8123003,
+    0.30152076, 0.9534596, -0.95751107, 0.28839657, 0.9715802, -0.23671055, 0.2299818, 0.97319496,
+    0.9557638, -0.2941352, 0.7409561, 0.67155343, -0.9971514, -0.07542631, 0.69057107, -0.7232645,
+    -0.2907137, -0.9568101, 0.5912778, -0.80646795, -0.94545925, -0.3257405, 0.66644555, 0.7455537,
+    0.6236135, 0.78173286, 0.9126994, -0.40863165, -0.8191762, 0.57354194, -0.8812746, -0.4726046,
+    0.99533135, 0.09651673, 0.98556507, -0.16929697, -0.8495981, 0.52743065, 0.6174854, -0.78658235,
+    0.85081565, 0.5254643, 0.99850327, -0.0546925, 0.19713716, -0.98037595, 0.66078556, -0.7505747,
+    -0.030974941, 0.9995202, -0.6731661, 0.73949134, -0.71950185, -0.69449055, 0.97275114, 0.2318516,
+    0.9997059, -0.02425069, 0.44217876, -0.89692694, 0.9981351, -0.061043672, -0.9173661, -0.39804456,
+    -0.81500566, -0.579453, -0.87893313, 0.476945, 0.015860584, 0.99987423, -0.8095465, 0.5870558,
+    -0.9165899, -0.39982867, -0.8023543, 0.5968481, -0.5176738, 0.85557806, -0.8154407, -0.57884055,
+    0.40220103, -0.91555136, -0.9052557, -0.4248672, 0.7317446, 0.681579, -0.56476325, -0.825253,
+    -0.8403276, -0.54207885, -0.93142813, 0.36392525, 0.52381986, 0.85182905, 0.7432804, -0.66898,
+    -0.9853716, -0.17041974, 0.46014687, 0.88784283, 0.8258554, 0.56388193, 0.6182366, 0.785992,
+    0.83315027, -0.55304664, 0.15003075, 0.9886813, -0.6623304, -0.7492119, -0.66859865, 0.74362344,
+    0.7025606, 0.7116239, -0.54193896, -0.84041786, -0.33886164, 0.9408362, 0.833153, 0.55304253,
+    -0.29897207, -0.95426184, 0.2638523, 0.9645631, 0.12410874, -0.9922686, -0.7282649, -0.6852957,
+    0.69625, 0.71779937, -0.91835356, 0.395761, -0.6326102, -0.7744703, -0.9331892, -0.35938552,
+    -0.11537793, -0.99332166, 0.9514975, -0.30765656, -0.08987977, -0.9959526, 0.6678497, 0.7442962,
+    0.79524004, -0.6062947, -0.6462007, -0.7631675, -0.27335986, 0.96191186, 0.966959, -0.25493184,
+    -0.9792895, 0.20246519, -0.5369503, -0.84361386, -0.27003646, -0.9628501, -0.6400277, 0.76835185,
+    -0.78545374, -0.6189204, 0.060059056, -0.9981948, -0.024557704, 0.9996984, -0.65983623, 0.7514095,
+    -0.62538946, -0.7803128, -0.6210409, -0.7837782, 0.8348889, 0.55041856, -0.15922752, 0.9872419,
+    0.83676225, 0.54756635, -0.8675754, -0.4973057, -0.20226626, -0.97933054, 0.939919, 0.34139755,
+    0.98774046, -0.1561049, -0.90344554, 0.42870283, 0.12698042, -0.9919052, -0.3819601, 0.92417884,
+    0.9754626, 0.22016525, -0.32040158, -0.94728184, -0.9874761, 0.15776874, 0.025353484, -0.99967855,
+    0.4835131, -0.8753371, -0.28508, -0.9585037, -0.06805516, -0.99768156, -0.7885244, -0.61500347,
+    0.3185392, -0.9479097, 0.8880043, 0.45983514, 0.64769214, -0.76190215, 0.98202413, 0.18875542,
+    0.93572754, -0.35272372, -0.88948953, 0.45695552, 0.7922791, 0.6101588, 0.74838185, 0.66326815,
+    -0.728893, -0.68462765, 0.8729033, -0.48789328, 0.8288346, 0.5594937, 0.08074567, 0.99673474,
+    0.97991484, -0.1994165, -0.5807307, -0.81409574, -0.47000498, -0.8826638, 0.2409493, 0.9705377,
+    0.9437817, -0.33056942, -0.89279985, -0.45045355, -0.80696225, 0.59060305, 0.062589735, 0.99803936,
+    -0.93125975, 0.36435598, 0.57774496, 0.81621736, -0.3360096, -0.9418586, 0.69793206, -0.71616393,
+    -0.0020081573, -0.999998, -0.18272944, -0.98316324, -0.6523912, 0.7578824, -0.43026268, -0.9027037,
+    -0.9985126, -0.054520912, -0.010281022, -0.99994713, -0.49460712, 0.86911666, -0.299935, 0.95395964,
+    0.8165472, 0.5772787, 0.26974604, 0.9629315, -0.7306287, -0.68277496, -0.7590952, -0.65097964,
+    -0.9070538, 0.4210146, -0.5104861, -0.859886, 0.86133504, 0.5080373, 0.50078815, -0.8655699,
+    -0.6541582, 0.7563578, -0.83827555, -0.54524684, 0.6940071, 0.7199682, 0.06950936, 0.9975813,
+    0.17029423, -0.9853933, 0.26959732, 0.9629731, 0.55196124, -0.83386976, 0.2256575, -0.9742067,
+    0.42152628, -0.9068162, 0.48818734, -0.87273884, -0.3683855, -0.92967314, -0.98253906, 0.18605645,
+    0.81256473, 0.582871, 0.3196461, -0.947537, 0.9570914, 0.28978625, -0.6876655, -0.7260276,
+    -0.9988771, -0.04737673, -0.1250179, 0.9921545, -0.82801336, 0.56070834, 0.93248636, -0.36120513,
+    0.63946533, 0.7688199, -0.016238471, -0.99986815, -0.99550146, -0.094746135, -0.8145332, 0.580117,
+    0.4037328, -0.91487694, 0.9944263, 0.10543368, -0.16247116, 0.9867133, -0.9949488, -0.10038388,
+    -0.69953024, 0.714603, 0.5263415, -0.85027325, -0.5395222, 0.8419714, 0.65793705, 0.7530729,
+    0.014267588, -0.9998982, -0.6734384, 0.7392433, 0.6394121, -0.7688642, 0.9211571, 0.38919085,
+    -0.14663722, -0.98919034, -0.7823181, 0.6228791, -0.5039611, -0.8637264, -0.774312, -0.632804,
+};
+
+const gradients3 = [256]f32{
+    0.0, 1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0,
+    1.0, 0.0, 1.0, 0.0, -1.0, 0.0, 1.0, 0.0, 1.0, 0.0, -1.0, 0.0, -1.0, 0.0, -1.0, 0.0,
+    1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0, 0.0,
+    0.0, 1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0,
+    1.0, 0.0, 1.0, 0.0, -1.0, 0.0, 1.0, 0.0, 1.0, 0.0, -1.0, 0.0, -1.0, 0.0, -1.0, 0.0,
+    1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0, 0.0,
+    0.0, 1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0,
+    1.0, 0.0, 1.0, 0.0, -1.0, 0.0, 1.0, 0.0, 1.0, 0.0, -1.0, 0.0, -1.0, 0.0, -1.0, 0.0,
+    1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0, 0.0,
+    0.0, 1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0,
+    1.0, 0.0, 1.0, 0.0, -1.0, 0.0, 1.0, 0.0, 1.0, 0.0, -1.0, 0.0, -1.0, 0.0, -1.0, 0.0,
+    1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0, 0.0,
+    0.0, 1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0,
+    1.0, 0.0, 1.0, 0.0, -1.0, 0.0, 1.0, 0.0, 1.0, 0.0, -1.0, 0.0, -1.0, 0.0, -1.0, 0.0,
+    1.0, 1.0, 0.0, 0.0, -1.0, 1.0, 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, -1.0, -1.0, 0.0, 0.0,
+    1.0, 1.0, 0.0, 0.0, 0.0, -1.0, 1.0, 0.0, -1.0, 1.0, 0.0, 0.0, 0.0, -1.0, -1.0, 0.0,
+};
+
+const rand_vecs3 = [1024]f32{
+    -0.7292737, -0.66184396, 0.17355819, 0.0, 0.7902921, -0.5480887, -0.2739291, 0.0,
+    0.7217579, 0.62262124, -0.3023381, 0.0, 0.5656831, -0.8208298, -0.079000026, 0.0,
+    0.76004905, -0.55559796, -0.33709997, 0.0, 0.37139457, 0.50112647, 0.78162545, 0.0,
+    -0.12770624, -0.4254439, -0.8959289, 0.0, -0.2881561, -0.5815839, 0.7607406, 0.0,
+    0.5849561, -0.6628202, -0.4674352, 0.0, 0.33071712, 0.039165374, 0.94291687, 0.0,
+    0.8712122, -0.41133744, -0.26793817, 0.0, 0.580981, 0.7021916, 0.41156778, 0.0,
+    0.5037569, 0.6330057, -0.5878204, 0.0, 0.44937122, 0.6013902, 0.6606023, 0.0,
+    -0.6878404, 0.090188906, -0.7202372, 0.0, -0.59589565, -0.64693505, 0.47579765, 0.0,
+    -0.5127052, 0.1946922, -0.83619875, 0.0, -0.99115074, -0.054102764, -0.12121531, 0.0,
+    -0.21497211, 0.9720882, -0.09397608, 0.0, -0.7518651, -0.54280573, 0.37424695, 0.0,
+    0.5237069, 0.8516377, -0.021078179, 0.0, 0.6333505, 0.19261672, -0.74951047, 0.0,
+    -0.06788242, 0.39983058, 0.9140719, 0.0, -0.55386287, -0.47298968, -0.6852129, 0.0,
+    -0.72614557, -0.5911991, 0.35099334, 0.0, -0.9229275, -0.17828088, 0.34120494, 0.0,
+    -0.6968815, 0.65112746, 0.30064803, 0.0, 0.96080446, -0.20983632, -0.18117249, 0.0,
+    0.068171464, -0.9743405, 0.21450691, 0.0, -0.3577285, -0.6697087, -0.65078455, 0.0,
+    -0.18686211, 0.7648617, -0.61649746, 0.0, -0.65416974, 0.3967915, 0.64390874, 0.0,
+    0.699334, -0.6164538, 0.36182392, 0.0, -0.15466657, 0.6291284, 0.7617583, 0.0,
+    -0.6841613, -0.2580482, -0.68215424, 0.0, 0.5383981, 0.4258655, 0.727163, 0.0,
+    -0.5026988, -0.7939833, -0.3418837, 0.0, 0.32029718, 0.28344154, 0.9039196, 0.0,
+    0.86832273, -0.00037626564, -0.49599952, 0.0, 0.79112005, -0.085110456, 0.60571057, 0.0,
+    -0.04011016, -0.43972486, 0.8972364, 0.0, 0.914512, 0.35793462, -0.18854876, 0.0,
+    -0.96120393, -0.27564842, 0.010246669, 0.0, 0.65103614, -0.28777993, -0.70237786, 0.0,
+    -0.20417863, 0.73652375, 0.6448596, 0.0, -0.7718264, 0.37906268, 0.5104856, 0.0,
+    -0.30600828, -0.7692988, 0.56083715, 0.0, 0.45400733, -0.5024843, 0.73578995, 0.0,
+    0.48167956, 0.6021208, -0.636738, 0.0, 0.69619805, -0.32221973, 0.6414692, 0.0,
+    -0.65321606, -0.6781149, 0.33685157, 0.0, 0.50893015, -0.61546624, -0.60182345, 0.0,
+    -0.16359198, -0.9133605, -0.37284088, 0.0, 0.5240802, -0.8437664, 0.11575059, 0.0,
+    0.5902587, 0.4983818, -0.63498837, 0.0, 0.5863228, 0.49476475, 0.6414308, 0.0,
+    0.6779335, 0.23413453, 0.6968409, 0.0, 0.7177054, -0.68589795, 0.12017863, 0.0,
+    -0.532882, -0.5205125, 0.6671608, 0.0, -0.8654874, -0.07007271, -0.4960054, 0.0,
+    -0.286181, 0.79520893, 0.53454953, 0.0, -0.048495296, 0.98108363, -0.18741156, 0.0,
+    -0.63585216, 0.60583484, 0.47818002, 0.0, 0.62547946, -0.28616196, 0.72586966, 0.0,
+    -0.258526, 0.50619495, -0.8227582, 0.0, 0.021363068, 0.50640166, -0.862033, 0.0,
+    0.20011178, 0.85992634, 0.46955505, 0.0, 0.47435614, 0.6014985, -0.6427953, 0.0,
+    0.6622994, -0.52024746, -0.539168, 0.0, 0.08084973, -0.65327203, 0.7527941, 0.0,
+    -0.6893687, 0.059286036, 0.7219805, 0.0, -0.11218871, -0.96731853, 0.22739525, 0.0,
+    0.7344116, 0.59796685, -0.3210533, 0.0, 0.5789393, -0.24888498, 0.776457, 0.0,
+    0.69881827, 0.35571697, -0.6205791, 0.0, -0.86368454, -0.27487713, -0.4224826, 0.0,
+    -0.4247028, -0.46408808, 0.77733505, 0.0, 0.5257723, -0.84270173, 0.11583299, 0.0,
+    0.93438303, 0.31630248, -0.16395439, 0.0, -0.10168364, -0.8057303, -0.58348876, 0.0,
+    -0.6529239, 0.50602126, -0.5635893, 0.0, -0.24652861, -0.9668206, -0.06694497, 0.0,
+    -0.9776897, -0.20992506, -0.0073688254, 0.0, 0.7736893, 0.57342446, 0.2694238, 0.0,
+    -0.6095088, 0.4995679, 0.6155737, 0.0, 0.5794535, 0.7434547, 0.33392924, 0.0,
+    -0.8226211, 0.081425816, 0.56272936, 0.0, -0.51038545, 0.47036678, 0.719904, 0.0,
+    -0.5764972, -0.072316565, -0.81389266, 0.0, 0.7250629, 0.39499715, -0.56414634, 0.0,
+    -0.1525424, 0.48608407, -0.8604958, 0.0, -0.55509764, -0.49578208, 0.6678823, 0.0,
+    -0.18836144, 0.91458696, 0.35784173, 0.0, 0.76255566, -0.54144084, -0.35404897, 0.0,
+    -0.5870232, -0.3226498, -0.7424964, 0.0, 0.30511242, 0.2262544, -0.9250488, 0.0,
+    0.63795763, 0.57724243, -0.50970703, 0.0, -0.5966776, 0.14548524, -0.7891831, 0.0,
+    -0.65833056, 0.65554875, -0.36994147, 0.0, 0.74348927, 0.23510846, 0.6260573, 0.0,
+    0.5562114, 0.82643604, -0.08736329, 0.0, -0.302894, -0.8251527, 0.47684193, 0.0,
+    0.11293438, -0.9858884, -0.123571075, 0.0, 0.5937653, -0.5896814, 0.5474657, 0.0,
+    0.6757964, -0.58357584, -0.45026484, 0.0, 0.7242303, -0.11527198, 0.67985505, 0.0,
+    -0.9511914, 0.0753624, -0.29925808, 0.0, 0.2539471, -0.18863393, 0.9486454, 0.0,
+    0.5714336, -0.16794509, -0.8032796, 0.0, -0.06778235, 0.39782694, 0.9149532, 0.0,
+    0.6074973, 0.73306, -0.30589226, 0.0, -0.54354787, 0.16758224, 0.8224791, 0.0,
+    -0.5876678, -0.3380045, -0.7351187, 0.0, -0.79675627, 0.040978227, -0.60290986, 0.0,
+    -0.19963509, 0.8706295, 0.4496111, 0.0, -0.027876602, -0.91062325, -0.4122962, 0.0,
+    -0.7797626, -0.6257635, 0.019757755, 0.0, -0.5211233, 0.74016446, -0.42495546, 0.0,
+    0.8575425, 0.4053273, -0.31675017, 0.0, 0.10452233, 0.8390196, -0.53396744, 0.0,
+    0.3501823, 0.9242524, -0.15208502, 0.0, 0.19878499, 0.076476134, 0.9770547, 0.0,
+    0.78459966, 0.6066257, -0.12809642, 0.0, 0.09006737, -0.97509897, -0.20265691, 0.0,
+    -0.82743436, -0.54229957, 0.14582036, 0.0, -0.34857976, -0.41580227, 0.8400004, 0.0,
+    -0.2471779, -0.730482, -0.6366311, 0.0, -0.3700155, 0.8577948, 0.35675845, 0.0,
+    0.59133947, -0.54831195, -0.59133035, 0.0, 0.120487355, -0.7626472, -0.6354935, 0.0,
+    0.6169593, 0.03079648, 0.7863923, 0.0, 0.12581569, -0.664083, -0.73699677, 0.0,
+    -0.6477565, -0.17401473, -0.74170774, 0.0, 0.6217889, -0.7804431, -0.06547655, 0.0,
+    0.6589943, -0.6096988, 0.44044736, 0.0, -0.26898375, -0.6732403, -0.68876356, 0.0,
+    -0.38497752, 0.56765425, 0.7277094, 0.0, 0.57544446, 0.81104714, -0.10519635, 0.0,
+    0.91415936, 0.3832948, 0.13190056, 0.0, -0.10792532, 0.9245494, 0.36545935, 0.0,
+    0.3779771, 0.30431488, 0.87437165, 0.0, -0.21428852, -0.8259286, 0.5214617, 0.0,
+    0.58025444, 0.41480985, -0.7008834, 0.0, -0.19826609, 0.85671616, -0.47615966, 0.0,
+    -0.033815537, 0.37731808, -0.9254661, 0.0, -0.68679225, -0.6656598, 0.29191336, 0.0,
+    0.7731743, -0.28757936, -0.565243, 0.0, -0.09655942, 0.91937083, -0.3813575, 0.0,
+    0.27157024, -0.957791, -0.09426606, 0.0, 0.24510157, -0.6917999, -0.6792188, 0.0,
+    0.97770077, -0.17538553, 0.115503654, 0.0, -0.522474, 0.8521607, 0.029036159, 0.0,
+    -0.77348804, -0.52612925, 0.35341796, 0.0, -0.71344924, -0.26954725, 0.6467878, 0.0,
+    0.16440372, 0.5105846, -0.84396374, 0.0, 0.6494636, 0.055856112, 0.7583384, 0.0,
+    -0.4711971, 0.50172806, -0.7254256, 0.0, -0.63357645, -0.23816863, -0.7361091, 0.0,
+    -0.9021533, -0.2709478, -0.33571818, 0.0, -0.3793711, 0.8722581, 0.3086152, 0.0,
+    -0.68555987, -0.32501432, 0.6514394, 0.0, 0.29009423, -0.7799058, -0.5546101, 0.0,
+    -0.20983194, 0.8503707, 0.48253515, 0.0, -0.45926037, 0.6598504, -0.5947077, 0.0,
+    0.87159455, 0.09616365, -0.48070312, 0.0, -0.6776666, 0.71185046, -0.1844907, 0.0,
+    0.7044378, 0.3124276, 0.637304, 0.0, -0.7052319, -0.24010932, -0.6670798, 0.0,
+    0.081921004, -0.72073364, -0.68835455, 0.0, -0.6993681, -0.5875763, -0.4069869, 0.0,
+    -0.12814544, 0.6419896, 0.75592864, 0.0, -0.6337388, -0.67854714, -0.3714147, 0.0,
+    0.5565052, -0.21688876, -0.8020357, 0.0, -0.57915545, 0.7244372, -0.3738579, 0.0,
+    0.11757791, -0.7096451, 0.69467926, 0.0, -0.613462, 0.13236311, 0.7785528, 0.0,
+    0.69846356, -0.029805163, -0.7150247, 0.0, 0.83180827, -0.3930172, 0.39195976, 0.0,
+    0.14695764, 0.055416517, -0.98758924, 0.0, 0.70886856, -0.2690504, 0.65201014, 0.0,
+    0.27260533, 0.67369765, -0.68688995, 0.0, -0.65912956, 0.30354586, -0.68804663, 0.0,
+    0.48151314, -0.752827, 0.4487723, 0.0, 0.943001, 0.16756473, -0.28752613, 0.0,
+    0.43480295, 0.7695305, -0.46772778, 0.0, 0.39319962, 0.5944736, 0.70142365, 0.0,
+    0.72543365, -0.60392565, 0.33018148, 0.0, 0.75902355, -0.6506083, 0.024333132, 0.0,
+    -0.8552769, -0.3430043, 0.38839358, 0.0, -0.6139747, 0.6981725, 0.36822575, 0.0,
+    -0.74659055, -0.575201, 0.33428493, 0.0, 0.5730066, 0.8105555, -0.12109168, 0.0,
+    -0.92258775, -0.3475211, -0.16751404, 0.0, -0.71058166, -0.47196922, -0.5218417, 0.0,
+    -0.0856461, 0.35830015, 0.9296697, 0.0, -0.8279698, -0.2043157, 0.5222271, 0.0,
+    0.42794403, 0.278166, 0.8599346, 0.0, 0.539908, -0.78571206, -0.3019204, 0.0,
+    0.5678404, -0.5495414, -0.61283076, 0.0, -0.9896071, 0.13656391, -0.045034185, 0.0,
+    -0.6154343, -0.64408755, 0.45430374, 0.0, 0.10742044, -0.79463404, 0.59750944, 0.0,
+    -0.359545, -0.888553, 0.28495783, 0.0, -0.21804053, 0.1529889, 0.9638738, 0.0,
+    -0.7277432, -0.61640507, -0.30072346, 0.0, 0.7249729, -0.0066971947, 0.68874484, 0.0,
+    -0.5553659, -0.5336586, 0.6377908, 0.0, 0.5137558, 0.79762083, -0.316, 0.0,
+    -0.3794025, 0.92456084, -0.035227515, 0.0, 0.82292485, 0.27453658, -0.49741766, 0.0,
+    -0.5404114, 0.60911417, 0.5804614, 0.0, 0.8036582, -0.27030295, 0.5301602, 0.0,
+    0.60443187, 0.68329686, 0.40959433, 0.0, 0.06389989, 0.96582085, -0.2512108, 0.0,
+    0.10871133, 0.74024713, -0.6634878, 0.0, -0.7134277, -0.6926784, 0.10591285, 0.0,
+    0.64588976, -0.57245487, -0.50509584, 0.0, -0.6553931, 0.73814714, 0.15999562, 0.0,
+    0.39109614, 0.91888714, -0.05186756, 0.0, -0.48790225, -0.5904377, 0.64291114, 0.0,
+    0.601479, 0.77074414, -0.21018201, 0.0, -0.5677173, 0.7511361, 0.33688518, 0.0,
+    0.7858574, 0.22667466, 0.5753667, 0.0, -0.45203456, -0.6042227, -0.65618575, 0.0,
+    0.0022721163, 0.4132844, -0.9105992, 0.0, -0.58157516, -0.5162926, 0.6286591, 0.0,
+    -0.03703705, 0.8273786, 0.5604221, 0.0, -0.51196927, 0.79535437, -0.324498, 0.0,
+    -0.26824173, -0.957229, -0.10843876, 0.0, -0.23224828, -0.9679131, -0.09594243, 0.0,
+    0.3554329, -0.8881506, 0.29130062, 0.0, 0.73465204, -0.4371373, 0.5188423, 0.0,
+    0.998512, 0.046590112, -0.028339446, 0.0, -0.37276876, -0.9082481, 0.19007573, 0.0,
+    0.9173738, -0.3483642, 0.19252984, 0.0, 0.2714911, 0.41475296, -0.86848867, 0.0,
+    0.5131763, -0.71163344, 0.4798207, 0.0, -0.87373537, 0.18886992, -0.44823506, 0.0,
+    0.84600437, -0.3725218, 0.38145, 0.0, 0.89787275, -0.17802091, -0.40265754, 0.0,
+    0.21780656, -0.9698323, -0.10947895, 0.0, -0.15180314, -0.7788918, -0.6085091, 0.0,
+    -0.2600385, -0.4755398, -0.840382, 0.0, 0.5723135, -0.7474341, -0.33734185, 0.0,
+    -0.7174141, 0.16990171, -0.67561114, 0.0, -0.6841808, 0.021457076, -0.72899675, 0.0,
+    -0.2007448, 0.06555606, -0.9774477, 0.0, -0.11488037, -0.8044887, 0.5827524, 0.0,
+    -0.787035, 0.03447489, 0.6159443, 0.0, -0.20155965, 0.68598723, 0.69913894, 0.0,
+    -0.085810825, -0.10920836, -0.99030805, 0.0, 0.5532693, 0.73252505, -0.39661077, 0.0,
+    -0.18424894, -0.9777375, -0.100407675, 0.0, 0.07754738, -0.9111506, 0.40471104, 0.0,
+    0.13998385, 0.7601631, -0.63447344, 0.0, 0.44844192, -0.84528923, 0.29049253, 0.0,
+};
+
+const expectApproxEqAbs = std.testing.expectApproxEqAbs;
+
+fn expectGridsMatch(gen: FnlGenerator) !void {
+    const grid = Grid{
+        .origin = .{ -7.3, 3.1, -2.2 },
+        .offset = .{ 3, -9, 0 },
+        .step = 0.37,
+        .width = 13,
+        .height = 5,
+        .depth = 3,
+    };
+    var out2: [13 * 5]f32 = undefined;
+    var out3: [13 * 5 * 3]f32 = undefined;
+    noise2Grid(&gen, grid, &out2);
+    noise3Grid(&gen, grid, &out3);
+
+    var i: u32 = 0;
+    while (i < out3.len) : (i += 1) {
+        const x = grid.origin[0] + @intToFloat(f32, 3 + @intCast(i32, i % grid.width)) * grid.step;
+        const y = grid.origin[1] + @intToFloat(f32, -9 + @intCast(i32, i / grid.width % grid.height)) * grid.step;
+        const z = grid.origin[2] + @intToFloat(f32, i / (grid.width * grid.height)) * grid.step;
+        if (i < out2.len) try expectApproxEqAbs(gen.noise2(x, y), out2[i], 1e-5);
+        try expectApproxEqAbs(gen.noise3(x, y, z), out3[i], 1e-5);
+    }
+}
+
+test "znoise.fnl.batch" {
+    const fractal_types = [_]FnlGenerator.FractalType{ .none, .fbm, .ridged, .pingpong };
+    for ([_]FnlGenerator.NoiseType{ .opensimplex2, .opensimplex2s, .cellular, .perlin, .value_cubic, .value }) |noise| {
+        for (fractal_types) |fractal| {
+            for ([_]FnlGenerator.RotationType3{ .none, .improve_xy_planes, .improve_xz_planes }) |rotation| {
+                try expectGridsMatch(.{
+                    .seed = 4321,
+                    .frequency = 0.11,
+                    .noise_type = noise,
+                    .fractal_type = fractal,
+                    .rotation_type3 = rotation,
+                    .weighted_strength = 0.3,
+                });
+            }
+        }
+    }
+
+    const return_types = [_]FnlGenerator.CellularReturnType{
+        .cellvalue,
+        .distance,
+        .distance2,
+        .distance2add,
+        .distance2sub,
+        .distance2mul,
+        .distance2div,
+    };
+    for ([_]FnlGenerator.CellularDistanceFunc{ .euclidean, .euclideansq, .manhattan, .hybrid }) |distance_func| {
+        for (return_types) |return_type| {
+            try expectGridsMatch(.{
+                .frequency = 0.2,
+                .noise_type = .cellular,
+                .cellular_distance_func = distance_func,
+                .cellular_return_type = return_type,
+                .cellular_jitter_mod = 0.8,
+            });
+        }
+    }
+
+    var prng = std.rand.DefaultPrng.init(0);
+    const random = prng.random();
+    var xs: [37]f32 = undefined;
+    var ys: [37]f32 = undefined;
+    var zs: [37]f32 = undefined;
+    for (xs) |_, i| {
+        xs[i] = random.float(f32) * 2000.0 - 1000.0;
+        ys[i] = random.float(f32) * 2000.0 - 1000.0;
+        zs[i] = random.float(f32) * 2000.0 - 1000.0;
+    }
+    const gen = FnlGenerator{ .noise_type = .opensimplex2s, .fractal_type = .fbm };
+    var out: [37]f32 = undefined;
+    noise2Array(&gen, &xs, &ys, &out);
+    for (out) |v, i| try expectApproxEqAbs(gen.noise2(xs[i], ys[i]), v, 1e-5);
+    noise3Array(&gen, &xs, &ys, &zs, &out);
+    for (out) |v, i| try expectApproxEqAbs(gen.noise3(xs[i], ys[i], zs[i]), v, 1e-5);
+}
+
+fn centralDifference(gen: FnlGenerator, comptime dims: u32, p: [dims]f32, axis: usize, h: f32) f32 {
+    var lo = p;
+    var hi = p;
+    lo[axis] -= h;
+    hi[axis] += h;
+    const f_lo = if (dims == 2) gen.noise2(lo[0], lo[1]) else gen.noise3(lo[0], lo[1], lo[2]);
+    const f_hi = if (dims == 2) gen.noise2(hi[0], hi[1]) else gen.noise3(hi[0], hi[1], hi[2]);
+    return (f_hi - f_lo) / (2 * h);
+}
+
+fn expectGradient(gen: FnlGenerator, comptime dims: u32, p: [dims]f32, axis: usize, derivative: f32) !void {
+    const fd = centralDifference(gen, dims, p, axis, 0.01);
+    // Skip kinks (ridged fractal, clamped 2D fBm weight) within the step.
+    if (@fabs(fd - centralDifference(gen, dims, p, axis, 0.005)) > 1e-3) return;
+    try expectApproxEqAbs(fd, derivative, 2e-3 + 1e-2 * @fabs(fd));
+}
+
+fn expectDerivativesMatch(gen: FnlGenerator) !void {
+    const grid = Grid{ .origin = .{ 11.3, -4.9, 2.6 }, .step = 0.83, .width = 9, .height = 7, .depth = 3 };
+    const len2 = 9 * 7;
+    var values: [len2 * 3]f32 = undefined;
+    var dx: [len2 * 3]f32 = undefined;
+    var dy: [len2 * 3]f32 = undefined;
+    var dz: [len2 * 3]f32 = undefined;
+
+    noise3GridDeriv(&gen, grid, .{ .values = &values, .dx = &dx, .dy = &dy, .dz = &dz });
+    for (values) |v, i| {
+        const p = [3]f32{ grid.coord(0, i % 9), grid.coord(1, i / 9 % 7), grid.coord(2, i / len2) };
+        try expectApproxEqAbs(gen.noise3(p[0], p[1], p[2]), v, 1e-5);
+        const point = noise3Deriv(&gen, p[0], p[1], p[2]);
+        try expectApproxEqAbs(v, point[0], 1e-5);
+        for ([3]f32{ dx[i], dy[i], dz[i] }) |derivative, axis| {
+            try expectApproxEqAbs(derivative, point[axis + 1], 1e-5);
+            try expectGradient(gen, 3, p, axis, derivative);
+        }
+    }
+
+    noise2GridDeriv(&gen, grid, .{ .values = values[0..len2], .dx = dx[0..len2], .dy = dy[0..len2] });
+    for (values[0..len2]) |v, i| {
+        const p = [2]f32{ grid.coord(0, i % 9), grid.coord(1, i / 9) };
+        try expectApproxEqAbs(gen.noise2(p[0], p[1]), v, 1e-5);
+        const point = noise2Deriv(&gen, p[0], p[1]);
+        try expectApproxEqAbs(v, point[0], 1e-5);
+        for ([2]f32{ dx[i], dy[i] }) |derivative, axis| {
+            try expectApproxEqAbs(derivative, point[axis + 1], 1e-5);
+            try expectGradient(gen, 2, p, axis, derivative);
+        }
+    }
+}
+
+test "znoise.fnl.derivatives" {
+    const cellular_gen = FnlGenerator{ .noise_type = .cellular };
+    const pingpong_gen = FnlGenerator{ .fractal_type = .pingpong };
+    try std.testing.expect(!supportsDerivatives(&cellular_gen));
+    try std.testing.expect(!supportsDerivatives(&pingpong_gen));
+
+    for ([_]FnlGenerator.NoiseType{ .opensimplex2, .perlin, .value }) |noise| {
+        for ([_]FnlGenerator.FractalType{ .none, .fbm, .ridged }) |fractal| {
+            for ([_]FnlGenerator.RotationType3{ .none, .improve_xy_planes, .improve_xz_planes }) |rotation| {
+                const gen = FnlGenerator{
+                    .seed = 77,
+                    .frequency = 0.05,
+                    .noise_type = noise,
+                    .fractal_type = fractal,
+                    .rotation_type3 = rotation,
+                    .weighted_strength = 0.5,
+                };
+                try std.testing.expect(supportsDerivatives(&gen));
+                try expectDerivativesMatch(gen);
+            }
+        }
+    }
+}
+
+fn expectGeneratorMatches(comptime config: Config, settings: FnlGenerator) !void {
+    const gen = Generator(config).init(settings);
+    var c_gen = settings;
+    c_gen.noise_type = config.noise_type;
+    c_gen.fractal_type = config.fractal_type;
+    c_gen.rotation_type3 = config.rotation_type3;
+    c_gen.cellular_distance_func = config.cellular_distance_func;
+    c_gen.domain_warp_type = config.domain_warp_type;
+
+    var prng = std.rand.DefaultPrng.init(7);
+    const random = prng.random();
+    var i: u32 = 0;
+    while (i < 64) : (i += 1) {
+        const x = random.float(f32) * 200.0 - 100.0;
+        const y = random.float(f32) * 200.0 - 100.0;
+        const z = random.float(f32) * 200.0 - 100.0;
+        try std.testing.expectEqual(c_gen.noise2(x, y), gen.noise2(x, y));
+        try std.testing.expectEqual(c_gen.noise3(x, y, z), gen.noise3(x, y, z));
+
+        var c_warped = [3]f32{ x, y, z };
+        var warped = c_warped;
+        c_gen.domainWarp2(&c_warped[0], &c_warped[1]);
+        gen.domainWarp2(&warped[0], &warped[1]);
+        try std.testing.expectEqual(c_warped, warped);
+
+        c_warped = .{ x, y, z };
+        warped = c_warped;
+        c_gen.domainWarp3(&c_warped[0], &c_warped[1], &c_warped[2]);
+        gen.domainWarp3(&warped[0], &warped[1], &warped[2]);
+        try std.testing.expectEqual(c_warped, warped);
+    }
+}
+
+test "znoise.fnl.generator" {
+    const settings = FnlGenerator{
+        .seed = -1234,
+        .frequency = 0.07,
+        .weighted_strength = 0.4,
+        .cellular_return_type = .distance2add,
+        .domain_warp_amp = 20.0,
+    };
+    const noise_types = [_]FnlGenerator.NoiseType{ .opensimplex2, .opensimplex2s, .perlin, .value_cubic, .value };
+    const fractal_types = [_]FnlGenerator.FractalType{ .none, .fbm, .ridged, .pingpong };
+    inline for (noise_types) |noise_type| {
+        inline for (fractal_types) |fractal_type| {
+            try expectGeneratorMatches(.{ .noise_type = noise_type, .fractal_type = fractal_type }, settings);
+        }
+    }
+    inline for ([_]FnlGenerator.CellularDistanceFunc{ .euclidean, .euclideansq, .manhattan, .hybrid }) |func| {
+        try expectGeneratorMatches(.{ .noise_type = .cellular, .cellular_distance_func = func }, settings);
+    }
+
+    const warp_fractal_types = [_]FnlGenerator.FractalType{
+        .none,
+        .domain_warp_progressive,
+        .domain_warp_independent,
+    };
+    inline for ([_]FnlGenerator.DomainWarpType{ .opensimplex2, .opensimplex2_reduced, .basicgrid }) |warp_type| {
+        inline for (warp_fractal_types) |fractal_type| {
+            inline for ([_]FnlGenerator.RotationType3{ .none, .improve_xy_planes, .improve_xz_planes }) |rotation| {
+                try expectGeneratorMatches(.{
+                    .fractal_type = fractal_type,
+                    .rotation_type3 = rotation,
+                    .domain_warp_type = warp_type,
+                }, settings);
+            }
+        }
+    }
+
+    const gen = Generator(.{ .noise_type = .perlin, .fractal_type = .fbm }).init(.{});
+    var out: [16 * 8]f32 = undefined;
+    gen.noise2Grid(.{ .width = 16, .height = 8 }, &out);
+    for (out) |v, i| try std.testing.expectEqual(gen.noise2(@intToFloat(f32, i % 16), @intToFloat(f32, i / 16)), v);
+}
@@ -0,0 +1,395 @@
+// Noise tiles for chunked (streaming) worlds.
+//
+// `TileCache.getTiles()` takes a list of chunk requests (generator settings + chunk coordinates), returns cached tiles
+// and generates missing ones on a pool of worker threads. Finished tiles are kept in a fixed number of slots; when
+// all slots are taken the least recently requested tile is replaced.
+//
+// A tile covers `size` samples per edge plus `border` samples on every side. Sample coordinates are computed from
+// global sample indices (`FnlGenerator.Grid.offset`), so the border of a tile is bit-identical to the samples of its
+// neighbours.
+
+const std = @import("std");
+const builtin = @import("builtin");
+const assert = std.debug.assert;
+const FnlGenerator = @import("znoise.zig").FnlGenerator;
+
+pub const TileOptions = struct {
+    /// Samples per chunk edge (distance between chunk origins in samples).
+    size: u32 = 64,
+    /// Extra samples on every side of a chunk.
+    border: u32 = 0,
+    /// World-space distance between samples.
+    spacing: f32 = 1.0,
+    /// 2 - heightmap tiles (`noise2()`), 3 - volume tiles (`noise3()`).
+    dims: u32 = 2,
+    /// Number of tiles kept in memory; also the maximum number of requests per `getTiles()` call.
+    max_tiles: u32 = 256,
+    /// Threads generating tiles, including the calling thread (0 - one per CPU).
+    num_threads: u32 = 0,
+};
+
+pub const TileRequest = struct {
+    generator: FnlGenerator,
+    /// z is ignored for 2D tiles. Samples of the tile (border included) must have i32 indices
+    /// (`FnlGenerator.Grid.offset`), otherwise `getTiles()` returns `error.ChunkOutOfRange`.
+    chunk: [3]i32,
+};
+
+pub const BatchStats = struct {
+    num_cached: u32 = 0,
+    num_generated: u32 = 0,
+};
+
+pub const TileCache = struct {
+    allocator: std.mem.Allocator,
+    options: TileOptions,
+    /// Values per tile: `(size + 2 * border)^dims`.
+    tile_len: usize,
+
+    values: []f32,
+    slots: []Slot,
+    num_used_slots: u32 = 0,
+    map: std.HashMapUnmanaged(Key, u32, KeyContext, std.hash_map.default_max_load_percentage) = .{},
+    num_removed_keys: u32 = 0,
+    /// Most and least recently requested slots.
+    lru_head: u32 = none,
+    lru_tail: u32 = none,
+    batch: u64 = 0,
+
+    // Worker pool. `jobs` (slot indices) are handed out through `next_job`; `mutex` guards the rest.
+    threads: []std.Thread,
+    num_workers: usize = 0,
+    jobs: []u32,
+    num_jobs: usize = 0,
+    next_job: usize = 0,
+    mutex: std.Thread.Mutex = .{},
+    work_available: std.Thread.Condition = .{},
+    work_done: std.Thread.Condition = .{},
+    dispatch_count: u64 = 0,
+    num_busy_workers: usize = 0,
+    shutdown: bool = false,
+
+    const none = std.math.maxInt(u32);
+
+    const Key = extern struct {
+        generator: FnlGenerator,
+        chunk: [3]i32,
+    };
+
+    const KeyContext = struct {
+        pub fn hash(_: KeyContext, key: Key) u64 {
+            return std.hash.Wyhash.hash(0, std.mem.asBytes(&key));
+        }
+
+        pub fn eql(_: KeyContext, a: Key, b: Key) bool {
+            return std.mem.eql(u8, std.mem.asBytes(&a), std.mem.asBytes(&b));
+        }
+    };
+
+    const Slot = struct {
+        key: Key,
+        prev: u32,
+        next: u32,
+        /// Last `getTiles()` call that requested this tile.
+        batch: u64,
+    };
+
+    pub fn init(allocator: std.mem.Allocator, options: TileOptions) !*TileCache {
+        assert(options.dims == 2 or options.dims == 3);
+        assert(options.size > 0 and options.max_tiles > 0);
+
+        const edge = @as(usize, options.size) + 2 * options.border;
+        const tile_len = if (options.dims == 3) edge * edge * edge else edge * edge;
+
+        const cache = try allocator.create(TileCache);
+        errdefer allocator.destroy(cache);
+
+        const values = try allocator.alloc(f32, tile_len * options.max_tiles);
+        errdefer allocator.free(values);
+        const slots = try allocator.alloc(Slot, options.max_tiles);
+        errdefer allocator.free(slots);
+        const jobs = try allocator.alloc(u32, options.max_tiles);
+        errdefer allocator.free(jobs);
+
+        const num_threads: usize = if (builtin.single_threaded)
+            1
+        else if (options.num_threads == 0)
+            std.Thread.getCpuCount() catch 1
+        else
+            options.num_threads;
+        const threads = try allocator.alloc(std.Thread, num_threads - 1);
+        errdefer allocator.free(threads);
+
+        cache.* = .{
+            .allocator = allocator,
+            .options = options,
+            .tile_len = tile_len,
+            .values = values,
+            .slots = slots,
+            .threads = threads,
+            .jobs = jobs,
+        };
+        errdefer cache.map.deinit(allocator);
+        // One more than `max_tiles`: a new key is added before the evicted one is removed.
+        try cache.map.ensureTotalCapacity(allocator, options.max_tiles + 1);
+
+        // Fewer workers when a thread can't be spawned.
+        while (cache.num_workers < threads.len) : (cache.num_workers += 1) {
+            threads[cache.num_workers] = std.Thread.spawn(.{}, workerMain, .{cache}) catch break;
+        }
+
+        return cache;
+    }
+
+    pub fn deinit(cache: *TileCache) void {
+        {
+            cache.mutex.lock();
+            defer cache.mutex.unlock();
+            cache.shutdown = true;
+            cache.work_available.broadcast();
+        }
+        for (cache.threads[0..cache.num_workers]) |thread| thread.join();
+
+        const allocator = cache.allocator;
+        cache.map.deinit(allocator);
+        allocator.free(cache.threads);
+        allocator.free(cache.jobs);
+        allocator.free(cache.slots);
+        allocator.free(cache.values);
+        allocator.destroy(cache);
+    }
+
+    /// Sets `tiles[i]` to the values of the tile requested by `requests[i]`, generating the tiles that are not cached.
+    /// Tile values stay valid until the next `getTiles()` call. Not thread-safe.
+    pub fn getTiles(cache: *TileCache, requests: []const TileRequest, tiles: [][]const f32) !BatchStats {
+        assert(requests.len == tiles.len);
+        if (requests.len > cache.slots.len) return error.TooManyRequests;
+        for (requests) |request| {
+            for (request.chunk[0..cache.options.dims]) |chunk| {
+                const first = firstSample(cache.options, chunk);
+                const last = first + cache.options.size + 2 * @as(i64, cache.options.border) - 1;
+                if (first < std.math.minInt(i32) or last > std.math.maxInt(i32)) return error.ChunkOutOfRange;
+            }
+        }
+
+        // Removed keys leave tombstones in the hash map; rebuild it after as many removals as there are slots.
+        if (cache.num_removed_keys >= cache.slots.len) {
+            cache.map.clearRetainingCapacity();
+            for (cache.slots[0..cache.num_used_slots]) |slot, index| {
+                cache.map.putAssumeCapacityNoClobber(slot.key, @intCast(u32, index));
+            }
+            cache.num_removed_keys = 0;
+        }
+
+        cache.batch += 1;
+        var stats = BatchStats{};
+        var num_jobs: usize = 0;
+
+        for (requests) |request, i| {
+            var key = Key{ .generator = request.generator, .chunk = request.chunk };
+            if (cache.options.dims == 2) key.chunk[2] = 0;
+
+            const result = cache.map.getOrPutAssumeCapacity(key);
+            if (result.found_existing) {
+                stats.num_cached += 1;
+                cache.unlink(result.value_ptr.*);
+            } else {
+                stats.num_generated += 1;
+                const new_index = cache.allocateSlot();
+                cache.slots[new_index].key = key;
+                result.value_ptr.* = new_index;
+                cache.jobs[num_jobs] = new_index;
+                num_jobs += 1;
+            }
+            const index = result.value_ptr.*;
+            cache.slots[index].batch = cache.batch;
+            cache.pushFront(index);
+            tiles[i] = cache.tileValues(index);
+        }
+
+        if (num_jobs > 0) cache.runJobs(num_jobs);
+        return stats;
+    }
+
+    /// Index of the first sample of the chunk (skipping the border) in tile values.
+    pub fn chunkOrigin(cache: *const TileCache) usize {
+        const edge = cache.options.size + 2 * cache.options.border;
+        const b: usize = cache.options.border;
+        return if (cache.options.dims == 3) (b * edge + b) * edge + b else b * edge + b;
+    }
+
+    fn tileValues(cache: *const TileCache, index: u32) []f32 {
+        return cache.values[index * cache.tile_len ..][0..cache.tile_len];
+    }
+
+    /// Unused slot or the least recently requested one (never one requested in the current batch).
+    fn allocateSlot(cache: *TileCache) u32 {
+        if (cache.num_used_slots < cache.slots.len) {
+            cache.num_used_slots += 1;
+            return cache.num_used_slots - 1;
+        }
+        const index = cache.lru_tail;
+        assert(cache.slots[index].batch != cache.batch);
+        cache.unlink(index);
+        _ = cache.map.remove(cache.slots[index].key);
+        cache.num_removed_keys += 1;
+        return index;
+    }
+
+    fn unlink(cache: *TileCache, index: u32) void {
+        const slot = &cache.slots[index];
+        if (slot.prev != none) cache.slots[slot.prev].next = slot.next else cache.lru_head = slot.next;
+        if (slot.next != none) cache.slots[slot.next].prev = slot.prev else cache.lru_tail = slot.prev;
+    }
+
+    fn pushFront(cache: *TileCache, index: u32) void {
+        const slot = &cache.slots[index];
+        slot.prev = none;
+        slot.next = cache.lru_head;
+        if (cache.lru_head != none) cache.slots[cache.lru_head].prev = index else cache.lru_tail = index;
+        cache.lru_head = index;
+    }
+
+    fn runJobs(cache: *TileCache, num_jobs: usize) void {
+        {
+            cache.mutex.lock();
+            defer cache.mutex.unlock();
+            cache.num_jobs = num_jobs;
+            cache.next_job = 0;
+            cache.num_busy_workers = cache.num_workers;
+            cache.dispatch_count += 1;
+            cache.work_available.broadcast();
+        }
+
+        cache.takeJobs();
+
+        cache.mutex.lock();
+        defer cache.mutex.unlock();
+        while (cache.num_busy_workers > 0) cache.work_done.wait(&cache.mutex);
+    }
+
+    fn takeJobs(cache: *TileCache) void {
+        while (true) {
+            const job = @atomicRmw(usize, &cache.next_job, .Add, 1, .Monotonic);
+            if (job >= cache.num_jobs) return;
+            cache.generateTile(cache.jobs[job]);
+        }
+    }
+
+    fn workerMain(cache: *TileCache) void {
+        var seen_dispatch: u64 = 0;
+        while (true) {
+            {
+                cache.mutex.lock();
+                defer cache.mutex.unlock();
+                while (!cache.shutdown and cache.dispatch_count == seen_dispatch) {
+                    cache.work_available.wait(&cache.mutex);
+                }
+                if (cache.shutdown) return;
+                seen_dispatch = cache.dispatch_count;
+            }
+
+            cache.takeJobs();
+
+            cache.mutex.lock();
+            defer cache.mutex.unlock();
+            cache.num_busy_workers -= 1;
+            if (cache.num_busy_workers == 0) cache.work_done.signal();
+        }
+    }
+
+    /// Global index of the first sample (border included) of a chunk along one axis.
+    fn firstSample(options: TileOptions, chunk: i32) i64 {
+        return @as(i64, chunk) * options.size - options.border;
+    }
+
+    /// Sample indices of the tile are in i32 range (checked by `getTiles()`).
+    fn generateTile(cache: *TileCache, index: u32) void {
+        const options = cache.options;
+        const key = cache.slots[index].key;
+        const edge = options.size + 2 * options.border;
+
+        const grid = FnlGenerator.Grid{
+            .offset = .{
+                @intCast(i32, firstSample(options, key.chunk[0])),
+                @intCast(i32, firstSample(options, key.chunk[1])),
+                if (options.dims == 3) @intCast(i32, firstSample(options, key.chunk[2])) else 0,
+            },
+            .step = options.spacing,
+            .width = edge,
+            .height = edge,
+            .depth = if (options.dims == 3) edge else 1,
+        };
+        if (options.dims == 3) {
+            key.generator.noise3Grid(grid, cache.tileValues(index));
+        } else {
+            key.generator.noise2Grid(grid, cache.tileValues(index));
+        }
+    }
+};
+
+test "znoise.tiles.cache" {
+    const expect = std.testing.expect;
+    const expectEqual = std.testing.expectEqual;
+
+    const cache = try TileCache.init(std.testing.allocator, .{
+        .size = 8,
+        .border = 2,
+        .spacing = 0.5,
+        .max_tiles = 4,
+        .num_threads = 3,
+    });
+    defer cache.deinit();
+
+    const gen = FnlGenerator{ .noise_type = .perlin, .frequency = 0.2 };
+    const edge = 8 + 2 * 2;
+    var tiles: [5][]const f32 = undefined;
+
+    const requests0 = [_]TileRequest{
+        .{ .generator = gen, .chunk = .{ 0, 0, 0 } },
+        .{ .generator = gen, .chunk = .{ 1, 0, 7 } },
+        .{ .generator = gen, .chunk = .{ 0, 0, 0 } },
+    };
+    const stats0 = try cache.getTiles(&requests0, tiles[0..3]);
+    try expectEqual(BatchStats{ .num_cached = 1, .num_generated = 2 }, stats0);
+    try expect(tiles[0].ptr == tiles[2].ptr);
+
+    // Samples shared by neighbouring tiles are identical.
+    var y: usize = 0;
+    while (y < edge) : (y += 1) {
+        var x: usize = 0;
+        while (x < 2 * 2) : (x += 1) {
+            try expectEqual(tiles[0][y * edge + 8 + x], tiles[1][y * edge + x]);
+        }
+    }
+    const origin = cache.chunkOrigin();
+    try std.testing.expectApproxEqAbs(gen.noise2(8 * 0.5, 0.0), tiles[1][origin], 1e-5);
+
+    // Chunk (1, 0) is the least recently requested tile.
+    const requests1 = [_]TileRequest{
+        .{ .generator = gen, .chunk = .{ 2, 0, 0 } },
+        .{ .generator = gen, .chunk = .{ 3, 0, 0 } },
+        .{ .generator = gen, .chunk = .{ 4, 0, 0 } },
+    };
+    const stats1 = try cache.getTiles(&requests1, tiles[0..3]);
+    try expectEqual(BatchStats{ .num_cached = 0, .num_generated = 3 }, stats1);
+
+    const requests2 = [_]TileRequest{
+        .{ .generator = gen, .chunk = .{ 0, 0, 0 } },
+        .{ .generator = gen, .chunk = .{ 1, 0, 0 } },
+        .{ .generator = .{ .noise_type = .perlin, .frequency = 0.2, .seed = 7 }, .chunk = .{ 0, 0, 0 } },
+    };
+    const stats2 = try cache.getTiles(&requests2, tiles[0..3]);
+    try expectEqual(BatchStats{ .num_cached = 1, .num_generated = 2 }, stats2);
+
+    const requests3 = [_]TileRequest{.{ .generator = gen, .chunk = .{ 0, 0, 0 } }} ** 5;
+    try std.testing.expectError(error.TooManyRequests, cache.getTiles(&requests3, &tiles));
+
+    // Sample indices of chunk (2^28 - 1, 0) end at 2^31 + 1; z is ignored by 2D tiles.
+    const max_chunk = (1 << 28) - 1;
+    const requests4 = [_]TileRequest{.{ .generator = gen, .chunk = .{ max_chunk, 0, 0 } }};
+    try std.testing.expectError(error.ChunkOutOfRange, cache.getTiles(&requests4, tiles[0..1]));
+    const requests5 = [_]TileRequest{.{ .generator = gen, .chunk = .{ max_chunk - 1, -max_chunk, max_chunk } }};
+    const stats5 = try cache.getTiles(&requests5, tiles[0..1]);
+    try expectEqual(BatchStats{ .num_cached = 0, .num_generated = 1 }, stats5);
+}
@@ -1,5 +1,18 @@
 // znoise - Zig bindings for FastNoiseLite
 
+const fnl = @import("fnl.zig");
+const tiles = @import("tiles.zig");
+
+/// `FnlGenerator` with noise, fractal, 3D rotation, cellular distance and domain warp types fixed at compile time:
+/// `znoise.Generator(.{ .noise_type = .perlin, .fractal_type = .fbm }).init(.{ .seed = 42 })`.
+pub const Generator = fnl.Generator;
+pub const GeneratorConfig = fnl.Config;
+
+pub const TileCache = tiles.TileCache;
+pub const TileOptions = tiles.TileOptions;
+pub const TileRequest = tiles.TileRequest;
+pub const BatchStats = tiles.BatchStats;
+
 pub const FnlGenerator = extern struct {
     seed: i32 = 1337,
     frequency: f32 = 0.01,
@@ -75,8 +88,32 @@ pub const FnlGenerator = extern struct {
 
     pub const domainWarp3 = fnlDomainWarp3D;
     extern fn fnlDomainWarp3D(gen: *const FnlGenerator, x: *f32, y: *f32, z: *f32) void;
+
+    /// Batch versions of `noise2()` / `noise3()`. Noise, fractal and rotation types are dispatched once per call and
+    /// 4 (8 with AVX) samples are evaluated together; results match the scalar functions.
+    pub const Grid = fnl.Grid;
+    pub const noise2Grid = fnl.noise2Grid;
+    pub const noise3Grid = fnl.noise3Grid;
+    pub const noise2Array = fnl.noise2Array;
+    pub const noise3Array = fnl.noise3Array;
+
+    /// Value and analytic gradient in one evaluation: `noise2Deriv()` returns `.{ value, d/dx, d/dy }`,
+    /// `noise3Deriv()` `.{ value, d/dx, d/dy, d/dz }`. OpenSimplex2, Perlin and value noise with no fractal, fBm or
+    /// ridged fractal (see `supportsDerivatives()`); values match `noise2()` / `noise3()`.
+    pub const Derivatives2 = fnl.Derivatives2;
+    pub const Derivatives3 = fnl.Derivatives3;
+    pub const supportsDerivatives = fnl.supportsDerivatives;
+    pub const noise2Deriv = fnl.noise2Deriv;
+    pub const noise3Deriv = fnl.noise3Deriv;
+    pub const noise2GridDeriv = fnl.noise2GridDeriv;
+    pub const noise3GridDeriv = fnl.noise3GridDeriv;
 };
 
+comptime {
+    _ = fnl;
+    _ = tiles;
+}
+
 test "znoise.basic" {
     const gen = FnlGenerator{ .fractal_type = .fbm };
     const n2 = gen.noise2(0.1, 0.2);
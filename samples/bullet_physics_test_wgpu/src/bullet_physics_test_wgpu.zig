@@ -526,7 +526,7 @@ fn draw(demo: *DemoState) void {
 
         // Physics debug pass.
         pass: {
-            demo.physics.world.debugDrawAll();
+            demo.physics.debug.drawAll(demo.physics.world, null);
             const num_vertices = @intCast(u32, demo.physics.debug.lines.items.len);
             if (num_vertices == 0) break :pass;
 